@@ -39,7 +39,7 @@ void InterpreterOptions::printUsageAndExit(const char* progName) {
 	printf("%s version " USCXML_VERSION " (" CMAKE_BUILD_TYPE " build - " CMAKE_COMPILER_STRING ")\n", progStr.c_str());
 	printf("Usage\n");
 	printf("\t%s", progStr.c_str());
-	printf(" [-v] [-d] [-lN]");
+	printf(" [-v] [-d] [--metrics] [--trace] [--simulate] [-lN]");
 #ifdef BUILD_AS_PLUGINS
 	printf(" [-p pluginPath]");
 #endif
@@ -47,7 +47,7 @@ void InterpreterOptions::printUsageAndExit(const char* progName) {
 #ifdef HTTPS_ENABLED
 	printf(" [-sN] [--certificate=FILE | --private-key=FILE --public-key=FILE] ");
 #endif
-	printf(" \\\n\t\t URL1 [--disable-http] [--option1=value1 --option2=value2]");
+	printf(" \\\n\t\t URL1 [--disable-http] [--record=FILE] [--option1=value1 --option2=value2]");
 	printf(" \\\n\t\t[URL2 [--disable-http] [--option3=value3 --option4=value4]]");
 	printf(" \\\n\t\t[URLN [--disable-http] [--optionN=valueN --optionM=valueM]]");
 	printf("\n");
@@ -62,6 +62,10 @@ void InterpreterOptions::printUsageAndExit(const char* progName) {
 	printf("\t-sN       : port for HTTPS server\n");
 	printf("\t-wN       : port for WebSocket server\n");
     printf("\t-d        : start with debugger attachable\n");
+	printf("\t--metrics : collect metrics and export them at /metrics\n");
+	printf("\t--trace   : export the flight recorders at /trace\n");
+	printf("\t--simulate : run on a virtual clock that skips ahead to the next delayed event\n");
+	printf("\t--record=FILE : record the external events of the preceding document for uscxml-replay\n");
 	printf("\n");
     exit(1);
 }
@@ -73,6 +77,10 @@ InterpreterOptions InterpreterOptions::fromCmdLine(int argc, char** argv) {
 		{"check",         no_argument,       0, 'c'},
 		{"verbose",       no_argument,       0, 'v'},
 		{"debug",         no_argument,       0, 'd'},
+		{"metrics",       no_argument,       0, 0},
+		{"trace",         no_argument,       0, 0},
+		{"record",        required_argument, 0, 0},
+		{"simulate",      no_argument,       0, 0},
 		{"port",          required_argument, 0, 't'},
 		{"ssl-port",      required_argument, 0, 's'},
 		{"ws-port",       required_argument, 0, 'w'},
@@ -121,6 +129,14 @@ InterpreterOptions InterpreterOptions::fromCmdLine(int argc, char** argv) {
 				currOptions->certificate = optarg;
 			} else if (iequals(longOptions[optionInd].name, "public-key")) {
 				currOptions->publicKey = optarg;
+			} else if (iequals(longOptions[optionInd].name, "metrics")) {
+				currOptions->withMetrics = true;
+			} else if (iequals(longOptions[optionInd].name, "trace")) {
+				currOptions->withTrace = true;
+			} else if (iequals(longOptions[optionInd].name, "record")) {
+				currOptions->recordFile = optarg;
+			} else if (iequals(longOptions[optionInd].name, "simulate")) {
+				currOptions->simulate = true;
 			}
 			break;
 		}
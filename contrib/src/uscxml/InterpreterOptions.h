@@ -42,6 +42,9 @@ public:
 		withHTTPS(true),
 		withWS(true),
 		withDebugger(false),
+		withMetrics(false),
+		withTrace(false),
+		simulate(false),
 		logLevel(0),
 		httpPort(5080),
 		httpsPort(5443),
@@ -54,6 +57,9 @@ public:
 	bool withHTTPS;
 	bool withWS;
 	bool withDebugger;
+	bool withMetrics;
+	bool withTrace;
+	bool simulate;
 	int logLevel;
 	unsigned short httpPort;
 	unsigned short httpsPort;
@@ -62,6 +68,7 @@ public:
 	std::string certificate;
 	std::string privateKey;
 	std::string publicKey;
+	std::string recordFile;
 	std::vector<std::pair<std::string, InterpreterOptions*> > interpreters;
 	std::map<std::string, std::string> additionalParameters;
 
@@ -3,7 +3,11 @@
 #include "uscxml/InterpreterOptions.h"
 #include "uscxml/debug/InterpreterIssue.h"
 #include "uscxml/debug/DebuggerServlet.h"
+#include "uscxml/debug/MetricsServlet.h"
+#include "uscxml/debug/TraceServlet.h"
+#include "uscxml/debug/InterpreterRecorder.h"
 #include "uscxml/interpreter/InterpreterMonitor.h"
+#include "uscxml/interpreter/Scheduler.h"
 #include "uscxml/util/DOM.h"
 
 #include "uscxml/interpreter/Logging.h"
@@ -11,6 +15,8 @@
 #include "uscxml/plugins/Factory.h"
 #include "uscxml/server/HTTPServer.h"
 
+#include <fstream>
+
 
 int main(int argc, char** argv) {
 	using namespace uscxml;
@@ -54,9 +60,10 @@ int main(int argc, char** argv) {
 
 	// instantiate and configure interpreters
 	std::list<Interpreter> interpreters;
+	std::list<std::pair<Interpreter, InterpreterRecorder*> > recorders;
 	for(size_t i = 0; i < options.interpreters.size(); i++) {
 
-//		InterpreterOptions* currOptions = options.interpreters[0].second;
+		InterpreterOptions* currOptions = options.interpreters[i].second;
 		std::string documentURL = options.interpreters[i].first;
 
 		LOGD(USCXML_INFO) << "Processing " << documentURL << std::endl;
@@ -82,6 +89,17 @@ int main(int argc, char** argv) {
 					interpreter.addMonitor(vm);
 				}
 
+				if (currOptions->recordFile.length() > 0) {
+					std::ofstream* recordStream = new std::ofstream(currOptions->recordFile.c_str(), std::ios::binary | std::ios::trunc);
+					if (!*recordStream) {
+						LOGD(USCXML_ERROR) << "Cannot write recording to " << currOptions->recordFile << std::endl;
+						return EXIT_FAILURE;
+					}
+					InterpreterRecorder* recorder = new InterpreterRecorder(documentURL, recordStream);
+					interpreter.addMonitor(recorder);
+					recorders.push_back(std::make_pair(interpreter, recorder));
+				}
+
 				interpreters.push_back(interpreter);
 
 			} else {
@@ -106,23 +124,37 @@ int main(int argc, char** argv) {
 		}
 	}
 
+	if (options.withMetrics) {
+		HTTPServer::getInstance()->registerServlet("/metrics", new MetricsServlet());
+		for (auto interpreter : interpreters) {
+			interpreter.setMetricsEnabled(true);
+		}
+	}
+
+	if (options.withTrace) {
+		HTTPServer::getInstance()->registerServlet("/trace", new TraceServlet());
+	}
+
 	// run interpreters
 	if (interpreters.size() > 0) {
-		try {
-			std::list<Interpreter>::iterator interpreterIter = interpreters.begin();
-			while (interpreters.size() > 0) {
-				while(interpreterIter != interpreters.end()) {
-					InterpreterState state = interpreterIter->step();
-					if (state == USCXML_FINISHED) {
-						interpreterIter = interpreters.erase(interpreterIter);
-					} else {
-						interpreterIter++;
-					}
-				}
-				interpreterIter = interpreters.begin();
-			}
-		} catch (Event e) {
-			LOGD(USCXML_ERROR) << e << std::endl;
+		std::shared_ptr<Scheduler> scheduler;
+		if (options.simulate) {
+			// a single worker keeps the simulation deterministic
+			scheduler = std::shared_ptr<Scheduler>(new Scheduler(1, std::shared_ptr<VirtualClock>(new VirtualClock())));
+		} else {
+			scheduler = std::shared_ptr<Scheduler>(new Scheduler());
+		}
+		for (auto interpreter : interpreters) {
+			scheduler->add(interpreter);
+		}
+		scheduler->wait();
+
+		if (options.simulate) {
+			LOGD(USCXML_INFO) << "Simulated " << scheduler->getClock()->now() << "ms" << std::endl;
+		}
+
+		for (auto& recorder : recorders) {
+			recorder.second->finish(recorder.first);
 		}
 	} else if (options.withDebugger) {
 		while(true)
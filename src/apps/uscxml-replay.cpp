@@ -0,0 +1,154 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/debug/InterpreterRecorder.h"
+#include "uscxml/util/String.h"
+#include "uscxml/util/Convenience.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include "getopt.h"
+
+// every allocation in the process, the replay is the only thing running
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void printUsageAndExit(const char* progName) {
+	// remove path from program name
+	std::string progStr(progName);
+	if (progStr.find_last_of(PATH_SEPERATOR) != std::string::npos) {
+		progStr = progStr.substr(progStr.find_last_of(PATH_SEPERATOR) + 1, progStr.length() - (progStr.find_last_of(PATH_SEPERATOR) + 1));
+	}
+
+	printf("%s version " USCXML_VERSION " (" CMAKE_BUILD_TYPE " build - " CMAKE_COMPILER_STRING ")\n", progStr.c_str());
+	printf("Usage\n");
+	printf("\t%s", progStr.c_str());
+	printf(" [-r] [-n N] [-u URL] RECORDING");
+	printf("\n");
+	printf("Options\n");
+	printf("\t-r             : wait for the recorded time before every event\n");
+	printf("\t-n N           : replay N times (defaults to 1)\n");
+	printf("\t-u URL         : replay with another chart than the recorded one\n");
+	printf("\tRECORDING      : file written with uscxml-browser --record\n");
+	printf("\n");
+	exit(1);
+}
+
+int main(int argc, char** argv) {
+	using namespace uscxml;
+
+	InterpreterReplay::Pace pace = InterpreterReplay::AS_FAST_AS_POSSIBLE;
+	size_t runs = 1;
+	std::string url;
+
+	optind = 0;
+	opterr = 0;
+
+	struct option longOptions[] = {
+		{"recorded-pace", no_argument,       0, 'r'},
+		{"runs",          required_argument, 0, 'n'},
+		{"url",           required_argument, 0, 'u'},
+		{0, 0, 0, 0}
+	};
+
+	int optionInd = 0;
+	int option;
+	for (;;) {
+		option = getopt_long_only(argc, argv, "+rn:u:", longOptions, &optionInd);
+		if (option == -1) {
+			break;
+		}
+		switch(option) {
+		case 'r':
+			pace = InterpreterReplay::RECORDED;
+			break;
+		case 'n':
+			runs = strTo<size_t>(optarg);
+			break;
+		case 'u':
+			url = optarg;
+			break;
+		default:
+			printUsageAndExit(argv[0]);
+		}
+	}
+
+	if (optind != argc - 1 || runs == 0)
+		printUsageAndExit(argv[0]);
+
+	std::ifstream file(argv[optind], std::ios::binary);
+	if (!file) {
+		std::cerr << "Cannot open recording " << argv[optind] << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	std::stringstream content;
+	content << file.rdbuf();
+
+	InterpreterRecording recording;
+	try {
+		recording = InterpreterRecording::fromBuffer(content.str());
+	} catch (ErrorEvent e) {
+		std::cerr << "Cannot read recording " << argv[optind] << ": " << e << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	if (url.size() > 0)
+		recording.url = url;
+
+	if (!recording.finished)
+		std::cerr << "Recording was not finished, the final configuration will not be checked" << std::endl;
+
+	bool matches = true;
+	std::cout << "\"Run\", \"Events\", \"Macrosteps\", \"Events/s\", \"p50 (us)\", \"p90 (us)\", \"p99 (us)\", \"Max (us)\", \"Allocations\", \"Configuration\"" << std::endl;
+	for (size_t run = 0; run < runs; run++) {
+		Interpreter interpreter = Interpreter::fromURL(recording.url);
+		if (!interpreter) {
+			std::cerr << "Cannot load " << recording.url << std::endl;
+			exit(EXIT_FAILURE);
+		}
+
+		uint64_t allocationsBefore = allocations.load();
+		InterpreterReplay::Result result = InterpreterReplay::replay(recording, interpreter, pace);
+		uint64_t allocated = allocations.load() - allocationsBefore;
+
+		std::cout << run << ", " << result.events << ", " << result.macrosteps << ", " << result.eventsPerSecond << ", ";
+		std::cout << result.p50Ns / 1000.0 << ", " << result.p90Ns / 1000.0 << ", " << result.p99Ns / 1000.0 << ", " << result.maxNs / 1000.0 << ", ";
+		std::cout << allocated << ", " << (result.configurationMatches ? "matches" : "differs") << std::endl;
+
+		if (!result.configurationMatches) {
+			std::cerr << "Final configuration differs" << std::endl;
+			std::cerr << "\trecorded:";
+			for (auto& state : recording.configuration)
+				std::cerr << " " << state;
+			std::cerr << std::endl << "\treplayed:";
+			for (auto& state : result.configuration)
+				std::cerr << " " << state;
+			std::cerr << std::endl;
+			matches = false;
+		}
+	}
+
+	return (matches ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -28,6 +28,11 @@
 %ignore uscxml::Interpreter::fromElement;
 %ignore uscxml::Interpreter::fromClone;
 %ignore uscxml::Interpreter::getImpl();
+%ignore uscxml::Interpreter::serialize(SnapshotFormat);
+%ignore uscxml::Interpreter::checkpoint;
+%ignore uscxml::Interpreter::restore;
+%ignore uscxml::Interpreter::receive(const std::list<Event>&);
+%ignore uscxml::Interpreter::writeTrace;
 
 %ignore uscxml::InterpreterOptions;
 
@@ -53,6 +58,8 @@
 %ignore uscxml::InterpreterMonitor::beforeExecutingContent(const XERCESC_NS::DOMElement*);
 %ignore uscxml::InterpreterMonitor::afterExecutingContent(const XERCESC_NS::DOMElement*);
 
+%ignore uscxml::MonitorSnapshot;
+
 
 %ignore uscxml::InterpreterOptions::fromCmdLine(int, char**);
 %ignore uscxml::InterpreterOptions::additionalParameters;
@@ -78,6 +85,17 @@
 %ignore uscxml::WrappedDataModel::create(DataModelCallbacks*);
 %ignore uscxml::DataModelExtension::dm;
 
+// compiled expressions are opaque to the bindings, wrapped data-models evaluate strings
+%ignore uscxml::CompiledExpression;
+%ignore uscxml::DataModel::compile;
+%ignore uscxml::DataModel::evalCompiledAsBool;
+%ignore uscxml::DataModel::evalCompiledAsData;
+%ignore uscxml::DataModel::evalCompiled;
+%ignore uscxml::DataModelImpl::compile;
+%ignore uscxml::DataModelImpl::evalCompiledAsBool;
+%ignore uscxml::DataModelImpl::evalCompiledAsData;
+%ignore uscxml::DataModelImpl::evalCompiled;
+
 // Executable Content
 
 %ignore uscxml::ExecutableContent::ExecutableContent(const std::shared_ptr<ExecutableContentImpl>);
@@ -121,6 +139,8 @@
 %ignore uscxml::Event::getParams();
 %ignore uscxml::Event::getParam;
 %ignore uscxml::Event::setParams;
+%ignore uscxml::Event::enqueuedAt;
+%ignore uscxml::Event::nameId;
 
 // HTTPServer
 
@@ -132,6 +152,7 @@
 // Data
 
 %ignore uscxml::Data::toDocument;
+%ignore uscxml::Data::toJSON(const Data&, std::string&);
 %ignore uscxml::Data::Data(const XERCESC_NS::DOMElement*);
 %ignore uscxml::Data::Data(const char* data, size_t size, const std::string& mimeType, bool adopt);
 %ignore uscxml::Data::Data(const char* data, size_t size, const std::string& mimeType);
@@ -141,6 +162,9 @@
 %ignore uscxml::Blob::Blob(size_t size);
 %ignore uscxml::Blob::Blob(const char* data, size_t size, const std::string& mimeType, bool adopt);
 %ignore uscxml::Blob::Blob(const std::shared_ptr<BlobImpl>);
+%ignore uscxml::Blob::base64(std::ostream&) const;
+%ignore uscxml::BlobImpl::BlobImpl(const std::shared_ptr<BlobImpl>&, size_t, size_t);
+%ignore uscxml::BlobImpl::base64(std::ostream&) const;
 
 
 %ignore operator!=;
@@ -21,6 +21,8 @@
 #include "uscxml/Common.h"
 #include "uscxml/Interpreter.h"
 #include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/interpreter/ChartTemplate.h"
+#include "uscxml/interpreter/FastMicroStep.h"
 #include "uscxml/util/DOM.h"
 #include "uscxml/util/URL.h"
 #include "uscxml/util/MD5.hpp"
@@ -146,6 +148,31 @@ Interpreter Interpreter::fromDocument(XERCESC_NS::DOMDocument* dom, const std::s
 	return interpreter;
 }
 
+Interpreter Interpreter::fromTemplate(std::shared_ptr<ChartTemplate> chartTemplate) {
+	if (!chartTemplate->isShared()) {
+		// we cannot share the DOM, but at least we need not fetch it again
+		return fromXML(chartTemplate->_xml, chartTemplate->_baseURL);
+	}
+
+	std::shared_ptr<InterpreterImpl> interpreterImpl(new InterpreterImpl());
+	Interpreter interpreter(interpreterImpl);
+
+	std::shared_ptr<InterpreterImpl> prototype = chartTemplate->_prototype;
+	interpreterImpl->_template = chartTemplate;
+	interpreterImpl->_document = prototype->_document;
+	interpreterImpl->_scxml = prototype->_scxml;
+	interpreterImpl->_xmlPrefix = prototype->_xmlPrefix;
+	interpreterImpl->_xmlNS = prototype->_xmlNS;
+	interpreterImpl->_name = prototype->_name;
+	interpreterImpl->_binding = prototype->_binding;
+	interpreterImpl->_baseURL = prototype->_baseURL;
+	interpreterImpl->_md5 = chartTemplate->getMD5();
+	interpreterImpl->_microStepper = MicroStep(std::shared_ptr<MicroStepImpl>(new FastMicroStep(interpreterImpl.get(), chartTemplate->_chart)));
+
+	InterpreterImpl::addInstance(interpreterImpl);
+	return interpreter;
+}
+
 Interpreter Interpreter::fromURL(const std::string& url) {
 	URL absUrl = normalizeURL(url);
 
@@ -208,8 +235,16 @@ void Interpreter::deserialize(const std::string& encodedState) {
 	return _impl->deserialize(encodedState);
 }
 
-std::string Interpreter::serialize() {
-	return _impl->serialize();
+std::string Interpreter::serialize(SnapshotFormat format) {
+	return _impl->serialize(format);
+}
+
+std::string Interpreter::checkpoint(bool full) {
+	return _impl->checkpoint(full);
+}
+
+void Interpreter::restore(const std::string& base, const std::list<std::string>& deltas) {
+	_impl->restore(base, deltas);
 }
 
 InterpreterState Interpreter::step(size_t blockMs) {
@@ -243,6 +278,10 @@ void Interpreter::receive(const Event& event) {
 	_impl->enqueueExternal(event);
 }
 
+void Interpreter::receive(const std::list<Event>& events) {
+	_impl->enqueueExternalBatch(events);
+}
+
 void Interpreter::setActionLanguage(ActionLanguage actionLanguage) {
 	return _impl->setActionLanguage(actionLanguage);
 }
@@ -263,6 +302,22 @@ void Interpreter::removeMonitor(InterpreterMonitor* monitor) {
 	return _impl->removeMonitor(monitor);
 }
 
+void Interpreter::setMetricsEnabled(bool enabled) {
+	return _impl->setMetricsEnabled(enabled);
+}
+
+Data Interpreter::getMetrics() {
+	return _impl->getMetricsData();
+}
+
+void Interpreter::setTraceCapacity(size_t records) {
+	return _impl->setTraceCapacity(records);
+}
+
+void Interpreter::writeTrace(std::ostream& stream, InterpreterTrace::Format format, size_t records) {
+	return _impl->writeTrace(stream, format, records);
+}
+
 Logger Interpreter::getLogger() {
 	return _impl->getLogger();
 }
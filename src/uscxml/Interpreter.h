@@ -35,6 +35,8 @@
 #include "uscxml/interpreter/EventQueue.h"
 #include "uscxml/interpreter/InterpreterState.h"
 #include "uscxml/interpreter/InterpreterMonitor.h"
+#include "uscxml/interpreter/InterpreterTrace.h"
+#include "uscxml/util/Snapshot.h"
 
 #ifdef max
 #error define NOMINMAX or undefine the max macro please (https://support.microsoft.com/en-us/kb/143208)
@@ -45,6 +47,7 @@ namespace uscxml {
 class InterpreterMonitor;
 class LambdaMonitor;
 class InterpreterImpl;
+class ChartTemplate;
 class InterpreterIssue;
 
 class MicroStepCallbacks;
@@ -117,6 +120,13 @@ public:
 	 */
 	static Interpreter fromURL(const std::string& url);
 
+	/**
+	 * Instantiate an Interpeter from a precompiled ChartTemplate.
+	 * Sessions of the same template share the immutable parts of the chart.
+	 * @param chartTemplate The template from ChartTemplate::fromXML or ChartTemplate::fromURL.
+	 */
+	static Interpreter fromTemplate(std::shared_ptr<ChartTemplate> chartTemplate);
+
 	/**
 	 * Instantiate an Interpeter as a copy of another.
 	 * @param other The other interpreter.
@@ -161,13 +171,30 @@ public:
 
 	/**
 	 * Deserialize the state for the interpreter from a string.
+	 * Both, JSON and binary snapshots are recognized.
 	 */
 	void deserialize(const std::string& encodedState);
 
 	/**
 	 * Serialize the interpreter's state in a string.
+	 * @param format JSON or the more compact and faster binary snapshot.
+	 */
+	std::string serialize(SnapshotFormat format = SNAPSHOT_JSON);
+
+	/**
+	 * Incrementally checkpoint the interpreter's state.
+	 * The first checkpoint is a complete binary snapshot, every further one a
+	 * delta with only the changes since the previous checkpoint. All data is
+	 * evaluated again for a delta and compared with the previous checkpoint.
+	 * @param full Start a new chain with a complete snapshot.
 	 */
-	std::string serialize();
+	std::string checkpoint(bool full = false);
+
+	/**
+	 * Restore the state from a complete binary snapshot and a chain of deltas.
+	 * Further checkpoints continue the chain.
+	 */
+	void restore(const std::string& base, const std::list<std::string>& deltas);
 
 	/**
 	 * Get all state elements that constitute the active configuration.
@@ -200,6 +227,12 @@ public:
 	 */
 	void receive(const Event& event);
 
+	/**
+	 * Enqueue several events to the interpreter's external queue at once.
+	 * @events The events in the order they are to be processed
+	 */
+	void receive(const std::list<Event>& events);
+
 	/**
 	 * Adapt the constituting components for a SCXML interpreter.
 	 */
@@ -225,6 +258,28 @@ public:
 	 */
 	void removeMonitor(InterpreterMonitor* monitor);
 
+	/**
+	 * Collect latencies per processed event and counters for this session.
+	 */
+	void setMetricsEnabled(bool enabled);
+
+	/**
+	 * Return the metrics collected so far with latencies in nanoseconds.
+	 */
+	Data getMetrics();
+
+	/**
+	 * Number of records the flight recorder keeps, 0 disables it. Defaults
+	 * to USCXML_TRACE_RECORDS from the environment or 1024.
+	 */
+	void setTraceCapacity(size_t records);
+
+	/**
+	 * Write the last records of the flight recorder as binary or as JSON
+	 * for chrome://tracing.
+	 */
+	void writeTrace(std::ostream& stream, InterpreterTrace::Format format, size_t records = (size_t)-1);
+
 	/**
 	 * Return the logger associated with this interpreter
 	 */
@@ -19,36 +19,262 @@
 
 #include "Benchmark.h"
 
+#include <iomanip>
+#include <math.h>
+
 namespace uscxml {
 
-std::mutex Benchmark::benchMutex;
-std::map<std::string, size_t> Benchmark::benchmarks;
+std::atomic<bool> Benchmark::_enabled(false);
+std::vector<std::string> Benchmark::_probes;
+std::map<std::string, size_t> Benchmark::_probeIds;
+std::set<Benchmark::ThreadStats*> Benchmark::_threads;
+std::vector<Benchmark::Histogram*> Benchmark::_retired;
+std::vector<Benchmark::Histogram*> Benchmark::_baseline;
+std::mutex Benchmark::_mutex;
+
+/**
+ * The histograms of a single thread, merged into the retired histograms
+ * when the thread exits.
+ */
+class Benchmark::ThreadStats {
+public:
+	ThreadStats() {
+		for (size_t i = 0; i < USCXML_BENCHMARK_MAX_PROBES; i++) {
+			probes[i] = NULL;
+		}
+		std::lock_guard<std::mutex> lock(_mutex);
+		_threads.insert(this);
+	}
+
+	~ThreadStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_threads.erase(this);
+		for (size_t i = 0; i < USCXML_BENCHMARK_MAX_PROBES; i++) {
+			Histogram* histogram = probes[i].load(std::memory_order_relaxed);
+			if (histogram == NULL)
+				continue;
+			if (_retired.size() <= i)
+				_retired.resize(i + 1, NULL);
+			if (_retired[i] == NULL)
+				_retired[i] = new Histogram();
+			_retired[i]->merge(*histogram);
+			delete histogram;
+		}
+	}
+
+	std::atomic<Histogram*> probes[USCXML_BENCHMARK_MAX_PROBES];
+};
+
+Benchmark::Probe::Probe(const std::string& domain) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_probeIds.find(domain) == _probeIds.end()) {
+		_probeIds[domain] = _probes.size();
+		_probes.push_back(domain);
+	}
+	id = _probeIds[domain];
+}
+
+Benchmark::Histogram::Histogram() : count(0), total(0), max(0) {
+	for (size_t i = 0; i < nrBuckets; i++) {
+		buckets[i] = 0;
+	}
+}
+
+void Benchmark::Histogram::merge(const Histogram& other) {
+	count += other.count.load(std::memory_order_relaxed);
+	total += other.total.load(std::memory_order_relaxed);
+	if (other.max.load(std::memory_order_relaxed) > max)
+		max = other.max.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < nrBuckets; i++) {
+		buckets[i] += other.buckets[i].load(std::memory_order_relaxed);
+	}
+}
 
-Benchmark::Benchmark(const std::string& domain) : domain(domain), started(std::chrono::system_clock::now()) {
+void Benchmark::Histogram::subtract(const Histogram& other) {
+	count -= other.count.load(std::memory_order_relaxed);
+	total -= other.total.load(std::memory_order_relaxed);
+	size_t highest = 0;
+	for (size_t i = 0; i < nrBuckets; i++) {
+		buckets[i] -= other.buckets[i].load(std::memory_order_relaxed);
+		if (buckets[i] > 0)
+			highest = i;
+	}
+	// the maximum may be from before the baseline, cap it with the highest bucket left
+	if (highest + 1 < nrBuckets && max > lowerBound(highest + 1) - 1)
+		max = lowerBound(highest + 1) - 1;
 }
 
-Benchmark::~Benchmark() {
-	std::lock_guard<std::mutex> lock(benchMutex);
-	benchmarks[domain] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - started).count();
+uint64_t Benchmark::Histogram::percentile(double fraction) const {
+	uint64_t samples = count;
+	uint64_t wanted = (uint64_t)ceil(fraction * samples);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < nrBuckets; i++) {
+		seen += buckets[i];
+		if (seen >= wanted && seen > 0) {
+			// report the highest value in the bucket
+			if (i + 1 == nrBuckets || lowerBound(i + 1) - 1 > max)
+				return max;
+			return lowerBound(i + 1) - 1;
+		}
+	}
+	return max;
+}
+
+Data Benchmark::Histogram::toData(double ticksPerNanosecond) const {
+	Data data;
+	uint64_t samples = count;
+	data.compound["count"] = Data(samples);
+	data.compound["total"] = Data(total / ticksPerNanosecond);
+	data.compound["mean"] = Data(samples > 0 ? total / ticksPerNanosecond / samples : 0);
+	data.compound["p50"] = Data(percentile(0.5) / ticksPerNanosecond);
+	data.compound["p90"] = Data(percentile(0.9) / ticksPerNanosecond);
+	data.compound["p99"] = Data(percentile(0.99) / ticksPerNanosecond);
+	data.compound["max"] = Data(max / ticksPerNanosecond);
+	return data;
+}
+
+Benchmark::Benchmark(const std::string& domain) : started(0) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_probeIds.find(domain) == _probeIds.end()) {
+			_probeIds[domain] = _probes.size();
+			_probes.push_back(domain);
+		}
+		probe = _probeIds[domain];
+	}
+	if (_enabled)
+		started = now();
+}
+
+void Benchmark::record(size_t probe, uint64_t ticks) {
+	static thread_local ThreadStats stats;
+
+	if (probe >= USCXML_BENCHMARK_MAX_PROBES)
+		return;
+
+	Histogram* histogram = stats.probes[probe].load(std::memory_order_relaxed);
+	if (histogram == NULL) {
+		histogram = new Histogram();
+		stats.probes[probe].store(histogram, std::memory_order_release);
+	}
+	histogram->add(ticks);
+}
+
+void Benchmark::setEnabled(bool enabled) {
+	if (enabled)
+		calibrate();
+	_enabled = enabled;
+}
+
+// relate ticks to nanoseconds since the first probe was enabled
+static uint64_t calibrationTicks = 0;
+static std::chrono::steady_clock::time_point calibrationTime;
+static std::mutex calibrationMutex;
+
+void Benchmark::calibrate() {
+	std::lock_guard<std::mutex> lock(calibrationMutex);
+	if (calibrationTicks == 0) {
+		calibrationTicks = now();
+		calibrationTime = std::chrono::steady_clock::now();
+	}
+}
+
+double Benchmark::ticksPerNanosecond() {
+#ifdef USCXML_BENCHMARK_TSC
+	calibrate();
+	std::lock_guard<std::mutex> lock(calibrationMutex);
+
+	// the longer the period, the more accurate the rate
+	std::chrono::steady_clock::time_point until = calibrationTime + std::chrono::milliseconds(10);
+	while (std::chrono::steady_clock::now() < until) {}
+
+	uint64_t ticks = now() - calibrationTicks;
+	double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - calibrationTime).count();
+	return ticks / ns;
+#else
+	return ((double)std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num) / 1000000000.0;
+#endif
+}
+
+std::map<std::string, std::shared_ptr<Benchmark::Histogram> > Benchmark::collect() {
+	// called with the mutex locked
+	std::map<std::string, std::shared_ptr<Histogram> > histograms;
+	for (size_t i = 0; i < _probes.size() && i < USCXML_BENCHMARK_MAX_PROBES; i++) {
+		std::shared_ptr<Histogram> histogram(new Histogram());
+		for (auto thread : _threads) {
+			Histogram* stats = thread->probes[i].load(std::memory_order_acquire);
+			if (stats != NULL)
+				histogram->merge(*stats);
+		}
+		if (i < _retired.size() && _retired[i] != NULL)
+			histogram->merge(*_retired[i]);
+		if (i < _baseline.size() && _baseline[i] != NULL)
+			histogram->subtract(*_baseline[i]);
+
+		if (histogram->count > 0)
+			histograms[_probes[i]] = histogram;
+	}
+	return histograms;
+}
+
+void Benchmark::reset() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (size_t i = 0; i < _baseline.size(); i++) {
+		delete _baseline[i];
+	}
+	_baseline.clear();
+	_baseline.resize(_probes.size(), NULL);
+
+	for (size_t i = 0; i < _probes.size() && i < USCXML_BENCHMARK_MAX_PROBES; i++) {
+		_baseline[i] = new Histogram();
+		for (auto thread : _threads) {
+			Histogram* stats = thread->probes[i].load(std::memory_order_acquire);
+			if (stats != NULL)
+				_baseline[i]->merge(*stats);
+		}
+		if (i < _retired.size() && _retired[i] != NULL)
+			_baseline[i]->merge(*_retired[i]);
+	}
+}
+
+Data Benchmark::toData() {
+	double rate = ticksPerNanosecond();
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Data data;
+	for (auto histogram : collect()) {
+		data.compound[histogram.first] = histogram.second->toData(rate);
+	}
+	return data;
 }
 
 std::ostream& Benchmark::report(std::ostream& stream) {
-	std::lock_guard<std::mutex> lock(benchMutex);
+	Data data = toData();
 
 	size_t longestDomain = 0;
-	for (auto benchmark : benchmarks) {
-		longestDomain = (benchmark.first.size() > longestDomain ? benchmark.first.size() : longestDomain);
+	for (auto probe : data.compound) {
+		longestDomain = (probe.first.size() > longestDomain ? probe.first.size() : longestDomain);
 	}
-	longestDomain += 8;
 
-	for (auto benchmark : benchmarks) {
-		std::string padding;
-		for (int i = benchmark.first.size(); i < (longestDomain - log10(benchmark.second)); i++) {
-			padding += " ";
-		}
+	stream << std::left << std::setw(longestDomain + 2) << "probe";
+	stream << std::right << std::setw(12) << "count" << std::setw(14) << "total ms";
+	stream << std::setw(12) << "mean ns" << std::setw(12) << "p50 ns" << std::setw(12) << "p90 ns";
+	stream << std::setw(12) << "p99 ns" << std::setw(12) << "max ns" << std::endl;
 
-		stream << benchmark.first << ":" << padding << (double)benchmark.second / 1000.0 << "ms" << std::endl;
+	for (auto probe : data.compound) {
+		stream << std::left << std::setw(longestDomain + 2) << probe.first << std::right;
+		stream << std::setw(12) << probe.second["count"].atom;
+		stream << std::setw(14) << std::fixed << std::setprecision(3) << strTo<double>(probe.second["total"].atom) / 1000000.0;
+		stream << std::setprecision(0);
+		stream << std::setw(12) << strTo<double>(probe.second["mean"].atom);
+		stream << std::setw(12) << strTo<double>(probe.second["p50"].atom);
+		stream << std::setw(12) << strTo<double>(probe.second["p90"].atom);
+		stream << std::setw(12) << strTo<double>(probe.second["p99"].atom);
+		stream << std::setw(12) << strTo<double>(probe.second["max"].atom);
+		stream << std::endl;
 	}
+	stream.unsetf(std::ios::fixed);
+	stream << std::setprecision(6);
 	return stream;
 }
 
@@ -22,26 +22,165 @@
 
 #include <mutex>
 #include <map>
+#include <set>
+#include <atomic>
 #include <chrono>
 #include <string>
+#include <vector>
+#include <memory>
 #include <ostream>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define USCXML_BENCHMARK_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define USCXML_BENCHMARK_TSC 1
+#endif
+
 #include "uscxml/Common.h"              // for USCXML_API
+#include "uscxml/messages/Data.h"
+
+#define USCXML_BENCHMARK_CONCAT2(a, b) a##b
+#define USCXML_BENCHMARK_CONCAT(a, b) USCXML_BENCHMARK_CONCAT2(a, b)
+
+/**
+ * Time the rest of the enclosing scope as the named probe. The probe is
+ * registered once per call site, afterwards a sample is a timestamp at
+ * either end and some counters in memory owned by the calling thread.
+ */
+#define USCXML_BENCHMARK(domain) \
+static const uscxml::Benchmark::Probe USCXML_BENCHMARK_CONCAT(_benchProbe, __LINE__)(domain); \
+uscxml::Benchmark USCXML_BENCHMARK_CONCAT(_bench, __LINE__)(USCXML_BENCHMARK_CONCAT(_benchProbe, __LINE__));
+
+#define USCXML_BENCHMARK_MAX_PROBES 1024
 
 namespace uscxml {
 
+/**
+ * Latency probes for hot paths. Every thread keeps counters and a
+ * logarithmic histogram per probe it passed, which are merged only when a
+ * report is requested. Probes are disabled until setEnabled(true).
+ */
 class USCXML_API Benchmark {
 public:
+	class USCXML_API Probe {
+	public:
+		Probe(const std::string& domain);
+		size_t id;
+	};
+
+	/// Samples per histogram bucket, 8 buckets per power of two up to 2^47 ticks
+	class USCXML_API Histogram {
+	public:
+		Histogram();
+
+		static const size_t nrBuckets = 368;
+
+		static size_t log2(uint64_t value) {
+#if defined(__GNUC__)
+			return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return index;
+#else
+			size_t exponent = 0;
+			while (value >>= 1)
+				exponent++;
+			return exponent;
+#endif
+		}
+
+		static size_t bucketFor(uint64_t ticks) {
+			if (ticks < 8)
+				return (size_t)ticks;
+			size_t exponent = log2(ticks);
+			if (exponent > 47)
+				return nrBuckets - 1;
+			return (exponent - 2) * 8 + ((ticks >> (exponent - 3)) & 7);
+		}
+
+		/// Smallest number of ticks in the given bucket
+		static uint64_t lowerBound(size_t bucket) {
+			if (bucket < 8)
+				return bucket;
+			return (8 + (uint64_t)(bucket % 8)) << (bucket / 8 - 1);
+		}
+
+		void add(uint64_t ticks) {
+			// there is only ever one writer, no need for read-modify-write
+			count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			total.store(total.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+			if (ticks > max.load(std::memory_order_relaxed))
+				max.store(ticks, std::memory_order_relaxed);
+			std::atomic<uint64_t>& bucket = buckets[bucketFor(ticks)];
+			bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		void merge(const Histogram& other);
+		void subtract(const Histogram& other);
+		uint64_t percentile(double fraction) const;
+		/// count, total, mean, p50, p90, p99 and max in nanoseconds
+		Data toData(double ticksPerNanosecond) const;
+
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> total;
+		std::atomic<uint64_t> max;
+		std::atomic<uint64_t> buckets[nrBuckets];
+	};
+
+	Benchmark(const Probe& probe) : probe(probe.id), started(_enabled.load(std::memory_order_relaxed) ? now() : 0) {}
+	/// Resolves the probe by name with every call, prefer USCXML_BENCHMARK
 	Benchmark(const std::string& domain);
-	~Benchmark();
+	~Benchmark() {
+		if (started != 0)
+			record(probe, now() - started);
+	}
+
+	/// Timestamp in ticks, the time stamp counter where available
+	static uint64_t now() {
+#ifdef USCXML_BENCHMARK_TSC
+		return __rdtsc();
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
 
+	static void setEnabled(bool enabled);
+	static bool isEnabled() {
+		return _enabled;
+	}
+
+	/// Restart all statistics from zero
+	static void reset();
+
+	/// Statistics per probe in nanoseconds: count, total, mean, p50, p90, p99 and max
+	static Data toData();
 	static std::ostream& report(std::ostream& stream);
+
+	/// Rate to convert ticks from now() into nanoseconds
+	static double ticksPerNanosecond();
+	/// Take the first reference point for ticksPerNanosecond(), done by setEnabled(true)
+	static void calibrate();
+
 protected:
-	std::string domain;
-	std::chrono::time_point<std::chrono::system_clock> started;
+	static void record(size_t probe, uint64_t ticks);
+	static std::map<std::string, std::shared_ptr<Histogram> > collect();
+
+	size_t probe;
+	uint64_t started;
+
+	class ThreadStats;
+	friend class ThreadStats;
 
-	static std::map<std::string, size_t> benchmarks;
-	static std::mutex benchMutex;
+	static std::atomic<bool> _enabled;
+	static std::vector<std::string> _probes;
+	static std::map<std::string, size_t> _probeIds;
+	static std::set<ThreadStats*> _threads;
+	static std::vector<Histogram*> _retired;
+	static std::vector<Histogram*> _baseline;
+	static std::mutex _mutex;
 };
 
 }
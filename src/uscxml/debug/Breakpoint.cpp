@@ -83,8 +83,10 @@ Breakpoint::Breakpoint(const Data& data) {
 	if (data.hasKey("invokeType"))
 		invokeType = data.at("invokeType").atom;
 
-	if (data.hasKey("eventName"))
+	if (data.hasKey("eventName")) {
 		eventName = data.at("eventName").atom;
+		_eventDesc = EventDescriptor(eventName);
+	}
 
 	if (data.hasKey("execName"))
 		executableName = data.at("execName").atom;
@@ -225,8 +227,13 @@ bool Breakpoint::matches(Interpreter interpreter, const Breakpoint& other) const
 		return false;
 	}
 
-	if(eventName.length() > 0 && !nameMatch(eventName, other.eventName)) {
-		return false;
+	if(eventName.length() > 0) {
+		// breakpoints are shared by sessions on several threads, eventName may have been assigned directly
+		bool matched = (_eventDesc.str() == eventName ?
+		                _eventDesc.matches(other.eventName) :
+		                EventDescriptor(eventName).matches(other.eventName));
+		if (!matched)
+			return false;
 	}
 
 	if(executableName.length() > 0 && executableName != other.executableName) {
@@ -25,6 +25,7 @@
 #include "uscxml/Interpreter.h"
 //#include "DOM/Element.hpp"              // for Element
 #include "uscxml/messages/Data.h"       // for Data
+#include "uscxml/util/EventDescriptor.h"
 
 // forward declare
 namespace XERCESC_NS {
@@ -92,6 +93,9 @@ public:
 	std::string transTargetId;
 
 	std::string condition;
+
+protected:
+	EventDescriptor _eventDesc; ///< eventName compiled when read from data, never written when matching
 };
 
 }
@@ -22,12 +22,20 @@
 #include "InterpreterIssue.h"
 #include "uscxml/util/DOM.h"
 #include "uscxml/util/String.h"
+#include "uscxml/util/EventDescriptor.h"
 #include "uscxml/util/Predicates.h"
 #include "uscxml/interpreter/InterpreterImpl.h"
 #include "uscxml/plugins/Factory.h"
 
 #include <xercesc/dom/DOMDocument.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
 using namespace XERCESC_NS;
 
 namespace uscxml {
@@ -49,59 +57,39 @@ void assembleNodeSets(const std::string nsPrefix, DOMElement* node, std::map<std
 	}
 }
 
-std::list<std::set<const DOMElement* > > getAllConfigurations(const DOMElement* root) {
-	std::list<std::set<const DOMElement* > > allConfigurations;
-	std::string nsPrefix = X(root->getPrefix());
-	std::string localName = X(root->getLocalName());
-	bool isAtomic = true;
-
-//	std::cout << *root;
-
-	for (auto childElem = root->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
-//		std::cout << *childElem;
-
-		if (XMLString::compareIString(childElem->getTagName(), X(nsPrefix + "state")) == 0 ||
-		        XMLString::compareIString(childElem->getTagName(), X(nsPrefix + "parallel")) == 0 ||
-		        XMLString::compareIString(childElem->getTagName(), X(nsPrefix + "final")) == 0) {
-			// nested child state
-			std::list<std::set<const DOMElement*> > nestedConfigurations = getAllConfigurations(childElem);
-			isAtomic = false;
-			if (localName == "parallel" && allConfigurations.size() > 0) {
-				// for every nested configuration, every new nested is valid
-				std::list<std::set<const DOMElement*> > combinedConfigurations;
-				for (auto existIter = allConfigurations.begin(); existIter != allConfigurations.end(); existIter++) {
-					std::set<const DOMElement*> existingConfig = *existIter;
+/**
+ * The number of legal configurations of a state, saturating at two as we only
+ * ever need to know whether there is more than one.
+ */
+static size_t countConfigurations(const DOMElement* state, std::map<const DOMElement*, size_t>& counts) {
+	auto countIter = counts.find(state);
+	if (countIter != counts.end())
+		return countIter->second;
 
-					for (auto newIter = nestedConfigurations.begin(); newIter != nestedConfigurations.end(); newIter++) {
+	std::string nsPrefix = XML_PREFIX(state).str();
+	bool isParallel = (LOCALNAME(state) == "parallel");
+	bool isAtomic = true;
+	size_t count = 0;
 
-						std::set<const DOMElement*> newConfig = *newIter;
-						std::set<const DOMElement*> combinedSet;
-						combinedSet.insert(existingConfig.begin(), existingConfig.end());
-						combinedSet.insert(newConfig.begin(), newConfig.end());
+	for (auto childElem = state->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
+		std::string tagName = TAGNAME(childElem);
+		if (!iequals(tagName, nsPrefix + "state") &&
+		        !iequals(tagName, nsPrefix + "parallel") &&
+		        !iequals(tagName, nsPrefix + "final"))
+			continue;
 
-						combinedConfigurations.push_back(combinedSet);
-					}
-				}
-				allConfigurations = combinedConfigurations;
-			} else {
-				// just add nested configurations and this
-				for (auto newIter = nestedConfigurations.begin(); newIter != nestedConfigurations.end(); newIter++) {
-					std::set<const DOMElement*> newConfig = *newIter;
-					if (localName != "scxml")
-						newConfig.insert(root);
-					allConfigurations.push_back(newConfig);
-				}
-			}
-		}
+		// nested child state, all its configurations combine with the ones of a parallel sibling
+		size_t nested = countConfigurations(childElem, counts);
+		count = ((isParallel && !isAtomic) ? count * nested : count + nested);
+		count = (std::min)(count, (size_t)2);
+		isAtomic = false;
 	}
 
-	if (isAtomic) {
-		std::set<const DOMElement*> soleConfig;
-		soleConfig.insert(root);
-		allConfigurations.push_back(soleConfig);
-	}
-	return allConfigurations;
+	if (isAtomic)
+		count = 1;
 
+	counts[state] = count;
+	return count;
 }
 
 /**
@@ -122,15 +110,16 @@ bool hasLegalCompletion(const std::list<DOMElement*>& states) {
 			DOMNode* parent;
 
 			// ok to be directly ancestorally related
-			if (DOMUtils::isDescendant(s1, s2) || DOMUtils::isDescendant(s2, s1))
+			if (s1 == s2 || DOMUtils::isDescendant(s1, s2) || DOMUtils::isDescendant(s2, s1))
 				goto NEXT_PAIR;
 
-			// find least common ancestor
+			// find least common ancestor, it has to be parallel
 			parent = s1->getParentNode();
 			while(parent && parent->getNodeType() == DOMNode::ELEMENT_NODE) {
 				if (DOMUtils::isDescendant(s2, parent)) {
 					if (isParallel(static_cast<DOMElement*>(parent)))
 						goto NEXT_PAIR;
+					break;
 				}
 				parent = parent->getParentNode();
 			}
@@ -143,6 +132,74 @@ NEXT_PAIR:
 	return true;
 }
 
+/**
+ * The same with the ancestors taken from the index.
+ */
+bool hasLegalCompletion(const std::list<DOMElement*>& states, const ChartIndex& index) {
+	if (states.size() < 2)
+		return true;
+
+	std::vector<uint32_t> orders;
+	for (auto state : states) {
+		uint32_t order = index.getDocumentOrder(state);
+		if (order == ChartIndex::NONE)
+			return hasLegalCompletion(states); // state from an embedded document
+		orders.push_back(order);
+	}
+
+	for (size_t i = 0; i < orders.size(); i++) {
+		for (size_t j = i + 1; j < orders.size(); j++) {
+			uint32_t s1 = orders[i];
+			uint32_t s2 = orders[j];
+
+			if (s1 == s2 || index.isDescendant(s1, s2) || index.isDescendant(s2, s1))
+				continue;
+
+			uint32_t ancestor = index.getParent(s1);
+			while (ancestor != ChartIndex::NONE && !index.isDescendant(s2, ancestor))
+				ancestor = index.getParent(ancestor);
+
+			if (ancestor == ChartIndex::NONE || !isParallel(index.getStates()[ancestor]))
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Run independent checks on a few threads. Every check reports into a list of
+ * its own and the lists are joined in the order of the checks.
+ */
+static void runChecks(const std::vector<std::function<void(std::list<InterpreterIssue>&)> >& checks, std::list<InterpreterIssue>& issues) {
+	std::vector<std::list<InterpreterIssue> > reported(checks.size());
+	std::vector<std::exception_ptr> errors(checks.size());
+	std::atomic<size_t> next(0);
+
+	auto worker = [&]() {
+		for (size_t i = next++; i < checks.size(); i = next++) {
+			try {
+				checks[i](reported[i]);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}
+	};
+
+	size_t nrThreads = (std::min)((size_t)std::thread::hardware_concurrency(), checks.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nrThreads; i++)
+		threads.push_back(std::thread(worker));
+	worker(); // we are a worker as well
+	for (auto& thread : threads)
+		thread.join();
+
+	for (size_t i = 0; i < checks.size(); i++) {
+		if (errors[i])
+			std::rethrow_exception(errors[i]);
+		issues.splice(issues.end(), reported[i]);
+	}
+}
+
 std::list<InterpreterIssue> InterpreterIssue::forInterpreter(InterpreterImpl* interpreter) {
 	// some things we need to prepare first
 	if (interpreter->_factory == NULL)
@@ -178,7 +235,13 @@ std::list<InterpreterIssue> InterpreterIssue::forInterpreter(InterpreterImpl* in
 	std::list<DOMElement*> scxmls = nodeSets["scxml"];
 	scxmls.push_back(_scxml);
 
-	std::list<XERCESC_NS::DOMElement*> reachable = getReachableStates(_scxml);
+	// index the chart once and keep the reachable states as a bitset in document order
+	ChartIndex index(_scxml);
+	std::vector<bool> reachable(index.getStates().size(), false);
+	std::list<XERCESC_NS::DOMElement*> reachableStates = getReachableStates(index);
+	for (auto state : reachableStates) {
+		reachable[index.getDocumentOrder(state)] = true;
+	}
 
 	std::list<DOMElement*>& states = nodeSets["state"];
 	std::list<DOMElement*>& parallels = nodeSets["parallel"];
@@ -335,136 +398,179 @@ std::list<InterpreterIssue> InterpreterIssue::forInterpreter(InterpreterImpl* in
 	}
 
 
+	// the first state with a given id, the checks below only ever read it
 	for (auto stateIter = allStates.begin(); stateIter != allStates.end(); stateIter++) {
-		DOMElement* state = static_cast<DOMElement*>(*stateIter);
-
-		if (DOMUtils::isMember(state, finals) && !HAS_ATTR(state, kXMLCharId)) // id is not required for finals
+		DOMElement* state = *stateIter;
+		if (!HAS_ATTR(state, kXMLCharId) || ATTR(state, kXMLCharId).size() == 0)
 			continue;
+		if (seenStates.find(ATTR(state, kXMLCharId)) == seenStates.end())
+			seenStates[ATTR(state, kXMLCharId)] = state;
+	}
 
-		// check for existance of id attribute - this not actually required!
-		if (!HAS_ATTR(state, kXMLCharId)) {
-			issues.push_back(InterpreterIssue("State has no 'id' attribute", state, InterpreterIssue::USCXML_ISSUE_FATAL));
-			continue;
-		}
+	auto seenState = [&seenStates](const std::string& stateId) -> DOMElement* {
+		auto stateIter = seenStates.find(stateId);
+		return (stateIter != seenStates.end() ? stateIter->second : NULL);
+	};
 
-		if (ATTR(state, kXMLCharId).size() == 0) {
-			issues.push_back(InterpreterIssue("State has empty 'id' attribute", state, InterpreterIssue::USCXML_ISSUE_FATAL));
-			continue;
-		}
+	// is state a proper descendant of ancestor, with states of embedded documents outside the index
+	auto isDescendantState = [&index](const DOMElement* state, const DOMElement* ancestor) {
+		if (index.getDocumentOrder(state) != ChartIndex::NONE && index.getDocumentOrder(ancestor) != ChartIndex::NONE)
+			return index.isDescendant(state, ancestor);
+		return DOMUtils::isDescendant(state, ancestor);
+	};
 
-		std::string stateId = ATTR(state, kXMLCharId);
-
-		// check for valid transition with history states
-		if (LOCALNAME(state) == "history") {
-			std::list<DOMElement*> transitions = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "transition", state, false);
-			if (transitions.size() > 1) {
-				issues.push_back(InterpreterIssue("History pseudo-state with id '" + stateId + "' has multiple transitions", state, InterpreterIssue::USCXML_ISSUE_FATAL));
-			} else if (transitions.size() == 0) {
-				issues.push_back(InterpreterIssue("History pseudo-state with id '" + stateId + "' has no default transition", state, InterpreterIssue::USCXML_ISSUE_FATAL));
-			} else {
-				DOMElement* transition = static_cast<DOMElement*>(transitions.front());
-				if (HAS_ATTR(transition, kXMLCharCond)) {
-					issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' must not have a condition", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
-				}
-				if (HAS_ATTR(transition, kXMLCharEvent)) {
-					issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' must not have an event attribute", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
-				}
-				if (!HAS_ATTR(transition, kXMLCharTarget)) {
-					issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' has no target", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+	// the checks up to the datamodel only read the DOM and are independent of each other
+	std::vector<std::function<void(std::list<InterpreterIssue>&)> > checks;
+
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
+		for (auto stateIter = allStates.begin(); stateIter != allStates.end(); stateIter++) {
+			DOMElement* state = static_cast<DOMElement*>(*stateIter);
+
+			if (LOCALNAME(state) == "final" && !HAS_ATTR(state, kXMLCharId)) // id is not required for finals
+				continue;
+
+			// check for existance of id attribute - this not actually required!
+			if (!HAS_ATTR(state, kXMLCharId)) {
+				issues.push_back(InterpreterIssue("State has no 'id' attribute", state, InterpreterIssue::USCXML_ISSUE_FATAL));
+				continue;
+			}
+
+			if (ATTR(state, kXMLCharId).size() == 0) {
+				issues.push_back(InterpreterIssue("State has empty 'id' attribute", state, InterpreterIssue::USCXML_ISSUE_FATAL));
+				continue;
+			}
+
+			std::string stateId = ATTR(state, kXMLCharId);
+
+			// check for valid transition with history states
+			if (LOCALNAME(state) == "history") {
+				std::list<DOMElement*> transitions = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "transition", state, false);
+				if (transitions.size() > 1) {
+					issues.push_back(InterpreterIssue("History pseudo-state with id '" + stateId + "' has multiple transitions", state, InterpreterIssue::USCXML_ISSUE_FATAL));
+				} else if (transitions.size() == 0) {
+					issues.push_back(InterpreterIssue("History pseudo-state with id '" + stateId + "' has no default transition", state, InterpreterIssue::USCXML_ISSUE_FATAL));
 				} else {
-					std::list<DOMElement*> targetStates = getTargetStates(transition, _scxml);
-					for (auto tIter = targetStates.begin(); tIter != targetStates.end(); tIter++) {
-						DOMElement* target = *tIter;
-						if (HAS_ATTR(state, kXMLCharType) && ATTR(state, kXMLCharType) == "deep") {
-							if (!DOMUtils::isDescendant(target, state->getParentNode())) {
-								issues.push_back(InterpreterIssue("Transition in deep history pseudo-state '" + stateId + "' has illegal target state '" + ATTR(target, kXMLCharId) + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
-							}
-						} else {
-							if (target->getParentNode() != state->getParentNode()) {
-								issues.push_back(InterpreterIssue("Transition in shallow history pseudo-state '" + stateId + "' has illegal target state '" + ATTR(target, kXMLCharId) + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+					DOMElement* transition = static_cast<DOMElement*>(transitions.front());
+					if (HAS_ATTR(transition, kXMLCharCond)) {
+						issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' must not have a condition", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+					}
+					if (HAS_ATTR(transition, kXMLCharEvent)) {
+						issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' must not have an event attribute", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+					}
+					if (!HAS_ATTR(transition, kXMLCharTarget)) {
+						issues.push_back(InterpreterIssue("Transition in history pseudo-state '" + stateId + "' has no target", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+					} else {
+						std::list<DOMElement*> targetStates = getTargetStates(transition, index);
+						for (auto tIter = targetStates.begin(); tIter != targetStates.end(); tIter++) {
+							DOMElement* target = *tIter;
+							if (HAS_ATTR(state, kXMLCharType) && ATTR(state, kXMLCharType) == "deep") {
+								if (!DOMUtils::isDescendant(target, state->getParentNode())) {
+									issues.push_back(InterpreterIssue("Transition in deep history pseudo-state '" + stateId + "' has illegal target state '" + ATTR(target, kXMLCharId) + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+								}
+							} else {
+								if (target->getParentNode() != state->getParentNode()) {
+									issues.push_back(InterpreterIssue("Transition in shallow history pseudo-state '" + stateId + "' has illegal target state '" + ATTR(target, kXMLCharId) + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+								}
 							}
 						}
 					}
 				}
 			}
-		}
 
-		// check whether state is reachable
-		if (!DOMUtils::isMember(state, reachable) && areFromSameMachine(state, interpreter->_scxml)) {
-			issues.push_back(InterpreterIssue("State with id '" + stateId + "' is unreachable", state, InterpreterIssue::USCXML_ISSUE_WARNING));
-		}
+			// check whether state is reachable
+			uint32_t order = index.getDocumentOrder(state);
+			if ((order == ChartIndex::NONE || !reachable[order]) && areFromSameMachine(state, interpreter->_scxml)) {
+				issues.push_back(InterpreterIssue("State with id '" + stateId + "' is unreachable", state, InterpreterIssue::USCXML_ISSUE_WARNING));
+			}
 
-		// check for uniqueness of id attribute
-		if (seenStates.find(stateId) != seenStates.end()) {
-			issues.push_back(InterpreterIssue("Duplicate state with id '" + stateId + "'", state, InterpreterIssue::USCXML_ISSUE_FATAL));
-			continue;
+			// check for uniqueness of id attribute
+			if (seenState(stateId) != state) {
+				issues.push_back(InterpreterIssue("Duplicate state with id '" + stateId + "'", state, InterpreterIssue::USCXML_ISSUE_FATAL));
+				continue;
+			}
 		}
-		seenStates[ATTR(state, kXMLCharId)] = state;
-	}
+	});
 
-	for (auto tIter = transitions.begin(); tIter != transitions.end(); tIter++) {
-		DOMElement* transition = *tIter;
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
+		for (auto tIter = transitions.begin(); tIter != transitions.end(); tIter++) {
+			DOMElement* transition = *tIter;
 
-		// check for valid target
-		if (HAS_ATTR(transition, kXMLCharTarget)) {
-			std::list<std::string> targetIds = tokenize(ATTR(transition, kXMLCharTarget));
-			if (targetIds.size() == 0) {
-				issues.push_back(InterpreterIssue("Transition has empty target state list", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
-			}
+			// check for valid target
+			if (HAS_ATTR(transition, kXMLCharTarget)) {
+				std::list<std::string> targetIds = tokenize(ATTR(transition, kXMLCharTarget));
+				if (targetIds.size() == 0) {
+					issues.push_back(InterpreterIssue("Transition has empty target state list", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+				}
 
-			for (std::list<std::string>::iterator targetIter = targetIds.begin(); targetIter != targetIds.end(); targetIter++) {
-				if (seenStates.find(*targetIter) == seenStates.end()) {
-					issues.push_back(InterpreterIssue("Transition has non-existant target state with id '" + *targetIter + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
-					continue;
+				for (std::list<std::string>::iterator targetIter = targetIds.begin(); targetIter != targetIds.end(); targetIter++) {
+					if (seenState(*targetIter) == NULL) {
+						issues.push_back(InterpreterIssue("Transition has non-existant target state with id '" + *targetIter + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
+						continue;
+					}
 				}
 			}
 		}
-	}
+	});
 
 	// check for redundancy of transition
-	for (auto stateIter = allStates.begin(); stateIter != allStates.end(); stateIter++) {
-		DOMElement* state = *stateIter;
-		std::list<DOMElement*> transitions = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "transition", state, false);
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
+		for (auto stateIter = allStates.begin(); stateIter != allStates.end(); stateIter++) {
+			DOMElement* state = *stateIter;
+			std::list<DOMElement*> transitionList = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "transition", state, false);
+			std::vector<DOMElement*> transitions(transitionList.begin(), transitionList.end());
+
+			// compile every descriptor and intern the event names it lists only once
+			std::vector<EventDescriptor> eventDescs(transitions.size());
+			std::vector<std::vector<uint32_t> > eventNames(transitions.size());
+			for (size_t i = 0; i < transitions.size(); i++) {
+				if (!HAS_ATTR(transitions[i], kXMLCharEvent))
+					continue;
+				eventDescs[i] = EventDescriptor(ATTR(transitions[i], kXMLCharEvent));
+				std::list<std::string> events = tokenize(ATTR(transitions[i], kXMLCharEvent));
+				for (auto& event : events) {
+					eventNames[i].push_back(EventName::intern(event));
+				}
+			}
 
-		for (auto tIter = transitions.begin(); tIter != transitions.end(); tIter++) {
-			DOMElement* transition = *tIter;
-			for (auto t2Iter = transitions.begin(); t2Iter != tIter; t2Iter++) {
-				DOMElement* earlierTransition = *t2Iter;
-
-				// will the earlier transition always be enabled when the later is?
-				if (!HAS_ATTR(earlierTransition, kXMLCharCond)) {
-					// earlier transition has no condition -> check event descriptor
-					if (!HAS_ATTR(earlierTransition, kXMLCharEvent)) {
-						// earlier transition is eventless
-						issues.push_back(InterpreterIssue("Transition can never be optimally enabled", transition, InterpreterIssue::USCXML_ISSUE_INFO));
-						goto NEXT_TRANSITION;
-
-					} else if (HAS_ATTR(transition, kXMLCharEvent)) {
-						// does the earlier transition match all our events?
-						std::list<std::string> events = tokenize(ATTR(transition, kXMLCharEvent));
-
-						bool allMatched = true;
-						for (std::list<std::string>::iterator eventIter = events.begin(); eventIter != events.end(); eventIter++) {
-							if (!nameMatch(ATTR(earlierTransition, kXMLCharEvent), *eventIter)) {
-								allMatched = false;
-								break;
-							}
-						}
+			for (size_t i = 0; i < transitions.size(); i++) {
+				DOMElement* transition = transitions[i];
+				for (size_t j = 0; j < i; j++) {
+					DOMElement* earlierTransition = transitions[j];
 
-						if (allMatched) {
+					// will the earlier transition always be enabled when the later is?
+					if (!HAS_ATTR(earlierTransition, kXMLCharCond)) {
+						// earlier transition has no condition -> check event descriptor
+						if (!HAS_ATTR(earlierTransition, kXMLCharEvent)) {
+							// earlier transition is eventless
 							issues.push_back(InterpreterIssue("Transition can never be optimally enabled", transition, InterpreterIssue::USCXML_ISSUE_INFO));
 							goto NEXT_TRANSITION;
+
+						} else if (HAS_ATTR(transition, kXMLCharEvent)) {
+							// does the earlier transition match all our events?
+							bool allMatched = true;
+							for (auto nameId : eventNames[i]) {
+								if (!eventDescs[j].matches(EventName::forId(nameId))) {
+									allMatched = false;
+									break;
+								}
+							}
+
+							if (allMatched) {
+								issues.push_back(InterpreterIssue("Transition can never be optimally enabled", transition, InterpreterIssue::USCXML_ISSUE_INFO));
+								goto NEXT_TRANSITION;
+							}
 						}
 					}
 				}
-			}
 NEXT_TRANSITION:
-			;
+				;
+			}
 		}
-	}
+	});
 
 	// check for useless history elements
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
+		std::map<const DOMElement*, size_t> configurations;
 		for (auto histIter = histories.begin(); histIter != histories.end(); histIter++) {
 			DOMElement* history = *histIter;
 
@@ -476,16 +582,15 @@ NEXT_TRANSITION:
 				issues.push_back(InterpreterIssue("Useless history '" + ATTR(history, kXMLCharId) + "' in atomic state", history, InterpreterIssue::USCXML_ISSUE_INFO));
 				continue;
 			}
-			std::list<std::set<const DOMElement* > > configs = getAllConfigurations(parent);
-			if (configs.size() <= 1) {
+			if (countConfigurations(parent, configurations) <= 1) {
 				issues.push_back(InterpreterIssue("Useless history '" + ATTR(history, kXMLCharId) + "' in state with single legal configuration", history, InterpreterIssue::USCXML_ISSUE_INFO));
 				continue;
 			}
 		}
-	}
+	});
 
 	// check for valid initial attribute
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		std::list<DOMElement*> withInitialAttr;
 		withInitialAttr.insert(withInitialAttr.end(), allStates.begin(), allStates.end());
 		withInitialAttr.push_back(_scxml);
@@ -494,34 +599,24 @@ NEXT_TRANSITION:
 			DOMElement* state = *stateIter;
 
 			if (HAS_ATTR(state, kXMLCharInitial)) {
-				std::list<DOMElement*> childs;
-				std::list<DOMElement*> tmp;
-				tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "state", state, true);
-				childs.insert(childs.end(), tmp.begin(), tmp.end());
-				tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "parallel", state, true);
-				childs.insert(childs.end(), tmp.begin(), tmp.end());
-				tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "final", state, true);
-				childs.insert(childs.end(), tmp.begin(), tmp.end());
-				tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "history", state, true);
-				childs.insert(childs.end(), tmp.begin(), tmp.end());
-
 				std::list<std::string> intials = tokenize(ATTR(state, kXMLCharInitial));
 				for (std::list<std::string>::iterator initIter = intials.begin(); initIter != intials.end(); initIter++) {
-					if (seenStates.find(*initIter) == seenStates.end()) {
+					DOMElement* initState = seenState(*initIter);
+					if (initState == NULL) {
 						issues.push_back(InterpreterIssue("Initial attribute has invalid target state with id '" + *initIter + "'", state, InterpreterIssue::USCXML_ISSUE_FATAL));
 						continue;
 					}
 					// value of the 'initial' attribute [..] must be descendants of the containing <state> or <parallel> element
-					if (!DOMUtils::isMember(seenStates[*initIter], childs)) {
+					if (!isDescendantState(initState, state)) {
 						issues.push_back(InterpreterIssue("Initial attribute references non-child state '" + *initIter + "'", state, InterpreterIssue::USCXML_ISSUE_FATAL));
 					}
 				}
 			}
 		}
-	}
+	});
 
 	// check for legal configuration of target sets
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		std::map<DOMElement*, std::string > targetIdSets;
 		for (auto iter = transitions.begin(); iter != transitions.end(); iter++) {
 			DOMElement* transition = *iter;
@@ -553,20 +648,20 @@ NEXT_TRANSITION:
 			std::list<DOMElement*> targets;
 			std::list<std::string> targetIds = tokenize(setIter->second);
 			for (auto tgtIter = targetIds.begin(); tgtIter != targetIds.end(); tgtIter++) {
-				if (seenStates.find(*tgtIter) == seenStates.end())
+				if (seenState(*tgtIter) == NULL)
 					goto NEXT_SET;
-				targets.push_back(seenStates[*tgtIter]);
+				targets.push_back(seenState(*tgtIter));
 			}
-			if (!hasLegalCompletion(targets)) {
+			if (!hasLegalCompletion(targets, index)) {
 				issues.push_back(InterpreterIssue("Target states cause illegal configuration", setIter->first, InterpreterIssue::USCXML_ISSUE_FATAL));
 			}
 NEXT_SET:
 			;
 		}
-	}
+	});
 
 	// check for valid initial transition
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		std::list<DOMElement*> initTrans;
 
 		for (auto iter = initials.begin(); iter != initials.end(); iter++) {
@@ -602,30 +697,20 @@ NEXT_SET:
 			if (!isState(state))
 				continue; // syntax will catch this one
 
-			std::list<DOMElement*> childs;
-			std::list<DOMElement*> tmp;
-			tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "state", state, true);
-			childs.insert(childs.end(), tmp.begin(), tmp.end());
-			tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "parallel", state, true);
-			childs.insert(childs.end(), tmp.begin(), tmp.end());
-			tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "final", state, true);
-			childs.insert(childs.end(), tmp.begin(), tmp.end());
-			tmp = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "history", state, true);
-			childs.insert(childs.end(), tmp.begin(), tmp.end());
-
 			std::list<std::string> intials = tokenize(ATTR(transition, kXMLCharTarget));
 			for (std::list<std::string>::iterator initIter = intials.begin(); initIter != intials.end(); initIter++) {
 				// the 'target' of a <transition> inside an <initial> or <history> element: all the states must be descendants of the containing <state> or <parallel> element
-				if (!DOMUtils::isMember(seenStates[*initIter], childs)) {
+				DOMElement* initState = seenState(*initIter);
+				if (initState == NULL || !isDescendantState(initState, state)) {
 					issues.push_back(InterpreterIssue("Target of initial transition references non-child state '" + *initIter + "'", transition, InterpreterIssue::USCXML_ISSUE_FATAL));
 				}
 			}
 		}
-	}
+	});
 
 
 	// check that all invokers exists
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		for (auto iter = invokes.begin(); iter != invokes.end(); iter++) {
 			DOMElement* invoke = *iter;
 			if (HAS_ATTR(invoke, kXMLCharType) && !_factory->hasInvoker(ATTR(invoke, kXMLCharType))) {
@@ -645,10 +730,10 @@ NEXT_SET:
 				continue;
 			}
 		}
-	}
+	});
 
 	// check that all io processors exists
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		for (auto iter = sends.begin(); iter != sends.end(); iter++) {
 			DOMElement* send = *iter;
 			if (HAS_ATTR(send, kXMLCharType) && !_factory->hasIOProcessor(ATTR(send, kXMLCharType))) {
@@ -659,10 +744,12 @@ NEXT_SET:
 				continue;
 			}
 		}
-	}
+	});
 
 	// check that all custom executable content is known
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
+		std::set<DOMElement*> knownExecContents(allExecContents.begin(), allExecContents.end());
+
 		std::list<DOMElement*> allExecContentContainers;
 		allExecContentContainers.insert(allExecContentContainers.end(), onEntries.begin(), onEntries.end());
 		allExecContentContainers.insert(allExecContentContainers.end(), onExits.begin(), onExits.end());
@@ -675,7 +762,7 @@ NEXT_SET:
 			for (auto ecIter = execContents.begin(); ecIter != execContents.end(); ecIter++) {
 				DOMElement* execContent = static_cast<DOMElement*>(*ecIter);
 				// SCXML specific executable content, always available
-				if (DOMUtils::isMember(execContent, allExecContents)) {
+				if (knownExecContents.find(execContent) != knownExecContents.end()) {
 					continue;
 				}
 
@@ -685,10 +772,10 @@ NEXT_SET:
 				}
 			}
 		}
-	}
+	});
 
 	// check that all SCXML elements have valid parents and required attributes
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		for (auto iter = allElements.begin(); iter != allElements.end(); iter++) {
 			DOMElement* element = *iter;
 			std::string localName = LOCALNAME(element);
@@ -721,10 +808,10 @@ NEXT_SET:
 				continue;
 			}
 		}
-	}
+	});
 
 	// check attribute constraints
-	{
+	checks.push_back([&](std::list<InterpreterIssue>& issues) {
 		for (auto iter = initials.begin(); iter != initials.end(); iter++) {
 			DOMElement* initial = *iter;
 			if (initial->getParentNode() && initial->getParentNode()->getNodeType() == DOMNode::ELEMENT_NODE) {
@@ -841,7 +928,9 @@ NEXT_SET:
 
 			}
 		}
-	}
+	});
+
+	runChecks(checks, issues);
 
 	// check that the datamodel is known if not already instantiated
 	if (!interpreter->_dataModel) {
@@ -917,7 +1006,7 @@ NEXT_SET:
 		for (auto iter = withExprAttrs.begin(); iter != withExprAttrs.end(); iter++) {
 			DOMElement* withExprAttr = *iter;
 			if (HAS_ATTR(withExprAttr, kXMLCharExpr)) {
-				if (DOMUtils::isMember(withExprAttr, datas) || DOMUtils::isMember(withExprAttr, assigns)) {
+				if (LOCALNAME(withExprAttr) == "data" || LOCALNAME(withExprAttr) == "assign") {
 					if (!_dataModel.isValidSyntax("foo = " + ATTR(withExprAttr, kXMLCharExpr))) { // TODO: this is ECMAScripty!
 						issues.push_back(InterpreterIssue("Syntax error in expr attribute", withExprAttr, InterpreterIssue::USCXML_ISSUE_WARNING));
 						continue;
@@ -0,0 +1,293 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "uscxml/debug/InterpreterRecorder.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/interpreter/VirtualTimeDelayedEventQueue.h"
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#define USCXML_RECORDING_MAGIC "USCXMLRC"
+
+namespace uscxml {
+
+enum RecordingTag {
+	RECORDED_EVENT = 1,
+	RECORDED_END = 2
+};
+
+void InterpreterRecording::writeHeader(std::string& buffer, const std::string& url) {
+	SnapshotWriter writer(buffer);
+	writer.writeBytes(USCXML_RECORDING_MAGIC, 8);
+	writer.writeVarint(version);
+	writer.writeString(url);
+}
+
+void InterpreterRecording::writeEvent(std::string& buffer, uint64_t deltaUs, const Event& event) {
+	SnapshotWriter writer(buffer);
+	writer.writeVarint(RECORDED_EVENT);
+	writer.writeVarint(deltaUs);
+	Event copy(event);
+	writer.writeData(copy);
+}
+
+void InterpreterRecording::writeEnd(std::string& buffer, uint64_t deltaUs, const std::list<std::string>& configuration) {
+	SnapshotWriter writer(buffer);
+	writer.writeVarint(RECORDED_END);
+	writer.writeVarint(deltaUs);
+	writer.writeVarint(configuration.size());
+	for (auto& state : configuration)
+		writer.writeString(state);
+}
+
+std::string InterpreterRecording::toBuffer() const {
+	std::string buffer;
+	writeHeader(buffer, url);
+
+	uint64_t lastUs = 0;
+	for (auto& entry : events) {
+		writeEvent(buffer, entry.timeUs - lastUs, entry.event);
+		lastUs = entry.timeUs;
+	}
+	if (finished)
+		writeEnd(buffer, durationUs - lastUs, configuration);
+	return buffer;
+}
+
+InterpreterRecording InterpreterRecording::fromBuffer(const std::string& buffer) {
+	if (buffer.size() < 8 || memcmp(buffer.data(), USCXML_RECORDING_MAGIC, 8) != 0) {
+		ERROR_PLATFORM_THROW("Not a recording");
+	}
+
+	SnapshotReader reader(buffer);
+	reader.readBytes(8);
+	if (reader.readVarint() != version) {
+		ERROR_PLATFORM_THROW("Recording has an unsupported version");
+	}
+
+	InterpreterRecording recording;
+	recording.url = reader.readString();
+
+	uint64_t timeUs = 0;
+	bool unknownEntry = false;
+	try {
+		while (!reader.atEnd() && !recording.finished && !unknownEntry) {
+			uint64_t tag = reader.readVarint();
+			timeUs += reader.readVarint();
+
+			switch (tag) {
+			case RECORDED_EVENT: {
+				Entry entry;
+				entry.timeUs = timeUs;
+				entry.event = Event::fromData(reader.readData());
+				recording.events.push_back(entry);
+				break;
+			}
+			case RECORDED_END: {
+				uint64_t nrStates = reader.readVarint();
+				std::list<std::string> configuration;
+				for (uint64_t i = 0; i < nrStates; i++)
+					configuration.push_back(reader.readString());
+				recording.configuration = configuration;
+				recording.durationUs = timeUs;
+				recording.finished = true;
+				break;
+			}
+			default:
+				unknownEntry = true;
+			}
+		}
+	} catch (ErrorEvent e) {
+		// the process taking the recording may have died while appending an entry
+	}
+
+	if (unknownEntry) {
+		ERROR_PLATFORM_THROW("Recording has an unknown entry");
+	}
+
+	return recording;
+}
+
+std::list<std::string> InterpreterRecording::getConfiguration(Interpreter& interpreter) {
+	// microsteppers do not agree on an order for the active states
+	std::vector<std::string> states;
+	for (auto state : interpreter.getConfiguration()) {
+		states.push_back(HAS_ATTR(state, kXMLCharId) ? ATTR(state, kXMLCharId) : DOMUtils::xPathForNode(state));
+	}
+	std::sort(states.begin(), states.end());
+	return std::list<std::string>(states.begin(), states.end());
+}
+
+InterpreterRecorder::InterpreterRecorder(const std::string& url, std::ostream* stream) : _stream(stream), _lastUs(0) {
+	_recording.url = url;
+	_start = std::chrono::steady_clock::now();
+
+	if (_stream) {
+		std::string buffer;
+		InterpreterRecording::writeHeader(buffer, url);
+		_stream->write(buffer.data(), buffer.size());
+		_stream->flush();
+	}
+}
+
+uint64_t InterpreterRecorder::elapsedUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void InterpreterRecorder::beforeProcessingEvent(const std::string& sessionId, const Event& event) {
+	if (event.eventType != Event::EXTERNAL)
+		return;
+
+	// the session will send these again when replayed
+	if (event.invokeid.size() > 0 || event.origin == "#_scxml_" + sessionId)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_recording.finished)
+		return;
+
+	InterpreterRecording::Entry entry;
+	entry.timeUs = elapsedUs();
+	entry.event = event;
+	entry.event.enqueuedAt = 0;
+
+	if (_stream) {
+		std::string buffer;
+		InterpreterRecording::writeEvent(buffer, entry.timeUs - _lastUs, entry.event);
+		_stream->write(buffer.data(), buffer.size());
+		_stream->flush();
+	}
+
+	_lastUs = entry.timeUs;
+	_recording.events.push_back(entry);
+}
+
+void InterpreterRecorder::finish(Interpreter& interpreter) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_recording.finished)
+		return;
+
+	_recording.durationUs = elapsedUs();
+	_recording.configuration = InterpreterRecording::getConfiguration(interpreter);
+	_recording.finished = true;
+
+	if (_stream) {
+		std::string buffer;
+		InterpreterRecording::writeEnd(buffer, _recording.durationUs - _lastUs, _recording.configuration);
+		_stream->write(buffer.data(), buffer.size());
+		_stream->flush();
+	}
+}
+
+InterpreterRecording InterpreterRecorder::getRecording() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _recording;
+}
+
+InterpreterReplay::Result InterpreterReplay::replay(const InterpreterRecording& recording, Pace pace) {
+	return replay(recording, Interpreter::fromURL(recording.url), pace);
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+	if (sorted.empty())
+		return 0;
+	return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+}
+
+InterpreterReplay::Result InterpreterReplay::replay(const InterpreterRecording& recording, Interpreter interpreter, Pace pace) {
+	using namespace std::chrono;
+
+	Result result;
+	std::vector<uint64_t> latencies;
+	latencies.reserve(recording.events.size());
+
+	std::shared_ptr<VirtualTimeDelayedEventQueue> delayQueue(new VirtualTimeDelayedEventQueue(interpreter.getImpl().get()));
+	std::shared_ptr<VirtualClock> clock = delayQueue->getClock();
+
+	ActionLanguage al = *interpreter.getActionLanguage();
+	al.delayQueue = DelayedEventQueue(delayQueue);
+	interpreter.setActionLanguage(al);
+
+	steady_clock::time_point start = steady_clock::now();
+	InterpreterState state = USCXML_INSTANTIATED;
+
+	// take the macrostep for whatever was just delivered
+	auto macrostep = [&]() {
+		steady_clock::time_point stepStart = steady_clock::now();
+		do {
+			state = interpreter.step(0);
+		} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+		latencies.push_back(duration_cast<nanoseconds>(steady_clock::now() - stepStart).count());
+		result.macrosteps++;
+	};
+
+	// deliver the chart's own delayed events until the given virtual time
+	auto advanceTo = [&](uint64_t timeMs) {
+		while (state != USCXML_FINISHED && clock->nextDue() <= timeMs) {
+			if (pace == RECORDED)
+				std::this_thread::sleep_until(start + milliseconds(clock->nextDue()));
+			clock->advanceToNext();
+			macrostep();
+		}
+		clock->advanceTo(timeMs);
+	};
+
+	// initialization is not part of the recording
+	do {
+		state = interpreter.step(0);
+	} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+	start = steady_clock::now();
+
+	for (auto& entry : recording.events) {
+		advanceTo(entry.timeUs / 1000);
+		if (state == USCXML_FINISHED)
+			break;
+
+		if (pace == RECORDED)
+			std::this_thread::sleep_until(start + microseconds(entry.timeUs));
+
+		interpreter.receive(entry.event);
+		macrostep();
+		result.events++;
+	}
+
+	if (recording.finished)
+		advanceTo(recording.durationUs / 1000);
+
+	result.seconds = duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1000000000.0;
+	result.eventsPerSecond = (result.seconds > 0 ? result.events / result.seconds : 0);
+
+	std::sort(latencies.begin(), latencies.end());
+	result.p50Ns = percentile(latencies, 0.5);
+	result.p90Ns = percentile(latencies, 0.9);
+	result.p99Ns = percentile(latencies, 0.99);
+	result.maxNs = (latencies.empty() ? 0 : latencies.back());
+
+	result.configuration = InterpreterRecording::getConfiguration(interpreter);
+	if (recording.finished)
+		result.configurationMatches = (result.configuration == recording.configuration);
+
+	return result;
+}
+
+}
@@ -0,0 +1,149 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef INTERPRETERRECORDER_H_0E6B93A5
+#define INTERPRETERRECORDER_H_0E6B93A5
+
+#include "uscxml/Common.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterMonitor.h"
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace uscxml {
+
+/**
+ * The external events a session processed with their times and payloads and,
+ * once finished, the configuration it ended in.
+ *
+ * Encoded with the SnapshotWriter primitives after the magic "USCXMLRC" as a
+ * version and the chart's URL, followed by entries of a tag, the microseconds
+ * since the previous entry and an event or the final configuration. Entries
+ * are only appended, so a recording can be written while it is taken.
+ */
+class USCXML_API InterpreterRecording {
+public:
+	struct Entry {
+		uint64_t timeUs; ///< Microseconds since the recording started
+		Event event;
+	};
+
+	InterpreterRecording() : durationUs(0), finished(false) {}
+
+	/// Throws an error.platform event if the buffer is no recording, a truncated last entry is ignored
+	static InterpreterRecording fromBuffer(const std::string& buffer);
+	std::string toBuffer() const;
+
+	/// The sorted ids of the active states, the XPath for states without an id
+	static std::list<std::string> getConfiguration(Interpreter& interpreter);
+
+	static void writeHeader(std::string& buffer, const std::string& url);
+	static void writeEvent(std::string& buffer, uint64_t deltaUs, const Event& event);
+	static void writeEnd(std::string& buffer, uint64_t deltaUs, const std::list<std::string>& configuration);
+
+	std::string url;
+	std::vector<Entry> events;
+	uint64_t durationUs; ///< Microseconds until finished
+	bool finished;
+	std::list<std::string> configuration; ///< Only if finished
+
+	/// Incremented with every incompatible change of the encoding
+	static const uint8_t version = 1;
+};
+
+/**
+ * Records the external events processed by a session.
+ *
+ * Events the session sent to itself and events from its invokers are left
+ * out, the session will send them again when replayed.
+ */
+class USCXML_API InterpreterRecorder : public InterpreterMonitor {
+public:
+	/**
+	 * @param url The chart to replay the recording with.
+	 * @param stream Where to append every entry as it is recorded, if any.
+	 */
+	InterpreterRecorder(const std::string& url, std::ostream* stream = NULL);
+
+	virtual uint32_t getCallbacks() {
+		return MonitorCallback::beforeProcessingEvent;
+	}
+
+	virtual void beforeProcessingEvent(const std::string& sessionId, const Event& event);
+
+	/// Record the configuration the interpreter ended in, nothing is recorded afterwards
+	void finish(Interpreter& interpreter);
+
+	InterpreterRecording getRecording();
+
+protected:
+	uint64_t elapsedUs();
+
+	InterpreterRecording _recording;
+	std::ostream* _stream;
+	std::chrono::steady_clock::time_point _start;
+	uint64_t _lastUs;
+	std::mutex _mutex;
+};
+
+/**
+ * Feeds a recording into an interpreter on a virtual clock.
+ *
+ * Delayed events the chart sends are delivered when the virtual clock passes
+ * their due time, which only advances to the recorded time of the next event.
+ * The replay is deterministic as long as the chart does not depend on the
+ * wall clock or on invoked sessions running in their own threads.
+ */
+class USCXML_API InterpreterReplay {
+public:
+	enum Pace {
+		AS_FAST_AS_POSSIBLE,
+		RECORDED ///< Wait for the recorded time before delivering an event
+	};
+
+	struct Result {
+		Result() : events(0), macrosteps(0), seconds(0), eventsPerSecond(0), p50Ns(0), p90Ns(0), p99Ns(0), maxNs(0), configurationMatches(true) {}
+
+		size_t events; ///< Recorded events delivered
+		size_t macrosteps; ///< Including the ones for delayed events
+		double seconds;
+		double eventsPerSecond;
+		uint64_t p50Ns; ///< Macrostep latency percentiles from delivering an event until the interpreter is idle
+		uint64_t p90Ns;
+		uint64_t p99Ns;
+		uint64_t maxNs;
+		std::list<std::string> configuration;
+		bool configurationMatches; ///< Also true if the recording was not finished
+	};
+
+	/// Replay into a new interpreter for the recorded URL
+	static Result replay(const InterpreterRecording& recording, Pace pace = AS_FAST_AS_POSSIBLE);
+
+	/// Replay into an interpreter that did not step yet, its delayed event queue is replaced
+	static Result replay(const InterpreterRecording& recording, Interpreter interpreter, Pace pace = AS_FAST_AS_POSSIBLE);
+};
+
+}
+
+#endif /* end of include guard: INTERPRETERRECORDER_H_0E6B93A5 */
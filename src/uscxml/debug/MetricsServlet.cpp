@@ -0,0 +1,112 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "uscxml/debug/MetricsServlet.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+
+#include <sstream>
+
+namespace uscxml {
+
+static std::string escapeLabel(const std::string& value) {
+	std::string escaped;
+	for (size_t i = 0; i < value.size(); i++) {
+		switch (value[i]) {
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		default:
+			escaped += value[i];
+		}
+	}
+	return escaped;
+}
+
+static double seconds(const Data& nanoseconds) {
+	return strTo<double>(nanoseconds.atom) / 1000000000.0;
+}
+
+std::ostream& MetricsServlet::report(std::ostream& stream) {
+	std::map<std::string, Data> sessions;
+
+	std::map<std::string, std::weak_ptr<InterpreterImpl> > instances = InterpreterImpl::getInstances();
+	for (auto weakInstance : instances) {
+		std::shared_ptr<InterpreterImpl> instance = weakInstance.second.lock();
+		if (instance) {
+			Data metrics = instance->getMetricsData();
+			// only sessions that ever had metrics enabled
+			if (metrics.hasKey("phases"))
+				sessions[weakInstance.first] = metrics;
+		}
+	}
+
+	stream << "# HELP uscxml_microsteps_total Microsteps taken by a session." << std::endl;
+	stream << "# TYPE uscxml_microsteps_total counter" << std::endl;
+	for (auto& session : sessions) {
+		stream << "uscxml_microsteps_total{session=\"" << escapeLabel(session.first) << "\"} " << session.second["microsteps"].atom << std::endl;
+	}
+
+	stream << "# HELP uscxml_events_total Events dequeued by a session." << std::endl;
+	stream << "# TYPE uscxml_events_total counter" << std::endl;
+	for (auto& session : sessions) {
+		for (auto& event : session.second["events"].compound) {
+			stream << "uscxml_events_total{session=\"" << escapeLabel(session.first) << "\",event=\"" << escapeLabel(event.first) << "\"} " << event.second.atom << std::endl;
+		}
+	}
+
+	stream << "# HELP uscxml_delayed_sends Delayed sends of a session not yet delivered." << std::endl;
+	stream << "# TYPE uscxml_delayed_sends gauge" << std::endl;
+	for (auto& session : sessions) {
+		stream << "uscxml_delayed_sends{session=\"" << escapeLabel(session.first) << "\"} " << session.second["delayedInFlight"].atom << std::endl;
+	}
+
+	stream << "# HELP uscxml_phase_seconds Time spent per event in each phase of processing it." << std::endl;
+	stream << "# TYPE uscxml_phase_seconds summary" << std::endl;
+	for (auto& session : sessions) {
+		for (auto& phase : session.second["phases"].compound) {
+			std::string labels = "session=\"" + escapeLabel(session.first) + "\",phase=\"" + phase.first + "\"";
+			stream << "uscxml_phase_seconds{" << labels << ",quantile=\"0.5\"} " << seconds(phase.second["p50"]) << std::endl;
+			stream << "uscxml_phase_seconds{" << labels << ",quantile=\"0.9\"} " << seconds(phase.second["p90"]) << std::endl;
+			stream << "uscxml_phase_seconds{" << labels << ",quantile=\"0.99\"} " << seconds(phase.second["p99"]) << std::endl;
+			stream << "uscxml_phase_seconds_sum{" << labels << "} " << seconds(phase.second["total"]) << std::endl;
+			stream << "uscxml_phase_seconds_count{" << labels << "} " << phase.second["count"].atom << std::endl;
+		}
+	}
+
+	return stream;
+}
+
+bool MetricsServlet::requestFromHTTP(const HTTPServer::Request& request) {
+	std::stringstream content;
+	report(content);
+
+	HTTPServer::Reply reply(request);
+	reply.content = content.str();
+	reply.headers["Content-Type"] = "text/plain; version=0.0.4";
+	HTTPServer::reply(reply);
+	return true;
+}
+
+}
@@ -0,0 +1,50 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef METRICSSERVLET_H_3D0A5E21
+#define METRICSSERVLET_H_3D0A5E21
+
+#include "uscxml/Common.h"
+#include "uscxml/server/HTTPServer.h"
+
+#include <ostream>
+
+namespace uscxml {
+
+/**
+ * Metrics of all sessions with metrics enabled in the Prometheus text format.
+ */
+class USCXML_API MetricsServlet : public HTTPServlet {
+public:
+	virtual ~MetricsServlet() {}
+
+	bool requestFromHTTP(const HTTPServer::Request& request);
+	void setURL(const std::string& url) {
+		_url = url;
+	}
+
+	static std::ostream& report(std::ostream& stream);
+
+protected:
+	std::string _url;
+};
+
+}
+
+#endif /* end of include guard: METRICSSERVLET_H_3D0A5E21 */
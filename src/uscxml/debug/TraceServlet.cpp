@@ -0,0 +1,86 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "uscxml/debug/TraceServlet.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/util/Convenience.h"
+
+#include <sstream>
+
+namespace uscxml {
+
+std::ostream& TraceServlet::report(std::ostream& stream, InterpreterTrace::Format format, const std::string& sessionId, size_t records) {
+	std::list<std::shared_ptr<InterpreterImpl> > sessions;
+
+	std::map<std::string, std::weak_ptr<InterpreterImpl> > instances = InterpreterImpl::getInstances();
+	for (auto weakInstance : instances) {
+		if (sessionId.size() > 0 && weakInstance.first != sessionId)
+			continue;
+		std::shared_ptr<InterpreterImpl> instance = weakInstance.second.lock();
+		if (instance)
+			sessions.push_back(instance);
+	}
+
+	if (format == InterpreterTrace::CHROME) {
+		std::list<InterpreterTrace::Session> traces;
+		for (auto& session : sessions)
+			traces.push_back(session->readTrace(records));
+		InterpreterTrace::writeChrome(stream, traces);
+		return stream;
+	}
+
+	for (auto& session : sessions)
+		session->writeTrace(stream, format, records);
+
+	return stream;
+}
+
+bool TraceServlet::requestFromHTTP(const HTTPServer::Request& request) {
+	std::map<std::string, Data> query = request.data.at("query").compound;
+
+	InterpreterTrace::Format format = InterpreterTrace::BINARY;
+	if (query.find("format") != query.end() && query["format"].atom == "chrome")
+		format = InterpreterTrace::CHROME;
+
+	std::string sessionId;
+	if (query.find("session") != query.end())
+		sessionId = query["session"].atom;
+
+	size_t records = (size_t)-1;
+	if (query.find("records") != query.end())
+		records = strTo<size_t>(query["records"].atom);
+
+	if (sessionId.size() > 0 && InterpreterImpl::getInstances().count(sessionId) == 0) {
+		HTTPServer::Reply reply(request);
+		reply.status = 404;
+		HTTPServer::reply(reply);
+		return true;
+	}
+
+	std::stringstream content;
+	report(content, format, sessionId, records);
+
+	HTTPServer::Reply reply(request);
+	reply.content = content.str();
+	reply.headers["Content-Type"] = (format == InterpreterTrace::CHROME ? "application/json" : "application/octet-stream");
+	HTTPServer::reply(reply);
+	return true;
+}
+
+}
@@ -0,0 +1,57 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef TRACESERVLET_H_6F13C9D4
+#define TRACESERVLET_H_6F13C9D4
+
+#include "uscxml/Common.h"
+#include "uscxml/server/HTTPServer.h"
+#include "uscxml/interpreter/InterpreterTrace.h"
+
+#include <ostream>
+
+namespace uscxml {
+
+/**
+ * The last records of the flight recorders of all sessions or, with
+ * ?session=<id>, of a single one. Pass ?records=<n> to limit the records
+ * per session and ?format=chrome for JSON instead of the binary format.
+ */
+class USCXML_API TraceServlet : public HTTPServlet {
+public:
+	virtual ~TraceServlet() {}
+
+	bool requestFromHTTP(const HTTPServer::Request& request);
+	void setURL(const std::string& url) {
+		_url = url;
+	}
+
+	/// Binary traces of several sessions are concatenated, as JSON they share one timeline
+	static std::ostream& report(std::ostream& stream,
+	                            InterpreterTrace::Format format,
+	                            const std::string& sessionId = "",
+	                            size_t records = (size_t)-1);
+
+protected:
+	std::string _url;
+};
+
+}
+
+#endif /* end of include guard: TRACESERVLET_H_6F13C9D4 */
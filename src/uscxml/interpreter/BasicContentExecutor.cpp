@@ -23,6 +23,8 @@
 #include "uscxml/util/Predicates.h"
 #include "uscxml/util/UUID.h"
 #include "uscxml/util/URL.h"
+#include "uscxml/util/EventDescriptor.h"
+#include "uscxml/debug/Benchmark.h"
 
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
@@ -40,11 +42,14 @@ std::shared_ptr<ContentExecutorImpl> BasicContentExecutor::create(ContentExecuto
 }
 
 void BasicContentExecutor::processRaise(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: raise");
 	Event raised(ATTR(content, kXMLCharEvent));
+	raised.nameId = EventName::lookup(raised.name);
 	_callbacks->enqueueInternal(raised);
 }
 
 void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
+	USCXML_BENCHMARK("BasicContentExecutor: send");
 	Event sendEvent;
 	std::string target;
 	std::string type = "http://www.w3.org/TR/scxml/#SCXMLEventProcessor"; // default
@@ -62,9 +67,11 @@ void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
 	try {
 		// event
 		if (HAS_ATTR(element, kXMLCharEventExpr)) {
-			sendEvent.name = _callbacks->evalAsData(ATTR(element, kXMLCharEventExpr)).atom;
+			sendEvent.name = _callbacks->evalAsData(getExpr(element, kXMLCharEventExpr)).atom;
 		} else if (HAS_ATTR(element, kXMLCharEvent)) {
 			sendEvent.name = ATTR(element, kXMLCharEvent);
+			// interned with the chart, the id travels to the receiving session
+			sendEvent.nameId = EventName::lookup(sendEvent.name);
 		}
 	} catch (ErrorEvent e) {
 		ERROR_EXECUTION_RETHROW(e, "Syntax error in send element eventexpr", element);
@@ -73,7 +80,7 @@ void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
 	try {
 		// target
 		if (HAS_ATTR(element, kXMLCharTargetExpr)) {
-			target = _callbacks->evalAsData(ATTR(element, kXMLCharTargetExpr)).atom;
+			target = _callbacks->evalAsData(getExpr(element, kXMLCharTargetExpr)).atom;
 		} else if (HAS_ATTR(element, kXMLCharTarget)) {
 			target = ATTR(element, kXMLCharTarget);
 		}
@@ -84,7 +91,7 @@ void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
 	try {
 		// type
 		if (HAS_ATTR(element, kXMLCharTypeExpr)) {
-			type = _callbacks->evalAsData(ATTR(element, kXMLCharTypeExpr)).atom;
+			type = _callbacks->evalAsData(getExpr(element, kXMLCharTypeExpr)).atom;
 		} else if (HAS_ATTR(element, kXMLCharType)) {
 			type = ATTR(element, kXMLCharType);
 		}
@@ -131,7 +138,7 @@ void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
 		// delay
 		std::string delay;
 		if (HAS_ATTR(element, kXMLCharDelayExpr)) {
-			delay = _callbacks->evalAsData(ATTR(element, kXMLCharDelayExpr));
+			delay = _callbacks->evalAsData(getExpr(element, kXMLCharDelayExpr));
 		} else if (HAS_ATTR(element, kXMLCharDelay)) {
 			delay = ATTR(element, kXMLCharDelay);
 		}
@@ -199,11 +206,12 @@ void BasicContentExecutor::processSend(XERCESC_NS::DOMElement* element) {
 }
 
 void BasicContentExecutor::processCancel(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: cancel");
 	std::string sendid;
 	if (HAS_ATTR(content, kXMLCharSendId)) {
 		sendid = ATTR(content, kXMLCharSendId);
 	} else if (HAS_ATTR(content, kXMLCharSendIdExpr)) {
-		sendid = _callbacks->evalAsData(ATTR(content, kXMLCharSendIdExpr)).atom;
+		sendid = _callbacks->evalAsData(getExpr(content, kXMLCharSendIdExpr)).atom;
 	} else {
 		ERROR_EXECUTION_THROW2("Cancel element has neither sendid nor sendidexpr attribute", content);
 
@@ -212,7 +220,8 @@ void BasicContentExecutor::processCancel(XERCESC_NS::DOMElement* content) {
 }
 
 void BasicContentExecutor::processIf(XERCESC_NS::DOMElement* content) {
-	bool blockIsTrue = _callbacks->isTrue(ATTR(content, kXMLCharCond));
+	USCXML_BENCHMARK("BasicContentExecutor: if");
+	bool blockIsTrue = _callbacks->isTrue(getExpr(content, kXMLCharCond));
 
 	for (auto childElem = content->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
 		if (iequals(TAGNAME(childElem), XML_PREFIX(content).str() + "elseif")) {
@@ -220,7 +229,7 @@ void BasicContentExecutor::processIf(XERCESC_NS::DOMElement* content) {
 				// last block was true, break here
 				break;
 			}
-			blockIsTrue = _callbacks->isTrue(ATTR(childElem, kXMLCharCond));
+			blockIsTrue = _callbacks->isTrue(getExpr(childElem, kXMLCharCond));
 			continue;
 		}
 		if (iequals(TAGNAME(childElem), XML_PREFIX(content).str() + "else")) {
@@ -241,6 +250,7 @@ void BasicContentExecutor::processIf(XERCESC_NS::DOMElement* content) {
 }
 
 void BasicContentExecutor::processAssign(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: assign");
 	std::string location = ATTR(content, kXMLCharLocation);
 
 	std::map<std::string, std::string> additionalAttr;
@@ -255,6 +265,7 @@ void BasicContentExecutor::processAssign(XERCESC_NS::DOMElement* content) {
 }
 
 void BasicContentExecutor::processForeach(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: foreach");
 	std::string array = ATTR(content, kXMLCharArray);
 	std::string item = ATTR(content, kXMLCharItem);
 	std::string index = (HAS_ATTR(content, kXMLCharIndex) ? ATTR(content, kXMLCharIndex) : "");
@@ -272,10 +283,10 @@ void BasicContentExecutor::processForeach(XERCESC_NS::DOMElement* content) {
 }
 
 void BasicContentExecutor::processLog(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: log");
 	std::string label = ATTR(content, kXMLCharLabel);
-	std::string expr = ATTR(content, kXMLCharExpr);
 
-	Data d = _callbacks->evalAsData(expr);
+	Data d = _callbacks->evalAsData(getExpr(content, kXMLCharExpr));
 #if 0
 	if (label.size() > 0) {
 		_callbacks->getLogger().log(USCXML_LOG) << label << ": ";
@@ -289,13 +300,36 @@ void BasicContentExecutor::processLog(XERCESC_NS::DOMElement* content) {
 }
 
 void BasicContentExecutor::processScript(XERCESC_NS::DOMElement* content) {
+	USCXML_BENCHMARK("BasicContentExecutor: script");
 	// contents were already downloaded in setupDOM, see to SCXML rec 5.8
-	std::string scriptContent(X(content->getTextContent()));
-	_callbacks->eval(scriptContent);
+	_callbacks->eval(getExpr(content));
 
 }
 
+CompiledExpression& BasicContentExecutor::getExpr(XERCESC_NS::DOMElement* element, const X& attr) {
+	// a missing attribute is the empty expression, these may as well share a key
+	const DOMNode* node = element->getAttributeNode(attr);
+	auto exprIter = _compiled.find(node);
+	if (exprIter != _compiled.end())
+		return *exprIter->second;
+
+	std::shared_ptr<CompiledExpression> expr = _callbacks->compile(node != NULL ? ATTR(element, attr) : "");
+	_compiled[node] = expr;
+	return *expr;
+}
+
+CompiledExpression& BasicContentExecutor::getExpr(XERCESC_NS::DOMElement* element) {
+	auto exprIter = _compiled.find(element);
+	if (exprIter != _compiled.end())
+		return *exprIter->second;
+
+	std::shared_ptr<CompiledExpression> expr = _callbacks->compile(DOMUtils::textContent(element));
+	_compiled[element] = expr;
+	return *expr;
+}
+
 void BasicContentExecutor::process(XERCESC_NS::DOMElement* block) {
+	USCXML_BENCHMARK("BasicContentExecutor: process");
 	std::string tagName = TAGNAME(block);
 	std::string xmlPrefix = XML_PREFIX(block);
 
@@ -405,6 +439,7 @@ void BasicContentExecutor::process(XERCESC_NS::DOMElement* block) {
 }
 
 void BasicContentExecutor::invoke(XERCESC_NS::DOMElement* element) {
+	USCXML_BENCHMARK("BasicContentExecutor: invoke");
 	std::string type;
 	std::string source;
 	bool autoForward = false;
@@ -412,7 +447,7 @@ void BasicContentExecutor::invoke(XERCESC_NS::DOMElement* element) {
 
 	// type
 	if (HAS_ATTR(element, kXMLCharTypeExpr)) {
-		type = _callbacks->evalAsData(ATTR(element, kXMLCharTypeExpr)).atom;
+		type = _callbacks->evalAsData(getExpr(element, kXMLCharTypeExpr)).atom;
 	} else if (HAS_ATTR(element, kXMLCharType)) {
 		type = ATTR(element, kXMLCharType);
 	} else {
@@ -422,7 +457,7 @@ void BasicContentExecutor::invoke(XERCESC_NS::DOMElement* element) {
 
 	// src
 	if (HAS_ATTR(element, kXMLCharSourceExpr)) {
-		source = _callbacks->evalAsData(ATTR(element, kXMLCharSourceExpr)).atom;
+		source = _callbacks->evalAsData(getExpr(element, kXMLCharSourceExpr)).atom;
 	} else if (HAS_ATTR(element, kXMLCharSource)) {
 		source = ATTR(element, kXMLCharSource);
 	}
@@ -507,6 +542,7 @@ void BasicContentExecutor::invoke(XERCESC_NS::DOMElement* element) {
 }
 
 void BasicContentExecutor::uninvoke(XERCESC_NS::DOMElement* invoke) {
+	USCXML_BENCHMARK("BasicContentExecutor: uninvoke");
 	char* invokeId = (char*)invoke->getUserData(X(kXMLCharInvokeId));
 	assert(invokeId != NULL);
 
@@ -519,6 +555,7 @@ void BasicContentExecutor::uninvoke(XERCESC_NS::DOMElement* invoke) {
 }
 
 void BasicContentExecutor::raiseDoneEvent(XERCESC_NS::DOMElement* state, XERCESC_NS::DOMElement* doneData) {
+	USCXML_BENCHMARK("BasicContentExecutor: raiseDoneEvent");
 
 	Event doneEvent;
 	doneEvent.name = "done.state.";
@@ -589,9 +626,9 @@ void BasicContentExecutor::processParams(std::multimap<std::string, Data>& param
 		std::string name = ATTR(*paramIter, kXMLCharName);
 		Data d;
 		if (HAS_ATTR(*paramIter, kXMLCharExpr)) {
-			d = _callbacks->evalAsData(ATTR(*paramIter, kXMLCharExpr));
+			d = _callbacks->evalAsData(getExpr(*paramIter, kXMLCharExpr));
 		} else if (HAS_ATTR(*paramIter, kXMLCharLocation)) {
-			d = _callbacks->evalAsData(ATTR(*paramIter, kXMLCharLocation));
+			d = _callbacks->evalAsData(getExpr(*paramIter, kXMLCharLocation));
 		} else {
 			d = elementAsData(*paramIter);
 		}
@@ -59,7 +59,12 @@ protected:
 	void processNameLists(std::map<std::string, Data>& nameMap, XERCESC_NS::DOMElement* element);
 	void processParams(std::multimap<std::string, Data>& paramMap, XERCESC_NS::DOMElement* element);
 
+	CompiledExpression& getExpr(XERCESC_NS::DOMElement* element, const X& attr);
+	CompiledExpression& getExpr(XERCESC_NS::DOMElement* element);
+
 	std::map<XERCESC_NS::DOMElement*, ExecutableContent> _customExecContent;
+	/// Expressions compiled by the datamodel per attribute node or element for its text
+	std::map<const XERCESC_NS::DOMNode*, std::shared_ptr<CompiledExpression> > _compiled;
 };
 
 }
@@ -21,6 +21,8 @@
 #include <event2/util.h>                // for evutil_socket_t
 #include <event2/thread.h>
 #include <assert.h>
+#include <algorithm>
+#include <iterator>
 
 #include "uscxml/interpreter/Logging.h"
 
@@ -31,9 +33,7 @@ BasicEventQueue::BasicEventQueue() {
 BasicEventQueue::~BasicEventQueue() {
 }
 
-Event BasicEventQueue::dequeue(size_t blockMs) {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-
+void BasicEventQueue::waitForEvent(size_t blockMs) {
 	if (blockMs == std::numeric_limits<size_t>::max()) {
 		// handle "forever" explicitly, see comments below
 		while (_queue.empty()) {
@@ -66,6 +66,11 @@ Event BasicEventQueue::dequeue(size_t blockMs) {
 			_cond.wait_until(_mutex, endTime);
 		}
 	}
+}
+
+Event BasicEventQueue::dequeue(size_t blockMs) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	waitForEvent(blockMs);
 
 	if (_queue.size() > 0) {
 		Event event = _queue.front();
@@ -83,6 +88,25 @@ void BasicEventQueue::enqueue(const Event& event) {
 	_cond.notify_all();
 }
 
+void BasicEventQueue::enqueueBatch(const std::list<Event>& events) {
+	// copy outside of the lock and only link the nodes while holding it
+	std::list<Event> batch(events);
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_queue.splice(_queue.end(), batch);
+	_cond.notify_all();
+}
+
+size_t BasicEventQueue::dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	waitForEvent(blockMs);
+
+	size_t dequeued = (std::min)(max, _queue.size());
+	auto last = _queue.begin();
+	std::advance(last, dequeued);
+	events.splice(events.end(), _queue, _queue.begin(), last);
+	return dequeued;
+}
+
 void BasicEventQueue::reset() {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
 	_queue.clear();
@@ -45,7 +45,12 @@ public:
 	virtual Data serialize();
 	virtual void deserialize(const Data& data);
 
+	virtual void enqueueBatch(const std::list<Event>& events);
+	virtual size_t dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs);
+
 protected:
+	void waitForEvent(size_t blockMs); ///< with _mutex held
+
 	std::list<Event> _queue;
 	std::recursive_mutex _mutex;
 	std::condition_variable_any _cond;
@@ -0,0 +1,102 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "ChartTemplate.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/URL.h"
+#include "uscxml/util/MD5.hpp"
+
+namespace uscxml {
+
+std::map<std::string, std::weak_ptr<ChartTemplate> > ChartTemplate::_templates;
+std::mutex ChartTemplate::_templatesMutex;
+
+std::shared_ptr<ChartTemplate> ChartTemplate::fromURL(const std::string& url) {
+	URL absUrl(url);
+	if (absUrl.scheme() == "" || !absUrl.isAbsolute()) {
+		absUrl = URL::resolveWithCWD(absUrl);
+	}
+	return fromXML(absUrl.getInContent(), absUrl);
+}
+
+std::shared_ptr<ChartTemplate> ChartTemplate::fromXML(const std::string& xml, const std::string& baseURL) {
+	std::string key = md5(xml) + baseURL;
+
+	std::lock_guard<std::mutex> lock(_templatesMutex);
+
+	// forget about templates no longer in use
+	auto tmplIter = _templates.begin();
+	while(tmplIter != _templates.end()) {
+		if (!tmplIter->second.lock()) {
+			_templates.erase(tmplIter++);
+		} else {
+			tmplIter++;
+		}
+	}
+
+	std::shared_ptr<ChartTemplate> tmpl = _templates[key].lock();
+	if (!tmpl) {
+		tmpl = std::shared_ptr<ChartTemplate>(new ChartTemplate());
+		tmpl->compile(xml, baseURL);
+		_templates[key] = tmpl;
+	}
+	return tmpl;
+}
+
+ChartTemplate::~ChartTemplate() {
+}
+
+void ChartTemplate::compile(const std::string& xml, const std::string& baseURL) {
+	_xml = xml;
+	_baseURL = baseURL;
+	_md5 = md5(xml);
+
+	Interpreter prototype = Interpreter::fromXML(xml, baseURL);
+	_prototype = prototype.getImpl();
+	{
+		// the prototype is not a session
+		std::lock_guard<std::recursive_mutex> lock(InterpreterImpl::_instanceMutex);
+		InterpreterImpl::_instances.erase(_prototype->getSessionId());
+	}
+
+	// locate the scxml element and download scripts
+	_prototype->setupDOM();
+
+	// we cannot share a DOM that is changed at runtime
+	std::string prefix = _prototype->_xmlPrefix;
+	if (DOMUtils::filterChildElements(prefix + "invoke", _prototype->_scxml, true).size() > 0)
+		return;
+
+	// nor one whose nodes are handed to the datamodels as XML
+	std::list<XERCESC_NS::DOMElement*> dataElems = DOMUtils::filterChildElements(prefix + "data", _prototype->_scxml, true);
+	dataElems.splice(dataElems.end(), DOMUtils::filterChildElements(prefix + "content", _prototype->_scxml, true));
+	for (auto element : dataElems) {
+		if (HAS_ATTR(element, kXMLCharSource) || element->getFirstElementChild() != NULL)
+			return;
+	}
+
+	FastMicroStep compiler(NULL);
+	compiler.init(_prototype->_scxml);
+	_chart = compiler.getChart();
+	_isShared = true;
+}
+
+}
@@ -0,0 +1,95 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef CHARTTEMPLATE_H_7F3A92C4
+#define CHARTTEMPLATE_H_7F3A92C4
+
+#include "uscxml/Common.h"
+#include "uscxml/interpreter/FastMicroStep.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace uscxml {
+
+class InterpreterImpl;
+
+/**
+ * @ingroup interpreter
+ * A document parsed and compiled once to instantiate many sessions from.
+ *
+ * Templates are cached by the md5 of their document and base URL. Sessions
+ * created via Interpreter::fromTemplate share the template's DOM and the
+ * compiled tables of the FastMicroStep. This requires the DOM to remain
+ * unchanged and unexposed at runtime, documents with <invoke> elements or
+ * <data> and <content> elements with a src attribute or child elements are
+ * parsed anew for each session. Sessions only read the shared DOM, text
+ * content is taken via DOMUtils::textContent, never getTextContent(), as
+ * the latter allocates in the shared document.
+ */
+class USCXML_API ChartTemplate {
+public:
+	/**
+	 * Get the template for the given XML markup, compile it if needed.
+	 * @param xml Textual representation of an SCXML document.
+	 * @param baseURL An absolute URL to resolve relative URLs in the document.
+	 */
+	static std::shared_ptr<ChartTemplate> fromXML(const std::string& xml, const std::string& baseURL);
+
+	/**
+	 * Get the template for the document at the given URL, compile it if needed.
+	 * @param url An absolute URL to locate the SCXML document.
+	 */
+	static std::shared_ptr<ChartTemplate> fromURL(const std::string& url);
+
+	virtual ~ChartTemplate();
+
+	const std::string& getMD5() {
+		return _md5;
+	}
+
+	/// Whether sessions share the template's DOM and compiled chart
+	bool isShared() {
+		return _isShared;
+	}
+
+protected:
+	ChartTemplate() : _isShared(false) {}
+	void compile(const std::string& xml, const std::string& baseURL);
+
+	std::string _md5;
+	std::string _xml;
+	std::string _baseURL;
+	bool _isShared;
+
+	// owns the DOM, never stepped
+	std::shared_ptr<InterpreterImpl> _prototype;
+	std::shared_ptr<const FastMicroStep::Chart> _chart;
+
+	static std::map<std::string, std::weak_ptr<ChartTemplate> > _templates;
+	static std::mutex _templatesMutex;
+
+	friend class Interpreter;
+};
+
+}
+
+#endif /* end of include guard: CHARTTEMPLATE_H_7F3A92C4 */
@@ -0,0 +1,285 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "CompiledContentExecutor.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/util/String.h"
+#include "uscxml/util/Predicates.h"
+
+#include <xercesc/dom/DOM.hpp>
+
+#include "uscxml/interpreter/Logging.h"
+
+namespace uscxml {
+
+using namespace XERCESC_NS;
+
+std::shared_ptr<ContentExecutorImpl> CompiledContentExecutor::create(ContentExecutorCallbacks* callbacks) {
+	return std::shared_ptr<ContentExecutorImpl>(new CompiledContentExecutor(callbacks));
+}
+
+void CompiledContentExecutor::process(XERCESC_NS::DOMElement* block) {
+	if (iequals(TAGNAME(block), XML_PREFIX(block).str() + "finalize")) {
+		// rarely executed and with special semantics when empty
+		BasicContentExecutor::process(block);
+		return;
+	}
+
+	auto progIter = _programs.find(block);
+	if (progIter == _programs.end()) {
+		progIter = _programs.insert(std::make_pair(block, Program())).first;
+		compile(block, progIter->second);
+	}
+	run(progIter->second);
+}
+
+void CompiledContentExecutor::compile(XERCESC_NS::DOMElement* block, Program& program) {
+	std::string tagName = TAGNAME(block);
+	std::string xmlPrefix = XML_PREFIX(block);
+
+	if (iequals(tagName, xmlPrefix + "onentry") ||
+	        iequals(tagName, xmlPrefix + "onexit") ||
+	        iequals(tagName, xmlPrefix + "transition")) {
+		for (auto childElem = block->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
+			compileElement(childElem, program);
+		}
+		return;
+	}
+	compileElement(block, program);
+}
+
+void CompiledContentExecutor::compileElement(XERCESC_NS::DOMElement* element, Program& program) {
+	std::string tagName = TAGNAME(element);
+	std::string xmlPrefix = XML_PREFIX(element);
+
+	if (false) {
+	} else if (iequals(tagName, xmlPrefix + "raise")) {
+		size_t raise = emit(program, OP_RAISE, element);
+		program[raise].args.push_back(ATTR(element, kXMLCharEvent));
+
+	} else if (iequals(tagName, xmlPrefix + "send")) {
+		emit(program, OP_SEND, element);
+
+	} else if (iequals(tagName, xmlPrefix + "cancel")) {
+		emit(program, OP_CANCEL, element);
+
+	} else if (iequals(tagName, xmlPrefix + "if")) {
+		// errors in any of the conditions are reported for the if element
+		size_t branch = emit(program, OP_IF, element);
+		program[branch].expr = _callbacks->compile(ATTR(element, kXMLCharCond));
+		bool hasBranch = true;
+		std::list<size_t> toEnd;
+
+		for (auto childElem = element->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
+			if (iequals(TAGNAME(childElem), xmlPrefix + "elseif")) {
+				toEnd.push_back(emit(program, OP_JUMP, element));
+				if (hasBranch)
+					program[branch].jump = program.size();
+				branch = emit(program, OP_ELSEIF, element);
+				program[branch].expr = _callbacks->compile(ATTR(childElem, kXMLCharCond));
+				hasBranch = true;
+				continue;
+			}
+			if (iequals(TAGNAME(childElem), xmlPrefix + "else")) {
+				toEnd.push_back(emit(program, OP_JUMP, element));
+				if (hasBranch)
+					program[branch].jump = program.size();
+				hasBranch = false;
+				continue;
+			}
+			compileElement(childElem, program);
+		}
+
+		size_t end = emit(program, OP_END_IF, element);
+		if (hasBranch)
+			program[branch].jump = end;
+		for (auto jump : toEnd) {
+			program[jump].jump = end;
+		}
+
+	} else if (iequals(tagName, xmlPrefix + "assign")) {
+		size_t assign = emit(program, OP_ASSIGN, element);
+		program[assign].args.push_back(ATTR(element, kXMLCharLocation));
+
+		auto xmlAttrs = element->getAttributes();
+		size_t nrAttrs = xmlAttrs->getLength();
+		for (size_t i = 0; i < nrAttrs; i++) {
+			auto attr = xmlAttrs->item(i);
+			program[assign].attrs[X(attr->getNodeName()).str()] = X(attr->getNodeValue()).str();
+		}
+
+		// an expression is passed as such, everything else is resolved per execution
+		if (HAS_ATTR(element, kXMLCharExpr))
+			program[assign].data = elementAsData(element);
+
+	} else if (iequals(tagName, xmlPrefix + "foreach")) {
+		std::vector<std::string> args;
+		args.push_back(ATTR(element, kXMLCharItem));
+		args.push_back(ATTR(element, kXMLCharArray));
+		args.push_back(HAS_ATTR(element, kXMLCharIndex) ? ATTR(element, kXMLCharIndex) : "");
+
+		size_t foreach = emit(program, OP_FOREACH, element);
+		program[foreach].args = args;
+		size_t next = emit(program, OP_FOREACH_NEXT, element);
+		program[next].args = args;
+
+		for (auto childElem = element->getFirstElementChild(); childElem; childElem = childElem->getNextElementSibling()) {
+			compileElement(childElem, program);
+		}
+
+		size_t loop = emit(program, OP_JUMP, element);
+		program[loop].jump = next;
+		program[next].jump = emit(program, OP_FOREACH_END, element);
+
+	} else if (iequals(tagName, xmlPrefix + "log")) {
+		size_t log = emit(program, OP_LOG, element);
+		std::string label = ATTR(element, kXMLCharLabel);
+		program[log].args.push_back(label.size() > 0 ? label + ": " : "");
+		program[log].expr = _callbacks->compile(ATTR(element, kXMLCharExpr));
+
+	} else if (iequals(tagName, xmlPrefix + "script")) {
+		// contents were already downloaded in setupDOM, see to SCXML rec 5.8
+		size_t script = emit(program, OP_SCRIPT, element);
+		program[script].expr = _callbacks->compile(DOMUtils::textContent(element));
+
+	} else if (Factory::getInstance()->hasExecutableContent(LOCALNAME(element), X(element->getNamespaceURI()))) {
+		// custom executable content, ask the factory about it!
+		ExecutableContent custom = _callbacks->createExecutableContent(LOCALNAME(element), X(element->getNamespaceURI()));
+
+		size_t enter = emit(program, OP_CUSTOM_ENTER, element);
+		program[enter].custom = custom;
+
+		if (custom.processChildren()) {
+			std::list<DOMNode*> childElems = DOMUtils::filterChildType(DOMNode::ELEMENT_NODE, element, false);
+			for(auto elemIter = childElems.begin(); elemIter != childElems.end(); elemIter++) {
+				compileElement(static_cast<DOMElement*>(*elemIter), program);
+			}
+		}
+
+		size_t exit = emit(program, OP_CUSTOM_EXIT, element);
+		program[exit].custom = custom;
+
+	} else {
+		size_t unknown = emit(program, OP_UNKNOWN, element);
+		program[unknown].args.push_back(tagName);
+	}
+}
+
+void CompiledContentExecutor::run(Program& program) {
+	// iteration and number of iterations of the enclosing foreach elements
+	std::vector<std::pair<uint32_t, uint32_t> > loops;
+	const MonitorSnapshot& monitors = _callbacks->getMonitors();
+
+	size_t pc = 0;
+	while (pc < program.size()) {
+		Instruction& instr = program[pc];
+		try {
+			switch (instr.opcode) {
+			case OP_JUMP:
+				pc = instr.jump;
+				continue;
+
+			case OP_IF:
+				USCXML_MONITOR_CALLBACK1(monitors, beforeExecutingContent, instr.element);
+			// fall through
+			case OP_ELSEIF:
+				if (!_callbacks->isTrue(*instr.expr)) {
+					pc = instr.jump;
+					continue;
+				}
+				break;
+
+			case OP_FOREACH:
+				USCXML_MONITOR_CALLBACK1(monitors, beforeExecutingContent, instr.element);
+				loops.push_back(std::make_pair(0, _callbacks->getLength(instr.args[1])));
+				break;
+
+			case OP_FOREACH_NEXT:
+				if (loops.back().first >= loops.back().second) {
+					loops.pop_back();
+					pc = instr.jump;
+					continue;
+				}
+				_callbacks->setForeach(instr.args[0], instr.args[1], instr.args[2], loops.back().first++);
+				break;
+
+			case OP_END_IF:
+			case OP_FOREACH_END:
+				USCXML_MONITOR_CALLBACK1(monitors, afterExecutingContent, instr.element);
+				break;
+
+			case OP_CUSTOM_ENTER:
+				USCXML_MONITOR_CALLBACK1(monitors, beforeExecutingContent, instr.element);
+				instr.custom.enterElement(instr.element);
+				break;
+
+			case OP_CUSTOM_EXIT:
+				instr.custom.exitElement(instr.element);
+				USCXML_MONITOR_CALLBACK1(monitors, afterExecutingContent, instr.element);
+				break;
+
+			default:
+				// all other instructions are executed at once
+				USCXML_MONITOR_CALLBACK1(monitors, beforeExecutingContent, instr.element);
+
+				switch (instr.opcode) {
+				case OP_RAISE:
+					_callbacks->enqueueInternal(Event(instr.args[0]));
+					break;
+				case OP_SEND:
+					processSend(instr.element);
+					break;
+				case OP_CANCEL:
+					processCancel(instr.element);
+					break;
+				case OP_ASSIGN:
+					_callbacks->assign(instr.args[0], instr.data.empty() ? elementAsData(instr.element) : instr.data, instr.attrs);
+					break;
+				case OP_LOG: {
+					Data d = _callbacks->evalAsData(*instr.expr);
+					// see issue113
+					_callbacks->getLogger().log(USCXML_LOG) << instr.args[0] << d << std::endl;
+					break;
+				}
+				case OP_SCRIPT:
+					_callbacks->eval(*instr.expr);
+					break;
+				default:
+					LOG(_callbacks->getLogger(), USCXML_ERROR) << instr.args[0] << std::endl;
+					assert(false);
+					break;
+				}
+
+				USCXML_MONITOR_CALLBACK1(monitors, afterExecutingContent, instr.element);
+				break;
+			}
+		} catch (ErrorEvent exc) {
+
+			Event e(exc);
+			_callbacks->enqueueInternal(e);
+			LOG(_callbacks->getLogger(), USCXML_ERROR) << exc << std::endl;
+			USCXML_MONITOR_CALLBACK1(monitors, afterExecutingContent, instr.element);
+
+			throw e; // will be catched in microstepper
+		}
+		pc++;
+	}
+}
+
+}
@@ -0,0 +1,99 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef COMPILEDCONTENTEXECUTOR_H_6F1D2A4C
+#define COMPILEDCONTENTEXECUTOR_H_6F1D2A4C
+
+#include "BasicContentExecutor.h"
+
+#include <vector>
+
+namespace uscxml {
+
+/**
+ * @ingroup execcontent
+ * @ingroup impl
+ *
+ * A content executor compiling blocks of executable content into a flat
+ * program on first execution.
+ *
+ * Tag names are dispatched, attributes read and expressions compiled only
+ * once per block, control flow of `if` and `foreach` are jumps in the
+ * program. Sending, invoking and done events are inherited from the
+ * BasicContentExecutor.
+ */
+class USCXML_API CompiledContentExecutor : public BasicContentExecutor {
+public:
+	CompiledContentExecutor(ContentExecutorCallbacks* callbacks) : BasicContentExecutor(callbacks) {}
+	virtual ~CompiledContentExecutor() {}
+
+	virtual std::shared_ptr<ContentExecutorImpl> create(ContentExecutorCallbacks* callbacks);
+
+	virtual void process(XERCESC_NS::DOMElement* block);
+
+protected:
+	enum Opcode {
+		OP_RAISE,
+		OP_SEND,
+		OP_CANCEL,
+		OP_IF,          ///< monitor and evaluate cond, jump if false
+		OP_ELSEIF,      ///< evaluate cond, jump if false
+		OP_END_IF,      ///< monitor
+		OP_ASSIGN,
+		OP_FOREACH,     ///< monitor and push the number of iterations
+		OP_FOREACH_NEXT,///< set item and index or pop and jump past the loop
+		OP_FOREACH_END, ///< monitor
+		OP_LOG,
+		OP_SCRIPT,
+		OP_CUSTOM_ENTER,
+		OP_CUSTOM_EXIT,
+		OP_JUMP,
+		OP_UNKNOWN
+	};
+
+	struct Instruction {
+		Instruction(Opcode opcode, XERCESC_NS::DOMElement* element) : opcode(opcode), element(element), jump(0) {}
+
+		Opcode opcode;
+		/// The element to report to monitors and in errors
+		XERCESC_NS::DOMElement* element;
+		size_t jump;
+		std::shared_ptr<CompiledExpression> expr;
+		std::vector<std::string> args;
+		std::map<std::string, std::string> attrs;
+		Data data;
+		ExecutableContent custom;
+	};
+	typedef std::vector<Instruction> Program;
+
+	void compile(XERCESC_NS::DOMElement* block, Program& program);
+	void compileElement(XERCESC_NS::DOMElement* element, Program& program);
+	void run(Program& program);
+
+	size_t emit(Program& program, Opcode opcode, XERCESC_NS::DOMElement* element) {
+		program.push_back(Instruction(opcode, element));
+		return program.size() - 1;
+	}
+
+	std::map<XERCESC_NS::DOMElement*, Program> _programs;
+};
+
+}
+
+#endif /* end of include guard: COMPILEDCONTENTEXECUTOR_H_6F1D2A4C */
@@ -39,6 +39,7 @@ class DOMNode;
 namespace uscxml {
 
 class X;
+class CompiledExpression;
 
 /**
  * @ingroup execcontent
@@ -52,6 +53,7 @@ public:
 	virtual void cancelDelayed(const std::string& eventId) = 0;
 
 	virtual bool isTrue(const std::string& expr) = 0;
+	virtual bool isTrue(CompiledExpression& expr) = 0;
 	virtual size_t getLength(const std::string& expr) = 0;
 
 	virtual void setForeach(const std::string& item,
@@ -60,7 +62,10 @@ public:
 	                        uint32_t iteration) = 0;
 
 	virtual Data evalAsData(const std::string& expr) = 0;
+	virtual Data evalAsData(CompiledExpression& expr) = 0;
 	virtual void eval(const std::string& expr) = 0;
+	virtual void eval(CompiledExpression& expr) = 0;
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr) = 0;
 	virtual Data getAsData(const std::string& expr) = 0;
 	virtual bool isLegalDataValue(const std::string& expr) = 0;
 	virtual void assign(const std::string& location, const Data& data, const std::map<std::string, std::string>& attrs) = 0;
@@ -76,7 +81,7 @@ public:
 	virtual const Event& getCurrentEvent() = 0;
 
 	/** Monitoring */
-	virtual std::set<InterpreterMonitor*> getMonitors() = 0;
+	virtual const MonitorSnapshot& getMonitors() = 0;
 	virtual const std::string& getSessionId() = 0;
 	virtual Logger getLogger() = 0;
 
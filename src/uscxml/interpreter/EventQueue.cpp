@@ -20,6 +20,7 @@
 #include "uscxml/Common.h"
 #include "EventQueue.h"
 #include "EventQueueImpl.h"
+#include "uscxml/debug/Benchmark.h"
 #include <string>
 #include <map>
 #include <list>
@@ -33,15 +34,34 @@
 namespace uscxml {
 
 Event EventQueue::dequeue(size_t blockMs) {
+	if (blockMs > 0) {
+		// waiting for an event would dominate the timing
+		return _impl->dequeue(blockMs);
+	}
+	USCXML_BENCHMARK("EventQueue: dequeue");
 	return _impl->dequeue(blockMs);
 }
 void EventQueue::enqueue(const Event& event) {
+	USCXML_BENCHMARK("EventQueue: enqueue");
 	return _impl->enqueue(event);
 }
 void EventQueue::reset() {
 	return _impl->reset();
 }
 
+void EventQueue::enqueueBatch(const std::list<Event>& events) {
+	USCXML_BENCHMARK("EventQueue: enqueueBatch");
+	return _impl->enqueueBatch(events);
+}
+size_t EventQueue::dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs) {
+	if (blockMs > 0) {
+		// as with dequeue, waiting would dominate the timing
+		return _impl->dequeueBatch(events, max, blockMs);
+	}
+	USCXML_BENCHMARK("EventQueue: dequeueBatch");
+	return _impl->dequeueBatch(events, max, blockMs);
+}
+
 Data EventQueue::serialize() {
 	return _impl->serialize();
 }
@@ -59,9 +79,11 @@ std::shared_ptr<EventQueueImpl> EventQueue::getImplBase() {
 PIMPL_OPERATORS_INHERIT_IMPL(DelayedEventQueue, EventQueue)
 
 void DelayedEventQueue::enqueueDelayed(const Event& event, size_t delayMs, const std::string& eventUUID) {
+	USCXML_BENCHMARK("DelayedEventQueue: enqueueDelayed");
 	_impl->enqueueDelayed(event, delayMs, eventUUID);
 }
 void DelayedEventQueue::cancelDelayed(const std::string& eventUUID) {
+	USCXML_BENCHMARK("DelayedEventQueue: cancelDelayed");
 	return _impl->cancelDelayed(eventUUID);
 }
 
@@ -23,6 +23,8 @@
 #include "uscxml/Common.h"
 #include "uscxml/messages/Event.h"
 
+#include <list>
+
 namespace uscxml {
 
 class EventQueueImpl;
@@ -40,6 +42,11 @@ public:
 	virtual void enqueue(const Event& event);
 	virtual void reset();
 
+	/// Append all events in order, taking the queue's lock only once
+	virtual void enqueueBatch(const std::list<Event>& events);
+	/// Move up to max events to the end of events, blocking only while there are none
+	virtual size_t dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs);
+
 	Data serialize();
 	void deserialize(const Data& data);
 
@@ -44,6 +44,29 @@ public:
 	virtual void reset() = 0;
 	virtual Data serialize() = 0;
 	virtual void deserialize(const Data& data) = 0;
+
+	/// Append all events in order with a single wakeup, defaults to enqueue() per event
+	virtual void enqueueBatch(const std::list<Event>& events) {
+		for (auto& event : events)
+			enqueue(event);
+	}
+
+	/**
+	 * Move up to max events to the end of the given list. Blocks as dequeue()
+	 * while the queue is empty and returns the number of events moved. The
+	 * default dequeue()s per event.
+	 */
+	virtual size_t dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs) {
+		size_t dequeued = 0;
+		while (dequeued < max) {
+			Event event = dequeue(dequeued == 0 ? blockMs : 0);
+			if (!event)
+				break;
+			events.push_back(event);
+			dequeued++;
+		}
+		return dequeued;
+	}
 };
 
 /**
@@ -26,10 +26,14 @@
 #include "uscxml/util/Predicates.h"
 #include "uscxml/util/Convenience.h"
 #include "uscxml/interpreter/InterpreterMonitor.h"
+#include "uscxml/debug/Benchmark.h"
+#include "uscxml/interpreter/InterpreterMetrics.h"
+#include "uscxml/interpreter/InterpreterTrace.h"
 
 #include "uscxml/interpreter/Logging.h"
 
 #include <stdlib.h> // strtol
+#include <algorithm>
 
 #undef USCXML_VERBOSE
 #undef WITH_CACHE_FILES
@@ -40,6 +44,9 @@
 #define BIT_SET_AT(idx, bitset) bitset[idx] = true;
 #define BIT_CLEAR(idx, bitset) bitset[idx] = false;
 
+// memory per session for the candidates of event names the chart did not intern
+#define USCXML_CANDIDATE_CACHE_BYTES 65536
+
 #define USCXML_GET_TRANS(i) (*_transitions[i])
 #define USCXML_GET_STATE(i) (*_states[i])
 
@@ -86,12 +93,25 @@ FastMicroStep::FastMicroStep(MicroStepCallbacks* callbacks)
 	: MicroStepImpl(callbacks), _flags(USCXML_CTX_PRISTINE), _isInitialized(false), _isCancelled(false) {
 }
 
+FastMicroStep::FastMicroStep(MicroStepCallbacks* callbacks, std::shared_ptr<const Chart> chart)
+	: MicroStepImpl(callbacks), _flags(USCXML_CTX_PRISTINE), _chart(chart), _isInitialized(false), _isCancelled(false) {
+}
+
 FastMicroStep::~FastMicroStep() {
-	for (size_t i = 0; i < _states.size(); i++) {
-		delete(_states[i]);
+}
+
+FastMicroStep::Chart::EventNode::~EventNode() {
+	for (auto child : children) {
+		delete child.second;
+	}
+}
+
+FastMicroStep::Chart::~Chart() {
+	for (size_t i = 0; i < states.size(); i++) {
+		delete(states[i]);
 	}
-	for (size_t i = 0; i < _transitions.size(); i++) {
-		delete(_transitions[i]);
+	for (size_t i = 0; i < transitions.size(); i++) {
+		delete(transitions[i]);
 	}
 }
 
@@ -113,6 +133,25 @@ void FastMicroStep::deserialize(const Data& encodedState) {
 	_history         = fromBase64(encodedState["histories"].atom);
 	_initializedData = fromBase64(encodedState["intializedData"].atom);
 
+	restoreInvocations();
+}
+
+void FastMicroStep::readSnapshot(SnapshotReader& reader) {
+	// a rejected snapshot must not leave us half restored
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> configuration   = readBitset(reader, USCXML_NUMBER_STATES);
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> invocations     = readBitset(reader, USCXML_NUMBER_STATES);
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> history         = readBitset(reader, USCXML_NUMBER_STATES);
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> initializedData = readBitset(reader, USCXML_NUMBER_STATES);
+
+	_configuration   = configuration;
+	_invocations     = invocations;
+	_history         = history;
+	_initializedData = initializedData;
+
+	restoreInvocations();
+}
+
+void FastMicroStep::restoreInvocations() {
 	for (size_t i = 0; i < USCXML_NUMBER_STATES; i++) {
 		if (BIT_HAS(i, _invocations) && USCXML_GET_STATE(i).invoke.size() > 0) {
 			for (auto invIter = USCXML_GET_STATE(i).invoke.begin(); invIter != USCXML_GET_STATE(i).invoke.end(); invIter++) {
@@ -138,6 +177,13 @@ Data FastMicroStep::serialize() {
 	return encodedState;
 }
 
+void FastMicroStep::writeSnapshot(SnapshotWriter& writer) {
+	writeBitset(writer, _configuration);
+	writeBitset(writer, _invocations);
+	writeBitset(writer, _history);
+	writeBitset(writer, _initializedData);
+}
+
 void FastMicroStep::resortStates(DOMElement* element, const X& xmlPrefix) {
 
 	/**
@@ -288,6 +334,7 @@ NEXT_ANCESTOR:
 }
 
 void FastMicroStep::init(XERCESC_NS::DOMElement* scxml) {
+	USCXML_BENCHMARK("FastMicroStep: init");
 
 	_scxml = scxml;
 	_binding = (HAS_ATTR(_scxml, kXMLCharBinding) && iequals(ATTR(_scxml, kXMLCharBinding), "late") ? LATE : EARLY);
@@ -297,36 +344,58 @@ void FastMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		_xmlPrefix = std::string(_xmlPrefix) + ":";
 	}
 
+	// compile unless we were given a chart for this document
+	if (!_chart || _chart->scxml != _scxml) {
+		compile();
+	}
+
+	_states = _chart->states;
+	_transitions = _chart->transitions;
+	_exitSets = _chart->exitSets;
+
+	_configuration.resize(_states.size());
+	_history.resize(_states.size());
+	_initializedData.resize(_states.size());
+	_invocations.resize(_states.size());
+
+	// initialize bitarrays for step()
+	_exitSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
+	_entrySet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
+	_targetSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
+	_tmpStates = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
+	_conflicts = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_transitions.size(), false);
+	_transSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_transitions.size(), false);
+	_conds.clear();
+	_conds.resize(_transitions.size());
+
+	_isInitialized = true;
+}
+
+void FastMicroStep::compile() {
+	std::shared_ptr<Chart> chart(new Chart());
+	chart->scxml = _scxml;
+
 	resortStates(_scxml, _xmlPrefix);
 
 #ifdef WITH_CACHE_FILES
-	bool withCache = !envVarIsTrue("USCXML_NOCACHE_FILES");
-	Data& cache = _callbacks->getCache().compound["FastMicroStep"];
+	Data noCache;
+	bool withCache = (_callbacks != NULL && !envVarIsTrue("USCXML_NOCACHE_FILES"));
+	Data& cache = (withCache ? _callbacks->getCache().compound["FastMicroStep"] : noCache);
 #endif
 
 	/** -- All things states -- */
 
+	// index the resorted states once instead of searching the DOM per state
+	ChartIndex index(_scxml);
+
 	std::list<XERCESC_NS::DOMElement*> tmp;
 	size_t i, j;
 
-	tmp = DOMUtils::inDocumentOrder({
-		_xmlPrefix.str() + "state",
-		_xmlPrefix.str() + "parallel",
-		_xmlPrefix.str() + "scxml",
-		_xmlPrefix.str() + "initial",
-		_xmlPrefix.str() + "final",
-		_xmlPrefix.str() + "history"
-	}, _scxml);
-
-	_states.resize(tmp.size());
-	_configuration.resize(tmp.size());
-	_history.resize(tmp.size());
-	_initializedData.resize(tmp.size());
-	_invocations.resize(tmp.size());
+	_states.resize(index.getStates().size());
 
 	for (i = 0; i < _states.size(); i++) {
 		_states[i] = new State(i);
-		_states[i]->element = tmp.front();
+		_states[i]->element = index.getStates()[i];
 		if (HAS_ATTR(_states[i]->element, kXMLCharId)) {
 			_states[i]->name = ATTR(_states[i]->element, kXMLCharId);
 		}
@@ -334,9 +403,7 @@ void FastMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		_states[i]->completion.resize(_states.size());
 		_states[i]->ancestors.resize(_states.size());
 		_states[i]->children.resize(_states.size());
-		tmp.pop_front();
 	}
-	assert(tmp.size() == 0);
 
 	if (_binding == Binding::EARLY && _states.size() > 0) {
 		// add all data elements to the first state
@@ -351,27 +418,20 @@ void FastMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		_states[0]->data = DOMUtils::filterChildElements(_xmlPrefix.str() + "data", dataModels, false);
 	}
 
-#ifdef WITH_CACHE_FILES
-	auto currState = cache.compound["states"].array.begin();
-	auto endState = cache.compound["states"].array.end();
-#endif
-
 	for (i = 0; i < _states.size(); i++) {
 #ifdef WITH_CACHE_FILES
 		Data* cachedState = NULL;
 		if (withCache) {
-			if (currState != endState) {
-				cachedState = &(*currState);
-				currState++;
-			} else {
-				cache.compound["states"].array.push_back(Data());
-				cachedState = &(*cache.compound["states"].array.rbegin());
-			}
+			// the array relocates when growing, only index into it
+			std::vector<Data>& cachedStates = cache.compound["states"].array;
+			if (cachedStates.size() <= i)
+				cachedStates.push_back(Data());
+			cachedState = &cachedStates[i];
 		}
 #endif
 		// collect states with an id attribute
 		if (HAS_ATTR(_states[i]->element, kXMLCharId)) {
-			_stateIds[ATTR(_states[i]->element, kXMLCharId)] = i;
+			chart->stateIds[ATTR(_states[i]->element, kXMLCharId)] = i;
 		}
 
 		// check for executable content and datamodels
@@ -433,16 +493,12 @@ void FastMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		}
 #endif
 		{
-			std::list<DOMElement*> completion = getCompletion(_states[i]->element);
-			for (j = 0; j < _states.size(); j++) {
-				if (!completion.empty() && _states[j]->element == completion.front()) {
-					_states[i]->completion[j] = true;
-					completion.pop_front();
-				} else {
-					_states[i]->completion[j] = false;
-				}
+			std::list<DOMElement*> completion = getCompletion(_states[i]->element, index);
+			for (auto state : completion) {
+				uint32_t order = index.getDocumentOrder(state);
+				if (order != ChartIndex::NONE)
+					_states[i]->completion[order] = true;
 			}
-			assert(completion.size() == 0);
 		}
 #ifdef WITH_CACHE_FILES
 		if (withCache)
@@ -466,29 +522,20 @@ COMPLETION_STABLISHED:
 #endif
 		}
 
-		// parent relation
-		DOMNode* parent = _states[i]->element->getParentNode();
-		if (parent && parent->getNodeType() == DOMNode::ELEMENT_NODE) {
-			State* uscxmlState = (State*)parent->getUserData(X("uscxmlState"));
-			// parent maybe a content element
-			if (uscxmlState != NULL) {
-				_states[i]->parent = uscxmlState->documentOrder;
-			}
+		// parent relation, the parent maybe a content element
+		uint32_t parent = index.getParent(i);
+		if (parent != ChartIndex::NONE) {
+			_states[i]->parent = parent;
 		}
 
 		// establish the states' ancestors
-		while(parent && parent->getNodeType() == DOMNode::ELEMENT_NODE) {
-			State* uscxmlState = (State*)parent->getUserData(X("uscxmlState"));
-
-			if (uscxmlState == NULL)
-				break;
-
+		while(parent != ChartIndex::NONE) {
 			// ancestors
-			BIT_SET_AT(uscxmlState->documentOrder, _states[i]->ancestors);
+			BIT_SET_AT(parent, _states[i]->ancestors);
 
 			// children
-			BIT_SET_AT(i, uscxmlState->children);
-			parent = parent->getParentNode();
+			BIT_SET_AT(i, _states[parent]->children);
+			parent = index.getParent(parent);
 		}
 	}
 
@@ -521,23 +568,16 @@ COMPLETION_STABLISHED:
 	}
 	assert(tmp.size() == 0);
 
-#ifdef WITH_CACHE_FILES
-	auto currTrans = cache.compound["transitions"].array.begin();
-	auto endTrans = cache.compound["transitions"].array.end();
-#endif
-
 	for (i = 0; i < _transitions.size(); i++) {
 
 #ifdef WITH_CACHE_FILES
 		Data* cachedTrans = NULL;
 		if (withCache) {
-			if (currTrans != endTrans) {
-				cachedTrans = &(*currTrans);
-				currTrans++;
-			} else {
-				cache.compound["transitions"].array.push_back(Data());
-				cachedTrans = &(*cache.compound["transitions"].array.rbegin());
-			}
+			// the array relocates when growing, only index into it
+			std::vector<Data>& cachedTransitions = cache.compound["transitions"].array;
+			if (cachedTransitions.size() <= i)
+				cachedTransitions.push_back(Data());
+			cachedTrans = &cachedTransitions[i];
 		}
 #endif
 
@@ -556,8 +596,8 @@ COMPLETION_STABLISHED:
 		{
 			std::list<std::string> targets = tokenize(ATTR(_transitions[i]->element, kXMLCharTarget));
 			for (auto tIter = targets.begin(); tIter != targets.end(); tIter++) {
-				if (_stateIds.find(*tIter) != _stateIds.end()) {
-					_transitions[i]->target[_stateIds[*tIter]] = true;
+				if (chart->stateIds.find(*tIter) != chart->stateIds.end()) {
+					_transitions[i]->target[chart->stateIds[*tIter]] = true;
 				}
 			}
 		}
@@ -614,6 +654,49 @@ TARGET_SET_ESTABLISHED:
 		}
 	}
 
+	/** -- Index transitions by their event descriptors -- */
+
+	chart->events.transitions.resize(_transitions.size());
+	chart->wildcardTransitions.resize(_transitions.size());
+	chart->eventlessTransitions.resize(_transitions.size());
+
+	for (i = 0; i < _transitions.size(); i++) {
+		/* never select history or initial transitions automatically */
+		if (_transitions[i]->type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL))
+			continue;
+
+		if (_transitions[i]->event.size() == 0) {
+			chart->eventlessTransitions[i] = true;
+			continue;
+		}
+
+		EventDescriptor eventDesc(_transitions[i]->event);
+		if (eventDesc.isWildcard())
+			chart->wildcardTransitions[i] = true;
+
+		for (auto& desc : eventDesc.getDescriptors()) {
+			Chart::EventNode* node = &chart->events;
+			for (auto token : desc.tokens) {
+				if (node->children.find(token) == node->children.end()) {
+					node->children[token] = new Chart::EventNode();
+					node->children[token]->transitions.resize(_transitions.size());
+				}
+				node = node->children[token];
+			}
+			node->transitions[i] = true;
+
+			if (chart->eventsCaseless.find(desc.caseless) == chart->eventsCaseless.end())
+				chart->eventsCaseless[desc.caseless].resize(_transitions.size());
+			chart->eventsCaseless[desc.caseless][i] = true;
+		}
+	}
+
+	// resolve the events the document itself raises, sends or waits for once
+	std::set<uint32_t> eventIds = internEventNames(_scxml, _xmlPrefix.str());
+	for (auto eventId : eventIds) {
+		chart->matchCandidates(EventName::forId(eventId), chart->internedCandidates[eventId]);
+	}
+
 	/**
 	 * This bound by cache locality!
 	 * Before you change anything, do benchmark!
@@ -749,16 +832,10 @@ CONFLICTING_TRANS:
 	}
 #endif
 
-	// initialize bitarrays for step()
-	_exitSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
-	_entrySet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
-	_targetSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
-	_tmpStates = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_states.size(), false);
-	_conflicts = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_transitions.size(), false);
-	_transSet = boost::dynamic_bitset<BITSET_BLOCKTYPE>(_transitions.size(), false);
-
-	_isInitialized = true;
-
+	chart->states = _states;
+	chart->transitions = _transitions;
+	chart->exitSets = _exitSets;
+	_chart = chart;
 }
 
 std::string FastMicroStep::toBase64(const boost::dynamic_bitset<BITSET_BLOCKTYPE>& bitset) {
@@ -790,6 +867,86 @@ boost::dynamic_bitset<BITSET_BLOCKTYPE> FastMicroStep::fromBase64(const std::str
 	return bitset;
 }
 
+void FastMicroStep::writeBitset(SnapshotWriter& writer, const boost::dynamic_bitset<BITSET_BLOCKTYPE>& bitset) {
+	std::vector<boost::dynamic_bitset<BITSET_BLOCKTYPE>::block_type> blocks(bitset.num_blocks());
+	boost::to_block_range(bitset, blocks.begin());
+
+	writer.writeVarint(bitset.size());
+	writer.writeBytes(blocks.data(), blocks.size() * sizeof(boost::dynamic_bitset<BITSET_BLOCKTYPE>::block_type));
+}
+
+boost::dynamic_bitset<BITSET_BLOCKTYPE> FastMicroStep::readBitset(SnapshotReader& reader, size_t expectedBits) {
+	// check the untrusted size before allocating anything
+	size_t nrBits = reader.readVarint();
+	if (nrBits != expectedBits) {
+		ERROR_PLATFORM_THROW("Snapshot does not match the number of states");
+	}
+
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> bitset(nrBits);
+	size_t size = reader.readVarint();
+	if (size != bitset.num_blocks() * sizeof(boost::dynamic_bitset<BITSET_BLOCKTYPE>::block_type)) {
+		ERROR_PLATFORM_THROW("Malformed bitset in snapshot");
+	}
+	const char* data = reader.readBytes(size);
+
+	// the buffer may not be aligned for the block type
+	std::vector<boost::dynamic_bitset<BITSET_BLOCKTYPE>::block_type> blocks(bitset.num_blocks());
+	memcpy(blocks.data(), data, size);
+	boost::from_block_range(blocks.begin(), blocks.end(), bitset);
+	return bitset;
+}
+
+void FastMicroStep::Chart::matchCandidates(const EventName& name, boost::dynamic_bitset<BITSET_BLOCKTYPE>& candidates) const {
+	candidates = wildcardTransitions;
+
+	// every descriptor that is a token-wise prefix of the event name matches
+	const EventNode* node = &events;
+	for (auto token : name.getTokens()) {
+		auto childIter = node->children.find(token);
+		if (childIter == node->children.end())
+			break;
+		node = childIter->second;
+		candidates |= node->transitions;
+	}
+
+	// or equals it ignoring case
+	auto caselessIter = eventsCaseless.find(name.getCaseless());
+	if (caselessIter != eventsCaseless.end())
+		candidates |= caselessIter->second;
+}
+
+const boost::dynamic_bitset<BITSET_BLOCKTYPE>& FastMicroStep::getCandidates(const Event& event) {
+	if (event.nameId != 0) {
+		auto internedIter = _chart->internedCandidates.find(event.nameId);
+		if (internedIter != _chart->internedCandidates.end())
+			return internedIter->second;
+	}
+
+	auto candIter = _candidates.find(event.name);
+	if (candIter != _candidates.end())
+		return candIter->second;
+
+	// do not grow without bounds with generated event names, every entry holds a bit per transition
+	size_t maxCandidates = std::min((size_t)1024, std::max((size_t)8, USCXML_CANDIDATE_CACHE_BYTES * 8 / (_transitions.size() + 1)));
+	if (_candidates.size() >= maxCandidates)
+		_candidates.clear();
+
+	boost::dynamic_bitset<BITSET_BLOCKTYPE>& candidates = _candidates[event.name];
+	if (event.nameId != 0) {
+		_chart->matchCandidates(EventName::forId(event.nameId), candidates);
+	} else {
+		_chart->matchCandidates(EventName(event.name), candidates);
+	}
+	return candidates;
+}
+
+CompiledExpression& FastMicroStep::getCond(size_t transition) {
+	// the datamodel is not yet available in init
+	if (!_conds[transition])
+		_conds[transition] = _callbacks->compile(USCXML_GET_TRANS(transition).cond);
+	return *_conds[transition];
+}
+
 void FastMicroStep::markAsCancelled() {
 	_isCancelled = true;
 }
@@ -800,7 +957,9 @@ InterpreterState FastMicroStep::step(size_t blockMs) {
 		return USCXML_INITIALIZED;
 	}
 
-	std::set<InterpreterMonitor*> monitors = _callbacks->getMonitors();
+	const MonitorSnapshot& monitors = _callbacks->getMonitors();
+	InterpreterMetrics* metrics = _callbacks->getMetrics();
+	InterpreterTrace* trace = _callbacks->getTrace();
 	size_t i, j, k;
 
 	_exitSet.reset();
@@ -829,6 +988,7 @@ InterpreterState FastMicroStep::step(size_t blockMs) {
 				/* call all on exit handlers */
 				for (auto exitIter = USCXML_GET_STATE(i).onExit.begin(); exitIter != USCXML_GET_STATE(i).onExit.end(); exitIter++) {
 					try {
+						InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_EXIT, i);
 						_callbacks->process(*exitIter);
 					} catch (...) {
 						// do nothing and continue with next block
@@ -938,21 +1098,20 @@ SELECT_TRANSITIONS:
 	// we read an event - unset stable to signal onstable again later
 	_flags &= ~USCXML_CTX_STABLE;
 
-	for (i = 0; i < _transitions.size(); i++) {
-		/* never select history or initial transitions automatically */
-		if unlikely(USCXML_GET_TRANS(i).type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL))
-			continue;
+	{
+		USCXML_BENCHMARK("FastMicroStep: select transitions");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::SELECT);
+
+		/* only consider transitions that match the event, history and initial transitions are never candidates */
+		const boost::dynamic_bitset<BITSET_BLOCKTYPE>& candidates = (_event ? getCandidates(_event) : _chart->eventlessTransitions);
 
-		/* is the transition active? */
-		if (BIT_HAS(USCXML_GET_TRANS(i).source, _configuration)) {
-			/* is it non-conflicting? */
-			if (!BIT_HAS(i, _conflicts)) {
-				/* is it spontaneous with an event or vice versa? */
-				if ((USCXML_GET_TRANS(i).event.size() == 0 && !_event) ||
-				        (USCXML_GET_TRANS(i).event.size() != 0 && _event)) {
+		for (i = candidates.find_first(); i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos; i = candidates.find_next(i)) {
+			/* is the transition active? */
+			if (BIT_HAS(USCXML_GET_TRANS(i).source, _configuration)) {
+				/* is it non-conflicting? */
+				if (!BIT_HAS(i, _conflicts)) {
 					/* is it enabled? */
-					if ((!_event || _callbacks->isMatched(_event, USCXML_GET_TRANS(i).event)) &&
-					        (USCXML_GET_TRANS(i).cond.size() == 0 || _callbacks->isTrue(USCXML_GET_TRANS(i).cond))) {
+					if (USCXML_GET_TRANS(i).cond.size() == 0 || _callbacks->isTrue(getCond(i))) {
 
 						/* remember that we found a transition */
 						_flags |= USCXML_CTX_TRANSITION_FOUND;
@@ -1013,187 +1172,212 @@ SELECT_TRANSITIONS:
 
 
 	/* REMEMBER_HISTORY: */
-	for (i = 0; i < _states.size(); i++) {
-		if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_SHALLOW ||
-		            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP) {
-			/* a history state whose parent is about to be exited */
-			if unlikely(BIT_HAS(USCXML_GET_STATE(i).parent, _exitSet)) {
-				_tmpStates = USCXML_GET_STATE(i).completion;
+	{
+		USCXML_BENCHMARK("FastMicroStep: remember history");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::EXIT);
+
+		for (i = 0; i < _states.size(); i++) {
+			if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_SHALLOW ||
+			            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP) {
+				/* a history state whose parent is about to be exited */
+				if unlikely(BIT_HAS(USCXML_GET_STATE(i).parent, _exitSet)) {
+					_tmpStates = USCXML_GET_STATE(i).completion;
 
-				/* set those states who were enabled */
-				_tmpStates &= _configuration;
+					/* set those states who were enabled */
+					_tmpStates &= _configuration;
 
-				/* clear current history with completion mask */
-				_history &= ~(USCXML_GET_STATE(i).completion);
+					/* clear current history with completion mask */
+					_history &= ~(USCXML_GET_STATE(i).completion);
 
-				/* set history */
-				_history |= _tmpStates;
+					/* set history */
+					_history |= _tmpStates;
 
+				}
 			}
 		}
 	}
 
 ESTABLISH_ENTRYSET:
-	/* calculate new entry set */
-	_entrySet = _targetSet;
+	{
+		USCXML_BENCHMARK("FastMicroStep: establish entry set");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::ENTRY);
 
-	/* iterate for ancestors */
-	i = _entrySet.find_first();
-	while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
-		_entrySet |= USCXML_GET_STATE(i).ancestors;
-		i = _entrySet.find_next(i);
-	}
-
-	/* iterate for descendants */
-	i = _entrySet.find_first();
-	while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+		/* calculate new entry set */
+		_entrySet = _targetSet;
 
-		switch (USCXML_STATE_MASK(USCXML_GET_STATE(i).type)) {
-		case USCXML_STATE_FINAL:
-		case USCXML_STATE_ATOMIC:
-			break;
-
-		case USCXML_STATE_PARALLEL: {
-			_entrySet |= USCXML_GET_STATE(i).completion;
-			break;
+		/* iterate for ancestors */
+		i = _entrySet.find_first();
+		while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+			_entrySet |= USCXML_GET_STATE(i).ancestors;
+			i = _entrySet.find_next(i);
 		}
 
-		case USCXML_STATE_HISTORY_SHALLOW:
-		case USCXML_STATE_HISTORY_DEEP: {
-			if (!BIT_HAS_AND(USCXML_GET_STATE(i).completion, _history) &&
-			        !BIT_HAS(USCXML_GET_STATE(i).parent, _configuration)) {
+		/* iterate for descendants */
+		i = _entrySet.find_first();
+		while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
 
-				/* nothing set for history, look for a default transition */
-				for (j = 0; j < _transitions.size(); j++) {
-					if unlikely(USCXML_GET_TRANS(j).source == i) {
-						_entrySet |= USCXML_GET_TRANS(j).target;
+			switch (USCXML_STATE_MASK(USCXML_GET_STATE(i).type)) {
+			case USCXML_STATE_FINAL:
+			case USCXML_STATE_ATOMIC:
+				break;
 
-						if(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP &&
-						        !BIT_HAS_AND(USCXML_GET_TRANS(j).target, USCXML_GET_STATE(i).children)) {
-							for (k = i + 1; k < _states.size(); k++) {
-								if (BIT_HAS(k, USCXML_GET_TRANS(j).target)) {
-									_entrySet |= USCXML_GET_STATE(k).ancestors;
-									break;
+			case USCXML_STATE_PARALLEL: {
+				_entrySet |= USCXML_GET_STATE(i).completion;
+				break;
+			}
+
+			case USCXML_STATE_HISTORY_SHALLOW:
+			case USCXML_STATE_HISTORY_DEEP: {
+				if (!BIT_HAS_AND(USCXML_GET_STATE(i).completion, _history) &&
+				        !BIT_HAS(USCXML_GET_STATE(i).parent, _configuration)) {
+
+					/* nothing set for history, look for a default transition */
+					for (j = 0; j < _transitions.size(); j++) {
+						if unlikely(USCXML_GET_TRANS(j).source == i) {
+							_entrySet |= USCXML_GET_TRANS(j).target;
+
+							if(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP &&
+							        !BIT_HAS_AND(USCXML_GET_TRANS(j).target, USCXML_GET_STATE(i).children)) {
+								for (k = i + 1; k < _states.size(); k++) {
+									if (BIT_HAS(k, USCXML_GET_TRANS(j).target)) {
+										_entrySet |= USCXML_GET_STATE(k).ancestors;
+										break;
+									}
 								}
 							}
+							BIT_SET_AT(j, _transSet);
+							break;
 						}
-						BIT_SET_AT(j, _transSet);
-						break;
+						/* Note: SCXML mandates every history to have a transition! */
 					}
-					/* Note: SCXML mandates every history to have a transition! */
-				}
-			} else {
-				_tmpStates = USCXML_GET_STATE(i).completion;
-				_tmpStates &= _history;
-				_entrySet |= _tmpStates;
-
-				if (USCXML_GET_STATE(i).type == (USCXML_STATE_HAS_HISTORY | USCXML_STATE_HISTORY_DEEP)) {
-					/* a deep history state with nested histories -> more completion */
-					for (j = i + 1; j < USCXML_NUMBER_STATES; j++) {
-						if (BIT_HAS(j, USCXML_GET_STATE(i).completion) &&
-						        BIT_HAS(j, _entrySet) &&
-						        (USCXML_GET_STATE(j).type & USCXML_STATE_HAS_HISTORY)) {
-							for (k = j + 1; k < USCXML_NUMBER_STATES; k++) {
-								/* add nested history to entry_set */
-								if ((USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_HISTORY_DEEP ||
-								        USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_HISTORY_SHALLOW) &&
-								        BIT_HAS(k, USCXML_GET_STATE(j).children)) {
-									/* a nested history state */
-									BIT_SET_AT(k, _entrySet);
+				} else {
+					_tmpStates = USCXML_GET_STATE(i).completion;
+					_tmpStates &= _history;
+					_entrySet |= _tmpStates;
+
+					if (USCXML_GET_STATE(i).type == (USCXML_STATE_HAS_HISTORY | USCXML_STATE_HISTORY_DEEP)) {
+						/* a deep history state with nested histories -> more completion */
+						for (j = i + 1; j < USCXML_NUMBER_STATES; j++) {
+							if (BIT_HAS(j, USCXML_GET_STATE(i).completion) &&
+							        BIT_HAS(j, _entrySet) &&
+							        (USCXML_GET_STATE(j).type & USCXML_STATE_HAS_HISTORY)) {
+								for (k = j + 1; k < USCXML_NUMBER_STATES; k++) {
+									/* add nested history to entry_set */
+									if ((USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_HISTORY_DEEP ||
+									        USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_HISTORY_SHALLOW) &&
+									        BIT_HAS(k, USCXML_GET_STATE(j).children)) {
+										/* a nested history state */
+										BIT_SET_AT(k, _entrySet);
+									}
 								}
 							}
 						}
 					}
 				}
+				break;
 			}
-			break;
-		}
 
-		case USCXML_STATE_INITIAL: {
-			for (j = 0; j < USCXML_NUMBER_TRANS; j++) {
-				if (USCXML_GET_TRANS(j).source == i) {
-					BIT_SET_AT(j, _transSet);
-					BIT_CLEAR(i, _entrySet);
-					_entrySet |= USCXML_GET_TRANS(j).target;
-					for (k = i + 1; k < USCXML_NUMBER_STATES; k++) {
-						if (BIT_HAS(k, USCXML_GET_TRANS(j).target)) {
-							_entrySet |= USCXML_GET_STATE(k).ancestors;
+			case USCXML_STATE_INITIAL: {
+				for (j = 0; j < USCXML_NUMBER_TRANS; j++) {
+					if (USCXML_GET_TRANS(j).source == i) {
+						BIT_SET_AT(j, _transSet);
+						BIT_CLEAR(i, _entrySet);
+						_entrySet |= USCXML_GET_TRANS(j).target;
+						for (k = i + 1; k < USCXML_NUMBER_STATES; k++) {
+							if (BIT_HAS(k, USCXML_GET_TRANS(j).target)) {
+								_entrySet |= USCXML_GET_STATE(k).ancestors;
+							}
 						}
 					}
 				}
+				break;
 			}
-			break;
-		}
-		case USCXML_STATE_COMPOUND: { /* we need to check whether one child is already in entry_set */
-			if (!BIT_HAS_AND(_entrySet, USCXML_GET_STATE(i).children) &&
-			        (!BIT_HAS_AND(_configuration, USCXML_GET_STATE(i).children) ||
-			         BIT_HAS_AND(_exitSet, USCXML_GET_STATE(i).children))) {
-				_entrySet |= USCXML_GET_STATE(i).completion;
-				if (!BIT_HAS_AND(USCXML_GET_STATE(i).completion, USCXML_GET_STATE(i).children)) {
-					/* deep completion */
-					for (j = i + 1; j < USCXML_NUMBER_STATES; j++) {
-						if (BIT_HAS(j, USCXML_GET_STATE(i).completion)) {
-							_entrySet |= USCXML_GET_STATE(j).ancestors;
-							break; /* completion of compound is single state */
+			case USCXML_STATE_COMPOUND: { /* we need to check whether one child is already in entry_set */
+				if (!BIT_HAS_AND(_entrySet, USCXML_GET_STATE(i).children) &&
+				        (!BIT_HAS_AND(_configuration, USCXML_GET_STATE(i).children) ||
+				         BIT_HAS_AND(_exitSet, USCXML_GET_STATE(i).children))) {
+					_entrySet |= USCXML_GET_STATE(i).completion;
+					if (!BIT_HAS_AND(USCXML_GET_STATE(i).completion, USCXML_GET_STATE(i).children)) {
+						/* deep completion */
+						for (j = i + 1; j < USCXML_NUMBER_STATES; j++) {
+							if (BIT_HAS(j, USCXML_GET_STATE(i).completion)) {
+								_entrySet |= USCXML_GET_STATE(j).ancestors;
+								break; /* completion of compound is single state */
+							}
 						}
 					}
 				}
+				break;
 			}
-			break;
-		}
-		}
-		i = _entrySet.find_next(i);
+			}
+			i = _entrySet.find_next(i);
 
+		}
 	}
 
-
 #ifdef USCXML_VERBOSE
 	std::cerr << "Transitions: " << transSet << std::endl;
 #endif
 
 	/* EXIT_STATES: */
-	/* we cannot use find_first due to ordering */
-	i = USCXML_NUMBER_STATES;
-	while(i-- > 0) {
-		if (BIT_HAS(i, _exitSet) && BIT_HAS(i, _configuration)) {
+	{
+		USCXML_BENCHMARK("FastMicroStep: exit states");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::EXIT);
 
-			USCXML_MONITOR_CALLBACK2(monitors, beforeExitingState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
+		/* we cannot use find_first due to ordering */
+		i = USCXML_NUMBER_STATES;
+		while(i-- > 0) {
+			if (BIT_HAS(i, _exitSet) && BIT_HAS(i, _configuration)) {
 
-			/* call all on exit handlers */
-			for (auto exitIter = USCXML_GET_STATE(i).onExit.begin(); exitIter != USCXML_GET_STATE(i).onExit.end(); exitIter++) {
-				try {
-					_callbacks->process(*exitIter);
-				} catch (...) {
-					// do nothing and continue with next block
+				USCXML_MONITOR_CALLBACK2(monitors, beforeExitingState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
+				if (trace)
+					trace->record(InterpreterTrace::EXIT_STATE, i);
+
+				/* call all on exit handlers */
+				for (auto exitIter = USCXML_GET_STATE(i).onExit.begin(); exitIter != USCXML_GET_STATE(i).onExit.end(); exitIter++) {
+					try {
+						InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_EXIT, i);
+						_callbacks->process(*exitIter);
+					} catch (...) {
+						// do nothing and continue with next block
+					}
 				}
-			}
-			BIT_CLEAR(i, _configuration);
+				BIT_CLEAR(i, _configuration);
 
-			USCXML_MONITOR_CALLBACK2(monitors, afterExitingState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
+				USCXML_MONITOR_CALLBACK2(monitors, afterExitingState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
 
+			}
 		}
 	}
 
 	/* TAKE_TRANSITIONS: */
-	i = _transSet.find_first();
-	while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
-		if ((USCXML_GET_TRANS(i).type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL)) == 0) {
-			USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, USCXML_GET_TRANS(i).element);
+	{
+		USCXML_BENCHMARK("FastMicroStep: take transitions");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::TRANSITIONS);
+
+		i = _transSet.find_first();
+		while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+			if ((USCXML_GET_TRANS(i).type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL)) == 0) {
+				USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, USCXML_GET_TRANS(i).element);
+				if (trace)
+					trace->record(InterpreterTrace::TAKE_TRANSITION, i);
 
-			if (USCXML_GET_TRANS(i).onTrans != NULL) {
+				if (USCXML_GET_TRANS(i).onTrans != NULL) {
 
-				/* call executable content in non-history, non-initial transition */
-				try {
-					_callbacks->process(USCXML_GET_TRANS(i).onTrans);
-				} catch (...) {
-					// do nothing and continue with next block
+					/* call executable content in non-history, non-initial transition */
+					try {
+						InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_TRANSITION, i);
+						_callbacks->process(USCXML_GET_TRANS(i).onTrans);
+					} catch (...) {
+						// do nothing and continue with next block
+					}
 				}
-			}
 
-			USCXML_MONITOR_CALLBACK1(monitors, afterTakingTransition, USCXML_GET_TRANS(i).element);
+				USCXML_MONITOR_CALLBACK1(monitors, afterTakingTransition, USCXML_GET_TRANS(i).element);
 
+			}
+			i = _transSet.find_next(i);
 		}
-		i = _transSet.find_next(i);
 	}
 
 #ifdef USCXML_VERBOSE
@@ -1203,111 +1387,123 @@ ESTABLISH_ENTRYSET:
 
 
 	/* ENTER_STATES: */
-	i = _entrySet.find_first();
-	while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+	{
+		USCXML_BENCHMARK("FastMicroStep: enter states");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::ENTRY);
 
-		if (BIT_HAS(i, _configuration)) {
-			// already active
-			i = _entrySet.find_next(i);
-			continue;
-		}
+		i = _entrySet.find_first();
+		while(i != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
 
-		/* these are no proper states */
-		if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP ||
-		            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_SHALLOW ||
-		            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_INITIAL) {
-			i = _entrySet.find_next(i);
-			continue;
-		}
+			if (BIT_HAS(i, _configuration)) {
+				// already active
+				i = _entrySet.find_next(i);
+				continue;
+			}
 
-		USCXML_MONITOR_CALLBACK2(monitors, beforeEnteringState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
+			/* these are no proper states */
+			if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_DEEP ||
+			            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_HISTORY_SHALLOW ||
+			            USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_INITIAL) {
+				i = _entrySet.find_next(i);
+				continue;
+			}
 
-		BIT_SET_AT(i, _configuration);
+			USCXML_MONITOR_CALLBACK2(monitors, beforeEnteringState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
+			if (trace)
+				trace->record(InterpreterTrace::ENTER_STATE, i);
 
-		/* initialize data */
-		if (!BIT_HAS(i, _initializedData)) {
-			for (auto dataIter = USCXML_GET_STATE(i).data.begin(); dataIter != USCXML_GET_STATE(i).data.end(); dataIter++) {
-				_callbacks->initData(*dataIter);
-			}
-			BIT_SET_AT(i, _initializedData);
-		}
+			BIT_SET_AT(i, _configuration);
 
-		/* call all on entry handlers */
-		for (auto entryIter = USCXML_GET_STATE(i).onEntry.begin(); entryIter != USCXML_GET_STATE(i).onEntry.end(); entryIter++) {
-			try {
-				_callbacks->process(*entryIter);
-			} catch (...) {
-				// do nothing and continue with next block
+			/* initialize data */
+			if (!BIT_HAS(i, _initializedData)) {
+				for (auto dataIter = USCXML_GET_STATE(i).data.begin(); dataIter != USCXML_GET_STATE(i).data.end(); dataIter++) {
+					_callbacks->initData(*dataIter);
+				}
+				BIT_SET_AT(i, _initializedData);
 			}
-		}
-
-		USCXML_MONITOR_CALLBACK2(monitors, afterEnteringState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
 
-		/* take history and initial transitions */
-		j = _transSet.find_first();
-		while(j != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
-			if unlikely((USCXML_GET_TRANS(j).type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL)) &&
-			            USCXML_GET_STATE(USCXML_GET_TRANS(j).source).parent == i) {
+			/* call all on entry handlers */
+			for (auto entryIter = USCXML_GET_STATE(i).onEntry.begin(); entryIter != USCXML_GET_STATE(i).onEntry.end(); entryIter++) {
+				try {
+					InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_ENTRY, i);
+					_callbacks->process(*entryIter);
+				} catch (...) {
+					// do nothing and continue with next block
+				}
+			}
 
-				USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, USCXML_GET_TRANS(j).element);
+			USCXML_MONITOR_CALLBACK2(monitors, afterEnteringState, USCXML_GET_STATE(i).name, USCXML_GET_STATE(i).element);
 
-				/* call executable content in transition */
-				if (USCXML_GET_TRANS(j).onTrans != NULL) {
-					try {
-						_callbacks->process(USCXML_GET_TRANS(j).onTrans);
-					} catch (...) {
-						// do nothing and continue with next block
+			/* take history and initial transitions */
+			j = _transSet.find_first();
+			while(j != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+				if unlikely((USCXML_GET_TRANS(j).type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL)) &&
+				            USCXML_GET_STATE(USCXML_GET_TRANS(j).source).parent == i) {
+
+					USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, USCXML_GET_TRANS(j).element);
+					if (trace)
+						trace->record(InterpreterTrace::TAKE_TRANSITION, j);
+
+					/* call executable content in transition */
+					if (USCXML_GET_TRANS(j).onTrans != NULL) {
+						try {
+							InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_TRANSITION, j);
+							_callbacks->process(USCXML_GET_TRANS(j).onTrans);
+						} catch (...) {
+							// do nothing and continue with next block
+						}
 					}
+
+					USCXML_MONITOR_CALLBACK1(monitors, afterTakingTransition, USCXML_GET_TRANS(j).element);
 				}
 
-				USCXML_MONITOR_CALLBACK1(monitors, afterTakingTransition, USCXML_GET_TRANS(j).element);
+				j = _transSet.find_next(j);
 			}
 
-			j = _transSet.find_next(j);
-		}
-
-		/* handle final states */
-		if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_FINAL) {
-			if unlikely(USCXML_GET_STATE(i).ancestors.count() == 1 && BIT_HAS(0, USCXML_GET_STATE(i).ancestors)) {
-				// only the topmost scxml is an ancestor
-				_flags |= USCXML_CTX_TOP_LEVEL_FINAL;
-			} else {
-				/* raise done event */
-				_callbacks->raiseDoneEvent(USCXML_GET_STATE(USCXML_GET_STATE(i).parent).element, USCXML_GET_STATE(i).doneData);
-			}
+			/* handle final states */
+			if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(i).type) == USCXML_STATE_FINAL) {
+				if unlikely(USCXML_GET_STATE(i).ancestors.count() == 1 && BIT_HAS(0, USCXML_GET_STATE(i).ancestors)) {
+					// only the topmost scxml is an ancestor
+					_flags |= USCXML_CTX_TOP_LEVEL_FINAL;
+				} else {
+					/* raise done event */
+					_callbacks->raiseDoneEvent(USCXML_GET_STATE(USCXML_GET_STATE(i).parent).element, USCXML_GET_STATE(i).doneData);
+				}
 
-			/**
-			 * are we the last final state to leave a parallel state?:
-			 * 1. Gather all parallel states in our ancestor chain
-			 * 2. Find all states for which these parallels are ancestors
-			 * 3. Iterate all active final states and remove their ancestors
-			 * 4. If a state remains, not all children of a parallel are final
-			 */
-			j = USCXML_GET_STATE(i).ancestors.find_first();
-			while(j != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
-				if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(j).type) == USCXML_STATE_PARALLEL) {
-					_tmpStates.reset();
-					k = _configuration.find_first();
-					while (k != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
-						if (BIT_HAS(j, USCXML_GET_STATE(k).ancestors)) {
-							if (USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_FINAL) {
-								_tmpStates ^= USCXML_GET_STATE(k).ancestors;
-							} else {
-								BIT_SET_AT(k, _tmpStates);
+				/**
+				 * are we the last final state to leave a parallel state?:
+				 * 1. Gather all parallel states in our ancestor chain
+				 * 2. Find all states for which these parallels are ancestors
+				 * 3. Iterate all active final states and remove their ancestors
+				 * 4. If a state remains, not all children of a parallel are final
+				 */
+				j = USCXML_GET_STATE(i).ancestors.find_first();
+				while(j != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+					if unlikely(USCXML_STATE_MASK(USCXML_GET_STATE(j).type) == USCXML_STATE_PARALLEL) {
+						_tmpStates.reset();
+						k = _configuration.find_first();
+						while (k != boost::dynamic_bitset<BITSET_BLOCKTYPE>::npos) {
+							if (BIT_HAS(j, USCXML_GET_STATE(k).ancestors)) {
+								if (USCXML_STATE_MASK(USCXML_GET_STATE(k).type) == USCXML_STATE_FINAL) {
+									_tmpStates ^= USCXML_GET_STATE(k).ancestors;
+								} else {
+									BIT_SET_AT(k, _tmpStates);
+								}
 							}
+							k = _configuration.find_next(k);
+						}
+						if (!_tmpStates.any()) {
+							// raise done for state j
+							_callbacks->raiseDoneEvent(USCXML_GET_STATE(j).element, USCXML_GET_STATE(j).doneData);
 						}
-						k = _configuration.find_next(k);
-					}
-					if (!_tmpStates.any()) {
-						// raise done for state j
-						_callbacks->raiseDoneEvent(USCXML_GET_STATE(j).element, USCXML_GET_STATE(j).doneData);
 					}
-				}
 
-				j = USCXML_GET_STATE(i).ancestors.find_next(j);
+					j = USCXML_GET_STATE(i).ancestors.find_next(j);
+				}
 			}
 		}
 	}
+
 	USCXML_MONITOR_CALLBACK(monitors, afterMicroStep);
 
 	// are we running in circles?
@@ -1339,9 +1535,12 @@ bool FastMicroStep::isInState(const std::string& stateId) {
 #ifdef USCXML_VERBOSE
 	printStateNames(_configuration);
 #endif
-	if (_stateIds.find(stateId) == _stateIds.end())
+	if (!_chart)
 		return false;
-	return _configuration[_stateIds[stateId]];
+	auto stateIter = _chart->stateIds.find(stateId);
+	if (stateIter == _chart->stateIds.end())
+		return false;
+	return _configuration[stateIter->second];
 }
 
 std::list<XERCESC_NS::DOMElement*> FastMicroStep::getConfiguration() {
@@ -1355,45 +1554,27 @@ std::list<XERCESC_NS::DOMElement*> FastMicroStep::getConfiguration() {
 }
 
 
-std::list<DOMElement*> FastMicroStep::getHistoryCompletion(const DOMElement* history) {
-	std::set<std::string> elements;
-	elements.insert(_xmlPrefix.str() + "history");
-	std::list<DOMElement*> histories = DOMUtils::inPostFixOrder(elements, _scxml);
-
-	std::list<DOMElement*> covered;
-	std::list<DOMElement*> perParentcovered;
-	const DOMNode* parent = NULL;
-
+std::list<DOMElement*> FastMicroStep::getHistoryCompletion(const DOMElement* history, const ChartIndex& index) {
 	std::list<DOMElement*> completion;
 
-
-	if (parent != history->getParentNode()) {
-		covered.insert(covered.end(), perParentcovered.begin(), perParentcovered.end());
-		perParentcovered.clear();
-		parent = history->getParentNode();
-	}
+	uint32_t parent = index.getParent(index.getDocumentOrder(history));
+	if (parent == ChartIndex::NONE)
+		return completion;
 
 	bool deep = (HAS_ATTR(history, kXMLCharType) && iequals(ATTR(history, kXMLCharType), "deep"));
 
-	for (size_t j = 0; j < _states.size(); j++) {
+	// the states within the history's parent follow it in document order
+	for (uint32_t j = parent + 1; j <= index.getLastDescendant(parent); j++) {
 		if (_states[j]->element == history)
 			continue;
 
-		if (DOMUtils::isDescendant((DOMNode*)_states[j]->element, history->getParentNode()) && isHistory(_states[j]->element)) {
+		if (isHistory(_states[j]->element)) {
 			((DOMElement*)history)->setUserData(X("hasHistoryChild"), _states[j], NULL);
-		}
-
-		if (DOMUtils::isMember(_states[j]->element, covered))
 			continue;
+		}
 
-		if (deep) {
-			if (DOMUtils::isDescendant(_states[j]->element, history->getParentNode()) && !isHistory(_states[j]->element)) {
-				completion.push_back(_states[j]->element);
-			}
-		} else {
-			if (_states[j]->element->getParentNode() == history->getParentNode() && !isHistory(_states[j]->element)) {
-				completion.push_back(_states[j]->element);
-			}
+		if (deep || index.getParent(j) == parent) {
+			completion.push_back(_states[j]->element);
 		}
 	}
 
@@ -1417,17 +1598,17 @@ void FastMicroStep::printStateNames(const boost::dynamic_bitset<BITSET_BLOCKTYPE
 }
 #endif
 
-std::list<DOMElement*> FastMicroStep::getCompletion(const DOMElement* state) {
+std::list<DOMElement*> FastMicroStep::getCompletion(const DOMElement* state, const ChartIndex& index) {
 
 	if (isHistory(state)) {
 		// we already did in setHistoryCompletion
-		return getHistoryCompletion(state);
+		return getHistoryCompletion(state, index);
 
 	} else if (isParallel(state)) {
 		return getChildStates(state);
 
 	} else if (HAS_ATTR(state, kXMLCharInitial)) {
-		return getStates(tokenize(ATTR(state, kXMLCharInitial)), _scxml);
+		return getStates(tokenize(ATTR(state, kXMLCharInitial)), index);
 
 	} else {
 		std::list<DOMElement*> completion;
@@ -24,10 +24,13 @@
 
 #include "uscxml/Common.h"
 #include "uscxml/util/DOM.h" // X
+#include "uscxml/util/ChartIndex.h"
+#include "uscxml/util/EventDescriptor.h"
 
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include "MicroStepImpl.h"
 
 #include <boost/dynamic_bitset.hpp>
@@ -50,7 +53,10 @@ namespace uscxml {
  */
 class FastMicroStep : public MicroStepImpl {
 public:
+	class Chart;
+
 	FastMicroStep(MicroStepCallbacks* callbacks);
+	FastMicroStep(MicroStepCallbacks* callbacks, std::shared_ptr<const Chart> chart);
 	virtual ~FastMicroStep();
 	virtual std::shared_ptr<MicroStepImpl> create(MicroStepCallbacks* callbacks);
 
@@ -66,6 +72,20 @@ public:
 
 	virtual void deserialize(const Data& encodedState);
 	virtual Data serialize();
+	virtual void readSnapshot(SnapshotReader& reader);
+	virtual void writeSnapshot(SnapshotWriter& writer);
+
+	virtual XERCESC_NS::DOMElement* getStateElement(uint32_t index) {
+		return (index < _states.size() ? _states[index]->element : NULL);
+	}
+	virtual XERCESC_NS::DOMElement* getTransitionElement(uint32_t index) {
+		return (index < _transitions.size() ? _transitions[index]->element : NULL);
+	}
+
+	/// The compiled chart, available after init
+	std::shared_ptr<const Chart> getChart() {
+		return _chart;
+	}
 
 protected:
 	FastMicroStep() {}; // only for factory
@@ -112,12 +132,13 @@ protected:
 	};
 
 	virtual void init(XERCESC_NS::DOMElement* scxml);
+	void compile();
 
-	std::list<XERCESC_NS::DOMElement*> getCompletion(const XERCESC_NS::DOMElement* state);
+	std::list<XERCESC_NS::DOMElement*> getCompletion(const XERCESC_NS::DOMElement* state, const ChartIndex& index);
 
 	unsigned char _flags;
-	std::map<std::string, int> _stateIds;
 
+	std::shared_ptr<const Chart> _chart;
 	std::vector<State*> _states;
 	std::vector<Transition*> _transitions;
 	std::list<XERCESC_NS::DOMElement*> _globalScripts;
@@ -139,11 +160,14 @@ protected:
 	Event _event; // we do not care about the event's representation
 
 private:
-	std::list<XERCESC_NS::DOMElement*> getHistoryCompletion(const XERCESC_NS::DOMElement* state);
+	std::list<XERCESC_NS::DOMElement*> getHistoryCompletion(const XERCESC_NS::DOMElement* state, const ChartIndex& index);
 	void resortStates(XERCESC_NS::DOMElement* node, const X& xmlPrefix);
 
 	std::string toBase64(const boost::dynamic_bitset<BITSET_BLOCKTYPE>& bitset);
 	boost::dynamic_bitset<BITSET_BLOCKTYPE> fromBase64(const std::string& encoded);
+	void writeBitset(SnapshotWriter& writer, const boost::dynamic_bitset<BITSET_BLOCKTYPE>& bitset);
+	boost::dynamic_bitset<BITSET_BLOCKTYPE> readBitset(SnapshotReader& reader, size_t expectedBits);
+	void restoreInvocations();
 
 	boost::dynamic_bitset<BITSET_BLOCKTYPE> _exitSet;
 	boost::dynamic_bitset<BITSET_BLOCKTYPE> _entrySet;
@@ -164,7 +188,57 @@ private:
 	std::pair<uint32_t, uint32_t> getExitSet(const Transition* transition);
 	std::map<uint32_t, std::pair<uint32_t, uint32_t> > _exitSetCache;
 
+	const boost::dynamic_bitset<BITSET_BLOCKTYPE>& getCandidates(const Event& event);
+	/**
+	 * Transitions matching event names the chart did not intern, computed from the chart's event index.
+	 * Every entry takes a bit per transition, the cache is cleared when it would exceed
+	 * USCXML_CANDIDATE_CACHE_BYTES (64kB) per session, yet holds at least 8 and at most 1024 entries.
+	 */
+	std::unordered_map<std::string, boost::dynamic_bitset<BITSET_BLOCKTYPE> > _candidates;
+
+	CompiledExpression& getCond(size_t transition);
+	std::vector<std::shared_ptr<CompiledExpression> > _conds; ///< Compiled transition conditions
+
 	friend class Factory;
+	friend class ChartTemplate;
+
+public:
+	/**
+	 * The immutable, compiled part of a state-chart.
+	 *
+	 * Instances are shared between all sessions of a ChartTemplate, each
+	 * FastMicroStep only allocates its own configuration, history and
+	 * invocation bitsets.
+	 */
+	class Chart {
+	public:
+		~Chart();
+
+		XERCESC_NS::DOMElement* scxml = NULL;
+		std::vector<State*> states;
+		std::vector<Transition*> transitions;
+		std::vector<std::pair<uint32_t, uint32_t> > exitSets;
+		std::map<std::string, int> stateIds;
+
+		/// An interned token of an event descriptor with all transitions whose descriptor ends here
+		class EventNode {
+		public:
+			~EventNode();
+			std::map<uint32_t, EventNode*> children;
+			boost::dynamic_bitset<BITSET_BLOCKTYPE> transitions;
+		};
+
+		EventNode events;
+		std::map<uint32_t, boost::dynamic_bitset<BITSET_BLOCKTYPE> > eventsCaseless; ///< Interned lower-cased descriptors for exact matches
+		boost::dynamic_bitset<BITSET_BLOCKTYPE> wildcardTransitions;
+		boost::dynamic_bitset<BITSET_BLOCKTYPE> eventlessTransitions;
+
+		/// Transitions matching the names in the document's event attributes by their EventName id
+		std::unordered_map<uint32_t, boost::dynamic_bitset<BITSET_BLOCKTYPE> > internedCandidates;
+
+		/// Collect the transitions matching an event name from the index
+		void matchCandidates(const EventName& name, boost::dynamic_bitset<BITSET_BLOCKTYPE>& candidates) const;
+	};
 };
 
 }
@@ -23,9 +23,11 @@
 #include "uscxml/Interpreter.h"
 #include "uscxml/interpreter/InterpreterImpl.h" // beware cyclic reference!
 #include "uscxml/interpreter/BasicEventQueue.h"
-#include "uscxml/interpreter/BasicDelayedEventQueue.h"
+#include "uscxml/interpreter/TimerWheelDelayedEventQueue.h"
+#include "uscxml/interpreter/InterpreterSnapshot.h"
 #include "uscxml/messages/Event.h"
 #include "uscxml/util/String.h"
+#include "uscxml/util/Convenience.h"
 #include "uscxml/util/Predicates.h"
 #include "uscxml/util/MD5.hpp"
 #include "uscxml/plugins/InvokerImpl.h"
@@ -73,7 +75,7 @@ void InterpreterImpl::addInstance(std::shared_ptr<InterpreterImpl> interpreterIm
 	_instances[interpreterImpl->getSessionId()] = interpreterImpl;
 }
 
-InterpreterImpl::InterpreterImpl() : _isInitialized(false), _document(NULL), _scxml(NULL), _state(USCXML_INSTANTIATED) {
+InterpreterImpl::InterpreterImpl() : _isInitialized(false), _document(NULL), _scxml(NULL), _state(USCXML_INSTANTIATED), _monitorEpoch(0), _activeMonitorEpoch(0), _metrics(NULL), _trace(NULL) {
 	try {
 		::xercesc_3_1::XMLPlatformUtils::Initialize();
 	} catch (const XERCESC_NS::XMLException& toCatch) {
@@ -82,6 +84,16 @@ InterpreterImpl::InterpreterImpl() : _isInitialized(false), _document(NULL), _sc
 
 	_sessionId = UUID::getUUID();
 	_factory = Factory::getInstance();
+
+	_activeMonitors = std::shared_ptr<const MonitorSnapshot>(new MonitorSnapshot());
+	_publishedMonitors = _activeMonitors;
+
+	// the flight recorder is always on unless USCXML_TRACE_RECORDS is 0
+	size_t traceRecords = InterpreterTrace::DEFAULT_CAPACITY;
+	const char* traceEnv = getenv("USCXML_TRACE_RECORDS");
+	if (traceEnv != NULL)
+		traceRecords = strTo<size_t>(traceEnv);
+	setTraceCapacity(traceRecords);
 }
 
 
@@ -100,7 +112,7 @@ InterpreterImpl::~InterpreterImpl() {
 
 	if (_delayQueue)
 		_delayQueue.cancelAllDelayed();
-	if (_document)
+	if (_document && !_template)
 		delete _document;
 
 	if (_lambdaMonitor)
@@ -129,15 +141,146 @@ InterpreterImpl::~InterpreterImpl() {
 
 InterpreterState InterpreterImpl::step(size_t blockMs) {
 	std::lock_guard<std::recursive_mutex> lock(_serializationMutex);
+
+	// only look at the published monitors when they changed
+	if (_monitorEpoch.load(std::memory_order_acquire) != _activeMonitorEpoch) {
+		std::lock_guard<std::mutex> monitorLock(_monitorMutex);
+		_activeMonitors = _publishedMonitors;
+		_activeMonitorEpoch = _monitorEpoch.load(std::memory_order_relaxed);
+	}
 	if (!_isInitialized) {
 		init();
 		_state = USCXML_INITIALIZED;
 	} else {
 		_state = _microStepper.step(blockMs);
+
+		InterpreterMetrics* metrics = getMetrics();
+		if (metrics) {
+			if (_state == USCXML_MICROSTEPPED) {
+				metrics->microstep();
+			} else if (_state == USCXML_MACROSTEPPED || _state == USCXML_IDLE) {
+				metrics->stable();
+			}
+		}
+
+		InterpreterTrace* trace = getTrace();
+		if (trace && (_state == USCXML_MACROSTEPPED || _state == USCXML_IDLE))
+			trace->record(InterpreterTrace::STABLE, 0);
 	}
 	return _state;
 }
 
+void InterpreterImpl::setMetricsEnabled(bool enabled) {
+	std::lock_guard<std::mutex> lock(_metricsMutex);
+	if (enabled) {
+		if (!_metricsData)
+			_metricsData = std::shared_ptr<InterpreterMetrics>(new InterpreterMetrics());
+		Benchmark::calibrate();
+		_metrics = _metricsData.get();
+	} else {
+		_metrics = NULL;
+	}
+}
+
+Data InterpreterImpl::getMetricsData() {
+	Data metrics;
+	std::shared_ptr<InterpreterMetrics> data;
+	{
+		std::lock_guard<std::mutex> lock(_metricsMutex);
+		data = _metricsData;
+	}
+	if (data)
+		metrics = data->toData();
+
+	{
+		std::lock_guard<std::recursive_mutex> lock(_delayMutex);
+		metrics.compound["delayedInFlight"] = Data(_delayedEventTargets.size());
+	}
+	metrics.compound["sessionId"] = Data(_sessionId, Data::VERBATIM);
+	return metrics;
+}
+
+void InterpreterImpl::setTraceCapacity(size_t records) {
+	std::lock_guard<std::mutex> lock(_traceMutex);
+	if (records > 0) {
+		_traces.push_back(std::shared_ptr<InterpreterTrace>(new InterpreterTrace(records)));
+		_trace = _traces.back().get();
+	} else {
+		_trace = NULL;
+	}
+}
+
+void InterpreterImpl::indexTraceNames() {
+	// called with _traceMutex held, the microstepper's indices are stable once it was initialized
+	std::shared_ptr<InterpreterTrace::Names> names(new InterpreterTrace::Names());
+
+	DOMElement* element;
+	for (uint32_t i = 0; (element = _traceStepper->getStateElement(i)) != NULL; i++) {
+		names->states[i] = (HAS_ATTR(element, kXMLCharId) ? ATTR(element, kXMLCharId) : DOMUtils::xPathForNode(element));
+	}
+	for (uint32_t i = 0; (element = _traceStepper->getTransitionElement(i)) != NULL; i++) {
+		names->transitions[i] = DOMUtils::xPathForNode(element);
+	}
+
+	_traceNames = names;
+}
+
+void InterpreterImpl::writeTrace(std::ostream& stream, InterpreterTrace::Format format, size_t records) {
+	InterpreterTrace::Session session = readTrace(records);
+	InterpreterTrace::write(stream, format, session.id, session.records, session.names);
+}
+
+InterpreterTrace::Session InterpreterImpl::readTrace(size_t records) {
+	std::shared_ptr<InterpreterTrace> trace;
+	std::shared_ptr<const InterpreterTrace::Names> names;
+	{
+		std::lock_guard<std::mutex> lock(_traceMutex);
+		if (_trace.load(std::memory_order_relaxed) != NULL)
+			trace = _traces.back();
+		// names are only needed when someone looks at the trace
+		if (!_traceNames && _traceStepper)
+			indexTraceNames();
+		names = _traceNames;
+	}
+
+	InterpreterTrace::Session session;
+	session.id = _sessionId;
+	if (trace)
+		session.records = trace->getRecords(records);
+
+	if (names)
+		session.names = *names;
+	for (auto& record : session.records) {
+		if (record.type != InterpreterTrace::EVENT || record.id == 0 || session.names.events.find(record.id) != session.names.events.end())
+			continue;
+		if (record.id & InterpreterTrace::LOCAL_NAME) {
+			std::string name;
+			if (trace->getLocalName(record.id, name))
+				session.names.events[record.id] = name;
+		} else {
+			session.names.events[record.id] = EventName::forId(record.id).str();
+		}
+	}
+	return session;
+}
+
+void InterpreterImpl::addMonitor(InterpreterMonitor* monitor) {
+	std::lock_guard<std::mutex> lock(_monitorMutex);
+	_monitors.insert(monitor);
+	publishMonitors();
+}
+
+void InterpreterImpl::removeMonitor(InterpreterMonitor* monitor) {
+	std::lock_guard<std::mutex> lock(_monitorMutex);
+	_monitors.erase(monitor);
+	publishMonitors();
+}
+
+void InterpreterImpl::publishMonitors() {
+	_publishedMonitors = std::shared_ptr<const MonitorSnapshot>(new MonitorSnapshot(_monitors));
+	_monitorEpoch.fetch_add(1, std::memory_order_release);
+}
+
 void InterpreterImpl::reset() {
 	if (_microStepper)
 		_microStepper.reset();
@@ -157,9 +300,43 @@ void InterpreterImpl::cancel() {
 	enqueueExternal(unblock);
 }
 
+void InterpreterImpl::indexSnapshot() {
+	if (_snapshotIndexed)
+		return;
+
+	// SCXML Rec: "the values of all attributes of type "id" must be unique within the session"
+	std::list<XERCESC_NS::DOMElement*> datas = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "data" }, _scxml);
+	for (auto data : datas) {
+		if (HAS_ATTR(data, kXMLCharId)) {
+			_snapshotDataIds.push_back(ATTR(data, kXMLCharId));
+		}
+	}
+
+	std::list<XERCESC_NS::DOMElement*> invokes = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "invoke" }, _scxml);
+	for (auto invokeElem : invokes) {
+		_snapshotInvokes.push_back(std::make_pair(invokeElem, DOMUtils::xPathForNode(invokeElem)));
+	}
+
+	if (_md5.size() == 0) {
+		// get md5 of current document
+		std::stringstream ss;
+		ss << *_document;
+		_md5 = md5(ss.str());
+	}
+
+	_snapshotIndexed = true;
+}
+
 void InterpreterImpl::deserialize(const std::string& encodedState) {
 
 	init();
+	indexSnapshot();
+
+	if (SnapshotReader::isSnapshot(encodedState)) {
+		deserializeBinary(encodedState);
+		return;
+	}
+
 //    std::cout << encodedState << std::endl;
 	Data state = Data::fromJSON(encodedState);
 	if (!state.hasKey("microstepper")) {
@@ -175,47 +352,90 @@ void InterpreterImpl::deserialize(const std::string& encodedState) {
 	}
 
 	if (state.hasKey("externalQueue")) {
-		_externalQueue.deserialize(state["externalQueue"]);
+		deserializeExternalQueue(state["externalQueue"]);
 	}
 
 	if (state.hasKey("delayQueue")) {
 		_delayQueue.deserialize(state["delayQueue"]);
 	}
 
-	if (_md5.size() == 0) {
-		// get md5 of current document
-		std::stringstream ss;
-		ss << *_document;
-		_md5 = md5(ss.str());
-	}
-
 	if (state["md5"].atom != _md5) {
 		ERROR_PLATFORM_THROW("MD5 hash mismatch in serialized state");
 	}
 
-	std::list<XERCESC_NS::DOMElement*> datas = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "data" }, _scxml);
-	for (auto data : datas) {
-		if (HAS_ATTR(data, kXMLCharId) && state["datamodel"].hasKey(ATTR(data, kXMLCharId)))
-			_dataModel.init(ATTR(data, kXMLCharId), state["datamodel"][ATTR(data, kXMLCharId)]);
+	for (auto& dataId : _snapshotDataIds) {
+		if (state["datamodel"].hasKey(dataId))
+			_dataModel.init(dataId, state["datamodel"][dataId]);
 	}
 
 	_microStepper.deserialize(state["microstepper"]);
 
-	std::list<XERCESC_NS::DOMElement*> invokes = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "invoke" }, _scxml);
-	for (auto invokeElem : invokes) {
+	for (auto& invoke : _snapshotInvokes) {
 		// BasicContentExecutor sets invokeid userdata upon invocation
-		char* invokeId = (char*)invokeElem->getUserData(X("invokeid"));
+		char* invokeId = (char*)invoke.first->getUserData(X("invokeid"));
 		if (invokeId != NULL && _invokers.find(invokeId) != _invokers.end()) {
-			std::string path = DOMUtils::xPathForNode(invokeElem);
-			if (state.hasKey("invoker") && state["invoker"].hasKey(path)) {
-				_invokers[invokeId].deserialize(state["invoker"][path]);
+			if (state.hasKey("invoker") && state["invoker"].hasKey(invoke.second)) {
+				_invokers[invokeId].deserialize(state["invoker"][invoke.second]);
 			}
 		}
 	}
 
 }
 
-std::string InterpreterImpl::serialize() {
+void InterpreterImpl::deserializeBinary(const std::string& encodedState) {
+	std::shared_ptr<InterpreterSnapshot> snapshot(new InterpreterSnapshot(InterpreterSnapshot::decode(encodedState)));
+	restoreSnapshot(*snapshot);
+
+	// further checkpoints continue from here
+	_checkpoint = snapshot;
+}
+
+void InterpreterImpl::restore(const std::string& base, const std::list<std::string>& deltas) {
+	init();
+	indexSnapshot();
+
+	std::shared_ptr<InterpreterSnapshot> snapshot(new InterpreterSnapshot(InterpreterSnapshot::decode(base)));
+	for (auto& delta : deltas) {
+		snapshot->apply(delta);
+	}
+	restoreSnapshot(*snapshot);
+
+	_checkpoint = snapshot;
+}
+
+void InterpreterImpl::restoreSnapshot(const InterpreterSnapshot& snapshot) {
+	// sections are in the order they are applied with JSON
+	if (snapshot.md5 != _md5) {
+		ERROR_PLATFORM_THROW("MD5 hash mismatch in serialized state");
+	}
+
+	deserializeExternalQueue(SnapshotReader(snapshot.externalQueue).readData());
+	_delayQueue.deserialize(SnapshotReader(snapshot.delayQueue).readData());
+
+	if (snapshot.datas.size() != _snapshotDataIds.size()) {
+		ERROR_PLATFORM_THROW("Number of data elements mismatch in serialized state");
+	}
+	for (size_t i = 0; i < _snapshotDataIds.size(); i++) {
+		_dataModel.init(_snapshotDataIds[i], SnapshotReader(snapshot.datas[i]).readData());
+	}
+
+	SnapshotReader microstepper(snapshot.microstepper);
+	_microStepper.readSnapshot(microstepper);
+
+	for (auto& invoker : snapshot.invokers) {
+		if (invoker.first >= _snapshotInvokes.size()) {
+			ERROR_PLATFORM_THROW("Invalid invoke element in serialized state");
+		}
+
+		// BasicContentExecutor sets invokeid userdata upon invocation
+		char* invokeId = (char*)_snapshotInvokes[invoker.first].first->getUserData(X("invokeid"));
+		if (invokeId != NULL && _invokers.find(invokeId) != _invokers.end()) {
+			_invokers[invokeId].deserialize(SnapshotReader(invoker.second).readData());
+		}
+	}
+}
+
+std::string InterpreterImpl::serialize(SnapshotFormat format) {
 	std::lock_guard<std::recursive_mutex> lock(_serializationMutex);
 
 	Data serialized;
@@ -223,43 +443,105 @@ std::string InterpreterImpl::serialize() {
 		ERROR_PLATFORM_THROW("Cannot serialize an unstable interpreter");
 	}
 
-	if (_md5.size() == 0) {
-		// get md5 of current document
-		std::stringstream ss;
-		ss << *_document;
-		_md5 = md5(ss.str());
-	}
+	indexSnapshot();
+
+	if (format == SNAPSHOT_BINARY)
+		return serializeBinary();
 
 	serialized["md5"] = Data(_md5);
 	serialized["url"] = Data(std::string(_baseURL));
 	serialized["microstepper"] = _microStepper.serialize();
 
-	// SCXML Rec: "the values of all attributes of type "id" must be unique within the session"
-	std::list<XERCESC_NS::DOMElement*> datas = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "data" }, _scxml);
-	for (auto data : datas) {
-		if (HAS_ATTR(data, kXMLCharId)) {
-			serialized["datamodel"][ATTR(data, kXMLCharId)] = _dataModel.evalAsData(ATTR(data, kXMLCharId));
-		}
+	for (auto& dataId : _snapshotDataIds) {
+		serialized["datamodel"][dataId] = _dataModel.evalAsData(dataId);
 	}
 
 	// save all invokers' state
-	std::list<XERCESC_NS::DOMElement*> invokes = DOMUtils::inDocumentOrder({ XML_PREFIX(_scxml).str() + "invoke" }, _scxml);
-	for (auto invokeElem : invokes) {
+	for (auto& invoke : _snapshotInvokes) {
 		// BasicContentExecutor sets invokeid userdata upon invocation
-		char* invokeId = (char*)invokeElem->getUserData(X("invokeid"));
+		char* invokeId = (char*)invoke.first->getUserData(X("invokeid"));
 		if (invokeId != NULL && _invokers.find(invokeId) != _invokers.end()) {
-			std::string path = DOMUtils::xPathForNode(invokeElem);
-			serialized["invoker"][path] = _invokers[invokeId].serialize();
+			serialized["invoker"][invoke.second] = _invokers[invokeId].serialize();
 		}
 	}
 
 //    serialized["internalQueue"] = _internalQueue.serialize();
-	serialized["externalQueue"] = _externalQueue.serialize();
+	serialized["externalQueue"] = serializeExternalQueue();
 	serialized["delayQueue"] = _delayQueue.serialize();
 
 	return serialized.asJSON();
 }
 
+std::string InterpreterImpl::serializeBinary() {
+	InterpreterSnapshot snapshot;
+	captureSnapshot(snapshot);
+	if (_checkpoint)
+		snapshot.sequence = _checkpoint->sequence;
+	return snapshot.encode();
+}
+
+std::string InterpreterImpl::checkpoint(bool full) {
+	std::lock_guard<std::recursive_mutex> lock(_serializationMutex);
+
+	if (_state != USCXML_IDLE && _state != USCXML_MACROSTEPPED && _state != USCXML_FINISHED) {
+		ERROR_PLATFORM_THROW("Cannot serialize an unstable interpreter");
+	}
+
+	indexSnapshot();
+
+	std::string encoded;
+	std::shared_ptr<InterpreterSnapshot> snapshot;
+	if (full || !_checkpoint) {
+		snapshot = std::shared_ptr<InterpreterSnapshot>(new InterpreterSnapshot());
+		captureSnapshot(*snapshot);
+		snapshot->sequence = (_checkpoint ? _checkpoint->sequence + 1 : 0);
+		encoded = snapshot->encode();
+	} else {
+		// the diff only keeps what changed
+		snapshot = std::shared_ptr<InterpreterSnapshot>(new InterpreterSnapshot());
+		captureSnapshot(*snapshot);
+		snapshot->sequence = _checkpoint->sequence + 1;
+		encoded = _checkpoint->diff(*snapshot);
+	}
+
+	_checkpoint = snapshot;
+	return encoded;
+}
+
+static std::string encodeData(const Data& data) {
+	std::string encoded;
+	SnapshotWriter writer(encoded);
+	writer.writeData(data);
+	return encoded;
+}
+
+void InterpreterImpl::captureSnapshot(InterpreterSnapshot& snapshot) {
+	snapshot.md5 = _md5;
+	snapshot.url = std::string(_baseURL);
+
+	snapshot.externalQueue = encodeData(serializeExternalQueue());
+	snapshot.delayQueue = encodeData(_delayQueue.serialize());
+
+	snapshot.datas.resize(_snapshotDataIds.size());
+	// with references between data, assigning one may change any other one
+	for (size_t i = 0; i < _snapshotDataIds.size(); i++) {
+		snapshot.datas[i] = encodeData(_dataModel.evalAsData(_snapshotDataIds[i]));
+	}
+
+	snapshot.microstepper.clear();
+	SnapshotWriter microstepper(snapshot.microstepper);
+	_microStepper.writeSnapshot(microstepper);
+
+	// invokers by their index in the invoke table
+	snapshot.invokers.clear();
+	for (size_t i = 0; i < _snapshotInvokes.size(); i++) {
+		// BasicContentExecutor sets invokeid userdata upon invocation
+		char* invokeId = (char*)_snapshotInvokes[i].first->getUserData(X("invokeid"));
+		if (invokeId != NULL && _invokers.find(invokeId) != _invokers.end()) {
+			snapshot.invokers[i] = encodeData(_invokers[invokeId].serialize());
+		}
+	}
+}
 
 void InterpreterImpl::setupDOM() {
 
@@ -403,6 +685,11 @@ void InterpreterImpl::init() {
 		_microStepper = MicroStep(std::shared_ptr<MicroStepImpl>(new LargeMicroStep(this)));
 	}
 	_microStepper.init(_scxml);
+	{
+		std::lock_guard<std::mutex> lock(_traceMutex);
+		_traceStepper = _microStepper.getImpl();
+		_traceNames.reset();
+	}
 
 	if (!_dataModel) {
 		_dataModel = _factory->createDataModel(HAS_ATTR(_scxml, kXMLCharDataModel) ? ATTR(_scxml, kXMLCharDataModel) : "null", this);
@@ -418,7 +705,7 @@ void InterpreterImpl::init() {
 		_internalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()));
 	}
 	if (!_delayQueue) {
-		_delayQueue = DelayedEventQueue(std::shared_ptr<DelayedEventQueueImpl>(new BasicDelayedEventQueue(this)));
+		_delayQueue = DelayedEventQueue(std::shared_ptr<DelayedEventQueueImpl>(new TimerWheelDelayedEventQueue(this)));
 	}
 
 	_isInitialized = true;
@@ -453,14 +740,17 @@ void InterpreterImpl::initData(XERCESC_NS::DOMElement* root) {
 }
 
 void InterpreterImpl::assign(const std::string& location, const Data& data, const std::map<std::string, std::string>& attrs) {
+	InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 	_dataModel.assign(location, data, attrs);
 }
 
 bool InterpreterImpl::isMatched(const Event& event, const std::string& eventDesc) {
+	// descriptors passed here are not part of the chart, do not intern them
 	return nameMatch(eventDesc, event.name);
 }
 
 bool InterpreterImpl::isTrue(const std::string& expr) {
+	InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 	try {
 		return _dataModel.evalAsBool(expr);
 	} catch (ErrorEvent e) {
@@ -476,6 +766,18 @@ bool InterpreterImpl::isTrue(const std::string& expr) {
 	}
 }
 
+bool InterpreterImpl::isTrue(CompiledExpression& expr) {
+	InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
+	try {
+		return _dataModel.evalCompiledAsBool(expr);
+	} catch (ErrorEvent e) {
+		// as above, test 244, 344 and 245
+		LOG(getLogger(), USCXML_ERROR) << e;
+		enqueueInternal(e);
+		return false;
+	}
+}
+
 
 bool InterpreterImpl::checkValidSendType(const std::string& type, const std::string& target) {
 
@@ -494,9 +796,28 @@ bool InterpreterImpl::checkValidSendType(const std::string& type, const std::str
 }
 
 Event InterpreterImpl::dequeueExternal(size_t blockMs) {
-	_currEvent = _externalQueue.dequeue(blockMs);
+	// drain several events while we hold the queue's lock anyway
+	if (_externalBatch.empty())
+		_externalQueue.dequeueBatch(_externalBatch, USCXML_EXTERNAL_BATCH, blockMs);
+
+	_currEvent = Event();
+	if (!_externalBatch.empty()) {
+		_currEvent = std::move(_externalBatch.front());
+		_externalBatch.pop_front();
+	}
+
 	if (_currEvent) {
-		_dataModel.setEvent(_currEvent);
+		resolveNameId(_currEvent);
+		InterpreterMetrics* metrics = getMetrics();
+		if (metrics)
+			metrics->dequeued(_currEvent);
+		InterpreterTrace* trace = getTrace();
+		if (trace)
+			trace->recordEvent(_currEvent.nameId, _currEvent.name, true);
+		{
+			InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::DATAMODEL);
+			_dataModel.setEvent(_currEvent);
+		}
 
 //		LOG(USCXML_ERROR) << e.name;
 
@@ -517,6 +838,25 @@ Event InterpreterImpl::dequeueExternal(size_t blockMs) {
 	return _currEvent;
 }
 
+Data InterpreterImpl::serializeExternalQueue() {
+	Data serialized = _externalQueue.serialize();
+	// events of the current batch are still ahead of the queue
+	for (auto& event : _externalBatch) {
+		serialized["batch"].array.push_back(event);
+	}
+	return serialized;
+}
+
+void InterpreterImpl::deserializeExternalQueue(const Data& data) {
+	_externalBatch.clear();
+	if (data.hasKey("batch")) {
+		for (auto& event : data["batch"].array) {
+			_externalBatch.push_back(Event::fromData(event));
+		}
+	}
+	_externalQueue.deserialize(data);
+}
+
 void InterpreterImpl::enqueue(const std::string& type, const std::string& target, size_t delayMs, const Event& sendEvent) {
 	std::lock_guard<std::recursive_mutex> lock(_delayMutex);
 
@@ -20,11 +20,13 @@
 #ifndef INTERPRETERIMPL_H_2A79C83D
 #define INTERPRETERIMPL_H_2A79C83D
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 #include <limits>
 
 #include "uscxml/Common.h"
@@ -38,12 +40,20 @@
 #include "uscxml/interpreter/ContentExecutorImpl.h"
 #include "uscxml/interpreter/EventQueue.h"
 #include "uscxml/interpreter/EventQueueImpl.h"
+#include "uscxml/interpreter/InterpreterMetrics.h"
+#include "uscxml/interpreter/InterpreterTrace.h"
+#include "uscxml/util/EventDescriptor.h"
+
+/// External events taken from the queue at once, they are still processed one per macrostep
+#define USCXML_EXTERNAL_BATCH 64
 //#include "uscxml/util/DOM.h"
 
 namespace uscxml {
 
 class InterpreterMonitor;
 class InterpreterIssue;
+class ChartTemplate;
+class InterpreterSnapshot;
 
 /**
  * @ingroup interpreter
@@ -75,7 +85,12 @@ public:
 	virtual void cancel(); ///< Cancel and finalize state machine
 
 	virtual void deserialize(const std::string& encodedState);
-	virtual std::string serialize();
+	virtual std::string serialize(SnapshotFormat format = SNAPSHOT_JSON);
+
+	/// A complete binary snapshot at first, then the changes since the last checkpoint
+	virtual std::string checkpoint(bool full = false);
+	/// Restore from a complete binary snapshot and the deltas following it
+	virtual void restore(const std::string& base, const std::list<std::string>& deltas);
 
 	InterpreterState getState() {
 		return _state;
@@ -85,31 +100,50 @@ public:
 		return _microStepper.getConfiguration();
 	}
 
-	void addMonitor(InterpreterMonitor* monitor) {
-		_monitors.insert(monitor);
-	}
+	void addMonitor(InterpreterMonitor* monitor);
+	void removeMonitor(InterpreterMonitor* monitor);
 
-	void removeMonitor(InterpreterMonitor* monitor) {
-		_monitors.erase(monitor);
-	}
+	void setMetricsEnabled(bool enabled);
+	Data getMetricsData();
+
+	/// Records kept by the flight recorder, 0 disables it and the records are discarded
+	void setTraceCapacity(size_t records);
+	/// Write the last records of the flight recorder, callable from any thread
+	void writeTrace(std::ostream& stream, InterpreterTrace::Format format, size_t records = (size_t)-1);
+	/// Copy the last records of the flight recorder with their names, callable from any thread
+	InterpreterTrace::Session readTrace(size_t records = (size_t)-1);
 
 	/**
 	 MicrostepCallbacks
 	 */
 	virtual Event dequeueInternal() {
 		_currEvent = _internalQueue.dequeue(0);
-		if (_currEvent)
+		if (_currEvent) {
+			resolveNameId(_currEvent);
+			InterpreterMetrics* metrics = getMetrics();
+			if (metrics)
+				metrics->dequeued(_currEvent);
+			InterpreterTrace* trace = getTrace();
+			if (trace)
+				trace->recordEvent(_currEvent.nameId, _currEvent.name, false);
+			InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::DATAMODEL);
 			_dataModel.setEvent(_currEvent);
+		}
 		return _currEvent;
 	}
 	virtual Event dequeueExternal(size_t blockMs);
 	virtual bool isTrue(const std::string& expr);
+	virtual bool isTrue(CompiledExpression& expr);
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr) {
+		return _dataModel.compile(expr);
+	}
 
 	virtual void raiseDoneEvent(XERCESC_NS::DOMElement* state, XERCESC_NS::DOMElement* doneData) {
 		_execContent.raiseDoneEvent(state, doneData);
 	}
 
 	virtual void process(XERCESC_NS::DOMElement* block) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::EXECUTABLE_CONTENT);
 		_execContent.process(block);
 	}
 
@@ -124,8 +158,17 @@ public:
 		_execContent.uninvoke(invoke);
 	}
 
-	virtual std::set<InterpreterMonitor*> getMonitors() {
-		return _monitors;
+	/// The monitors as of the start of the current step
+	virtual const MonitorSnapshot& getMonitors() {
+		return *_activeMonitors;
+	}
+
+	virtual InterpreterMetrics* getMetrics() {
+		return _metrics.load(std::memory_order_relaxed);
+	}
+
+	virtual InterpreterTrace* getTrace() {
+		return _trace.load(std::memory_order_relaxed);
 	}
 
 	virtual Interpreter getInterpreter() {
@@ -164,17 +207,39 @@ public:
 	 */
 
 	virtual void enqueueInternal(const Event& event) {
+		if (getMetrics()) {
+			Event stamped(event);
+			stamped.enqueuedAt = Benchmark::now();
+			return _internalQueue.enqueue(stamped);
+		}
 		return _internalQueue.enqueue(event);
 	}
 	virtual void enqueueExternal(const Event& event) {
+		if (getMetrics()) {
+			Event stamped(event);
+			stamped.enqueuedAt = Benchmark::now();
+			return _externalQueue.enqueue(stamped);
+		}
 		return _externalQueue.enqueue(event);
 	}
+	/// Enqueue several external events with a single lock of the queue
+	virtual void enqueueExternalBatch(const std::list<Event>& events) {
+		if (getMetrics()) {
+			std::list<Event> stamped(events);
+			uint64_t now = Benchmark::now();
+			for (auto& event : stamped)
+				event.enqueuedAt = now;
+			return _externalQueue.enqueueBatch(stamped);
+		}
+		return _externalQueue.enqueueBatch(events);
+	}
 	virtual void enqueueExternalDelayed(const Event& event, size_t delayMs, const std::string& eventUUID) {
 		return _delayQueue.enqueueDelayed(event, delayMs, eventUUID);
 	}
 	virtual void cancelDelayed(const std::string& eventId);
 
 	virtual size_t getLength(const std::string& expr) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 		return _dataModel.getLength(expr);
 	}
 
@@ -182,17 +247,29 @@ public:
 	                        const std::string& array,
 	                        const std::string& index,
 	                        uint32_t iteration) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 		return _dataModel.setForeach(item, array, index, iteration);
 	}
 	virtual Data evalAsData(const std::string& expr) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 		return _dataModel.evalAsData(expr);
 	}
+	virtual Data evalAsData(CompiledExpression& expr) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
+		return _dataModel.evalCompiledAsData(expr);
+	}
 
 	virtual void eval(const std::string& content) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 		_dataModel.eval(content);
 	}
+	virtual void eval(CompiledExpression& expr) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
+		_dataModel.evalCompiled(expr);
+	}
 
 	virtual Data getAsData(const std::string& expr) {
+		InterpreterMetrics::Timer timer(getMetrics(), InterpreterMetrics::DATAMODEL);
 		return _dataModel.getAsData(expr);
 	}
 
@@ -278,6 +355,12 @@ public:
 protected:
 	static void addInstance(std::shared_ptr<InterpreterImpl> instance);
 
+	/// Trust an event's name id only while it still names the event, copies may have been renamed
+	static void resolveNameId(Event& event) {
+		if (event.nameId == 0 || EventName::forId(event.nameId).str() != event.name)
+			event.nameId = EventName::lookup(event.name);
+	}
+
 	LambdaMonitor* _lambdaMonitor = NULL;
 
 	Binding _binding;
@@ -307,6 +390,7 @@ protected:
 	friend class SCXMLIOProcessor;
 	friend class DebugSession;
 	friend class Debugger;
+	friend class ChartTemplate;
 
 	std::string _xmlPrefix;
 	std::string _xmlNS;
@@ -315,6 +399,15 @@ protected:
 	URL _baseURL;
 	std::string _md5;
 
+	/// Ids of data elements and invoke elements with their xpath in document order
+	std::vector<std::string> _snapshotDataIds;
+	std::vector<std::pair<XERCESC_NS::DOMElement*, std::string> > _snapshotInvokes;
+	bool _snapshotIndexed = false;
+
+	/// The last checkpoint, deltas are diffed against it
+	std::shared_ptr<InterpreterSnapshot> _checkpoint;
+	std::shared_ptr<ChartTemplate> _template; // owns our DOM if set
+
 	MicroStep _microStepper;
 	DataModel _dataModel;
 	ContentExecutor _execContent;
@@ -329,6 +422,7 @@ protected:
 
 	Event _currEvent;
 	Event _invokeReq;
+	std::list<Event> _externalBatch; ///< Dequeued external events not yet processed
 
 	std::map<std::string, IOProcessor> _ioProcs;
 	std::map<std::string, Invoker> _invokers;
@@ -336,10 +430,42 @@ protected:
 	std::set<std::string> _autoForwarders;
 	std::set<InterpreterMonitor*> _monitors;
 
+	/**
+	 * Adding or removing monitors publishes a new snapshot and increments the
+	 * epoch, the interpreter adopts it before its next step.
+	 */
+	std::shared_ptr<const MonitorSnapshot> _publishedMonitors;
+	std::shared_ptr<const MonitorSnapshot> _activeMonitors;
+	std::atomic<uint32_t> _monitorEpoch;
+	uint32_t _activeMonitorEpoch;
+	std::mutex _monitorMutex;
+
+	/// NULL unless enabled, the statistics are kept when disabled again
+	std::atomic<InterpreterMetrics*> _metrics;
+	std::shared_ptr<InterpreterMetrics> _metricsData;
+	std::mutex _metricsMutex;
+
+	/// NULL if disabled, replaced traces are kept as a step may still write to them
+	std::atomic<InterpreterTrace*> _trace;
+	std::list<std::shared_ptr<InterpreterTrace> > _traces;
+	std::shared_ptr<const InterpreterTrace::Names> _traceNames; ///< Resolved from _traceStepper on the first read
+	std::shared_ptr<MicroStepImpl> _traceStepper; ///< The initialized microstepper
+	std::mutex _traceMutex;
+
 	Data _cache;
 
 private:
 	void setupDOM();
+	void indexSnapshot();
+	void indexTraceNames();
+	void deserializeBinary(const std::string& encodedState);
+	std::string serializeBinary();
+	void captureSnapshot(InterpreterSnapshot& snapshot);
+	/// The external queue including the events of the current batch
+	Data serializeExternalQueue();
+	void deserializeExternalQueue(const Data& data);
+	void restoreSnapshot(const InterpreterSnapshot& snapshot);
+	void publishMonitors();
 };
 
 }
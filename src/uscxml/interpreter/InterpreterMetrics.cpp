@@ -0,0 +1,97 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "uscxml/interpreter/InterpreterMetrics.h"
+
+#include <string.h>
+
+namespace uscxml {
+
+InterpreterMetrics::InterpreterMetrics() : _microsteps(0) {
+	memset(_current, 0, sizeof(_current));
+}
+
+void InterpreterMetrics::dequeued(const Event& event) {
+	flush();
+
+	if (event.enqueuedAt != 0) {
+		uint64_t now = Benchmark::now();
+		_current[QUEUE_WAIT] = (now > event.enqueuedAt ? now - event.enqueuedAt : 0);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_events[event.name]++;
+}
+
+void InterpreterMetrics::flush() {
+	bool recorded = false;
+	for (size_t i = 0; i < PHASES; i++) {
+		if (_current[i] != 0) {
+			recorded = true;
+			break;
+		}
+	}
+	if (!recorded)
+		return;
+
+	// every phase gets a sample per event, also the ones the event did not pass
+	for (size_t i = 0; i < PHASES; i++) {
+		_histograms[i].add(_current[i]);
+		_current[i] = 0;
+	}
+}
+
+Data InterpreterMetrics::toData() {
+	Data data;
+	double rate = Benchmark::ticksPerNanosecond();
+
+	data.compound["microsteps"] = Data(_microsteps.load(std::memory_order_relaxed));
+	for (size_t i = 0; i < PHASES; i++) {
+		data.compound["phases"].compound[phaseName((Phase)i)] = _histograms[i].toData(rate);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& event : _events) {
+		data.compound["events"].compound[event.first] = Data(event.second);
+	}
+	return data;
+}
+
+const char* InterpreterMetrics::phaseName(Phase phase) {
+	switch (phase) {
+	case QUEUE_WAIT:
+		return "queue_wait";
+	case SELECT:
+		return "select";
+	case EXIT:
+		return "exit";
+	case TRANSITIONS:
+		return "transitions";
+	case ENTRY:
+		return "entry";
+	case EXECUTABLE_CONTENT:
+		return "executable_content";
+	case DATAMODEL:
+		return "datamodel";
+	default:
+		return "";
+	}
+}
+
+}
@@ -0,0 +1,97 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef INTERPRETERMETRICS_H_6F1C2B7A
+#define INTERPRETERMETRICS_H_6F1C2B7A
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "uscxml/Common.h"
+#include "uscxml/messages/Event.h"
+#include "uscxml/debug/Benchmark.h"
+
+namespace uscxml {
+
+/**
+ * @ingroup interpreter
+ * Latencies per processed event and counters of a single session. The
+ * interpreter thread is the only writer, toData() may be called from any
+ * thread.
+ */
+class USCXML_API InterpreterMetrics {
+public:
+	enum Phase {
+		QUEUE_WAIT = 0,
+		SELECT,
+		EXIT,
+		TRANSITIONS,
+		ENTRY,
+		EXECUTABLE_CONTENT,
+		DATAMODEL,
+		PHASES
+	};
+
+	/// Adds the time until it goes out of scope to a phase of the current event
+	class Timer {
+	public:
+		Timer(InterpreterMetrics* metrics, Phase phase) : _metrics(metrics), _phase(phase), _started(metrics ? Benchmark::now() : 0) {}
+		~Timer() {
+			if (_metrics)
+				_metrics->_current[_phase] += Benchmark::now() - _started;
+		}
+
+	protected:
+		InterpreterMetrics* _metrics;
+		Phase _phase;
+		uint64_t _started;
+	};
+
+	InterpreterMetrics();
+
+	/// An event was taken from a queue, the phases from here on are accounted to it
+	void dequeued(const Event& event);
+	/// The interpreter reached a stable configuration
+	void stable() {
+		flush();
+	}
+	void microstep() {
+		_microsteps.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// microsteps, events by name and phases with statistics in nanoseconds
+	Data toData();
+
+	static const char* phaseName(Phase phase);
+
+protected:
+	void flush();
+
+	uint64_t _current[PHASES];
+	Benchmark::Histogram _histograms[PHASES];
+	std::atomic<uint64_t> _microsteps;
+	std::map<std::string, uint64_t> _events;
+	std::mutex _mutex;
+};
+
+}
+
+#endif /* end of include guard: INTERPRETERMETRICS_H_6F1C2B7A */
@@ -27,6 +27,8 @@
 
 #include <functional>
 #include <mutex>
+#include <set>
+#include <vector>
 
 #define USCXML_MONITOR_CATCH(callback) \
 catch (Event e) { LOG(USCXML_ERROR) << "Syntax error when calling " #callback " on monitors: " << std::endl << e << std::endl; } \
@@ -34,20 +36,27 @@ catch (std::bad_weak_ptr e) { LOG(USCXML_ERROR) << "Unclean shutdown " << std::e
 catch (...) { LOG(USCXML_ERROR) << "An exception occurred when calling " #callback " on monitors"; } \
 if (_state == USCXML_DESTROYED) { throw std::bad_weak_ptr(); }
 
+// dispatch only to the monitors of a MonitorSnapshot that override the callback
 #define USCXML_MONITOR_CALLBACK(callbacks, function) { \
-if (callbacks.size() > 0) {\
+const uscxml::MonitorSnapshot& monitorSnapshot = (callbacks); \
+if (monitorSnapshot.listens(uscxml::MonitorCallback::function)) {\
 const std::string& inptr = _callbacks->getSessionId(); \
-for (auto callback : callbacks) { callback->function(inptr); } } }
+for (auto& monitorEntry : monitorSnapshot.monitors) { \
+if (monitorEntry.second & uscxml::MonitorCallback::function) monitorEntry.first->function(inptr); } } }
 
 #define USCXML_MONITOR_CALLBACK1(callbacks, function, arg1) { \
-if (callbacks.size() > 0) {\
+const uscxml::MonitorSnapshot& monitorSnapshot = (callbacks); \
+if (monitorSnapshot.listens(uscxml::MonitorCallback::function)) {\
 const std::string& inptr = _callbacks->getSessionId(); \
-for (auto callback : callbacks) { callback->function(inptr, arg1); } } }
+for (auto& monitorEntry : monitorSnapshot.monitors) { \
+if (monitorEntry.second & uscxml::MonitorCallback::function) monitorEntry.first->function(inptr, arg1); } } }
 
 #define USCXML_MONITOR_CALLBACK2(callbacks, function, arg1, arg2) { \
-if (callbacks.size() > 0) {\
+const uscxml::MonitorSnapshot& monitorSnapshot = (callbacks); \
+if (monitorSnapshot.listens(uscxml::MonitorCallback::function)) {\
 const std::string& inptr = _callbacks->getSessionId(); \
-for (auto callback : callbacks) { callback->function(inptr, arg1, arg2); } } }
+for (auto& monitorEntry : monitorSnapshot.monitors) { \
+if (monitorEntry.second & uscxml::MonitorCallback::function) monitorEntry.first->function(inptr, arg1, arg2); } } }
 
 // forward declare
 namespace XERCESC_NS {
@@ -58,6 +67,34 @@ namespace uscxml {
 
 class Interpreter;
 
+/**
+ * The callbacks of an InterpreterMonitor as bits, named after the methods.
+ */
+struct USCXML_API MonitorCallback {
+	enum Mask {
+		beforeProcessingEvent  = 1 << 0,
+		beforeMicroStep        = 1 << 1,
+		beforeExitingState     = 1 << 2,
+		afterExitingState      = 1 << 3,
+		beforeExecutingContent = 1 << 4,
+		afterExecutingContent  = 1 << 5,
+		beforeUninvoking       = 1 << 6,
+		afterUninvoking        = 1 << 7,
+		beforeTakingTransition = 1 << 8,
+		afterTakingTransition  = 1 << 9,
+		beforeEnteringState    = 1 << 10,
+		afterEnteringState     = 1 << 11,
+		beforeInvoking         = 1 << 12,
+		afterInvoking          = 1 << 13,
+		afterMicroStep         = 1 << 14,
+		onStableConfiguration  = 1 << 15,
+		beforeCompletion       = 1 << 16,
+		afterCompletion        = 1 << 17,
+		reportIssue            = 1 << 18,
+		ALL                    = (1 << 19) - 1
+	};
+};
+
 class USCXML_API InterpreterMonitor {
 public:
 	InterpreterMonitor() : _copyToInvokers(false) {
@@ -66,6 +103,14 @@ public:
 	InterpreterMonitor(Logger logger) : _copyToInvokers(false), _logger(logger) {}
 	virtual ~InterpreterMonitor() {}
 
+	/**
+	 * The callbacks this monitor wants to receive as a MonitorCallback mask,
+	 * queried once when the monitor is added to an interpreter.
+	 */
+	virtual uint32_t getCallbacks() {
+		return MonitorCallback::ALL;
+	}
+
 	virtual void beforeProcessingEvent(const std::string& sessionId,
 	                                   const Event& event) {}
 	virtual void beforeMicroStep(const std::string& sessionId) {}
@@ -130,6 +175,30 @@ protected:
 	Logger _logger;
 };
 
+/**
+ * An immutable copy of the monitors of an interpreter with the callbacks
+ * each of them wants. Interpreters publish a new one whenever a monitor is
+ * added or removed.
+ */
+class USCXML_API MonitorSnapshot {
+public:
+	MonitorSnapshot() : callbacks(0) {}
+	MonitorSnapshot(const std::set<InterpreterMonitor*>& monitorSet) : callbacks(0) {
+		for (auto monitor : monitorSet) {
+			uint32_t mask = monitor->getCallbacks();
+			monitors.push_back(std::make_pair(monitor, mask));
+			callbacks |= mask;
+		}
+	}
+
+	bool listens(uint32_t callback) const {
+		return (callbacks & callback) != 0;
+	}
+
+	std::vector<std::pair<InterpreterMonitor*, uint32_t> > monitors;
+	uint32_t callbacks; ///< Union of the callbacks of all monitors
+};
+
 class USCXML_API StateTransitionMonitor : public uscxml::InterpreterMonitor {
 public:
 	StateTransitionMonitor(std::string prefix = "") : _logPrefix(prefix) {}
@@ -143,6 +212,16 @@ public:
 	virtual void beforeEnteringState(const std::string& sessionId, const std::string& stateName, const XERCESC_NS::DOMElement* state);
 	virtual void beforeMicroStep(const std::string& sessionId);
 
+	virtual uint32_t getCallbacks() {
+		return (MonitorCallback::beforeTakingTransition |
+		        MonitorCallback::beforeExecutingContent |
+		        MonitorCallback::onStableConfiguration |
+		        MonitorCallback::beforeProcessingEvent |
+		        MonitorCallback::beforeExitingState |
+		        MonitorCallback::beforeEnteringState |
+		        MonitorCallback::beforeMicroStep);
+	}
+
 protected:
 	static std::recursive_mutex _mutex;
 	std::string _logPrefix;
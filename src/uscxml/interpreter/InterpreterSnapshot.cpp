@@ -0,0 +1,259 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "InterpreterSnapshot.h"
+#include "uscxml/messages/Event.h"
+
+#include <list>
+#include <string.h>
+
+// sections present in a delta
+#define DELTA_EXTERNAL_QUEUE 0x01
+#define DELTA_DELAY_QUEUE    0x02
+#define DELTA_MICROSTEPPER   0x04
+
+// equal bytes to tolerate within a run of changed bytes
+#define DELTA_RUN_GAP 8
+
+namespace uscxml {
+
+/**
+ * The microstepper section is opaque, but mostly made up of bitsets with the
+ * same length. It is diffed as runs of changed bytes.
+ */
+static void writeByteRuns(SnapshotWriter& writer, const std::string& from, const std::string& to) {
+	std::list<std::pair<size_t, size_t> > runs;
+	size_t i = 0;
+	while (i < to.size()) {
+		if (i < from.size() && from[i] == to[i]) {
+			i++;
+			continue;
+		}
+		size_t start = i;
+		size_t lastChanged = i;
+		while (i < to.size() && i - lastChanged <= DELTA_RUN_GAP) {
+			if (i >= from.size() || from[i] != to[i])
+				lastChanged = i;
+			i++;
+		}
+		runs.push_back(std::make_pair(start, lastChanged + 1 - start));
+		i = lastChanged + 1;
+	}
+
+	writer.writeVarint(to.size());
+	writer.writeVarint(runs.size());
+	for (auto& run : runs) {
+		writer.writeVarint(run.first);
+		writer.writeBytes(to.data() + run.first, run.second);
+	}
+}
+
+static void readByteRuns(SnapshotReader& reader, std::string& to) {
+	// bytes past the previous section have to be in the runs that follow
+	uint64_t toSize = reader.readVarint();
+	if (toSize > to.size() + reader.remaining()) {
+		ERROR_PLATFORM_THROW("Malformed microstepper delta");
+	}
+	to.resize(toSize);
+	size_t nrRuns = reader.readVarint();
+	for (size_t i = 0; i < nrRuns; i++) {
+		uint64_t offset = reader.readVarint();
+		uint64_t size = reader.readVarint();
+		const char* bytes = reader.readBytes(size);
+		if (offset > to.size() || size > to.size() - offset) {
+			ERROR_PLATFORM_THROW("Malformed microstepper delta");
+		}
+		memcpy(&to[offset], bytes, size);
+	}
+}
+
+std::string InterpreterSnapshot::encode() const {
+	std::string encoded;
+	SnapshotWriter writer(encoded);
+	writer.writeHeader();
+
+	writer.writeString(md5);
+	writer.writeString(url);
+	writer.writeVarint(sequence);
+
+	// sections are in the order they are applied with JSON
+	writer.writeRaw(externalQueue);
+	writer.writeRaw(delayQueue);
+
+	writer.writeVarint(datas.size());
+	for (auto& data : datas) {
+		writer.writeRaw(data);
+	}
+
+	writer.writeString(microstepper);
+
+	writer.writeVarint(invokers.size());
+	for (auto& invoker : invokers) {
+		writer.writeVarint(invoker.first);
+		writer.writeRaw(invoker.second);
+	}
+
+	return encoded;
+}
+
+InterpreterSnapshot InterpreterSnapshot::decode(const std::string& encoded) {
+	InterpreterSnapshot snapshot;
+	SnapshotReader reader(encoded);
+	if (reader.readHeader()) {
+		ERROR_PLATFORM_THROW("Expected a complete snapshot, not a delta");
+	}
+
+	snapshot.md5 = reader.readString();
+	snapshot.url = reader.readString();
+	snapshot.sequence = reader.readVarint();
+
+	snapshot.externalQueue = reader.readDataBytes();
+	snapshot.delayQueue = reader.readDataBytes();
+
+	size_t nrDatas = reader.readVarint();
+	for (size_t i = 0; i < nrDatas; i++) {
+		snapshot.datas.push_back(reader.readDataBytes());
+	}
+
+	snapshot.microstepper = reader.readString();
+
+	size_t nrInvokers = reader.readVarint();
+	for (size_t i = 0; i < nrInvokers; i++) {
+		size_t index = reader.readVarint();
+		snapshot.invokers[index] = reader.readDataBytes();
+	}
+
+	return snapshot;
+}
+
+std::string InterpreterSnapshot::diff(const InterpreterSnapshot& newer) const {
+	if (newer.md5 != md5 || newer.datas.size() != datas.size()) {
+		ERROR_PLATFORM_THROW("Cannot diff snapshots of different documents");
+	}
+
+	std::string encoded;
+	SnapshotWriter writer(encoded);
+	writer.writeHeader(true);
+
+	writer.writeString(md5);
+	writer.writeVarint(sequence);
+	writer.writeVarint(newer.sequence);
+
+	uint8_t sections = 0;
+	if (newer.externalQueue != externalQueue)
+		sections |= DELTA_EXTERNAL_QUEUE;
+	if (newer.delayQueue != delayQueue)
+		sections |= DELTA_DELAY_QUEUE;
+	if (newer.microstepper != microstepper)
+		sections |= DELTA_MICROSTEPPER;
+	writer.writeVarint(sections);
+
+	if (sections & DELTA_EXTERNAL_QUEUE)
+		writer.writeRaw(newer.externalQueue);
+	if (sections & DELTA_DELAY_QUEUE)
+		writer.writeRaw(newer.delayQueue);
+	if (sections & DELTA_MICROSTEPPER)
+		writeByteRuns(writer, microstepper, newer.microstepper);
+
+	std::list<size_t> changedDatas;
+	for (size_t i = 0; i < datas.size(); i++) {
+		if (newer.datas[i] != datas[i])
+			changedDatas.push_back(i);
+	}
+	writer.writeVarint(changedDatas.size());
+	for (auto index : changedDatas) {
+		writer.writeVarint(index);
+		writer.writeRaw(newer.datas[index]);
+	}
+
+	std::list<size_t> changedInvokers;
+	for (auto& invoker : newer.invokers) {
+		auto oldIter = invokers.find(invoker.first);
+		if (oldIter == invokers.end() || oldIter->second != invoker.second)
+			changedInvokers.push_back(invoker.first);
+	}
+	writer.writeVarint(changedInvokers.size());
+	for (auto index : changedInvokers) {
+		writer.writeVarint(index);
+		writer.writeRaw(newer.invokers.at(index));
+	}
+
+	std::list<size_t> removedInvokers;
+	for (auto& invoker : invokers) {
+		if (newer.invokers.find(invoker.first) == newer.invokers.end())
+			removedInvokers.push_back(invoker.first);
+	}
+	writer.writeVarint(removedInvokers.size());
+	for (auto index : removedInvokers) {
+		writer.writeVarint(index);
+	}
+
+	return encoded;
+}
+
+void InterpreterSnapshot::apply(const std::string& delta) {
+	SnapshotReader reader(delta);
+	if (!reader.readHeader()) {
+		ERROR_PLATFORM_THROW("Expected a delta, not a complete snapshot");
+	}
+
+	if (reader.readString() != md5) {
+		ERROR_PLATFORM_THROW("MD5 hash mismatch in delta");
+	}
+	if (reader.readVarint() != sequence) {
+		ERROR_PLATFORM_THROW("Delta does not continue the chain at checkpoint " + toStr(sequence));
+	}
+	uint64_t newSequence = reader.readVarint();
+
+	// work on a copy to leave the snapshot intact on malformed deltas
+	InterpreterSnapshot applied(*this);
+	applied.sequence = newSequence;
+
+	uint64_t sections = reader.readVarint();
+	if (sections & DELTA_EXTERNAL_QUEUE)
+		applied.externalQueue = reader.readDataBytes();
+	if (sections & DELTA_DELAY_QUEUE)
+		applied.delayQueue = reader.readDataBytes();
+	if (sections & DELTA_MICROSTEPPER)
+		readByteRuns(reader, applied.microstepper);
+
+	size_t nrDatas = reader.readVarint();
+	for (size_t i = 0; i < nrDatas; i++) {
+		size_t index = reader.readVarint();
+		if (index >= applied.datas.size()) {
+			ERROR_PLATFORM_THROW("Invalid data element in delta");
+		}
+		applied.datas[index] = reader.readDataBytes();
+	}
+
+	size_t nrInvokers = reader.readVarint();
+	for (size_t i = 0; i < nrInvokers; i++) {
+		size_t index = reader.readVarint();
+		applied.invokers[index] = reader.readDataBytes();
+	}
+
+	size_t nrRemoved = reader.readVarint();
+	for (size_t i = 0; i < nrRemoved; i++) {
+		applied.invokers.erase(reader.readVarint());
+	}
+
+	*this = applied;
+}
+
+}
@@ -0,0 +1,72 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef INTERPRETERSNAPSHOT_H_0B7D5E92
+#define INTERPRETERSNAPSHOT_H_0B7D5E92
+
+#include "uscxml/Common.h"
+#include "uscxml/util/Snapshot.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace uscxml {
+
+/**
+ * @ingroup interpreter
+ *
+ * The sections of a binary interpreter snapshot, each in its encoded form.
+ *
+ * Keeping the sections encoded allows to compare them with a previous
+ * checkpoint and to apply a chain of deltas without instantiating any
+ * values. Data values are identified by their index in the document order
+ * of the data elements, invokers by the index of their invoke element.
+ */
+class USCXML_API InterpreterSnapshot {
+public:
+	InterpreterSnapshot() : sequence(0) {}
+
+	/// Encode as a complete snapshot
+	std::string encode() const;
+	/// Decode a complete snapshot
+	static InterpreterSnapshot decode(const std::string& encoded);
+
+	/// Encode the changes to a newer checkpoint of the same session
+	std::string diff(const InterpreterSnapshot& newer) const;
+	/// Apply a delta with the next sequence number
+	void apply(const std::string& delta);
+
+	std::string md5;
+	std::string url;
+	/// Number of the checkpoint in its chain
+	uint64_t sequence;
+
+	std::string externalQueue;
+	std::string delayQueue;
+	std::vector<std::string> datas;
+	/// Opaque section of the microstepper
+	std::string microstepper;
+	std::map<size_t, std::string> invokers;
+};
+
+}
+
+#endif /* end of include guard: INTERPRETERSNAPSHOT_H_0B7D5E92 */
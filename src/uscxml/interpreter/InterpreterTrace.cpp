@@ -0,0 +1,286 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "uscxml/interpreter/InterpreterTrace.h"
+#include "uscxml/messages/Data.h"
+#include "uscxml/util/Convenience.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace uscxml {
+
+InterpreterTrace::InterpreterTrace(size_t capacity) : _written(0), _writing(0), _nextLocal(0) {
+	uint64_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+	_mask = size - 1;
+
+	_slots.reset(new Slot[size]);
+	for (uint64_t i = 0; i < size; i++) {
+		_slots[i].time.store(0, std::memory_order_relaxed);
+		_slots[i].word.store(0, std::memory_order_relaxed);
+	}
+
+	// we will need the rate to convert timestamps
+	Benchmark::calibrate();
+}
+
+uint32_t InterpreterTrace::localName(const std::string& name) {
+	uint64_t ringSize = 2 * (_mask + 1);
+
+	auto idIter = _localIds.find(name);
+	if (idIter != _localIds.end() && ((_nextLocal - idIter->second) & ~LOCAL_NAME) <= _mask)
+		return idIter->second | LOCAL_NAME;
+
+	uint32_t id = _nextLocal;
+	_nextLocal = (_nextLocal + 1) & ~LOCAL_NAME;
+
+	std::lock_guard<std::mutex> lock(_localMutex);
+	if (_localNames.size() < ringSize) {
+		_localNames.push_back(LocalName());
+	} else {
+		// recycle the slot, its previous name may be given a new id later
+		LocalName& recycled = _localNames[id % ringSize];
+		auto recycledIter = _localIds.find(recycled.name);
+		if (recycledIter != _localIds.end() && recycledIter->second == recycled.id)
+			_localIds.erase(recycledIter);
+	}
+	LocalName& slot = _localNames[id % ringSize];
+	slot.id = id;
+	slot.name = name;
+	_localIds[name] = id;
+
+	return id | LOCAL_NAME;
+}
+
+bool InterpreterTrace::getLocalName(uint32_t id, std::string& name) const {
+	id &= ~LOCAL_NAME;
+
+	std::lock_guard<std::mutex> lock(_localMutex);
+	size_t index = id % (2 * (_mask + 1));
+	if (index >= _localNames.size() || _localNames[index].id != id)
+		return false;
+	name = _localNames[index].name;
+	return true;
+}
+
+std::vector<InterpreterTrace::Record> InterpreterTrace::getRecords(size_t maxRecords) const {
+	uint64_t end = _written.load(std::memory_order_acquire);
+	uint64_t count = (std::min)((uint64_t)maxRecords, (std::min)(end, _mask + 1));
+	uint64_t begin = end - count;
+
+	std::vector<Record> records(count);
+	for (uint64_t i = begin; i < end; i++) {
+		const Slot& slot = _slots[i & _mask];
+		uint64_t word = slot.word.load(std::memory_order_relaxed);
+		Record& record = records[i - begin];
+		record.time = slot.time.load(std::memory_order_relaxed);
+		record.id = (uint32_t)(word >> 32);
+		record.type = (uint16_t)(word >> 16);
+		record.detail = (uint16_t)word;
+	}
+
+	// the writer may have lapped us meanwhile, drop what it overwrote
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t writing = _writing.load(std::memory_order_relaxed);
+	if (writing > _mask + 1 && writing - (_mask + 1) > begin) {
+		uint64_t overwritten = (std::min)(writing - (_mask + 1) - begin, count);
+		records.erase(records.begin(), records.begin() + overwritten);
+	}
+	return records;
+}
+
+const char* InterpreterTrace::typeName(Type type) {
+	switch (type) {
+	case EVENT:
+		return "event";
+	case EXIT_STATE:
+		return "exit";
+	case TAKE_TRANSITION:
+		return "transition";
+	case ENTER_STATE:
+		return "enter";
+	case CONTENT_BEGIN:
+		return "content_begin";
+	case CONTENT_END:
+		return "content_end";
+	case STABLE:
+		return "stable";
+	default:
+		return "";
+	}
+}
+
+void InterpreterTrace::write(std::ostream& stream, Format format, const std::string& sessionId, const std::vector<Record>& records, const Names& names) {
+	switch (format) {
+	case BINARY:
+		writeBinary(stream, sessionId, records, names);
+		break;
+	case CHROME:
+		writeChrome(stream, sessionId, records, names);
+		break;
+	}
+}
+
+static void writeUInt(std::ostream& stream, uint64_t value, size_t bytes) {
+	char buffer[8];
+	for (size_t i = 0; i < bytes; i++) {
+		buffer[i] = (char)(value & 0xff);
+		value >>= 8;
+	}
+	stream.write(buffer, bytes);
+}
+
+static void writeString(std::ostream& stream, const std::string& value) {
+	writeUInt(stream, value.size(), 4);
+	stream.write(value.data(), value.size());
+}
+
+static void writeNames(std::ostream& stream, const std::map<uint32_t, std::string>& names) {
+	writeUInt(stream, names.size(), 4);
+	for (auto& name : names) {
+		writeUInt(stream, name.first, 4);
+		writeString(stream, name.second);
+	}
+}
+
+void InterpreterTrace::writeBinary(std::ostream& stream, const std::string& sessionId, const std::vector<Record>& records, const Names& names) {
+	stream.write("USCXMLTR", 8);
+	writeUInt(stream, 1, 4);
+	writeString(stream, sessionId);
+
+	double rate = Benchmark::ticksPerNanosecond();
+	uint64_t rateBits;
+	memcpy(&rateBits, &rate, sizeof(rate));
+	writeUInt(stream, rateBits, 8);
+
+	writeNames(stream, names.events);
+	writeNames(stream, names.states);
+	writeNames(stream, names.transitions);
+
+	writeUInt(stream, records.size(), 4);
+	for (auto& record : records) {
+		writeUInt(stream, record.time, 8);
+		writeUInt(stream, record.id, 4);
+		writeUInt(stream, record.type, 2);
+		writeUInt(stream, record.detail, 2);
+	}
+}
+
+static std::string nameFor(const std::map<uint32_t, std::string>& names, uint32_t id) {
+	auto nameIter = names.find(id);
+	if (nameIter != names.end())
+		return nameIter->second;
+	return "#" + toStr(id);
+}
+
+void InterpreterTrace::writeChrome(std::ostream& stream, const std::string& sessionId, const std::vector<Record>& records, const Names& names) {
+	std::list<Session> sessions(1);
+	sessions.front().id = sessionId;
+	sessions.front().records = records;
+	sessions.front().names = names;
+	writeChrome(stream, sessions);
+}
+
+void InterpreterTrace::writeChrome(std::ostream& stream, const std::list<Session>& sessions) {
+	static const char* contents[] = { "onentry", "onexit", "transition" };
+	double rate = Benchmark::ticksPerNanosecond();
+
+	// timestamps of all sessions are taken from the same clock
+	uint64_t start = (uint64_t)-1;
+	for (auto& session : sessions) {
+		if (session.records.size() > 0)
+			start = (std::min)(start, session.records.front().time);
+	}
+	if (start == (uint64_t)-1)
+		start = 0;
+
+	bool first = true;
+	uint32_t tid = 0;
+	stream << "{\"traceEvents\":[";
+	for (auto& session : sessions) {
+		const std::vector<Record>& records = session.records;
+		const Names& names = session.names;
+		tid++;
+
+		stream << (first ? "" : ",") << std::endl;
+		first = false;
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid;
+		stream << ",\"args\":{\"name\":" << Data::toJSON(Data(session.id, Data::VERBATIM)) << "}}";
+
+		for (size_t i = 0; i < records.size(); i++) {
+			const Record& record = records[i];
+			std::string name;
+			std::string category;
+			char phase = 'i';
+
+			switch (record.type) {
+			case EVENT:
+				category = "event";
+				name = (record.id != 0 ? nameFor(names.events, record.id) : "(not interned)");
+				break;
+			case EXIT_STATE:
+			case ENTER_STATE:
+				category = "state";
+				name = std::string(typeName((Type)record.type)) + " " + nameFor(names.states, record.id);
+				break;
+			case TAKE_TRANSITION:
+				category = "transition";
+				name = nameFor(names.transitions, record.id);
+				break;
+			case CONTENT_BEGIN:
+			case CONTENT_END:
+				category = "content";
+				phase = (record.type == CONTENT_BEGIN ? 'B' : 'E');
+				name = std::string(contents[record.detail < 3 ? record.detail : 0]) + " " +
+				       (record.detail == ON_TRANSITION ? nameFor(names.transitions, record.id) : nameFor(names.states, record.id));
+				break;
+			case STABLE:
+				category = "step";
+				name = "stable";
+				break;
+			default:
+				continue;
+			}
+
+			// timestamps are microseconds, keep nanosecond resolution without touching the stream's precision
+			uint64_t ns = (uint64_t)((double)(record.time - start) / rate);
+			char ts[32];
+			snprintf(ts, sizeof(ts), "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+
+			stream << "," << std::endl;
+			stream << "{\"name\":" << Data::toJSON(Data(name, Data::VERBATIM)) << ",\"cat\":\"" << category << "\",\"ph\":\"" << phase << "\"";
+			stream << ",\"ts\":" << ts << ",\"pid\":1,\"tid\":" << tid;
+			if (phase == 'i')
+				stream << ",\"s\":\"t\"";
+			if (record.type == EVENT)
+				stream << ",\"args\":{\"external\":" << (record.detail ? "true" : "false") << "}";
+			stream << "}";
+		}
+	}
+
+	stream << std::endl << "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"sessions\":[";
+	for (auto iter = sessions.begin(); iter != sessions.end(); iter++)
+		stream << (iter != sessions.begin() ? "," : "") << Data::toJSON(Data(iter->id, Data::VERBATIM));
+	stream << "]}}" << std::endl;
+}
+
+}
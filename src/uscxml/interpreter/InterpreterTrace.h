@@ -0,0 +1,197 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef INTERPRETERTRACE_H_8B2E4F61
+#define INTERPRETERTRACE_H_8B2E4F61
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "uscxml/Common.h"
+#include "uscxml/debug/Benchmark.h"
+
+namespace uscxml {
+
+/**
+ * @ingroup interpreter
+ * Flight recorder of a single session. The interpreter thread appends compact
+ * records to a ring buffer without taking a lock and any thread may copy the
+ * most recent records at any time. Records overwritten while they are copied
+ * are dropped from the copy.
+ */
+class USCXML_API InterpreterTrace {
+public:
+	enum Type {
+		EVENT = 1, ///< An event was dequeued, id is its EventName id or a LOCAL_NAME, detail is 1 for external events
+		EXIT_STATE, ///< id is the state's index in the microstepper
+		TAKE_TRANSITION, ///< id is the transition's index in the microstepper
+		ENTER_STATE, ///< id is the state's index in the microstepper
+		CONTENT_BEGIN, ///< Executable content of a state or transition, detail is the Content
+		CONTENT_END,
+		STABLE ///< The configuration is stable
+	};
+
+	enum Content {
+		ON_ENTRY = 0,
+		ON_EXIT,
+		ON_TRANSITION
+	};
+
+	enum Format {
+		BINARY, ///< Header, names and 16 bytes per record, see writeBinary()
+		CHROME ///< JSON for chrome://tracing and compatible viewers
+	};
+
+	struct Record {
+		uint64_t time; ///< Benchmark::now() when recorded
+		uint32_t id;
+		uint16_t type;
+		uint16_t detail;
+	};
+
+	/// Names for the ids in records, missing ones are written as their index
+	struct Names {
+		std::map<uint32_t, std::string> events;
+		std::map<uint32_t, std::string> states;
+		std::map<uint32_t, std::string> transitions;
+	};
+
+	/// The records copied from the trace of a session and the names for their ids
+	struct Session {
+		std::string id;
+		std::vector<Record> records;
+		Names names;
+	};
+
+	/// Records the begin and end of executable content while in scope
+	class ContentScope {
+	public:
+		ContentScope(InterpreterTrace* trace, Content content, uint32_t id) : _trace(trace), _content(content), _id(id) {
+			if (_trace)
+				_trace->record(CONTENT_BEGIN, _id, _content);
+		}
+		~ContentScope() {
+			if (_trace)
+				_trace->record(CONTENT_END, _id, _content);
+		}
+
+	protected:
+		InterpreterTrace* _trace;
+		Content _content;
+		uint32_t _id;
+	};
+
+	/// Records kept per session unless USCXML_TRACE_RECORDS says otherwise
+	static const size_t DEFAULT_CAPACITY = 1024;
+
+	/// Set in the ids of event names that were not interned and are kept by the trace itself
+	static const uint32_t LOCAL_NAME = 0x80000000;
+
+	/// Capacity is rounded up to a power of two
+	InterpreterTrace(size_t capacity = DEFAULT_CAPACITY);
+
+	/// Only ever called from the interpreter thread
+	void record(Type type, uint32_t id, uint16_t detail = 0) {
+		uint64_t index = _written.load(std::memory_order_relaxed);
+		Slot& slot = _slots[index & _mask];
+
+		// announce the slot before overwriting it, readers drop what they copied from it
+		_writing.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.time.store(Benchmark::now(), std::memory_order_relaxed);
+		slot.word.store(((uint64_t)id << 32) | ((uint64_t)type << 16) | detail, std::memory_order_relaxed);
+		_written.store(index + 1, std::memory_order_release);
+	}
+
+	/// Record a dequeued event, names that were never interned are kept by the trace
+	void recordEvent(uint32_t nameId, const std::string& name, bool external) {
+		record(EVENT, (nameId != 0 ? nameId : localName(name)), (external ? 1 : 0));
+	}
+
+	/// The name for a LOCAL_NAME id, false once it was recycled
+	bool getLocalName(uint32_t id, std::string& name) const;
+
+	/// Copy of the last records in the order they were recorded, callable from any thread
+	std::vector<Record> getRecords(size_t maxRecords = (size_t)-1) const;
+
+	size_t getCapacity() const {
+		return _mask + 1;
+	}
+
+	/// Records written since the trace was created, including overwritten ones
+	uint64_t getWritten() const {
+		return _written.load(std::memory_order_acquire);
+	}
+
+	static void write(std::ostream& stream, Format format, const std::string& sessionId, const std::vector<Record>& records, const Names& names);
+
+	/**
+	 * All integers little-endian:
+	 * "USCXMLTR", uint32 version, session id, double ticks per nanosecond,
+	 * three name tables for events, states and transitions as uint32 count
+	 * followed by uint32 id and name per entry, uint32 number of records and
+	 * the records as uint64 time, uint32 id, uint16 type and uint16 detail.
+	 * Strings are a uint32 length followed by the bytes.
+	 */
+	static void writeBinary(std::ostream& stream, const std::string& sessionId, const std::vector<Record>& records, const Names& names);
+	static void writeChrome(std::ostream& stream, const std::string& sessionId, const std::vector<Record>& records, const Names& names);
+	/// All sessions in one traceEvents array on a common time base, each as its own thread
+	static void writeChrome(std::ostream& stream, const std::list<Session>& sessions);
+
+	static const char* typeName(Type type);
+
+protected:
+	struct Slot {
+		std::atomic<uint64_t> time;
+		std::atomic<uint64_t> word;
+	};
+
+	struct LocalName {
+		uint32_t id;
+		std::string name;
+	};
+
+	uint32_t localName(const std::string& name);
+
+	std::unique_ptr<Slot[]> _slots;
+	uint64_t _mask;
+	std::atomic<uint64_t> _written;
+	std::atomic<uint64_t> _writing;
+
+	/**
+	 * Ring of twice the capacity for names that were not interned, filled on
+	 * demand. A name is given a new id once its old one is a capacity behind,
+	 * so it is only recycled after every record using it was overwritten.
+	 */
+	std::vector<LocalName> _localNames;
+	std::map<std::string, uint32_t> _localIds; ///< Only accessed by the writer
+	uint32_t _nextLocal;
+	mutable std::mutex _localMutex;
+};
+
+}
+
+#endif /* end of include guard: INTERPRETERTRACE_H_8B2E4F61 */
@@ -19,6 +19,8 @@
 
 #include "LargeMicroStep.h"
 #include "uscxml/debug/Benchmark.h"
+#include "uscxml/interpreter/InterpreterMetrics.h"
+#include "uscxml/interpreter/InterpreterTrace.h"
 #include "uscxml/util/Predicates.h"
 
 #include <algorithm>
@@ -56,12 +58,6 @@
 #  define unlikely(x)     (x)
 #endif
 
-#if 0
-#define BENCHMARK(domain) Benchmark bench(domain);
-#else
-#define BENCHMARK(domain)
-#endif
-
 #ifdef USCXML_VERBOSE
 #include <iostream>
 #endif
@@ -198,60 +194,43 @@ bool LargeMicroStep::isInState(const std::string& stateId) {
 	return false;
 }
 
-std::list<DOMElement*> LargeMicroStep::getHistoryCompletion(const DOMElement* history) {
-	std::set<std::string> elements;
-	elements.insert(_xmlPrefix.str() + "history");
-	std::list<DOMElement*> histories = DOMUtils::inPostFixOrder(elements, _scxml);
-
-	std::list<DOMElement*> covered;
-	std::list<DOMElement*> perParentcovered;
-	const DOMNode* parent = NULL;
-
+std::list<DOMElement*> LargeMicroStep::getHistoryCompletion(const DOMElement* history, const ChartIndex& index) {
 	std::list<DOMElement*> completion;
 
-	if (parent != history->getParentNode()) {
-		covered.insert(covered.end(), perParentcovered.begin(), perParentcovered.end());
-		perParentcovered.clear();
-		parent = history->getParentNode();
-	}
+	uint32_t parent = index.getParent(index.getDocumentOrder(history));
+	if (parent == ChartIndex::NONE)
+		return completion;
 
 	bool deep = (HAS_ATTR(history, kXMLCharType) && iequals(ATTR(history, kXMLCharType), "deep"));
 
-	for (size_t j = 0; j < _states.size(); j++) {
+	// the states within the history's parent follow it in document order
+	for (uint32_t j = parent + 1; j <= index.getLastDescendant(parent); j++) {
 		if (_states[j]->element == history)
 			continue;
 
-		if (DOMUtils::isDescendant((DOMNode*)_states[j]->element, history->getParentNode()) && isHistory(_states[j]->element)) {
+		if (isHistory(_states[j]->element)) {
 			((DOMElement*)history)->setUserData(X("hasHistoryChild"), _states[j], NULL);
-		}
-
-		if (DOMUtils::isMember(_states[j]->element, covered))
 			continue;
+		}
 
-		if (deep) {
-			if (DOMUtils::isDescendant(_states[j]->element, history->getParentNode()) && !isHistory(_states[j]->element)) {
-				completion.push_back(_states[j]->element);
-			}
-		} else {
-			if (_states[j]->element->getParentNode() == history->getParentNode() && !isHistory(_states[j]->element)) {
-				completion.push_back(_states[j]->element);
-			}
+		if (deep || index.getParent(j) == parent) {
+			completion.push_back(_states[j]->element);
 		}
 	}
 
 	return completion;
 }
 
-std::list<DOMElement*> LargeMicroStep::getCompletion(const DOMElement* state) {
+std::list<DOMElement*> LargeMicroStep::getCompletion(const DOMElement* state, const ChartIndex& index) {
 	if (isHistory(state)) {
 		// we already did in setHistoryCompletion
-		return getHistoryCompletion(state);
+		return getHistoryCompletion(state, index);
 
 	} else if (isParallel(state)) {
 		return getChildStates(state);
 
 	} else if (HAS_ATTR(state, kXMLCharInitial)) {
-		return getStates(tokenize(ATTR(state, kXMLCharInitial)), _scxml);
+		return getStates(tokenize(ATTR(state, kXMLCharInitial)), index);
 
 	} else {
 		std::list<DOMElement*> completion;
@@ -283,38 +262,28 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 	}
 
 	{
-		BENCHMARK("init resort states")
+		USCXML_BENCHMARK("LargeMicroStep: init resort states");
 		resortStates(_scxml, _xmlPrefix);
 	}
 
-	std::set<std::string> stateIds;
-
 	/** -- All things states -- */
 
+	// index the resorted states once instead of searching the DOM per state
+	ChartIndex index(_scxml);
+
 	std::list<XERCESC_NS::DOMElement*> tmp;
 	size_t i, j;
 
-	tmp = DOMUtils::inDocumentOrder({
-		_xmlPrefix.str() + "state",
-		_xmlPrefix.str() + "parallel",
-		_xmlPrefix.str() + "scxml",
-		_xmlPrefix.str() + "initial",
-		_xmlPrefix.str() + "final",
-		_xmlPrefix.str() + "history"
-	}, _scxml);
-
-	_states.resize(tmp.size());
+	_states.resize(index.getStates().size());
 
 	for (i = 0; i < _states.size(); i++) {
 		_states[i] = new State(i);
-		_states[i]->element = tmp.front();
+		_states[i]->element = index.getStates()[i];
 		if (HAS_ATTR(_states[i]->element, kXMLCharId)) {
 			_states[i]->name = ATTR(_states[i]->element, kXMLCharId);
 		}
 		_states[i]->element->setUserData(X("uscxmlState"), _states[i], NULL);
-		tmp.pop_front();
 	}
-	assert(tmp.size() == 0);
 
 	if (_binding == Binding::EARLY && _states.size() > 0) {
 		// add all data elements to the first state
@@ -331,11 +300,6 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 	}
 
 	for (i = 0; i < _states.size(); i++) {
-		// collect states with an id attribute
-		if (HAS_ATTR(_states[i]->element, kXMLCharId)) {
-			stateIds.insert(ATTR(_states[i]->element, kXMLCharId));
-		}
-
 		// TODO: Reserve space for ancestors? => Measure performance!
 
 		// check for executable content and datamodels
@@ -392,7 +356,7 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		}
 
 		// establish the states' completion
-		std::list<DOMElement*> completionList = getCompletion(_states[i]->element);
+		std::list<DOMElement*> completionList = getCompletion(_states[i]->element, index);
 		for (j = 0; completionList.size() > 0; j++) {
 			_states[i]->completion.insert((State*)completionList.front()->getUserData(X("uscxmlState")));
 			completionList.pop_front();
@@ -448,8 +412,9 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 			_transitions[i]->target.reserve(targets.size());
 
 			for (auto tIter = targets.begin(); tIter != targets.end(); tIter++) {
-				if (stateIds.find(*tIter) != stateIds.end()) {
-					_transitions[i]->target.push_back((State*)getState(*tIter, _scxml)->getUserData(X("uscxmlState")));
+				DOMElement* target = index.getState(*tIter);
+				if (target != NULL) {
+					_transitions[i]->target.push_back((State*)target->getUserData(X("uscxmlState")));
 				}
 			}
 		}
@@ -478,6 +443,7 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 		// the transitions event and condition
 		_transitions[i]->event = (HAS_ATTR(_transitions[i]->element, kXMLCharEvent) ?
 		                          ATTR(_transitions[i]->element, kXMLCharEvent) : "");
+		_transitions[i]->eventDesc = EventDescriptor(_transitions[i]->event);
 		_transitions[i]->cond = (HAS_ATTR(_transitions[i]->element, kXMLCharCond) ?
 		                         ATTR(_transitions[i]->element, kXMLCharCond) : "");
 
@@ -488,6 +454,9 @@ void LargeMicroStep::init(XERCESC_NS::DOMElement* scxml) {
 
 	}
 
+	// events the document raises or sends are matched by the id of their name
+	internEventNames(_scxml, _xmlPrefix.str());
+
 	/* Connect states and transitions */
 	for (auto state : _states) {
 		std::list<XERCESC_NS::DOMElement*> transList = DOMUtils::filterChildElements(_xmlPrefix.str() + "transition", state->element);
@@ -532,7 +501,9 @@ InterpreterState LargeMicroStep::step(size_t blockMs) {
 		return USCXML_INITIALIZED;
 	}
 
-	std::set<InterpreterMonitor*> monitors = _callbacks->getMonitors();
+	const MonitorSnapshot& monitors = _callbacks->getMonitors();
+	InterpreterMetrics* metrics = _callbacks->getMetrics();
+	InterpreterTrace* trace = _callbacks->getTrace();
 
 	_exitSet.clear();
 	_entrySet.clear();
@@ -555,6 +526,7 @@ InterpreterState LargeMicroStep::step(size_t blockMs) {
 			/* call all on exit handlers */
 			for (auto onExit : (*stateIter)->onExit) {
 				try {
+					InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_EXIT, (*stateIter)->documentOrder);
 					_callbacks->process(onExit);
 				} catch (...) {
 					// do nothing and continue with next block
@@ -656,8 +628,17 @@ SELECT_TRANSITIONS:
 	// we read an event - unset stable to signal onstable again later
 	_flags &= ~USCXML_CTX_STABLE;
 
+	// tokenize once for all transitions unless the name was interned
+	if (_event.nameId != 0) {
+		_matchName = &EventName::forId(_event.nameId);
+	} else {
+		_eventName = EventName(_event.name);
+		_matchName = &_eventName;
+	}
+
 	{
-		BENCHMARK("select transitions");
+		USCXML_BENCHMARK("LargeMicroStep: select transitions");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::SELECT);
 
 		// iterate active states in postfix order and find transitions
 		for (auto stateIter = _configurationPostFix.begin(); stateIter != _configurationPostFix.end();) {
@@ -679,7 +660,7 @@ SELECT_TRANSITIONS:
 
 				/* check whether it is explicitly conflicting or compatible, calculate if neither */
 				if (_flags & USCXML_CTX_TRANSITION_FOUND) {
-					BENCHMARK("select transitions conflict & compatible calc");
+					USCXML_BENCHMARK("LargeMicroStep: select transitions conflict & compatible calc");
 					
 					const bool isconflicting = _conflicting.num_blocks() > transition->postFixOrder 
 						&& _conflicting[transition->postFixOrder];
@@ -691,7 +672,7 @@ SELECT_TRANSITIONS:
 					const bool notcompatible = _compatible.num_blocks() <= transition->postFixOrder || !_compatible[transition->postFixOrder];
 					if (notcompatible) {
 						// it is not explicitly compatible, we know nothing!
-						BENCHMARK("select transitions conflict & compatible calc no entry");
+						USCXML_BENCHMARK("LargeMicroStep: select transitions conflict & compatible calc no entry");
 
 						bool conflicts = false;
 						for (auto enabledTrans : _transSet) {
@@ -724,18 +705,23 @@ SELECT_TRANSITIONS:
 				}
 
 				/* is it matched? */
-				if (_event && !_callbacks->isMatched(_event, transition->event))
+				if (_event && !transition->eventDesc.matches(*_matchName))
 					continue;
 
 				/* is it enabled? */
-				if (transition->cond.size() > 0 && !_callbacks->isTrue(transition->cond))
-					continue;
+				if (transition->cond.size() > 0) {
+					// the datamodel is not yet available in init
+					if (!transition->compiledCond)
+						transition->compiledCond = _callbacks->compile(transition->cond);
+					if (!_callbacks->isTrue(*transition->compiledCond))
+						continue;
+				}
 
 				// This transition is fine and ought to be taken!
 
 				/* update conflicting and compatible transitions */
 				if (_flags & USCXML_CTX_TRANSITION_FOUND) {
-					BENCHMARK("select transitions conflict & compatible update");
+					USCXML_BENCHMARK("LargeMicroStep: select transitions conflict & compatible update");
 
 					/* remove all compatible transitions not listed in ours */
 					size_t i = _compatible.find_first();
@@ -840,7 +826,8 @@ SELECT_TRANSITIONS:
 
 	/* REMEMBER_HISTORY: */
 	{
-		BENCHMARK("remember history");
+		USCXML_BENCHMARK("LargeMicroStep: remember history");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::EXIT);
 
 		for (auto state : _states) {
 			if likely(USCXML_STATE_MASK(state->type) != USCXML_STATE_HISTORY_SHALLOW &&
@@ -880,7 +867,8 @@ ESTABLISH_ENTRYSET:
 
 	/* iterate for ancestors */
 	{
-		BENCHMARK("add ancestors");
+		USCXML_BENCHMARK("LargeMicroStep: add ancestors");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::ENTRY);
 		// running from back to front allows us to add parents only due to document order
 		for (auto stateIter = _entrySet.end() ; stateIter != _entrySet.begin() ; /* Do nothing */ ) {
 			--stateIter;
@@ -892,7 +880,8 @@ ESTABLISH_ENTRYSET:
 
 	/* iterate for descendants */
 	{
-		BENCHMARK("add descendants");
+		USCXML_BENCHMARK("LargeMicroStep: add descendants");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::ENTRY);
 		// we cannot use the simplified for loop as inserting will invalidate those iterators
 		for (auto stateIter = _entrySet.begin(); stateIter != _entrySet.end(); stateIter++ ) {
 			State* state = *stateIter;
@@ -903,14 +892,14 @@ ESTABLISH_ENTRYSET:
 				break;
 
 			case USCXML_STATE_PARALLEL: {
-				BENCHMARK("add descendants parallel");
+				USCXML_BENCHMARK("LargeMicroStep: add descendants parallel");
 				_entrySet.insert(state->completion.begin(), state->completion.end());
 				break;
 			}
 
 			case USCXML_STATE_HISTORY_SHALLOW:
 			case USCXML_STATE_HISTORY_DEEP: {
-				BENCHMARK("add descendants history");
+				USCXML_BENCHMARK("LargeMicroStep: add descendants history");
 				if (_configuration.find(state->parent) == _configuration.end() &&
 				        !intersects(state->completion.begin(), state->completion.end(), _history.begin(), _history.end())) {
 
@@ -971,7 +960,7 @@ ESTABLISH_ENTRYSET:
 			}
 
 			case USCXML_STATE_INITIAL: {
-				BENCHMARK("add descendants initial");
+				USCXML_BENCHMARK("LargeMicroStep: add descendants initial");
 				for (auto transition : state->transitions) {
 					_transSet.insert(transition); // remember transition for onentry later
 
@@ -993,11 +982,11 @@ ESTABLISH_ENTRYSET:
 			}
 
 			case USCXML_STATE_COMPOUND: {
-				BENCHMARK("add descendants compound");
+				USCXML_BENCHMARK("LargeMicroStep: add descendants compound");
 
 				/* Compound state may already be complete */
 				{
-					BENCHMARK("add descendants compound intersect entry/child");
+					USCXML_BENCHMARK("LargeMicroStep: add descendants compound intersect entry/child");
 					for (auto child : state->children) {
 						/* one child is already in entry_set */
 						if (_entrySet.find(child) != _entrySet.end())
@@ -1013,7 +1002,7 @@ ESTABLISH_ENTRYSET:
 
 				/* deep completion */
 				{
-					BENCHMARK("add descendants compound deep completion");
+					USCXML_BENCHMARK("LargeMicroStep: add descendants compound deep completion");
 					for (auto completion : state->completion) {
 
 						if (std::binary_search(state->children.begin(), state->children.end(), completion))
@@ -1047,15 +1036,19 @@ NEXT_DESCENDANT:
 
 	/* EXIT_STATES: */
 	{
-		BENCHMARK("exit states");
+		USCXML_BENCHMARK("LargeMicroStep: exit states");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::EXIT);
 		for (auto stateIter = _exitSet.end() ; stateIter != _exitSet.begin() ; /* Do nothing */ ) {
 			State* state = *(--stateIter);
 
 			USCXML_MONITOR_CALLBACK2(monitors, beforeExitingState, state->name, state->element);
+			if (trace)
+				trace->record(InterpreterTrace::EXIT_STATE, state->documentOrder);
 
 			/* call all on exit handlers */
 			for (auto exitIter = state->onExit.begin(); exitIter != state->onExit.end(); exitIter++) {
 				try {
+					InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_EXIT, state->documentOrder);
 					_callbacks->process(*exitIter);
 				} catch (...) {
 					// do nothing and continue with next block
@@ -1071,15 +1064,19 @@ NEXT_DESCENDANT:
 
 	/* TAKE_TRANSITIONS: */
 	{
-		BENCHMARK("take transitions");
+		USCXML_BENCHMARK("LargeMicroStep: take transitions");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::TRANSITIONS);
 		for (auto transition : _transSet) {
 			if ((transition->type & (USCXML_TRANS_HISTORY | USCXML_TRANS_INITIAL)) == 0) {
 				USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, transition->element);
+				if (trace)
+					trace->record(InterpreterTrace::TAKE_TRANSITION, transition->postFixOrder);
 
 				if (transition->onTrans != NULL) {
 
 					/* call executable content in non-history, non-initial transition */
 					try {
+						InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_TRANSITION, transition->postFixOrder);
 						_callbacks->process(transition->onTrans);
 					} catch (...) {
 						// do nothing and continue with next block
@@ -1099,7 +1096,8 @@ NEXT_DESCENDANT:
 
 	/* ENTER_STATES: */
 	{
-		BENCHMARK("enter states");
+		USCXML_BENCHMARK("LargeMicroStep: enter states");
+		InterpreterMetrics::Timer timer(metrics, InterpreterMetrics::ENTRY);
 		for (auto state : _entrySet) {
 
 			/* these are no proper states */
@@ -1110,6 +1108,8 @@ NEXT_DESCENDANT:
 			}
 
 			USCXML_MONITOR_CALLBACK2(monitors, beforeEnteringState, state->name, state->element);
+			if (trace)
+				trace->record(InterpreterTrace::ENTER_STATE, state->documentOrder);
 
 			_configuration.insert(state);
 			_configurationPostFix.insert(state);
@@ -1127,6 +1127,7 @@ NEXT_DESCENDANT:
 			/* call all on entry handlers */
 			for (auto onEntry : state->onEntry) {
 				try {
+					InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_ENTRY, state->documentOrder);
 					_callbacks->process(onEntry);
 				} catch (...) {
 					// do nothing and continue with next block
@@ -1148,10 +1149,13 @@ NEXT_DESCENDANT:
 						continue;
 
 					USCXML_MONITOR_CALLBACK1(monitors, beforeTakingTransition, transition->element);
+					if (trace)
+						trace->record(InterpreterTrace::TAKE_TRANSITION, transition->postFixOrder);
 
 					/* call executable content in transition */
 					if (transition->onTrans != NULL) {
 						try {
+							InterpreterTrace::ContentScope content(trace, InterpreterTrace::ON_TRANSITION, transition->postFixOrder);
 							_callbacks->process(transition->onTrans);
 						} catch (...) {
 							// do nothing and continue with next block
@@ -1165,7 +1169,7 @@ NEXT_DESCENDANT:
 
 			/* handle final states */
 			if unlikely(USCXML_STATE_MASK(state->type) == USCXML_STATE_FINAL) {
-				BENCHMARK("enter states final")
+				USCXML_BENCHMARK("LargeMicroStep: enter states final");
 				if unlikely(state->parent == _states[0]) {
 					// only the topmost scxml is an ancestor
 					_flags |= USCXML_CTX_TOP_LEVEL_FINAL;
@@ -1182,7 +1186,7 @@ NEXT_DESCENDANT:
 				 * 4. If a state remains, not all children of a parallel are final
 				 */
 				{
-					BENCHMARK("enter states final parallel")
+					USCXML_BENCHMARK("LargeMicroStep: enter states final parallel");
 
 					State* anc = state->parent;
 					while(anc != NULL) {
@@ -27,6 +27,7 @@
 
 #include "uscxml/util/Predicates.h"
 #include "uscxml/util/String.h"
+#include "uscxml/util/EventDescriptor.h"
 #include "uscxml/interpreter/InterpreterMonitor.h"
 
 #include <boost/container/flat_set.hpp>
@@ -71,6 +72,13 @@ public:
 	virtual void deserialize(const Data& encodedState);
 	virtual Data serialize();
 
+	virtual XERCESC_NS::DOMElement* getStateElement(uint32_t index) {
+		return (index < _states.size() ? _states[index]->element : NULL);
+	}
+	virtual XERCESC_NS::DOMElement* getTransitionElement(uint32_t index) {
+		return (index < _transitions.size() ? _transitions[index]->element : NULL);
+	}
+
 protected:
 	LargeMicroStep() {} // only for the factory
 
@@ -119,7 +127,9 @@ protected:
 		XERCESC_NS::DOMElement* onTrans = NULL;
 
 		std::string event;
+		EventDescriptor eventDesc;
 		std::string cond;
+		std::shared_ptr<CompiledExpression> compiledCond;
 
 		unsigned char type = 0;
 
@@ -150,8 +160,8 @@ protected:
 
 	void init(XERCESC_NS::DOMElement* scxml);
 
-	std::list<XERCESC_NS::DOMElement*> getCompletion(const XERCESC_NS::DOMElement* state);
-	std::list<XERCESC_NS::DOMElement*> getHistoryCompletion(const XERCESC_NS::DOMElement* history);
+	std::list<XERCESC_NS::DOMElement*> getCompletion(const XERCESC_NS::DOMElement* state, const ChartIndex& index);
+	std::list<XERCESC_NS::DOMElement*> getHistoryCompletion(const XERCESC_NS::DOMElement* history, const ChartIndex& index);
 
 	unsigned char _flags = 0;
 	boost::container::flat_set<boost::container::flat_set<State*, StateOrder> > _microstepConfigurations;
@@ -159,6 +169,8 @@ protected:
 	bool _isInitialized = false;
 	bool _isCancelled = false;
 	Event _event; // we do not care about the event's representation
+	EventName _eventName; ///< The tokenized name of an event that was not interned
+	const EventName* _matchName = NULL;
 
 	std::list<XERCESC_NS::DOMElement*> _globalScripts;
 
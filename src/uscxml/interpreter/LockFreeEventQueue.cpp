@@ -0,0 +1,205 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "LockFreeEventQueue.h"
+
+#include <chrono>
+#include <limits>
+#include <utility>
+
+namespace uscxml {
+
+/**
+ * This is Dmitry Vyukov's intrusive MPSC queue: producers exchange the head
+ * and link the previous head to their node afterwards, the consumer follows
+ * the links from the tail. A consumer may briefly see an empty queue while a
+ * producer is between both steps, it will be woken up by that producer.
+ *
+ * All accesses to _head, Node::next and _sleeping are sequentially
+ * consistent: either the consumer sees a node linked after it announced to
+ * sleep or the producer sees the consumer sleeping after linking its node.
+ */
+
+LockFreeEventQueue::LockFreeEventQueue() : _sleeping(false) {
+	_tail = new Node();
+	_head.store(_tail);
+}
+
+LockFreeEventQueue::~LockFreeEventQueue() {
+	while (_tail != NULL) {
+		Node* next = _tail->next.load();
+		delete _tail;
+		_tail = next;
+	}
+}
+
+std::shared_ptr<EventQueueImpl> LockFreeEventQueue::create() {
+	return std::shared_ptr<EventQueueImpl>(new LockFreeEventQueue());
+}
+
+void LockFreeEventQueue::enqueue(const Event& event) {
+	Node* node = new Node(event);
+	Node* prev = _head.exchange(node);
+	prev->next.store(node);
+
+	if (_sleeping.load()) {
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_cond.notify_all();
+	}
+}
+
+void LockFreeEventQueue::enqueueBatch(const std::list<Event>& events) {
+	if (events.empty())
+		return;
+
+	// link the nodes privately and publish them with a single exchange
+	Node* first = NULL;
+	Node* last = NULL;
+	for (auto& event : events) {
+		Node* node = new Node(event);
+		if (last != NULL) {
+			last->next.store(node);
+		} else {
+			first = node;
+		}
+		last = node;
+	}
+
+	Node* prev = _head.exchange(last);
+	prev->next.store(first);
+
+	if (_sleeping.load()) {
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_cond.notify_all();
+	}
+}
+
+bool LockFreeEventQueue::pop(Event& event) {
+	std::lock_guard<std::mutex> lock(_consumerMutex);
+
+	Node* tail = _tail;
+	Node* next = tail->next.load();
+	if (next == NULL)
+		return false;
+
+	// next becomes the new stub node
+	event = std::move(next->event);
+	_tail = next;
+	delete tail;
+	return true;
+}
+
+size_t LockFreeEventQueue::pop(std::list<Event>& events, size_t max) {
+	std::lock_guard<std::mutex> lock(_consumerMutex);
+
+	size_t popped = 0;
+	while (popped < max) {
+		Node* tail = _tail;
+		Node* next = tail->next.load();
+		if (next == NULL)
+			break;
+
+		events.push_back(std::move(next->event));
+		_tail = next;
+		delete tail;
+		popped++;
+	}
+	return popped;
+}
+
+bool LockFreeEventQueue::await(size_t blockMs, const std::function<bool()>& tryPop) {
+	if (tryPop())
+		return true;
+	if (blockMs == 0)
+		return false;
+
+	using namespace std::chrono;
+	steady_clock::time_point now = steady_clock::now();
+	steady_clock::time_point endTime = steady_clock::time_point::max();
+	bool forever = true;
+
+	// now + milliseconds(blockMs) may not fit into the duration type, see BasicEventQueue
+	if (blockMs < (size_t)duration_cast<milliseconds>(steady_clock::duration::max() - now.time_since_epoch()).count()) {
+		endTime = now + milliseconds(blockMs);
+		forever = false;
+	}
+
+	bool popped = false;
+	std::unique_lock<std::mutex> lock(_sleepMutex);
+	while(true) {
+		_sleeping.store(true);
+		if ((popped = tryPop()))
+			break;
+
+		if (forever) {
+			_cond.wait(lock);
+		} else if (_cond.wait_until(lock, endTime) == std::cv_status::timeout) {
+			popped = tryPop();
+			break;
+		}
+	}
+	_sleeping.store(false);
+	return popped;
+}
+
+Event LockFreeEventQueue::dequeue(size_t blockMs) {
+	Event event;
+	await(blockMs, [this, &event]() {
+		return pop(event);
+	});
+	return event;
+}
+
+size_t LockFreeEventQueue::dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs) {
+	if (max == 0)
+		return 0;
+
+	size_t dequeued = 0;
+	await(blockMs, [this, &events, &dequeued, max]() {
+		dequeued = pop(events, max);
+		return dequeued > 0;
+	});
+	return dequeued;
+}
+
+void LockFreeEventQueue::reset() {
+	Event event;
+	while(pop(event)) {}
+}
+
+Data LockFreeEventQueue::serialize() {
+	std::lock_guard<std::mutex> lock(_consumerMutex);
+	Data serialized;
+
+	// keep the format of the BasicEventQueue
+	for (Node* node = _tail->next.load(); node != NULL; node = node->next.load()) {
+		serialized["BasicEventQueue"].array.push_back(node->event);
+	}
+	return serialized;
+}
+
+void LockFreeEventQueue::deserialize(const Data& data) {
+	if (data.hasKey("BasicEventQueue")) {
+		for (auto event : data["BasicEventQueue"].array) {
+			enqueue(Event::fromData(event));
+		}
+	}
+}
+
+}
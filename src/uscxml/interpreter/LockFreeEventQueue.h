@@ -0,0 +1,87 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef LOCKFREEEVENTQUEUE_H_8E2B5C17
+#define LOCKFREEEVENTQUEUE_H_8E2B5C17
+
+#include "EventQueueImpl.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <list>
+
+namespace uscxml {
+
+/**
+ * @ingroup eventqueue
+ * @ingroup impl
+ *
+ * An unbounded multi-producer / single-consumer event queue.
+ *
+ * Enqueuing is wait-free and never takes a lock unless the consumer is
+ * blocked in dequeue() and needs to be woken up. Only a single thread, the
+ * interpreter's, may dequeue. Serialization is compatible with the
+ * BasicEventQueue.
+ */
+class USCXML_API LockFreeEventQueue : public EventQueueImpl {
+public:
+	LockFreeEventQueue();
+	virtual ~LockFreeEventQueue();
+	virtual std::shared_ptr<EventQueueImpl> create();
+	virtual Event dequeue(size_t blockMs);
+	virtual void enqueue(const Event& event);
+	virtual void reset();
+	virtual Data serialize();
+	virtual void deserialize(const Data& data);
+
+	virtual void enqueueBatch(const std::list<Event>& events);
+	virtual size_t dequeueBatch(std::list<Event>& events, size_t max, size_t blockMs);
+
+protected:
+	struct Node {
+		Node() : next(NULL) {}
+		Node(const Event& event) : next(NULL), event(event) {}
+		std::atomic<Node*> next;
+		Event event;
+	};
+
+	bool pop(Event& event);
+	size_t pop(std::list<Event>& events, size_t max);
+	/// Block up to blockMs until tryPop succeeds
+	bool await(size_t blockMs, const std::function<bool()>& tryPop);
+
+	/// Producers append at the head
+	std::atomic<Node*> _head;
+	/// The consumer removes after the tail, which is always a stub node
+	Node* _tail;
+
+	/// Serializes the consumer with reset() and serialize() only
+	std::mutex _consumerMutex;
+
+	/// Eventcount to block the consumer
+	std::atomic<bool> _sleeping;
+	std::mutex _sleepMutex;
+	std::condition_variable _cond;
+};
+
+}
+
+#endif /* end of include guard: LOCKFREEEVENTQUEUE_H_8E2B5C17 */
@@ -20,8 +20,37 @@
 #include "MicroStep.h"
 #include "MicroStepImpl.h"
 
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/String.h"
+#include "uscxml/util/EventDescriptor.h"
+
 namespace uscxml {
 
+std::set<uint32_t> MicroStepImpl::internEventNames(const XERCESC_NS::DOMElement* scxml, const std::string& xmlPrefix) {
+	std::set<uint32_t> ids;
+	std::list<XERCESC_NS::DOMElement*> elements = DOMUtils::inDocumentOrder({
+		xmlPrefix + "transition",
+		xmlPrefix + "send",
+		xmlPrefix + "raise"
+	}, scxml);
+
+	for (auto element : elements) {
+		if (!HAS_ATTR(element, kXMLCharEvent))
+			continue;
+
+		if (iequals(TAGNAME(element), xmlPrefix + "transition")) {
+			// every descriptor is also the name of an event it matches
+			EventDescriptor eventDesc(ATTR(element, kXMLCharEvent));
+			for (auto& desc : eventDesc.getDescriptors())
+				ids.insert(desc.id);
+		} else {
+			ids.insert(EventName::intern(ATTR(element, kXMLCharEvent)));
+		}
+	}
+	ids.erase(0);
+	return ids;
+}
+
 InterpreterState MicroStep::step(size_t blockMs) {
 	return _impl->step(blockMs);
 }
@@ -52,6 +81,14 @@ Data MicroStep::serialize() {
 	return _impl->serialize();
 }
 
+void MicroStep::readSnapshot(SnapshotReader& reader) {
+	_impl->readSnapshot(reader);
+}
+
+void MicroStep::writeSnapshot(SnapshotWriter& writer) {
+	_impl->writeSnapshot(writer);
+}
+
 std::shared_ptr<MicroStepImpl> MicroStep::getImpl() const {
 	return _impl;
 }
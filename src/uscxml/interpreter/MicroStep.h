@@ -38,6 +38,8 @@ class DOMElement;
 namespace uscxml {
 
 class MicroStepImpl;
+class SnapshotReader;
+class SnapshotWriter;
 
 /**
  * @ingroup microstep
@@ -62,6 +64,12 @@ public:
 	/// @copydoc MicroStepImpl::serialize
 	virtual Data serialize();
 
+	/// @copydoc MicroStepImpl::readSnapshot
+	virtual void readSnapshot(SnapshotReader& reader);
+
+	/// @copydoc MicroStepImpl::writeSnapshot
+	virtual void writeSnapshot(SnapshotWriter& writer);
+
 	std::shared_ptr<MicroStepImpl> getImpl() const;
 protected:
 	std::shared_ptr<MicroStepImpl> _impl;
@@ -27,11 +27,16 @@
 #include "uscxml/Common.h"
 #include "uscxml/Interpreter.h"
 #include "uscxml/messages/Event.h"
+#include "uscxml/util/Snapshot.h"
 
 
 namespace uscxml {
 
 class InterpreterMonitor;
+class MonitorSnapshot;
+class InterpreterMetrics;
+class InterpreterTrace;
+class CompiledExpression;
 
 /**
  * @ingroup microstep
@@ -47,6 +52,8 @@ public:
 
 	/** Datamodel */
 	virtual bool isTrue(const std::string& expr) = 0;
+	virtual bool isTrue(CompiledExpression& expr) = 0;
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr) = 0;
 	virtual void initData(XERCESC_NS::DOMElement* element) = 0;
 
 	/** Executable Content */
@@ -57,9 +64,17 @@ public:
 	virtual void uninvoke(XERCESC_NS::DOMElement* invoke) = 0;
 
 	/** Monitoring */
-	virtual std::set<InterpreterMonitor*> getMonitors() = 0;
+	virtual const MonitorSnapshot& getMonitors() = 0;
 	virtual const std::string& getSessionId() = 0;
 	virtual Logger getLogger() = 0;
+	/// NULL unless metrics are enabled
+	virtual InterpreterMetrics* getMetrics() {
+		return NULL;
+	}
+	/// NULL unless tracing
+	virtual InterpreterTrace* getTrace() {
+		return NULL;
+	}
 
 	/** Cache Data */
 	virtual Data& getCache() = 0;
@@ -91,13 +106,33 @@ public:
 	virtual void deserialize(const Data& encodedState) = 0;
 	virtual Data serialize() = 0;
 
+	/// Read the state from a binary snapshot, defaults to deserialize()
+	virtual void readSnapshot(SnapshotReader& reader) {
+		deserialize(reader.readData());
+	}
+	/// Write the state into a binary snapshot, defaults to serialize()
+	virtual void writeSnapshot(SnapshotWriter& writer) {
+		writer.writeData(serialize());
+	}
+
 	/// To register at the factory
 	virtual std::string getName() = 0;
 
+	/// The element for a state or transition index in trace records, NULL if unknown
+	virtual XERCESC_NS::DOMElement* getStateElement(uint32_t index) {
+		return NULL;
+	}
+	virtual XERCESC_NS::DOMElement* getTransitionElement(uint32_t index) {
+		return NULL;
+	}
+
 protected:
 	MicroStepImpl() {};
 	MicroStepCallbacks* _callbacks;
 
+	/// Intern the names in all event attributes of transitions, sends and raises as EventNames
+	static std::set<uint32_t> internEventNames(const XERCESC_NS::DOMElement* scxml, const std::string& xmlPrefix);
+
 };
 
 }
@@ -0,0 +1,305 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "Scheduler.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/interpreter/BasicEventQueue.h"
+#include "uscxml/interpreter/VirtualTimeDelayedEventQueue.h"
+#include "uscxml/interpreter/Logging.h"
+
+#include <algorithm>
+
+namespace uscxml {
+
+// the scheduler and worker the current thread belongs to, if any
+static thread_local Scheduler* _currScheduler = NULL;
+static thread_local size_t _currWorker = 0;
+// the session the current thread is stepping, it will see its own events before it parks
+static thread_local void* _currSession = NULL;
+
+void Scheduler::WakingEventQueue::enqueue(const Event& event) {
+	_queue.enqueue(event);
+	std::shared_ptr<Session> session = _session.lock();
+	if (session && session.get() != _currSession)
+		_scheduler->notify(session);
+}
+
+Scheduler::Scheduler(size_t nrWorkers, std::shared_ptr<VirtualClock> clock) :
+	_nrReady(0), _nrSleeping(0), _nextWorker(0), _isStarted(true), _clock(clock), _isAdvancing(false) {
+	nrWorkers = std::max(nrWorkers, (size_t)1);
+	for (size_t i = 0; i < nrWorkers; i++) {
+		_workers.push_back(new Worker());
+	}
+	for (size_t i = 0; i < nrWorkers; i++) {
+		_workers[i]->thread = new std::thread(Scheduler::runWorker, this, i);
+	}
+}
+
+Scheduler::~Scheduler() {
+	stop();
+	for (auto worker : _workers) {
+		delete worker;
+	}
+}
+
+void Scheduler::add(Interpreter interpreter) {
+	std::shared_ptr<Session> session(new Session(interpreter));
+	session->sessionId = interpreter.getImpl()->getSessionId();
+
+	// route all events through queues that will wake us, delayed events sent to #_internal arrive in the internal one
+	ActionLanguage al = *interpreter.getActionLanguage();
+	if (!al.externalQueue) {
+		al.externalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()));
+	}
+	if (!al.internalQueue) {
+		al.internalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()));
+	}
+	al.externalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new WakingEventQueue(this, session, al.externalQueue)));
+	al.internalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new WakingEventQueue(this, session, al.internalQueue)));
+	if (_clock && !al.delayQueue) {
+		al.delayQueue = DelayedEventQueue(std::shared_ptr<DelayedEventQueueImpl>(new VirtualTimeDelayedEventQueue(interpreter.getImpl().get(), _clock)));
+	}
+	interpreter.setActionLanguage(al);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_sessions[session->sessionId] = session;
+	}
+
+	// step once to initialize
+	notify(session);
+}
+
+void Scheduler::wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_sessions.empty() && _isStarted) {
+		_finishedCond.wait(lock);
+	}
+}
+
+void Scheduler::stop() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_isStarted)
+			return;
+		_isStarted = false;
+		_cond.notify_all();
+		_finishedCond.notify_all();
+	}
+
+	for (auto worker : _workers) {
+		worker->thread->join();
+		delete worker->thread;
+		worker->thread = NULL;
+		worker->runQueue.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_sessions.clear();
+}
+
+size_t Scheduler::getNumberOfSessions() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _sessions.size();
+}
+
+Scheduler::Stats Scheduler::getStats(const std::string& sessionId) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_sessions.find(sessionId) == _sessions.end())
+		return Stats();
+
+	std::lock_guard<std::mutex> statsLock(_sessions[sessionId]->statsMutex);
+	return _sessions[sessionId]->stats;
+}
+
+Scheduler::Stats Scheduler::getStats() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	Stats stats = _finishedStats;
+	for (auto session : _sessions) {
+		std::lock_guard<std::mutex> statsLock(session.second->statsMutex);
+		stats.runs += session.second->stats.runs;
+		stats.totalLatencyUs += session.second->stats.totalLatencyUs;
+		stats.maxLatencyUs = std::max(stats.maxLatencyUs, session.second->stats.maxLatencyUs);
+	}
+	return stats;
+}
+
+void Scheduler::notify(std::shared_ptr<Session> session) {
+	int state = session->state;
+	while(true) {
+		switch (state) {
+		case Session::PARKED:
+			if (session->state.compare_exchange_weak(state, Session::READY)) {
+				makeReady(session);
+				return;
+			}
+			break;
+		case Session::RUNNING:
+			// the worker will see this when it is about to park the session
+			if (session->state.compare_exchange_weak(state, Session::RUNNING_NOTIFIED))
+				return;
+			break;
+		default:
+			// already ready, notified or finished
+			return;
+		}
+	}
+}
+
+void Scheduler::makeReady(std::shared_ptr<Session> session) {
+	session->readySince = std::chrono::steady_clock::now();
+
+	// keep sessions woken by one of our workers local
+	size_t workerId = (_currScheduler == this ? _currWorker : _nextWorker++ % _workers.size());
+	_nrReady++;
+	{
+		std::lock_guard<std::mutex> lock(_workers[workerId]->mutex);
+		_workers[workerId]->runQueue.push_back(session);
+	}
+
+	if (_nrSleeping > 0) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_cond.notify_one();
+	}
+}
+
+std::shared_ptr<Scheduler::Session> Scheduler::next(size_t workerId) {
+	std::shared_ptr<Session> session;
+
+	// our own run queue first, then steal from the back of our peers'
+	for (size_t i = 0; i < _workers.size(); i++) {
+		Worker* worker = _workers[(workerId + i) % _workers.size()];
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		if (worker->runQueue.empty())
+			continue;
+
+		if (i == 0) {
+			session = worker->runQueue.front();
+			worker->runQueue.pop_front();
+		} else {
+			session = worker->runQueue.back();
+			worker->runQueue.pop_back();
+		}
+		_nrReady--;
+		break;
+	}
+	return session;
+}
+
+void Scheduler::run(std::shared_ptr<Session> session) {
+	using namespace std::chrono;
+
+	uint64_t latencyUs = duration_cast<microseconds>(steady_clock::now() - session->readySince).count();
+	{
+		std::lock_guard<std::mutex> lock(session->statsMutex);
+		session->stats.runs++;
+		session->stats.totalLatencyUs += latencyUs;
+		session->stats.maxLatencyUs = std::max(session->stats.maxLatencyUs, latencyUs);
+	}
+
+	session->state = Session::RUNNING;
+
+	for (size_t i = 0; i < maxStepsPerRun; i++) {
+		InterpreterState state;
+		try {
+			state = session->interpreter.step(0);
+		} catch (Event e) {
+			LOGD(USCXML_ERROR) << e << std::endl;
+			finish(session);
+			return;
+		}
+
+		switch (state) {
+		case USCXML_FINISHED:
+			finish(session);
+			return;
+		case USCXML_IDLE: {
+			int expected = Session::RUNNING;
+			if (session->state.compare_exchange_strong(expected, Session::PARKED))
+				return;
+			// an event arrived while we were running
+			session->state = Session::RUNNING;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	// time slice exhausted, yield to other sessions
+	session->state = Session::READY;
+	makeReady(session);
+}
+
+void Scheduler::finish(std::shared_ptr<Session> session) {
+	session->state = Session::FINISHED;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	{
+		std::lock_guard<std::mutex> statsLock(session->statsMutex);
+		_finishedStats.runs += session->stats.runs;
+		_finishedStats.totalLatencyUs += session->stats.totalLatencyUs;
+		_finishedStats.maxLatencyUs = std::max(_finishedStats.maxLatencyUs, session->stats.maxLatencyUs);
+	}
+	_sessions.erase(session->sessionId);
+	_finishedCond.notify_all();
+}
+
+bool Scheduler::advanceClock(std::unique_lock<std::mutex>& lock) {
+	// only the last worker to go to sleep will see every session parked
+	if (!_clock || _isAdvancing || _nrSleeping < _workers.size())
+		return false;
+
+	_isAdvancing = true;
+
+	// delivering the timers' events will notify the sessions and take our lock
+	lock.unlock();
+	bool advanced = _clock->advanceToNext();
+	lock.lock();
+
+	_isAdvancing = false;
+	return advanced;
+}
+
+void Scheduler::runWorker(void* instance, size_t workerId) {
+	Scheduler* INSTANCE = (Scheduler*)instance;
+	_currScheduler = INSTANCE;
+	_currWorker = workerId;
+
+	while(INSTANCE->_isStarted) {
+		std::shared_ptr<Session> session = INSTANCE->next(workerId);
+		if (session) {
+			_currSession = session.get();
+			INSTANCE->run(session);
+			_currSession = NULL;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(INSTANCE->_mutex);
+		INSTANCE->_nrSleeping++;
+		while (INSTANCE->_nrReady == 0 && INSTANCE->_isStarted) {
+			if (INSTANCE->advanceClock(lock))
+				continue;
+			INSTANCE->_cond.wait(lock);
+		}
+		INSTANCE->_nrSleeping--;
+	}
+}
+
+}
@@ -0,0 +1,203 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef SCHEDULER_H_4A1D5C7E
+#define SCHEDULER_H_4A1D5C7E
+
+#include "uscxml/Common.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/EventQueue.h"
+#include "uscxml/interpreter/EventQueueImpl.h"
+#include "uscxml/interpreter/VirtualClock.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace uscxml {
+
+/**
+ * @ingroup interpreter
+ * Drive many interpreters on a fixed pool of worker threads.
+ *
+ * Sessions are only ever stepped with a blockMs of 0. An idle session is
+ * parked until an event is enqueued into its external or internal queue,
+ * which also covers delayed events as they are delivered via the IO
+ * processors, including those sent to #_internal. Ready
+ * sessions are kept in per-worker run queues and idle workers steal from
+ * their peers.
+ *
+ * With a VirtualClock, sessions without a delayed event queue of their own
+ * get a VirtualTimeDelayedEventQueue on it and the clock is advanced to the
+ * next due timer whenever every session is parked. Simulated time then passes
+ * as fast as the sessions process their events. Timers due at the same
+ * virtual time fire in the order the sessions were added, so every session
+ * processes the same events at the same virtual times with any number of
+ * workers. This holds as long as sessions are added in the same order and
+ * events only arrive delayed or from the session itself, not from other
+ * sessions, IO processors or sessions invoked in their own threads. Only a
+ * single worker also fixes the interleaving of the sessions.
+ */
+class USCXML_API Scheduler {
+public:
+	/// Run queue latency, i.e. the time a session was ready but not running
+	struct Stats {
+		Stats() : runs(0), totalLatencyUs(0), maxLatencyUs(0) {}
+		size_t runs;
+		uint64_t totalLatencyUs;
+		uint64_t maxLatencyUs;
+		double avgLatencyUs() const {
+			return (runs > 0 ? (double)totalLatencyUs / runs : 0);
+		}
+	};
+
+	Scheduler(size_t nrWorkers = std::thread::hardware_concurrency(),
+	          std::shared_ptr<VirtualClock> clock = std::shared_ptr<VirtualClock>());
+	virtual ~Scheduler();
+
+	/**
+	 * Adopt an interpreter and start to process it.
+	 * This will replace the interpreter's event queues with ones that notify
+	 * the scheduler, it is not to be stepped by anyone else afterwards and must
+	 * not receive events once the scheduler is destroyed.
+	 */
+	void add(Interpreter interpreter);
+
+	/// Block until all sessions finished
+	void wait();
+
+	/// Stop the workers and release all remaining sessions
+	void stop();
+
+	size_t getNumberOfSessions();
+	size_t getNumberOfWorkers() {
+		return _workers.size();
+	}
+
+	/// The clock advanced when all sessions are parked, if any
+	std::shared_ptr<VirtualClock> getClock() {
+		return _clock;
+	}
+
+	/// Run queue latency for the given session
+	Stats getStats(const std::string& sessionId);
+	/// Run queue latency aggregated over all sessions
+	Stats getStats();
+
+	/// Time slice in microsteps before a busy session yields its worker
+	size_t maxStepsPerRun = 64;
+
+protected:
+	class Session;
+
+	/**
+	 * Decorates an event queue to notify the scheduler on enqueue.
+	 */
+	class WakingEventQueue : public EventQueueImpl {
+	public:
+		WakingEventQueue(Scheduler* scheduler, std::weak_ptr<Session> session, EventQueue queue) :
+			_scheduler(scheduler), _session(session), _queue(queue) {}
+		virtual ~WakingEventQueue() {}
+
+		virtual std::shared_ptr<EventQueueImpl> create() {
+			return _queue.getImplBase()->create();
+		}
+		virtual Event dequeue(size_t blockMs) {
+			return _queue.dequeue(blockMs);
+		}
+		virtual void enqueue(const Event& event);
+		virtual void reset() {
+			_queue.reset();
+		}
+		virtual Data serialize() {
+			return _queue.serialize();
+		}
+		virtual void deserialize(const Data& data) {
+			_queue.deserialize(data);
+		}
+
+	protected:
+		Scheduler* _scheduler;
+		std::weak_ptr<Session> _session;
+		EventQueue _queue;
+	};
+
+	class Session {
+	public:
+		enum State {
+			PARKED,
+			READY, ///< Waiting in a run queue
+			RUNNING,
+			RUNNING_NOTIFIED, ///< Notified while running, needs another run
+			FINISHED
+		};
+
+		Session(Interpreter interpreter) : interpreter(interpreter), state(PARKED) {}
+
+		Interpreter interpreter;
+		std::string sessionId;
+		std::atomic<int> state;
+		std::chrono::steady_clock::time_point readySince;
+
+		Stats stats;
+		std::mutex statsMutex;
+	};
+
+	struct Worker {
+		Worker() : thread(NULL) {}
+		std::thread* thread;
+		std::deque<std::shared_ptr<Session> > runQueue;
+		std::mutex mutex;
+	};
+
+	void notify(std::shared_ptr<Session> session);
+	void makeReady(std::shared_ptr<Session> session);
+	void run(std::shared_ptr<Session> session);
+	std::shared_ptr<Session> next(size_t workerId);
+	void finish(std::shared_ptr<Session> session);
+	bool advanceClock(std::unique_lock<std::mutex>& lock);
+
+	static void runWorker(void* instance, size_t workerId);
+
+	std::vector<Worker*> _workers;
+	std::map<std::string, std::shared_ptr<Session> > _sessions;
+	std::atomic<size_t> _nrReady;
+	std::atomic<size_t> _nrSleeping;
+	std::atomic<size_t> _nextWorker;
+	std::atomic<bool> _isStarted;
+
+	std::shared_ptr<VirtualClock> _clock;
+	bool _isAdvancing;
+
+	Stats _finishedStats;
+
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	std::condition_variable _finishedCond;
+};
+
+}
+
+#endif /* end of include guard: SCHEDULER_H_4A1D5C7E */
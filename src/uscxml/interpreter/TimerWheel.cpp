@@ -0,0 +1,302 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "TimerWheel.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+
+#define LEVEL_SHIFT(level) ((level) * USCXML_TIMERWHEEL_BITS)
+#define LEVEL_RANGE(level) ((uint64_t)1 << LEVEL_SHIFT((level) + 1))
+#define SLOT_INDEX(tick, level) (((tick) >> LEVEL_SHIFT(level)) & (USCXML_TIMERWHEEL_SLOTS - 1))
+
+namespace uscxml {
+
+// the owner the current dispatcher thread is notifying, if any
+static thread_local TimerWheel::TimerCallbacks* _firingOwner = NULL;
+
+TimerWheel* TimerWheel::_instance = NULL;
+std::mutex TimerWheel::_instanceMutex;
+
+TimerWheel* TimerWheel::getInstance() {
+	std::lock_guard<std::mutex> lock(_instanceMutex);
+	if (_instance == NULL) {
+		// a small fixed pool - callbacks only enqueue events
+		size_t nrDispatchers = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+		_instance = new TimerWheel(nrDispatchers);
+	}
+	return _instance;
+}
+
+TimerWheel::TimerWheel(size_t nrDispatchers) : _currTick(0), _nrTimers(0), _tickerWakeup(0) {
+	_epoch = std::chrono::steady_clock::now();
+	_isStarted = true;
+
+	for (size_t i = 0; i < std::max(nrDispatchers, (size_t)1); i++) {
+		Dispatcher* dispatcher = new Dispatcher();
+		_dispatchers.push_back(dispatcher);
+		dispatcher->thread = new std::thread(TimerWheel::runDispatcher, this, dispatcher);
+	}
+	_ticker = new std::thread(TimerWheel::runTicker, this);
+}
+
+TimerWheel::~TimerWheel() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isStarted = false;
+		_cond.notify_all();
+		for (auto dispatcher : _dispatchers) {
+			dispatcher->cond.notify_all();
+		}
+	}
+
+	_ticker->join();
+	delete _ticker;
+
+	for (auto dispatcher : _dispatchers) {
+		dispatcher->thread->join();
+		delete dispatcher->thread;
+		delete dispatcher;
+	}
+}
+
+uint64_t TimerWheel::now() {
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(steady_clock::now() - _epoch).count();
+}
+
+void TimerWheel::schedule(Timer* timer, size_t delayMs, TimerCallbacks* owner) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	assert(timer->_state == Timer::IDLE);
+
+	uint64_t nowTick = now();
+	timer->_owner = owner;
+	timer->due = nowTick + delayMs;
+
+	if (_nrTimers == 0) {
+		// nothing to advance, the ticker may have been idle for a long time
+		_currTick = std::max(_currTick, nowTick);
+	}
+
+	if (timer->due <= _currTick) {
+		expire(timer);
+		return;
+	}
+
+	_nrTimers++;
+	insert(timer);
+
+	// the ticker might be sleeping past our due time
+	if (timer->due < _tickerWakeup)
+		_cond.notify_one();
+}
+
+bool TimerWheel::cancel(Timer* timer) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	switch (timer->_state) {
+	case Timer::SCHEDULED:
+		unlink(timer);
+		timer->_state = Timer::IDLE;
+		_nrTimers--;
+		return true;
+	case Timer::EXPIRED:
+		// dispatcher will dispose of it
+		timer->_state = Timer::CANCELLED;
+		return false;
+	case Timer::IDLE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void TimerWheel::waitForCallbacks(TimerCallbacks* owner) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	// we may be called from within timerFired - do not wait for ourself
+	size_t ownCallbacks = (_firingOwner == owner ? 1 : 0);
+	while (_firing.find(owner) != _firing.end() && _firing[owner] > ownCallbacks) {
+		_firingCond.wait(lock);
+	}
+}
+
+void TimerWheel::insert(Timer* timer) {
+	uint64_t delta = timer->due - _currTick;
+	uint64_t slotDue = timer->due;
+	size_t level = 0;
+
+	while (level < USCXML_TIMERWHEEL_LEVELS - 1 && delta >= LEVEL_RANGE(level))
+		level++;
+
+	if (delta >= LEVEL_RANGE(USCXML_TIMERWHEEL_LEVELS - 1) - LEVEL_RANGE(USCXML_TIMERWHEEL_LEVELS - 2)) {
+		// beyond the wheel's range, will be reinserted when its slot cascades
+		slotDue = _currTick + LEVEL_RANGE(USCXML_TIMERWHEEL_LEVELS - 1) - LEVEL_RANGE(USCXML_TIMERWHEEL_LEVELS - 2);
+	}
+
+	timer->_level = level;
+	timer->_index = SLOT_INDEX(slotDue, level);
+	Slot& slot = _slots[level][timer->_index];
+
+	// append to keep the order of timers with the same due tick
+	timer->_prev = slot.tail;
+	timer->_next = NULL;
+	if (slot.tail) {
+		slot.tail->_next = timer;
+	} else {
+		slot.head = timer;
+	}
+	slot.tail = timer;
+	timer->_state = Timer::SCHEDULED;
+}
+
+void TimerWheel::unlink(Timer* timer) {
+	Slot& slot = _slots[timer->_level][timer->_index];
+
+	if (timer->_prev) {
+		timer->_prev->_next = timer->_next;
+	} else {
+		slot.head = timer->_next;
+	}
+	if (timer->_next) {
+		timer->_next->_prev = timer->_prev;
+	} else {
+		slot.tail = timer->_prev;
+	}
+
+	timer->_prev = NULL;
+	timer->_next = NULL;
+}
+
+void TimerWheel::expire(Timer* timer) {
+	timer->_state = Timer::EXPIRED;
+	timer->_prev = NULL;
+	timer->_next = NULL;
+
+	// all timers of an owner go to the same dispatcher
+	Dispatcher* dispatcher = _dispatchers[((uintptr_t)timer->_owner / sizeof(void*)) % _dispatchers.size()];
+	dispatcher->expired.push_back(timer);
+	dispatcher->cond.notify_one();
+}
+
+void TimerWheel::cascade(size_t level, size_t index) {
+	Slot& slot = _slots[level][index];
+	Timer* timer = slot.head;
+	slot.head = NULL;
+	slot.tail = NULL;
+
+	while (timer) {
+		Timer* next = timer->_next;
+		insert(timer);
+		timer = next;
+	}
+}
+
+void TimerWheel::advanceTo(uint64_t tick) {
+	while (_currTick < tick) {
+		_currTick++;
+
+		// move timers down from the coarser levels when their slot comes around
+		for (size_t level = 1; level < USCXML_TIMERWHEEL_LEVELS; level++) {
+			if (SLOT_INDEX(_currTick, level - 1) != 0)
+				break;
+			cascade(level, SLOT_INDEX(_currTick, level));
+		}
+
+		Slot& slot = _slots[0][SLOT_INDEX(_currTick, 0)];
+		Timer* timer = slot.head;
+		slot.head = NULL;
+		slot.tail = NULL;
+
+		while (timer) {
+			Timer* next = timer->_next;
+			expire(timer);
+			_nrTimers--;
+			timer = next;
+		}
+	}
+}
+
+uint64_t TimerWheel::nextWakeup() {
+	if (_nrTimers == 0)
+		return std::numeric_limits<uint64_t>::max();
+
+	// next occupied slot on the finest level before it wraps
+	uint64_t tick = _currTick + 1;
+	do {
+		if (_slots[0][SLOT_INDEX(tick, 0)].head != NULL)
+			return tick;
+	} while (SLOT_INDEX(tick++, 0) != 0);
+
+	// next cascade
+	return tick - 1;
+}
+
+void TimerWheel::runTicker(void* instance) {
+	TimerWheel* INSTANCE = (TimerWheel*)instance;
+	std::unique_lock<std::mutex> lock(INSTANCE->_mutex);
+
+	while(INSTANCE->_isStarted) {
+		INSTANCE->advanceTo(INSTANCE->now());
+
+		INSTANCE->_tickerWakeup = INSTANCE->nextWakeup();
+		if (INSTANCE->_tickerWakeup == std::numeric_limits<uint64_t>::max()) {
+			INSTANCE->_cond.wait(lock);
+		} else {
+			INSTANCE->_cond.wait_until(lock, INSTANCE->_epoch + std::chrono::milliseconds(INSTANCE->_tickerWakeup));
+		}
+	}
+}
+
+void TimerWheel::runDispatcher(void* instance, Dispatcher* dispatcher) {
+	TimerWheel* INSTANCE = (TimerWheel*)instance;
+	std::unique_lock<std::mutex> lock(INSTANCE->_mutex);
+
+	while(INSTANCE->_isStarted) {
+		if (dispatcher->expired.empty()) {
+			dispatcher->cond.wait(lock);
+			continue;
+		}
+
+		Timer* timer = dispatcher->expired.front();
+		dispatcher->expired.pop_front();
+
+		if (timer->_state == Timer::CANCELLED) {
+			// owner cancelled while we were waiting
+			delete timer;
+			continue;
+		}
+
+		TimerCallbacks* owner = timer->_owner;
+		timer->_state = Timer::FIRING;
+		INSTANCE->_firing[owner]++;
+
+		// we cannot hold the mutex as the callback may schedule timers
+		lock.unlock();
+		_firingOwner = owner;
+		owner->timerFired(timer);
+		_firingOwner = NULL;
+		lock.lock();
+
+		if (--INSTANCE->_firing[owner] == 0)
+			INSTANCE->_firing.erase(owner);
+		INSTANCE->_firingCond.notify_all();
+	}
+}
+
+}
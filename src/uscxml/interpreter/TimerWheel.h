@@ -0,0 +1,171 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef TIMERWHEEL_H_8E2C17A3
+#define TIMERWHEEL_H_8E2C17A3
+
+#include "uscxml/Common.h"
+
+#include <map>
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+#define USCXML_TIMERWHEEL_LEVELS 4
+#define USCXML_TIMERWHEEL_BITS 8
+#define USCXML_TIMERWHEEL_SLOTS (1 << USCXML_TIMERWHEEL_BITS)
+
+namespace uscxml {
+
+/**
+ * @ingroup eventqueue
+ * A process-wide hierarchical timer wheel with millisecond ticks.
+ *
+ * Timers are kept in intrusive lists per slot, making schedule() and cancel()
+ * O(1). A single ticker thread advances the wheel and hands expired timers
+ * to a fixed pool of dispatcher threads. All timers of a given owner are
+ * dispatched by the same thread, preserving their order.
+ */
+class USCXML_API TimerWheel {
+public:
+	class Timer;
+
+	/**
+	 * @ingroup eventqueue
+	 * @ingroup callback
+	 */
+	class USCXML_API TimerCallbacks {
+	public:
+		virtual ~TimerCallbacks() {}
+		/// Called from a dispatcher thread, the owner is responsible to delete the timer.
+		virtual void timerFired(Timer* timer) = 0;
+	};
+
+	class USCXML_API Timer {
+	public:
+		Timer() : due(0), _owner(NULL), _prev(NULL), _next(NULL), _level(0), _index(0), _state(IDLE) {}
+		virtual ~Timer() {}
+
+		uint64_t due; ///< Tick when this timer is due
+
+	protected:
+		enum State {
+			IDLE,
+			SCHEDULED, ///< Resides in a slot of the wheel
+			EXPIRED, ///< Waiting for a dispatcher
+			FIRING, ///< Owner is being notified
+			CANCELLED ///< Cancelled while expired, dispatcher will delete
+		};
+
+		TimerCallbacks* _owner;
+		Timer* _prev;
+		Timer* _next;
+		size_t _level;
+		size_t _index;
+		State _state;
+
+		friend class TimerWheel;
+	};
+
+	TimerWheel(size_t nrDispatchers);
+	virtual ~TimerWheel();
+
+	/// The process-wide instance shared by all sessions
+	static TimerWheel* getInstance();
+
+	/**
+	 * Schedule a timer to fire after the given delay.
+	 * @param timer The timer, not to be deleted until fired or cancelled.
+	 * @param delayMs The delay in milliseconds.
+	 * @param owner Who to notify when the timer fires.
+	 */
+	void schedule(Timer* timer, size_t delayMs, TimerCallbacks* owner);
+
+	/**
+	 * Cancel a scheduled timer.
+	 * @return Whether the timer was removed and may be deleted by the caller.
+	 * If false, the timer is already in the process of firing and will be
+	 * disposed by the wheel or the owner.
+	 */
+	bool cancel(Timer* timer);
+
+	/// Block until no timer of the given owner is being dispatched anymore
+	void waitForCallbacks(TimerCallbacks* owner);
+
+	/// Milliseconds since the wheel was created
+	uint64_t now();
+
+	size_t getNumberOfThreads() {
+		return _dispatchers.size() + 1;
+	}
+
+	size_t getNumberOfTimers() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _nrTimers;
+	}
+
+protected:
+	struct Slot {
+		Slot() : head(NULL), tail(NULL) {}
+		Timer* head;
+		Timer* tail;
+	};
+
+	struct Dispatcher {
+		Dispatcher() : thread(NULL) {}
+		std::thread* thread;
+		std::list<Timer*> expired;
+		std::condition_variable cond;
+	};
+
+	void insert(Timer* timer);
+	void unlink(Timer* timer);
+	void expire(Timer* timer);
+	void cascade(size_t level, size_t index);
+	void advanceTo(uint64_t tick);
+	uint64_t nextWakeup();
+
+	static void runTicker(void* instance);
+	static void runDispatcher(void* instance, Dispatcher* dispatcher);
+
+	Slot _slots[USCXML_TIMERWHEEL_LEVELS][USCXML_TIMERWHEEL_SLOTS];
+	uint64_t _currTick;
+	size_t _nrTimers;
+	uint64_t _tickerWakeup;
+	std::chrono::steady_clock::time_point _epoch;
+
+	bool _isStarted;
+	std::thread* _ticker;
+	std::vector<Dispatcher*> _dispatchers;
+	std::map<TimerCallbacks*, size_t> _firing;
+
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	std::condition_variable _firingCond;
+
+	static TimerWheel* _instance;
+	static std::mutex _instanceMutex;
+};
+
+}
+
+#endif /* end of include guard: TIMERWHEEL_H_8E2C17A3 */
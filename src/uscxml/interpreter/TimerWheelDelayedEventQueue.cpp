@@ -0,0 +1,133 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "TimerWheelDelayedEventQueue.h"
+
+namespace uscxml {
+
+TimerWheelDelayedEventQueue::TimerWheelDelayedEventQueue(DelayedEventQueueCallbacks* callbacks, TimerWheel* wheel) {
+	_callbacks = callbacks;
+	_wheel = wheel;
+}
+
+TimerWheelDelayedEventQueue::~TimerWheelDelayedEventQueue() {
+	cancelAllDelayed();
+	_wheel->waitForCallbacks(this);
+}
+
+std::shared_ptr<DelayedEventQueueImpl> TimerWheelDelayedEventQueue::create(DelayedEventQueueCallbacks* callbacks) {
+	return std::shared_ptr<DelayedEventQueueImpl>(new TimerWheelDelayedEventQueue(callbacks, _wheel));
+}
+
+void TimerWheelDelayedEventQueue::timerFired(TimerWheel::Timer* timer) {
+	DelayedEvent* delayed = static_cast<DelayedEvent*>(timer);
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		auto timerIter = _timers.find(delayed->eventUUID);
+		if (timerIter == _timers.end() || timerIter->second != delayed) {
+			// cancelled while we were about to fire
+			delete delayed;
+			return;
+		}
+		_timers.erase(timerIter);
+	}
+
+	// we cannot hold the mutex as this may trigger a delayed send
+	_callbacks->eventReady(delayed->userData, delayed->eventUUID);
+	delete delayed;
+}
+
+void TimerWheelDelayedEventQueue::enqueueDelayed(const Event& event, size_t delayMs, const std::string& eventUUID) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if(_timers.find(eventUUID) != _timers.end()) {
+		cancelDelayed(eventUUID);
+	}
+
+	DelayedEvent* delayed = new DelayedEvent();
+	delayed->userData = event;
+	delayed->eventUUID = eventUUID;
+	_timers[eventUUID] = delayed;
+
+	_wheel->schedule(delayed, delayMs, this);
+}
+
+void TimerWheelDelayedEventQueue::cancelDelayed(const std::string& eventId) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	auto timerIter = _timers.find(eventId);
+	if (timerIter != _timers.end()) {
+		// if the wheel already handed it out, whoever holds it will delete it
+		if (_wheel->cancel(timerIter->second))
+			delete timerIter->second;
+		_timers.erase(timerIter);
+	}
+}
+
+void TimerWheelDelayedEventQueue::cancelAllDelayed() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	for (auto timer : _timers) {
+		if (_wheel->cancel(timer.second))
+			delete timer.second;
+	}
+	_timers.clear();
+}
+
+void TimerWheelDelayedEventQueue::reset() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	cancelAllDelayed();
+	_queue.clear();
+}
+
+Data TimerWheelDelayedEventQueue::serialize() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	Data serialized;
+	uint64_t now = _wheel->now();
+
+	for (auto timer : _timers) {
+		uint64_t delayMs = (timer.second->due > now ? timer.second->due - now : 0);
+
+		Data delayedEvent;
+		delayedEvent["event"] = timer.second->userData;
+		delayedEvent["delay"] = Data(delayMs, Data::INTERPRETED);
+
+		serialized["TimerWheelDelayedEventQueue"].array.push_back(delayedEvent);
+	}
+
+	return serialized;
+}
+
+void TimerWheelDelayedEventQueue::deserialize(const Data& data) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	std::vector<Data> delayedEvents;
+
+	if (data.hasKey("TimerWheelDelayedEventQueue")) {
+		delayedEvents = data["TimerWheelDelayedEventQueue"].array;
+	} else if (data.hasKey("BasicDelayedEventQueue")) {
+		delayedEvents = data["BasicDelayedEventQueue"].array;
+	}
+
+	for (auto delayedEvent : delayedEvents) {
+		Event e = Event::fromData(delayedEvent["event"]);
+		enqueueDelayed(e, strTo<size_t>(delayedEvent["delay"]), e.getUUID());
+	}
+}
+
+}
@@ -0,0 +1,80 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef TIMERWHEELDELAYEDEVENTQUEUE_H_5B0E3F61
+#define TIMERWHEELDELAYEDEVENTQUEUE_H_5B0E3F61
+
+#include "BasicEventQueue.h"
+#include "TimerWheel.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace uscxml {
+
+/**
+ * @ingroup eventqueue
+ * @ingroup impl
+ *
+ * A delayed event queue backed by the process-wide TimerWheel.
+ *
+ * Unlike the BasicDelayedEventQueue, instances do not own a thread or an
+ * event base, making them cheap enough for many thousand sessions.
+ */
+class USCXML_API TimerWheelDelayedEventQueue : public BasicEventQueue, public DelayedEventQueueImpl, public TimerWheel::TimerCallbacks {
+public:
+	TimerWheelDelayedEventQueue(DelayedEventQueueCallbacks* callbacks, TimerWheel* wheel = TimerWheel::getInstance());
+	virtual ~TimerWheelDelayedEventQueue();
+	virtual std::shared_ptr<DelayedEventQueueImpl> create(DelayedEventQueueCallbacks* callbacks);
+	virtual void enqueueDelayed(const Event& event, size_t delayMs, const std::string& eventUUID);
+	virtual void cancelDelayed(const std::string& eventId);
+	virtual void cancelAllDelayed();
+	virtual Event dequeue(size_t blockMs) {
+		return BasicEventQueue::dequeue(blockMs);
+	}
+	virtual void enqueue(const Event& event) {
+		return BasicEventQueue::enqueue(event);
+	}
+	virtual void reset();
+
+	virtual Data serialize();
+	virtual void deserialize(const Data& data);
+
+	virtual void timerFired(TimerWheel::Timer* timer);
+
+protected:
+	virtual std::shared_ptr<EventQueueImpl> create() {
+		ErrorEvent e("Cannot create a DelayedEventQueue without callbacks");
+		throw e;
+	}
+
+	class DelayedEvent : public TimerWheel::Timer {
+	public:
+		Event userData;
+		std::string eventUUID;
+	};
+
+	std::unordered_map<std::string, DelayedEvent*> _timers;
+	TimerWheel* _wheel;
+	DelayedEventQueueCallbacks* _callbacks;
+};
+
+}
+
+#endif /* end of include guard: TIMERWHEELDELAYEDEVENTQUEUE_H_5B0E3F61 */
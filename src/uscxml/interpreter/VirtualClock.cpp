@@ -0,0 +1,140 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "VirtualClock.h"
+
+#include <limits>
+#include <thread>
+
+namespace uscxml {
+
+const uint64_t VirtualClock::NEVER = std::numeric_limits<uint64_t>::max();
+
+uint64_t VirtualClock::now() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _now;
+}
+
+void VirtualClock::addOwner(TimerCallbacks* owner) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	getOwner(owner);
+}
+
+void VirtualClock::removeOwner(TimerCallbacks* owner) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_owners.erase(owner);
+}
+
+VirtualClock::Owner& VirtualClock::getOwner(TimerCallbacks* owner) {
+	auto ownerIter = _owners.find(owner);
+	if (ownerIter == _owners.end()) {
+		Owner& added = _owners[owner];
+		added.rank = _nextOwner++;
+		added.nextSeq = 0;
+		return added;
+	}
+	return ownerIter->second;
+}
+
+uint64_t VirtualClock::schedule(TimerCallbacks* owner, uint64_t delayMs) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	uint64_t timerId = _nextId++;
+	uint64_t due = (delayMs > NEVER - _now ? NEVER : _now + delayMs);
+	Owner& ranked = getOwner(owner);
+	TimerKey key(due, ranked.rank, ranked.nextSeq++);
+	_timers[key] = std::make_pair(owner, timerId);
+	_timerKeys[timerId] = key;
+	return timerId;
+}
+
+bool VirtualClock::cancel(uint64_t timerId) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto keyIter = _timerKeys.find(timerId);
+	if (keyIter == _timerKeys.end())
+		return false;
+	_timers.erase(keyIter->second);
+	_timerKeys.erase(keyIter);
+	return true;
+}
+
+uint64_t VirtualClock::nextDue() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return (_timers.empty() ? NEVER : std::get<0>(_timers.begin()->first));
+}
+
+uint64_t VirtualClock::getDue(uint64_t timerId) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto keyIter = _timerKeys.find(timerId);
+	return (keyIter == _timerKeys.end() ? NEVER : std::get<0>(keyIter->second));
+}
+
+size_t VirtualClock::getNumberOfTimers() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _timers.size();
+}
+
+size_t VirtualClock::advanceTo(uint64_t timeMs) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	size_t fired = 0;
+
+	while (!_timers.empty() && std::get<0>(_timers.begin()->first) <= timeMs) {
+		auto timerIter = _timers.begin();
+		uint64_t due = std::get<0>(timerIter->first);
+		TimerCallbacks* owner = timerIter->second.first;
+		uint64_t timerId = timerIter->second.second;
+
+		if (due > _now)
+			_now = due;
+		_timerKeys.erase(timerId);
+		_timers.erase(timerIter);
+
+		// the owner may schedule or cancel timers from within the callback
+		_firingOwner = owner;
+		_firingThread = std::this_thread::get_id();
+		lock.unlock();
+		owner->timerFired(timerId);
+		lock.lock();
+		_firingOwner = NULL;
+		_firingCond.notify_all();
+
+		fired++;
+	}
+
+	if (timeMs > _now)
+		_now = timeMs;
+	return fired;
+}
+
+bool VirtualClock::advanceToNext() {
+	uint64_t due = nextDue();
+	if (due == NEVER)
+		return false;
+	advanceTo(due);
+	return true;
+}
+
+void VirtualClock::waitForCallbacks(TimerCallbacks* owner) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	// we may be called from within timerFired - do not wait for ourself
+	while (_firingOwner == owner && _firingThread != std::this_thread::get_id()) {
+		_firingCond.wait(lock);
+	}
+}
+
+}
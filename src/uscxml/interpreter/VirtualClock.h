@@ -0,0 +1,127 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef VIRTUALCLOCK_H_2A7D5E90
+#define VIRTUALCLOCK_H_2A7D5E90
+
+#include "uscxml/Common.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <condition_variable>
+#include <unordered_map>
+#include <utility>
+#include <stdint.h>
+
+namespace uscxml {
+
+/**
+ * @ingroup eventqueue
+ * A clock in milliseconds that only moves when advanced.
+ *
+ * Timers fire on the thread advancing the clock, ordered by their due time.
+ * Timers due at the same time fire in the order their owners were added and,
+ * per owner, in the order they were scheduled in. This order does not depend
+ * on how the calls of different owners interleave, e.g. on several worker
+ * threads, only on the order of addOwner(). Only one thread at a time is
+ * supposed to advance the clock.
+ */
+class USCXML_API VirtualClock {
+public:
+	/**
+	 * @ingroup eventqueue
+	 * @ingroup callback
+	 */
+	class USCXML_API TimerCallbacks {
+	public:
+		virtual ~TimerCallbacks() {}
+		/// Called from the thread advancing the clock without the clock's lock held
+		virtual void timerFired(uint64_t timerId) = 0;
+	};
+
+	/// Due time of no timer at all
+	static const uint64_t NEVER;
+
+	VirtualClock(uint64_t startMs = 0) : _now(startMs), _nextId(1), _nextOwner(0), _firingOwner(NULL) {}
+
+	/// The current virtual time in milliseconds
+	uint64_t now();
+
+	/// Rank an owner after all owners added before, owners not added are with their first timer
+	void addOwner(TimerCallbacks* owner);
+
+	/// Forget an owner, its pending timers are kept
+	void removeOwner(TimerCallbacks* owner);
+
+	/// Schedule a timer for now() + delayMs, the returned id is never 0
+	uint64_t schedule(TimerCallbacks* owner, uint64_t delayMs);
+
+	/// Whether the timer was still pending, it will not fire if so
+	bool cancel(uint64_t timerId);
+
+	/// The due time of the earliest pending timer or NEVER
+	uint64_t nextDue();
+
+	/// The due time of a pending timer or NEVER
+	uint64_t getDue(uint64_t timerId);
+
+	size_t getNumberOfTimers();
+
+	/**
+	 * Fire all timers due up to the given time, including the ones they
+	 * schedule, and leave the clock at that time. The clock never goes back.
+	 * @return The number of timers fired.
+	 */
+	size_t advanceTo(uint64_t timeMs);
+
+	/// Advance to the earliest pending timer and fire all timers due then, false if there is none
+	bool advanceToNext();
+
+	/// Block until no timer of the given owner is being fired by another thread
+	void waitForCallbacks(TimerCallbacks* owner);
+
+protected:
+	typedef std::tuple<uint64_t, uint64_t, uint64_t> TimerKey; ///< due time, rank of the owner and its sequence number
+
+	struct Owner {
+		uint64_t rank;
+		uint64_t nextSeq;
+	};
+
+	Owner& getOwner(TimerCallbacks* owner);
+
+	std::map<TimerKey, std::pair<TimerCallbacks*, uint64_t> > _timers; ///< owner and id
+	std::unordered_map<uint64_t, TimerKey> _timerKeys;
+	std::unordered_map<TimerCallbacks*, Owner> _owners;
+
+	uint64_t _now;
+	uint64_t _nextId;
+	uint64_t _nextOwner;
+
+	TimerCallbacks* _firingOwner;
+	std::thread::id _firingThread;
+	std::condition_variable _firingCond;
+	std::mutex _mutex;
+};
+
+}
+
+#endif /* end of include guard: VIRTUALCLOCK_H_2A7D5E90 */
@@ -0,0 +1,144 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "VirtualTimeDelayedEventQueue.h"
+#include "uscxml/util/Convenience.h"
+
+#include <map>
+
+namespace uscxml {
+
+VirtualTimeDelayedEventQueue::VirtualTimeDelayedEventQueue(DelayedEventQueueCallbacks* callbacks, std::shared_ptr<VirtualClock> clock) {
+	_callbacks = callbacks;
+	_clock = clock;
+	_clock->addOwner(this);
+}
+
+VirtualTimeDelayedEventQueue::~VirtualTimeDelayedEventQueue() {
+	cancelAllDelayed();
+	_clock->waitForCallbacks(this);
+	_clock->removeOwner(this);
+}
+
+std::shared_ptr<DelayedEventQueueImpl> VirtualTimeDelayedEventQueue::create(DelayedEventQueueCallbacks* callbacks) {
+	return std::shared_ptr<DelayedEventQueueImpl>(new VirtualTimeDelayedEventQueue(callbacks, _clock));
+}
+
+void VirtualTimeDelayedEventQueue::timerFired(uint64_t timerId) {
+	DelayedEvent delayed;
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		auto timerIter = _timers.find(timerId);
+		if (timerIter == _timers.end()) {
+			// cancelled while we were about to fire
+			return;
+		}
+		delayed = timerIter->second;
+		_timerIds.erase(delayed.eventUUID);
+		_timers.erase(timerIter);
+	}
+
+	// we cannot hold the mutex as this may trigger a delayed send
+	_callbacks->eventReady(delayed.userData, delayed.eventUUID);
+}
+
+void VirtualTimeDelayedEventQueue::enqueueDelayed(const Event& event, size_t delayMs, const std::string& eventUUID) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if(_timerIds.find(eventUUID) != _timerIds.end()) {
+		cancelDelayed(eventUUID);
+	}
+
+	uint64_t timerId = _clock->schedule(this, delayMs);
+	DelayedEvent& delayed = _timers[timerId];
+	delayed.userData = event;
+	delayed.eventUUID = eventUUID;
+	_timerIds[eventUUID] = timerId;
+}
+
+void VirtualTimeDelayedEventQueue::cancelDelayed(const std::string& eventId) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	auto idIter = _timerIds.find(eventId);
+	if (idIter != _timerIds.end()) {
+		_clock->cancel(idIter->second);
+		_timers.erase(idIter->second);
+		_timerIds.erase(idIter);
+	}
+}
+
+void VirtualTimeDelayedEventQueue::cancelAllDelayed() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	for (auto timer : _timers) {
+		_clock->cancel(timer.first);
+	}
+	_timers.clear();
+	_timerIds.clear();
+}
+
+void VirtualTimeDelayedEventQueue::reset() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	cancelAllDelayed();
+	_queue.clear();
+}
+
+Data VirtualTimeDelayedEventQueue::serialize() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	Data serialized;
+	uint64_t now = _clock->now();
+
+	// in the order they were scheduled, so they are restored in the same order
+	std::map<uint64_t, DelayedEvent*> ordered;
+	for (auto& timer : _timers)
+		ordered[timer.first] = &timer.second;
+
+	for (auto timer : ordered) {
+		uint64_t due = _clock->getDue(timer.first);
+		uint64_t delayMs = (due > now ? due - now : 0);
+
+		Data delayedEvent;
+		delayedEvent["event"] = timer.second->userData;
+		delayedEvent["delay"] = Data(delayMs, Data::INTERPRETED);
+
+		serialized["VirtualTimeDelayedEventQueue"].array.push_back(delayedEvent);
+	}
+
+	return serialized;
+}
+
+void VirtualTimeDelayedEventQueue::deserialize(const Data& data) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	std::vector<Data> delayedEvents;
+
+	if (data.hasKey("VirtualTimeDelayedEventQueue")) {
+		delayedEvents = data["VirtualTimeDelayedEventQueue"].array;
+	} else if (data.hasKey("TimerWheelDelayedEventQueue")) {
+		delayedEvents = data["TimerWheelDelayedEventQueue"].array;
+	} else if (data.hasKey("BasicDelayedEventQueue")) {
+		delayedEvents = data["BasicDelayedEventQueue"].array;
+	}
+
+	for (auto delayedEvent : delayedEvents) {
+		Event e = Event::fromData(delayedEvent["event"]);
+		enqueueDelayed(e, strTo<size_t>(delayedEvent["delay"]), e.getUUID());
+	}
+}
+
+}
@@ -0,0 +1,86 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef VIRTUALTIMEDELAYEDEVENTQUEUE_H_71C4B2E8
+#define VIRTUALTIMEDELAYEDEVENTQUEUE_H_71C4B2E8
+
+#include "BasicEventQueue.h"
+#include "VirtualClock.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace uscxml {
+
+/**
+ * @ingroup eventqueue
+ * @ingroup impl
+ *
+ * A delayed event queue on a VirtualClock, delayed events are only delivered
+ * when the clock is advanced past their due time.
+ *
+ * Queues created from this one for invoked sessions share its clock.
+ */
+class USCXML_API VirtualTimeDelayedEventQueue : public BasicEventQueue, public DelayedEventQueueImpl, public VirtualClock::TimerCallbacks {
+public:
+	VirtualTimeDelayedEventQueue(DelayedEventQueueCallbacks* callbacks,
+	                             std::shared_ptr<VirtualClock> clock = std::shared_ptr<VirtualClock>(new VirtualClock()));
+	virtual ~VirtualTimeDelayedEventQueue();
+	virtual std::shared_ptr<DelayedEventQueueImpl> create(DelayedEventQueueCallbacks* callbacks);
+	virtual void enqueueDelayed(const Event& event, size_t delayMs, const std::string& eventUUID);
+	virtual void cancelDelayed(const std::string& eventId);
+	virtual void cancelAllDelayed();
+	virtual Event dequeue(size_t blockMs) {
+		return BasicEventQueue::dequeue(blockMs);
+	}
+	virtual void enqueue(const Event& event) {
+		return BasicEventQueue::enqueue(event);
+	}
+	virtual void reset();
+
+	virtual Data serialize();
+	virtual void deserialize(const Data& data);
+
+	virtual void timerFired(uint64_t timerId);
+
+	std::shared_ptr<VirtualClock> getClock() {
+		return _clock;
+	}
+
+protected:
+	virtual std::shared_ptr<EventQueueImpl> create() {
+		ErrorEvent e("Cannot create a DelayedEventQueue without callbacks");
+		throw e;
+	}
+
+	struct DelayedEvent {
+		Event userData;
+		std::string eventUUID;
+	};
+
+	std::unordered_map<uint64_t, DelayedEvent> _timers;
+	std::unordered_map<std::string, uint64_t> _timerIds;
+	std::shared_ptr<VirtualClock> _clock;
+	DelayedEventQueueCallbacks* _callbacks;
+};
+
+}
+
+#endif /* end of include guard: VIRTUALTIMEDELAYEDEVENTQUEUE_H_71C4B2E8 */
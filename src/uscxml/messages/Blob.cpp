@@ -18,13 +18,31 @@
  */
 
 #include "uscxml/messages/Blob.h"
+#include "uscxml/messages/Event.h"
 
 #include "uscxml/util/MD5.hpp"
 #include "uscxml/util/Base64.hpp"
 
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace uscxml {
 
 BlobImpl::~BlobImpl() {
+	if (_parent)
+		return;
+#ifndef _WIN32
+	if (_mapping != NULL) {
+		munmap(_mapping, _mappingSize);
+		return;
+	}
+#endif
 	free(data);
 }
 
@@ -33,18 +51,79 @@ std::string BlobImpl::md5() const {
 }
 
 BlobImpl* BlobImpl::fromBase64(const std::string base64, const std::string& mimeType) {
-	std::string decoded = base64Decode(base64);
-	return new BlobImpl(decoded.c_str(), decoded.length(), mimeType);
+	// decode right into the memory we adopt
+	char* decoded = (char*)malloc(base64DecodedSize(base64.size()));
+	size_t size = base64Decode(base64.data(), base64.size(), decoded);
+	return new BlobImpl(decoded, size, mimeType, true);
 }
 
-BlobImpl::BlobImpl(size_t _size) {
+BlobImpl* BlobImpl::fromFile(const std::string& path, const std::string& mimeType, size_t offset, size_t length) {
+	BlobImpl* blob = new BlobImpl();
+	blob->mimeType = mimeType;
+
+#ifndef _WIN32
+	int fd = open(path.c_str(), O_RDONLY);
+	struct stat fileStat;
+	if (fd < 0 || fstat(fd, &fileStat) != 0) {
+		if (fd >= 0)
+			close(fd);
+		delete blob;
+		ERROR_PLATFORM_THROW("Cannot open file '" + path + "'");
+	}
+
+	size_t fileSize = fileStat.st_size;
+	if (offset > fileSize)
+		offset = fileSize;
+	if (length > fileSize - offset)
+		length = fileSize - offset;
+
+	if (length > 0) {
+		// mappings start at page boundaries
+		size_t pageOffset = offset % sysconf(_SC_PAGESIZE);
+		blob->_mappingSize = length + pageOffset;
+		blob->_mapping = mmap(NULL, blob->_mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset - pageOffset);
+		if (blob->_mapping == MAP_FAILED) {
+			close(fd);
+			blob->_mapping = NULL;
+			delete blob;
+			ERROR_PLATFORM_THROW("Cannot map file '" + path + "'");
+		}
+		blob->data = (char*)blob->_mapping + pageOffset;
+		blob->size = length;
+	}
+	close(fd);
+#else
+	// no mapping on windows for now, read the region into memory
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL) {
+		delete blob;
+		ERROR_PLATFORM_THROW("Cannot open file '" + path + "'");
+	}
+
+	fseek(file, 0, SEEK_END);
+	size_t fileSize = ftell(file);
+	if (offset > fileSize)
+		offset = fileSize;
+	if (length > fileSize - offset)
+		length = fileSize - offset;
+
+	blob->data = (char*)malloc(length);
+	fseek(file, offset, SEEK_SET);
+	blob->size = fread(blob->data, 1, length, file);
+	fclose(file);
+#endif
+
+	return blob;
+}
+
+BlobImpl::BlobImpl(size_t _size) : _mapping(NULL), _mappingSize(0) {
 	data = (char*)malloc(_size);
 	memset(data, 0, _size);
 	size = _size;
 	mimeType = "application/octet-stream";
 }
 
-BlobImpl::BlobImpl(const char* _data, size_t _size, const std::string& _mimeType, bool adopt) {
+BlobImpl::BlobImpl(const char* _data, size_t _size, const std::string& _mimeType, bool adopt) : _mapping(NULL), _mappingSize(0) {
 	if (adopt) {
 		data = (char*)_data;
 	} else {
@@ -55,8 +134,25 @@ BlobImpl::BlobImpl(const char* _data, size_t _size, const std::string& _mimeType
 	size = _size;
 }
 
+BlobImpl::BlobImpl(const std::shared_ptr<BlobImpl>& parent, size_t offset, size_t _size) : _mapping(NULL), _mappingSize(0) {
+	// hold on to the blob owning the memory, not to another slice
+	_parent = (parent->_parent ? parent->_parent : parent);
+	if (offset > parent->size)
+		offset = parent->size;
+	if (_size > parent->size - offset)
+		_size = parent->size - offset;
+
+	data = parent->data + offset;
+	size = _size;
+	mimeType = parent->mimeType;
+}
+
 std::string BlobImpl::base64() const {
-	return base64Encode((char* const)data, size);
+	return base64Encode(data, size);
 }
 
-}
\ No newline at end of file
+void BlobImpl::base64(std::ostream& stream) const {
+	base64Encode(data, size, stream);
+}
+
+}
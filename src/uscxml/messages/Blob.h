@@ -22,6 +22,7 @@
 
 #include <string>
 #include <memory>
+#include <ostream>
 
 #include "uscxml/Common.h"
 
@@ -31,11 +32,14 @@ class USCXML_API BlobImpl {
 public:
 	BlobImpl(size_t size);
 	BlobImpl(const char* data, size_t size, const std::string& mimeType, bool adopt = false);
+	BlobImpl(const std::shared_ptr<BlobImpl>& parent, size_t offset, size_t size);
 	virtual ~BlobImpl();
 
 	std::string base64() const;
+	void base64(std::ostream& stream) const;
 	std::string md5() const;
 	static BlobImpl* fromBase64(const std::string base64, const std::string& mimeType);
+	static BlobImpl* fromFile(const std::string& path, const std::string& mimeType, size_t offset, size_t length);
 
 	char* getData() const {
 		return data;
@@ -60,6 +64,13 @@ protected:
 	char* data;
 	size_t size;
 	std::string mimeType;
+
+protected:
+	BlobImpl() : data(NULL), size(0), _mapping(NULL), _mappingSize(0) {}
+
+	std::shared_ptr<BlobImpl> _parent; ///< keeps the memory of a slice alive
+	void* _mapping; ///< page aligned start of a mapped file region
+	size_t _mappingSize;
 };
 
 class USCXML_API Blob {
@@ -78,10 +89,33 @@ public:
 		return Blob(std::shared_ptr<BlobImpl>(BlobImpl::fromBase64(base64, mimeType)));
 	}
 
+	/**
+	 * Map a region of a file into memory without reading it. Pages are loaded
+	 * when first accessed and writes to the data stay private to the Blob.
+	 */
+	static Blob fromFile(const std::string& path,
+	                     const std::string& mimeType = "application/octet-stream",
+	                     size_t offset = 0,
+	                     size_t length = std::string::npos) {
+		return Blob(std::shared_ptr<BlobImpl>(BlobImpl::fromFile(path, mimeType, offset, length)));
+	}
+
+	/**
+	 * A Blob referencing part of this one without copying. The memory stays
+	 * valid for as long as any slice of it is around.
+	 */
+	Blob slice(size_t offset, size_t length = std::string::npos) const {
+		return Blob(std::shared_ptr<BlobImpl>(new BlobImpl(_impl, offset, length)));
+	}
+
 	std::string base64() const {
 		return _impl->base64();
 	}
 
+	void base64(std::ostream& stream) const {
+		_impl->base64(stream);
+	}
+
 	std::string md5() const {
 		return _impl->md5();
 	}
@@ -20,7 +20,7 @@
 #include "uscxml/messages/Data.h"
 #include "uscxml/messages/Blob.h"
 
-#include <boost/algorithm/string.hpp>
+#include <vector>
 
 #ifndef NO_XERCESC
 #include "uscxml/util/DOM.h"
@@ -32,10 +32,6 @@
 #include <string.h>
 #endif
 
-extern "C" {
-#include "jsmn/jsmn.h" // minimal json parser
-}
-
 namespace uscxml {
 
 Data::Data(const char* data, size_t size, const std::string& mimeType, bool adopt) : node(NULL), binary(data, size, mimeType, adopt) {}
@@ -61,7 +57,7 @@ void Data::merge(const Data& other) {
 		if (array.size() == 0) {
 			array = other.array;
 		} else {
-			std::list<Data>::const_iterator arrIter = other.array.begin();
+			std::vector<Data>::const_iterator arrIter = other.array.begin();
 			while(arrIter != other.array.end()) {
 				array.push_back(*arrIter);
 				arrIter++;
@@ -74,133 +70,273 @@ void Data::merge(const Data& other) {
 	}
 }
 
-Data Data::fromJSON(const std::string& jsonString) {
+/**
+ * Single pass JSON reader building Data in place. It is as lenient as the
+ * non-strict jsmn parser we used before: commas and colons are whitespace
+ * and unquoted values or keys are primitives.
+ */
+class JSONReader {
+public:
+	JSONReader(const char* json, const char* end) : _pos(json), _end(end) {}
+
+	/// Parse the object or array at the current position, returns the position after it
+	const char* parse(Data& data) {
+		std::vector<Frame> stack;
+		stack.push_back(Frame(&data, *_pos));
+		_pos++;
+
+		while (!stack.empty()) {
+			if (_pos == _end) {
+				ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
+			}
 
-	Data data;
+			switch (*_pos) {
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+			case ',':
+			case ':':
+				_pos++;
+				break;
+			case '{':
+			case '[': {
+				Frame& frame = stack.back();
+				if (frame.type == '{' && frame.value == NULL) {
+					ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
+				}
+				Data* child = frame.nextValue();
+				stack.push_back(Frame(child, *_pos));
+				_pos++;
+				break;
+			}
+			case '}':
+			case ']':
+				if ((*_pos == '}') != (stack.back().type == '{')) {
+					ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
+				}
+				stack.pop_back();
+				_pos++;
+				break;
+			case '"': {
+				Frame& frame = stack.back();
+				if (frame.type == '{' && frame.value == NULL) {
+					std::string key;
+					readString(key);
+					frame.value = &(frame.data->compound[key]);
+					frame.value->clear();
+					frame.value->type = Data::INTERPRETED;
+				} else {
+					Data* value = frame.nextValue();
+					value->type = Data::VERBATIM;
+					readString(value->atom);
+				}
+				break;
+			}
+			default: {
+				Frame& frame = stack.back();
+				if (frame.type == '{' && frame.value == NULL) {
+					std::string key;
+					readPrimitive(key);
+					frame.value = &(frame.data->compound[key]);
+					frame.value->clear();
+					frame.value->type = Data::INTERPRETED;
+				} else {
+					readPrimitive(frame.nextValue()->atom);
+				}
+				break;
+			}
+			}
+		}
+		return _pos;
+	}
 
-	std::string trimmed = boost::trim_copy(jsonString);
+protected:
+	struct Frame {
+		Frame(Data* data, char type) : data(data), value(NULL), type(type) {}
 
-	if (trimmed.length() == 0)
-		return data;
+		/// The item to fill next, arrays only grow once nested items are complete
+		Data* nextValue() {
+			if (type == '[') {
+				data->array.push_back(Data());
+				return &(data->array.back());
+			}
+			Data* next = value;
+			value = NULL;
+			return next;
+		}
 
-	if (trimmed.find_first_of("{[") != 0)
-		return data;
+		Data* data;
+		Data* value; ///< the value for the last key in an object
+		char type;
+	};
 
-	jsmn_parser p;
+	void readString(std::string& target) {
+		const char* start = ++_pos;
 
-	jsmntok_t* t = NULL;
+		// fast path without escapes
+		while (_pos != _end && *_pos != '"' && *_pos != '\\')
+			_pos++;
+		if (_pos == _end) {
+			ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
+		}
+		target.assign(start, _pos - start);
 
-	// we do not know the number of tokens beforehand, start with something sensible and increase
-	int rv;
-	int frac = 16; // length/token ratio
-	do {
-		jsmn_init(&p);
+		while (*_pos != '"') {
+			if (*_pos == '\\') {
+				if (++_pos == _end) {
+					ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
+				}
+				switch (*_pos) {
+				case '"':
+					target += '"';
+					break;
+				case '/':
+					target += '/';
+					break;
+				case '\\':
+					target += '\\';
+					break;
+				case 'b':
+					target += '\b';
+					break;
+				case 'f':
+					target += '\f';
+					break;
+				case 'n':
+					target += '\n';
+					break;
+				case 'r':
+					target += '\r';
+					break;
+				case 't':
+					target += '\t';
+					break;
+				case 'u':
+					readCodePoint(target);
+					break;
+				default: {
+					ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
+				}
+				}
+				_pos++;
+			} else {
+				start = _pos;
+				while (_pos != _end && *_pos != '"' && *_pos != '\\')
+					_pos++;
+				target.append(start, _pos - start);
+			}
+			if (_pos == _end) {
+				ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
+			}
+		}
+		_pos++;
+	}
 
-		frac /= 2;
-		int nrTokens = trimmed.size() / frac;
-		if (t != NULL) {
-			free(t);
-//      LOG(USCXML_INFO) << "Increasing JSON length to token ratio to 1/" << frac;
+	static uint32_t readHex4(const char* hex) {
+		uint32_t value = 0;
+		for (size_t i = 0; i < 4; i++) {
+			char c = hex[i];
+			value <<= 4;
+			if (c >= '0' && c <= '9') {
+				value |= c - '0';
+			} else if (c >= 'a' && c <= 'f') {
+				value |= c - 'a' + 10;
+			} else if (c >= 'A' && c <= 'F') {
+				value |= c - 'A' + 10;
+			} else {
+				ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
+			}
 		}
-		t = (jsmntok_t*)malloc((nrTokens + 1) * sizeof(jsmntok_t));
-		if (t == NULL) {
-			ERROR_PLATFORM_THROW("Cannot parse JSON, ran out of memory!");
+		return value;
+	}
+
+	/// \uXXXX at the current position as UTF-8, leaves _pos at the last hex digit
+	void readCodePoint(std::string& target) {
+		if (_end - _pos < 5) {
+			ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
 		}
-		memset(t, 0, (nrTokens + 1) * sizeof(jsmntok_t));
 
-		rv = jsmn_parse(&p, trimmed.c_str(), t, nrTokens);
-	} while (rv == JSMN_ERROR_NOMEM && frac > 1);
+		uint32_t codePoint = readHex4(_pos + 1);
+		_pos += 4;
 
-	if (rv != 0) {
-		switch (rv) {
-		case JSMN_ERROR_NOMEM: {
-			ERROR_PLATFORM_THROW("Cannot parse JSON, not enough tokens were provided!");
-			break;
+		// surrogate pair
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF && _end - _pos >= 7 && _pos[1] == '\\' && _pos[2] == 'u') {
+			uint32_t low = readHex4(_pos + 3);
+			if (low >= 0xDC00 && low <= 0xDFFF) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				_pos += 6;
+			}
 		}
-		case JSMN_ERROR_INVAL: {
-			ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
-			break;
+
+		if (codePoint < 0x80) {
+			target += (char)codePoint;
+		} else if (codePoint < 0x800) {
+			target += (char)(0xC0 | (codePoint >> 6));
+			target += (char)(0x80 | (codePoint & 0x3F));
+		} else if (codePoint < 0x10000) {
+			target += (char)(0xE0 | (codePoint >> 12));
+			target += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			target += (char)(0x80 | (codePoint & 0x3F));
+		} else {
+			target += (char)(0xF0 | (codePoint >> 18));
+			target += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			target += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			target += (char)(0x80 | (codePoint & 0x3F));
 		}
-		case JSMN_ERROR_PART: {
-			ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
-			break;
+	}
+
+	void readPrimitive(std::string& target) {
+		const char* start = _pos;
+		bool hasEscape = false;
+		for (; _pos != _end; _pos++) {
+			char c = *_pos;
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+			        c == ',' || c == ':' || c == ']' || c == '}')
+				break;
+			if (c < 32 || c >= 127) {
+				ERROR_PLATFORM_THROW("Cannot parse JSON, invalid character inside JSON string!");
+			}
+			if (c == '\\')
+				hasEscape = true;
 		}
-		default:
-			break;
+		if (_pos == _end) {
+			ERROR_PLATFORM_THROW("Cannot parse JSON, the string is not a full JSON packet, more bytes expected!");
 		}
-		free(t);
-		return data;
+
+		target.assign(start, _pos - start);
+		if (hasEscape)
+			target = Data::jsonUnescape(target);
 	}
 
-	if ((size_t)t[0].end != trimmed.length())
-		return data;
+	const char* _pos;
+	const char* _end;
+};
 
-//	jsmntok_t* token = t;
-//	while(token->end) {
-//		std::cout << trimmed.substr(token->start, token->end - token->start) << std::endl;
-//		std::cout << "------" << std::endl;
-//		token++;
-//	}
-
-	std::list<Data*> dataStack;
-	std::list<jsmntok_t> tokenStack;
-	dataStack.push_back(&data);
-
-	size_t currTok = 0;
-	do {
-		// used for debugging
-//		jsmntok_t t2 = t[currTok];
-//		std::string value = trimmed.substr(t[currTok].start, t[currTok].end - t[currTok].start);
-		switch (t[currTok].type) {
-		case JSMN_STRING:
-			dataStack.back()->type = Data::VERBATIM;
-		case JSMN_PRIMITIVE: {
-			std::string value = trimmed.substr(t[currTok].start, t[currTok].end - t[currTok].start);
-//			if (dataStack.back()->type == Data::VERBATIM) {
-//				boost::replace_all(value, "\\\"", "\"");
-//				boost::replace_all(value, "\\n", "\n");
-//			}
-			value = jsonUnescape(value);
-			dataStack.back()->atom = value;
-			dataStack.pop_back();
-			currTok++;
-			break;
-		}
-		case JSMN_OBJECT:
-		case JSMN_ARRAY:
-			tokenStack.push_back(t[currTok]);
-			currTok++;
-			break;
-		}
-		// used for debugging
-//		t2 = t[currTok];
-//		value = trimmed.substr(t[currTok].start, t[currTok].end - t[currTok].start);
+static inline bool isJSONSpace(char c) {
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f');
+}
 
-		// there are no more tokens
-		if (t[currTok].end == 0 || tokenStack.empty())
-			break;
+Data Data::fromJSON(const std::string& jsonString) {
+	Data data;
 
-		// next token starts after current one => pop
-		while (t[currTok].end > tokenStack.back().end) {
-			tokenStack.pop_back();
-			dataStack.pop_back();
-		}
+	const char* start = jsonString.c_str();
+	const char* end = start + jsonString.length();
+	while (start != end && isJSONSpace(*start))
+		start++;
+	while (end != start && isJSONSpace(*(end - 1)))
+		end--;
 
-		if (tokenStack.back().type == JSMN_OBJECT && (t[currTok].type == JSMN_PRIMITIVE || t[currTok].type == JSMN_STRING)) {
-			// grab key and push new data
-			std::string value = jsonUnescape(trimmed.substr(t[currTok].start, t[currTok].end - t[currTok].start));
-			dataStack.push_back(&(dataStack.back()->compound[value]));
-			currTok++;
-		}
-		if (tokenStack.back().type == JSMN_ARRAY) {
-			// push new index
-			dataStack.back()->array.push_back(Data());
-			dataStack.push_back(&(dataStack.back()->array.back()));
-		}
+	if (start == end)
+		return data;
+
+	if (*start != '{' && *start != '[')
+		return data;
 
-	} while (true);
+	JSONReader reader(start, end);
+	if (reader.parse(data) != end)
+		return Data(); // trailing garbage
 
-	free(t);
 	return data;
 }
 
@@ -214,11 +350,16 @@ std::string Data::asJSON() const {
 }
 
 std::string Data::toJSON(const Data& data) {
-	std::stringstream os;
-	std::string indent;
-	for (size_t i = 0; i <= _dataIndentation; i++) {
-		indent += "  ";
-	}
+	std::string json;
+	toJSON(data, json);
+	return json;
+}
+
+void Data::toJSON(const Data& data, std::string& json) {
+	toJSON(data, json, 1);
+}
+
+void Data::toJSON(const Data& data, std::string& json, size_t indentation) {
 	if (false) {
 	} else if (data.compound.size() > 0) {
 		size_t longestKey = 0;
@@ -228,60 +369,60 @@ std::string Data::toJSON(const Data& data) {
 				longestKey = compoundIter->first.size();
 			compoundIter++;
 		}
-		std::string keyPadding;
-		for (size_t i = 0; i < longestKey; i++)
-			keyPadding += " ";
 
-		std::string seperator;
-		os << "{";
+		json += '{';
 		compoundIter = data.compound.begin();
 		while(compoundIter != data.compound.end()) {
-			os << seperator << std::endl << indent << "  \"" << jsonEscape(compoundIter->first) << "\": " << keyPadding.substr(0, longestKey - compoundIter->first.size());
-			_dataIndentation += 1;
-			os << compoundIter->second;
-			_dataIndentation -= 1;
-			seperator = ", ";
+			if (compoundIter != data.compound.begin())
+				json += ", ";
+			json += '\n';
+			json.append(2 * (indentation + 1) + 2, ' ');
+			json += '"';
+			jsonEscape(compoundIter->first, json);
+			json += "\": ";
+			json.append(longestKey - compoundIter->first.size(), ' ');
+			toJSON(compoundIter->second, json, indentation + 1);
 			compoundIter++;
 		}
-		os << std::endl << indent << "}";
+		json += '\n';
+		json.append(2 * (indentation + 1), ' ');
+		json += '}';
 	} else if (data.array.size() > 0) {
-
-		std::string seperator;
-		os << std::endl << indent << "[";
-		std::list<Data>::const_iterator arrayIter = data.array.begin();
+		json += '\n';
+		json.append(2 * (indentation + 1), ' ');
+		json += '[';
+		std::vector<Data>::const_iterator arrayIter = data.array.begin();
 		while(arrayIter != data.array.end()) {
-			_dataIndentation += 1;
-			os << seperator << *arrayIter;
-			_dataIndentation -= 1;
-			seperator = ", ";
+			if (arrayIter != data.array.begin())
+				json += ", ";
+			toJSON(*arrayIter, json, indentation + 1);
 			arrayIter++;
 		}
-		os << "]";
+		json += ']';
 	} else if (data.atom.size() > 0) {
 		// empty string is handled below
 		if (data.type == Data::VERBATIM) {
-			os << "\"" << jsonEscape(data.atom) << "\"";
+			json += '"';
+			jsonEscape(data.atom, json);
+			json += '"';
 		} else {
-			os << data.atom;
+			json += data.atom;
 		}
 #ifndef NO_XERCESC
 	} else if (data.node) {
 		std::ostringstream xmlSerSS;
 		xmlSerSS << *data.node;
-		std::string xmlSer = xmlSerSS.str();
-//		boost::replace_all(xmlSer, "\"", "\\\"");
-//		boost::replace_all(xmlSer, "\n", "\\n");
-//		boost::replace_all(xmlSer, "\t", "\\t");
-		os << "\"" << jsonEscape(xmlSer) << "\"";
+		json += '"';
+		jsonEscape(xmlSerSS.str(), json);
+		json += '"';
 #endif
 	} else {
 		if (data.type == Data::VERBATIM) {
-			os << "\"\""; // empty string
+			json += "\"\""; // empty string
 		} else {
-			os << "null"; // non object
+			json += "null"; // non object
 		}
 	}
-	return os.str();
 }
 
 std::string Data::jsonUnescape(const std::string& expr) {
@@ -339,33 +480,50 @@ std::string Data::jsonUnescape(const std::string& expr) {
 }
 
 std::string Data::jsonEscape(const std::string& expr) {
-	std::stringstream os;
+	std::string escaped;
+	jsonEscape(expr, escaped);
+	return escaped;
+}
+
+void Data::jsonEscape(const std::string& expr, std::string& escaped) {
+	escaped.reserve(escaped.size() + expr.size());
+
+	size_t plain = 0;
 	for (size_t i = 0; i < expr.size(); i++) {
-		// escape string
-		if (false) {
-		} else if (expr[i] == '\t') {
-			os << "\\t";
-		} else if (expr[i] == '\v') {
-			os << "\\v";
-		} else if (expr[i] == '\b') {
-			os << "\\b";
-		} else if (expr[i] == '\f') {
-			os << "\\f";
-		} else if (expr[i] == '\n') {
-			os << "\\n";
-		} else if (expr[i] == '\r') {
-			os << "\\r";
-//		} else if (expr[i] == '\'') {
-//			os << "\\\'";
-		} else if (expr[i] == '\"') {
-			os << "\\\"";
-		} else if (expr[i] == '\\') {
-			os << "\\\\";
-		} else {
-			os << expr[i];
+		const char* replacement;
+		switch (expr[i]) {
+		case '\t':
+			replacement = "\\t";
+			break;
+		case '\v':
+			replacement = "\\v";
+			break;
+		case '\b':
+			replacement = "\\b";
+			break;
+		case '\f':
+			replacement = "\\f";
+			break;
+		case '\n':
+			replacement = "\\n";
+			break;
+		case '\r':
+			replacement = "\\r";
+			break;
+		case '\"':
+			replacement = "\\\"";
+			break;
+		case '\\':
+			replacement = "\\\\";
+			break;
+		default:
+			continue;
 		}
+		// copy runs of characters that need no escaping at once
+		escaped.append(expr, plain, i - plain);
+		escaped += replacement;
+		plain = i + 1;
 	}
-
-	return os.str();
+	escaped.append(expr, plain, std::string::npos);
 }
 }
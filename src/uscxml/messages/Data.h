@@ -24,6 +24,7 @@
 #include <map>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "uscxml/Common.h"
 #include "uscxml/util/Convenience.h"
@@ -85,6 +86,31 @@ public:
 	~Data() {
 	}
 
+#ifndef SWIGIMPORTED
+	Data(const Data& other) = default;
+	Data& operator=(const Data& other) = default;
+
+	// Blob has no move operations, but arrays have to relocate their items cheaply
+	Data(Data&& other) noexcept
+		: node(other.node),
+		  compound(std::move(other.compound)),
+		  array(std::move(other.array)),
+		  atom(std::move(other.atom)),
+		  type(other.type) {
+		binary._impl = std::move(other.binary._impl);
+	}
+
+	Data& operator=(Data&& other) noexcept {
+		node = other.node;
+		compound = std::move(other.compound);
+		array = std::move(other.array);
+		atom = std::move(other.atom);
+		binary._impl = std::move(other.binary._impl);
+		type = other.type;
+		return *this;
+	}
+#endif
+
 	void clear() {
 		type = VERBATIM;
 		compound.clear();
@@ -100,8 +126,9 @@ public:
 	}
 
 	bool operator<(const Data& other) const {
-		if (other.atom != atom)
-			return other.atom < atom;
+		int atomCmp = other.atom.compare(atom);
+		if (atomCmp != 0)
+			return atomCmp < 0;
 		if (other.array != array)
 			return other.array < array;
 		if (other.compound != compound)
@@ -141,12 +168,10 @@ public:
 	}
 
 	Data& operator[](const size_t index) {
-		while(array.size() < index) {
-			array.push_back(Data("", Data::VERBATIM));
+		if (array.size() <= index) {
+			array.resize(index + 1, Data("", Data::VERBATIM));
 		}
-		std::list<Data>::iterator arrayIter = array.begin();
-		for (size_t i = 0; i < index; i++, arrayIter++) {}
-		return *arrayIter;
+		return array[index];
 	}
 #endif
 
@@ -163,9 +188,7 @@ public:
 
 	const Data item(const size_t index) const {
 		if (array.size() > index) {
-			std::list<Data>::const_iterator arrayIter = array.begin();
-			for (size_t i = 0; i < index; i++, arrayIter++) {}
-			return *arrayIter;
+			return array[index];
 		}
 		Data data;
 		return data;
@@ -176,15 +199,21 @@ public:
 	}
 
 	void put(size_t index, const Data& data) {
-		this[index] = data;
+		(*this)[index] = data;
 	}
 
 	bool operator==(const Data &other) const {
-		return !(*this != other);
+		// cheap comparisons first, containers compare their sizes before their items
+		return (type == other.type &&
+		        node == other.node &&
+		        binary == other.binary &&
+		        atom == other.atom &&
+		        array == other.array &&
+		        compound == other.compound);
 	}
 
 	bool operator!=(const Data &other) const {
-		return (*this < other || other < *this);
+		return !(*this == other);
 	}
 
 	operator std::string() const {
@@ -196,18 +225,21 @@ public:
 	}
 
 	operator std::list<Data>() {
-		return array;
+		return std::list<Data>(array.begin(), array.end());
 	}
 
 	static Data fromJSON(const std::string& jsonString);
 	static std::string toJSON(const Data& data);
+	/// Append the JSON representation to a buffer, e.g. one reused across calls
+	static void toJSON(const Data& data, std::string& json);
 	std::string asJSON() const;
 
+	// the bindings still see a list
 	std::list<Data> getArray() {
-		return array;
+		return std::list<Data>(array.begin(), array.end());
 	}
 	void setArray(const std::list<Data>& array) {
-		this->array = array;
+		this->array.assign(array.begin(), array.end());
 	}
 
 	std::string getAtom() const {
@@ -247,15 +279,18 @@ protected:
 	XERCESC_NS::DOMNode* node;
 //	std::shared_ptr<XERCESC_NS::DOMDocument> adoptedDoc;
 	std::map<std::string, Data> compound;
-	std::list<Data> array;
+	std::vector<Data> array;
 	std::string atom;
 	Blob binary;
 	Type type;
 
 protected:
+	static void toJSON(const Data& data, std::string& json, size_t indentation);
 	static std::string jsonEscape(const std::string& expr);
+	static void jsonEscape(const std::string& expr, std::string& escaped);
 	static std::string jsonUnescape(const std::string& expr);
 	friend USCXML_API std::ostream& operator<< (std::ostream& os, const Data& data);
+	friend class JSONReader;
 
 };
 
@@ -21,10 +21,10 @@
 
 namespace uscxml {
 
-Event::Event() : eventType(INTERNAL), hideSendId(false) {
+Event::Event() : eventType(INTERNAL), hideSendId(false), enqueuedAt(0), nameId(0) {
 }
 
-Event::Event(const std::string& name, Type type) : name(name), eventType(type), hideSendId(false) {
+Event::Event(const std::string& name, Type type) : name(name), eventType(type), hideSendId(false), enqueuedAt(0), nameId(0) {
 }
 
 Event Event::fromData(const Data& data) {
@@ -62,7 +62,7 @@ Event Event::fromData(const Data& data) {
 
 Event::operator Data() {
 	Data data;
-	data["data"] = data;
+	data["data"] = this->data;
 	data["raw"] = Data(raw, Data::VERBATIM);
 	data["name"] = Data(name, Data::VERBATIM);
 	data["eventType"] = Data(eventType, Data::VERBATIM);
@@ -216,6 +216,8 @@ public:
 	Data data;
 	std::map<std::string, Data> namelist;
 	std::multimap<std::string, Data> params;
+	uint64_t enqueuedAt; ///< Benchmark::now() when queued with metrics enabled, 0 otherwise
+	uint32_t nameId; ///< EventName id of the name or 0 if not yet resolved, a hint the interpreter checks against the name when dequeuing
 
 private:
 	mutable std::string uuid; // the sendid is not necessarily unique!
@@ -19,6 +19,7 @@
 
 #include "DataModel.h"
 #include "DataModelImpl.h"
+#include "uscxml/debug/Benchmark.h"
 
 namespace uscxml {
 
@@ -35,6 +36,7 @@ bool DataModel::isLegalDataValue(const std::string& expr) {
 }
 
 void DataModel::setEvent(const Event& event) {
+	USCXML_BENCHMARK("DataModel: setEvent");
 	return _impl->setEvent(event);
 }
 
@@ -43,17 +45,39 @@ Data DataModel::getAsData(const std::string& content) {
 }
 
 Data DataModel::evalAsData(const std::string& content) {
+	USCXML_BENCHMARK("DataModel: evalAsData");
 	return _impl->evalAsData(content);
 }
 
 void DataModel::eval(const std::string& content) {
+	USCXML_BENCHMARK("DataModel: eval");
 	_impl->eval(content);
 }
 
 bool DataModel::evalAsBool(const std::string& expr) {
+	USCXML_BENCHMARK("DataModel: evalAsBool");
 	return _impl->evalAsBool(expr);
 }
 
+std::shared_ptr<CompiledExpression> DataModel::compile(const std::string& expr) {
+	return _impl->compile(expr);
+}
+
+bool DataModel::evalCompiledAsBool(CompiledExpression& expr) {
+	USCXML_BENCHMARK("DataModel: evalCompiledAsBool");
+	return _impl->evalCompiledAsBool(expr);
+}
+
+Data DataModel::evalCompiledAsData(CompiledExpression& expr) {
+	USCXML_BENCHMARK("DataModel: evalCompiledAsData");
+	return _impl->evalCompiledAsData(expr);
+}
+
+void DataModel::evalCompiled(CompiledExpression& expr) {
+	USCXML_BENCHMARK("DataModel: evalCompiled");
+	_impl->evalCompiled(expr);
+}
+
 uint32_t DataModel::getLength(const std::string& expr) {
 	return _impl->getLength(expr);
 }
@@ -66,10 +90,12 @@ void DataModel::setForeach(const std::string& item,
 }
 
 void DataModel::assign(const std::string& location, const Data& data, const std::map<std::string, std::string>& attr) {
+	USCXML_BENCHMARK("DataModel: assign");
 	return _impl->assign(location, data, attr);
 }
 
 void DataModel::init(const std::string& location, const Data& data, const std::map<std::string, std::string>& attr) {
+	USCXML_BENCHMARK("DataModel: init");
 	return _impl->init(location, data, attr);
 }
 
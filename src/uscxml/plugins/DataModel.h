@@ -31,6 +31,7 @@ namespace uscxml {
 
 class DataModelImpl;
 class DataModelExtension;
+class CompiledExpression;
 
 /**
  * @ingroup datamodel
@@ -61,6 +62,15 @@ public:
 	/// @copydoc DataModelImpl::evalAsBool()
 	virtual bool evalAsBool(const std::string& expr);
 
+	/// @copydoc DataModelImpl::compile()
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr);
+	/// @copydoc DataModelImpl::evalCompiledAsBool()
+	virtual bool evalCompiledAsBool(CompiledExpression& expr);
+	/// @copydoc DataModelImpl::evalCompiledAsData()
+	virtual Data evalCompiledAsData(CompiledExpression& expr);
+	/// @copydoc DataModelImpl::evalCompiled()
+	virtual void evalCompiled(CompiledExpression& expr);
+
 	/// @copydoc DataModelImpl::getLength()
 	virtual uint32_t getLength(const std::string& expr);
 	/// @copydoc DataModelImpl::setForeach()
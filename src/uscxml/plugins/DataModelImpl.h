@@ -69,6 +69,20 @@ public:
 	DataModelImpl* dm;
 };
 
+/**
+ * @ingroup datamodel
+ * An expression prepared by a data-model for repeated evaluation.
+ *
+ * Data-models that can compile expressions will inherit this class to keep
+ * their compiled representation, the base class merely retains the source.
+ */
+class USCXML_API CompiledExpression {
+public:
+	CompiledExpression(const std::string& expr) : expr(expr) {}
+	virtual ~CompiledExpression() {}
+	const std::string expr;
+};
+
 /**
  * @ingroup datamodel
  * @ingroup abstract
@@ -201,6 +215,33 @@ public:
 	 */
 	virtual bool evalAsBool(const std::string& expr) = 0;
 
+	/**
+	 * Prepare an expression for repeated evaluation.
+	 * The returned handle is only valid for this instance and evaluated via
+	 * evalCompiledAsBool(), evalCompiledAsData() or evalCompiled(). Compiling
+	 * must not fail, syntax errors are to be raised when evaluating.
+	 * @param expr An expression in the data-model's language.
+	 * @return A handle to keep for as long as the expression is to be evaluated.
+	 */
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr) {
+		return std::shared_ptr<CompiledExpression>(new CompiledExpression(expr));
+	}
+
+	/// Evaluate a compiled expression as with evalAsBool()
+	virtual bool evalCompiledAsBool(CompiledExpression& expr) {
+		return evalAsBool(expr.expr);
+	}
+
+	/// Evaluate a compiled expression as with evalAsData()
+	virtual Data evalCompiledAsData(CompiledExpression& expr) {
+		return evalAsData(expr.expr);
+	}
+
+	/// Evaluate a compiled expression as with eval()
+	virtual void evalCompiled(CompiledExpression& expr) {
+		eval(expr.expr);
+	}
+
 	/**
 	 * Determine whether a given variable / location is declared.
 	 * @param expr The variable / location to check.
@@ -32,6 +32,7 @@ namespace uscxml {
 
 class Interpreter;
 class InterpreterMonitor;
+class MonitorSnapshot;
 class ActionLanguage;
 class Logger;
 
@@ -46,7 +47,7 @@ public:
 	virtual void enqueueInternal(const Event& event) = 0;
 	virtual void enqueueExternal(const Event& event) = 0;
 	virtual ActionLanguage* getActionLanguage() = 0; /// We return a pointer to relax dependencies in transpiled mode
-	virtual std::set<InterpreterMonitor*> getMonitors() = 0;
+	virtual const MonitorSnapshot& getMonitors() = 0;
 	virtual std::string getBaseURL() = 0;
 	virtual Logger getLogger() = 0;
 };
@@ -37,21 +37,6 @@
 #include <Pluma/Connector.hpp>
 #endif
 
-#define EVENT_STRING_OR_UNDEF(field, cond) \
-JSStringRef field##Name = JSStringCreateWithUTF8CString( #field ); \
-JSStringRef field##Val = JSStringCreateWithUTF8CString(event.field.c_str()); \
-JSObjectSetProperty(_ctx, \
-                    eventObj, \
-                    field##Name, \
-                    (cond ? JSValueMakeString(_ctx, field##Val) : JSValueMakeUndefined(_ctx)), \
-                    0, \
-                    &exception); \
-JSStringRelease(field##Name); \
-JSStringRelease(field##Val); \
-if (exception) \
-    handleException(exception);
-
-
 using namespace XERCESC_NS;
 
 #ifndef NO_XERCESC
@@ -102,11 +87,14 @@ bool pluginConnect(pluma::Host& host) {
 
 JSCDataModel::JSCDataModel() {
 	_ctx = NULL;
+	_eventClassRef = NULL;
 }
 
 JSCDataModel::~JSCDataModel() {
 	if (_ctx)
 		JSGlobalContextRelease(_ctx);
+	if (_eventClassRef)
+		JSClassRelease(_eventClassRef);
 }
 
 void JSCDataModel::addExtension(DataModelExtension* ext) {
@@ -189,6 +177,9 @@ JSClassDefinition JSCDataModel::jsExtensionClassDef = { 0, 0, "Extension", 0, 0,
 
 JSClassDefinition JSCDataModel::jsIOProcessorsClassDef = { 0, 0, "ioProcessors", 0, 0, 0, 0, 0, jsIOProcessorHasProp, jsIOProcessorGetProp, 0, 0, jsIOProcessorListProps, 0, 0, 0, 0 };
 JSClassDefinition JSCDataModel::jsInvokersClassDef = { 0, 0, "invokers", 0, 0, 0, 0, 0, jsInvokerHasProp, jsInvokerGetProp, 0, 0, jsInvokerListProps, 0, 0, 0, 0 };
+JSClassDefinition JSCDataModel::jsEventClassDef = { 0, 0, "EventFields", 0, 0, 0, 0, jsEventFinalize, 0, jsEventGetProp, 0, 0, jsEventListProps, 0, 0, 0, 0 };
+
+static const char* jsEventFields[] = { "sendid", "origin", "origintype", "invokeid", "type", "data", NULL };
 
 std::mutex JSCDataModel::_initMutex;
 
@@ -293,6 +284,8 @@ void JSCDataModel::setup() {
 	JSObjectSetProperty(_ctx, JSContextGetGlobalObject(_ctx), ioProcName, jsIOProc, kJSPropertyAttributeReadOnly | kJSPropertyAttributeDontDelete, NULL);
 	JSStringRelease(ioProcName);
 
+	_eventClassRef = JSClassCreate(&jsEventClassDef);
+
 	JSStringRef nameName = JSStringCreateWithUTF8CString("_name");
 	JSStringRef name = JSStringCreateWithUTF8CString(_callbacks->getName().c_str());
 	JSObjectSetProperty(_ctx, JSContextGetGlobalObject(_ctx), nameName, JSValueMakeString(_ctx, name), kJSPropertyAttributeReadOnly | kJSPropertyAttributeDontDelete, NULL);
@@ -309,113 +302,95 @@ void JSCDataModel::setup() {
 }
 
 void JSCDataModel::setEvent(const Event& event) {
-	Event* evPtr = new Event(event);
+	// the fields ignored by swig are only converted when a script reads them
+	EventFields* fields = new EventFields(this, event);
+	JSObjectRef fieldsObj = JSObjectMake(_ctx, _eventClassRef, fields);
+	JSObjectRef eventObj = SWIG_JSC_NewPointerObj(_ctx, &fields->event, SWIGTYPE_p_uscxml__Event, 0);
 
-	JSObjectRef eventObj = SWIG_JSC_NewPointerObj(_ctx, evPtr, SWIGTYPE_p_uscxml__Event, SWIG_POINTER_OWN);
-	JSObjectRef globalObject = JSContextGetGlobalObject(_ctx);
+	JSObjectSetPrototype(_ctx, fieldsObj, JSObjectGetPrototype(_ctx, eventObj));
+	JSObjectSetPrototype(_ctx, eventObj, fieldsObj);
 
+	JSObjectRef globalObject = JSContextGetGlobalObject(_ctx);
 	JSValueRef exception = NULL;
 
-	/* Manually handle swig ignored fields */
-	EVENT_STRING_OR_UNDEF(sendid, !event.hideSendId); // test333
-	EVENT_STRING_OR_UNDEF(origin, event.origin.size() > 0); // test335
-	EVENT_STRING_OR_UNDEF(origintype, event.origintype.size() > 0); // test337
-	EVENT_STRING_OR_UNDEF(invokeid, event.invokeid.size() > 0); // test339
-
-	/* Manually handle swig ignored event type */
-	JSStringRef eventTypeName = JSStringCreateWithUTF8CString("type");
-	JSStringRef eventTypeVal;
-
-	// test 331
-	switch (event.eventType) {
-	case Event::EXTERNAL:
-		eventTypeVal = JSStringCreateWithUTF8CString("external");
-		break;
-	case Event::INTERNAL:
-		eventTypeVal = JSStringCreateWithUTF8CString("internal");
-		break;
-	default:
-		eventTypeVal = JSStringCreateWithUTF8CString("platform");
-		break;
-	}
-
-	JSObjectSetProperty(_ctx, eventObj, eventTypeName, JSValueMakeString(_ctx, eventTypeVal), 0, &exception);
+	JSStringRef eventName = JSStringCreateWithUTF8CString("_event");
+	JSObjectSetProperty(_ctx, globalObject, eventName, eventObj, kJSPropertyAttributeDontDelete, &exception);
+	JSStringRelease(eventName);
 	if (exception)
 		handleException(exception);
 
-	JSStringRelease(eventTypeName);
-	JSStringRelease(eventTypeVal);
+}
+
+JSValueRef JSCDataModel::getEventFieldAsValue(const Event& event, const std::string& field) {
+	JSValueRef value = JSValueMakeUndefined(_ctx);
+	std::string fieldVal;
 
-	/* Manually handle swig ignored event data */
-	if (event.data.node) {
+	if (field == "sendid") {
+		if (event.hideSendId) // test333
+			return value;
+		fieldVal = event.sendid;
+	} else if (field == "origin") {
+		if (event.origin.size() == 0) // test335
+			return value;
+		fieldVal = event.origin;
+	} else if (field == "origintype") {
+		if (event.origintype.size() == 0) // test337
+			return value;
+		fieldVal = event.origintype;
+	} else if (field == "invokeid") {
+		if (event.invokeid.size() == 0) // test339
+			return value;
+		fieldVal = event.invokeid;
+	} else if (field == "type") {
+		// test 331
+		switch (event.eventType) {
+		case Event::EXTERNAL:
+			fieldVal = "external";
+			break;
+		case Event::INTERNAL:
+			fieldVal = "internal";
+			break;
+		default:
+			fieldVal = "platform";
+			break;
+		}
+	} else if (field == "data") {
+		if (event.data.node) {
 #ifndef NO_XERCESC
-		JSStringRef propName = JSStringCreateWithUTF8CString("data");
-		JSObjectSetProperty(_ctx, eventObj, propName, getNodeAsValue(event.data.node), 0, &exception);
-		JSStringRelease(propName);
-		if (exception)
-			handleException(exception);
+			return getNodeAsValue(event.data.node);
 #else
-		ERROR_EXECUTION_THROW("Compiled without DOM support");
+			// no nodes without DOM support
+			return value;
 #endif
-#if 0
-	} else if (event.content.length() > 0) {
-		// _event.data is a string or JSON
-		Data json = Data::fromJSON(event.content);
-		if (!json.empty()) {
-			JSStringRef propName = JSStringCreateWithUTF8CString("data");
-			JSObjectSetProperty(_ctx, eventObj, propName, getDataAsValue(json), 0, &exception);
-			JSStringRelease(propName);
-			if (exception)
-				handleException(exception);
-		} else {
-			JSStringRef propName = JSStringCreateWithUTF8CString("data");
-			JSStringRef contentStr = JSStringCreateWithUTF8CString(spaceNormalize(event.content).c_str());
-			JSObjectSetProperty(_ctx, eventObj, propName, JSValueMakeString(_ctx, contentStr), 0, &exception);
-			JSStringRelease(propName);
-			JSStringRelease(contentStr);
-
-			if (exception)
-				handleException(exception);
 		}
-#endif
-	} else {
 		// _event.data is KVP
-		Event eventCopy(event);
-		if (!eventCopy.params.empty()) {
-			Event::params_t::iterator paramIter = eventCopy.params.begin();
-			while(paramIter != eventCopy.params.end()) {
-				eventCopy.data.compound[paramIter->first] = paramIter->second;
+		Data data = event.data;
+		if (!event.params.empty()) {
+			Event::params_t::const_iterator paramIter = event.params.begin();
+			while(paramIter != event.params.end()) {
+				data.compound[paramIter->first] = paramIter->second;
 				paramIter++;
 			}
 		}
-		if (!eventCopy.namelist.empty()) {
-			Event::namelist_t::iterator nameListIter = eventCopy.namelist.begin();
-			while(nameListIter != eventCopy.namelist.end()) {
-				eventCopy.data.compound[nameListIter->first] = nameListIter->second;
+		if (!event.namelist.empty()) {
+			Event::namelist_t::const_iterator nameListIter = event.namelist.begin();
+			while(nameListIter != event.namelist.end()) {
+				data.compound[nameListIter->first] = nameListIter->second;
 				nameListIter++;
 			}
 		}
-		if (!eventCopy.data.empty()) {
-			JSStringRef propName = JSStringCreateWithUTF8CString("data");
-			JSObjectSetProperty(_ctx, eventObj, propName, getDataAsValue(eventCopy.data), 0, &exception);
-			JSStringRelease(propName);
-			if (exception)
-				handleException(exception);
-		} else {
-			// test 343 / test 488
-			JSStringRef propName = JSStringCreateWithUTF8CString("data");
-			JSObjectSetProperty(_ctx, eventObj, propName, JSValueMakeUndefined(_ctx), 0, &exception);
-			JSStringRelease(propName);
-			if (exception)
-				handleException(exception);
-		}
+		// test 343 / test 488
+		if (!data.empty())
+			value = getDataAsValue(data);
+		return value;
+	} else {
+		return NULL;
 	}
-	JSStringRef eventName = JSStringCreateWithUTF8CString("_event");
-	JSObjectSetProperty(_ctx, globalObject, eventName, eventObj, kJSPropertyAttributeDontDelete, &exception);
-	JSStringRelease(eventName);
-	if (exception)
-		handleException(exception);
 
+	JSStringRef fieldStr = JSStringCreateWithUTF8CString(fieldVal.c_str());
+	value = JSValueMakeString(_ctx, fieldStr);
+	JSStringRelease(fieldStr);
+	return value;
 }
 
 Data JSCDataModel::evalAsData(const std::string& content) {
@@ -482,7 +457,7 @@ JSValueRef JSCDataModel::getDataAsValue(const Data& data) {
 	if (data.array.size() > 0) {
 		std::vector<JSValueRef> elements(data.array.size());
 //		JSValueRef elements[data.array.size()];
-		std::list<Data>::const_iterator arrayIter = data.array.begin();
+		std::vector<Data>::const_iterator arrayIter = data.array.begin();
 		uint32_t index = 0;
 		while(arrayIter != data.array.end()) {
 			elements[index++] = getDataAsValue(*arrayIter);
@@ -911,4 +886,43 @@ void JSCDataModel::jsInvokerListProps(JSContextRef ctx, JSObjectRef object, JSPr
 	}
 }
 
+void JSCDataModel::jsEventFinalize(JSObjectRef object) {
+	delete (EventFields*)JSObjectGetPrivate(object);
+}
+
+JSValueRef JSCDataModel::jsEventGetProp(JSContextRef ctx, JSObjectRef object, JSStringRef propertyName, JSValueRef* exception) {
+	EventFields* fields = (EventFields*)JSObjectGetPrivate(object);
+
+	size_t maxSize = JSStringGetMaximumUTF8CStringSize(propertyName);
+	std::string buffer;
+	buffer.resize(maxSize);
+	JSStringGetUTF8CString(propertyName, &buffer[0], maxSize);
+	std::string prop(buffer.c_str());
+
+	// already converted, JSC will look at the stored property
+	if (fields->converted.find(prop) != fields->converted.end())
+		return NULL;
+
+	JSValueRef value = fields->dataModel->getEventFieldAsValue(fields->event, prop);
+	if (value == NULL)
+		return NULL;
+
+	// store the value so that changes by scripts persist
+	JSObjectSetProperty(ctx, object, propertyName, value, 0, exception);
+	fields->converted.insert(prop);
+	return value;
+}
+
+void JSCDataModel::jsEventListProps(JSContextRef ctx, JSObjectRef object, JSPropertyNameAccumulatorRef propertyNames) {
+	EventFields* fields = (EventFields*)JSObjectGetPrivate(object);
+
+	for (size_t i = 0; jsEventFields[i] != NULL; i++) {
+		if (fields->converted.find(jsEventFields[i]) != fields->converted.end())
+			continue;
+		JSStringRef fieldName = JSStringCreateWithUTF8CString(jsEventFields[i]);
+		JSPropertyNameAccumulatorAddName(propertyNames, fieldName);
+		JSStringRelease(fieldName);
+	}
+}
+
 }
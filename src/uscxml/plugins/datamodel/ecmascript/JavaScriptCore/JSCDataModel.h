@@ -109,6 +109,20 @@ protected:
 	static JSValueRef jsInvokerGetProp(JSContextRef ctx, JSObjectRef object, JSStringRef propertyName, JSValueRef* exception);
 	static void jsInvokerListProps(JSContextRef ctx, JSObjectRef object, JSPropertyNameAccumulatorRef propertyNames);
 
+	/// Prototype of _event with the fields not wrapped by SWIG, converted when first read
+	struct EventFields {
+		EventFields(JSCDataModel* dataModel, const Event& event) : dataModel(dataModel), event(event) {}
+		JSCDataModel* dataModel;
+		Event event; ///< also wrapped, but not owned by the SWIG object
+		std::set<std::string> converted;
+	};
+	static JSClassDefinition jsEventClassDef;
+	static void jsEventFinalize(JSObjectRef object);
+	static JSValueRef jsEventGetProp(JSContextRef ctx, JSObjectRef object, JSStringRef propertyName, JSValueRef* exception);
+	static void jsEventListProps(JSContextRef ctx, JSObjectRef object, JSPropertyNameAccumulatorRef propertyNames);
+	JSValueRef getEventFieldAsValue(const Event& event, const std::string& field);
+	JSClassRef _eventClassRef;
+
 	JSValueRef getNodeAsValue(const XERCESC_NS::DOMNode* node);
 	JSValueRef getDataAsValue(const Data& data);
 	Data getValueAsData(const JSValueRef value);
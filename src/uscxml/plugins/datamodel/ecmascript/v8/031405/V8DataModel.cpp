@@ -79,6 +79,10 @@ V8DataModel::V8DataModel() {
 }
 
 V8DataModel::~V8DataModel() {
+	// handles may outlive us, but not our scripts
+	for (auto& compiled : _compiled) {
+		static_cast<V8Expression*>(compiled.second.get())->script.Dispose();
+	}
 	_context.Dispose();
 //    if (_isolate != NULL) {
 //        _isolate->Dispose();
@@ -320,6 +324,8 @@ v8::Handle<v8::Value> V8DataModel::getInvokers(v8::Local<v8::String> property, c
 	return dataModel->_invokers;
 }
 
+static const char* v8EventFields[] = { "origintype", "origin", "sendid", "invokeid", "type", "data", NULL };
+
 void V8DataModel::setEvent(const Event& event) {
 
 	v8::Locker locker;
@@ -345,60 +351,80 @@ void V8DataModel::setEvent(const Event& event) {
 	v8::Handle<v8::Value> eventVal = SWIG_V8_NewPointerObj(evPtr, SWIGTYPE_p_uscxml__Event, SWIG_POINTER_OWN);
 	v8::Handle<v8::Object> eventObj = v8::Handle<v8::Object>::Cast(eventVal);
 
-	/*
-	    v8::Local<v8::Array> properties = eventObj->GetPropertyNames();
-	    for (int i = 0; i < properties->Length(); i++) {
-	        assert(properties->Get(i)->IsString());
-	        v8::String::AsciiValue key(v8::Local<v8::String>::Cast(properties->Get(i)));
-	        std::cout << *key << std::endl;
-	    }
-	*/
-
-	// test333
-	if (event.origintype.size() > 0) {
-		eventObj->Set(v8::String::NewSymbol("origintype"),v8::String::New(event.origintype.c_str()));
-	} else {
-		eventObj->Set(v8::String::NewSymbol("origintype"),v8::Undefined());
-	}
-	// test335
-	if (event.origin.size() > 0) {
-		eventObj->Set(v8::String::NewSymbol("origin"),v8::String::New(event.origin.c_str()));
-	} else {
-		eventObj->Set(v8::String::NewSymbol("origin"),v8::Undefined());
-	}
-	// test337
-	if (!event.hideSendId) {
-		eventObj->Set(v8::String::NewSymbol("sendid"),v8::String::New(event.sendid.c_str()));
-	} else {
-		eventObj->Set(v8::String::NewSymbol("sendid"),v8::Undefined());
-	}
-	// test339
-	if (event.invokeid.size() > 0) {
-		eventObj->Set(v8::String::NewSymbol("invokeid"),v8::String::New(event.invokeid.c_str()));
-	} else {
-		eventObj->Set(v8::String::NewSymbol("invokeid"),v8::Undefined());
+	// the fields ignored by swig are only converted when a script reads them
+	for (size_t i = 0; v8EventFields[i] != NULL; i++) {
+		eventObj->SetAccessor(v8::String::NewSymbol(v8EventFields[i]),
+		                      V8DataModel::getEventField,
+		                      V8DataModel::setEventField,
+		                      v8::External::New(reinterpret_cast<void*>(this)));
 	}
 
-	// test 331
-	switch (event.eventType) {
-	case Event::EXTERNAL:
-		eventObj->Set(v8::String::NewSymbol("type"), v8::String::New("external"));
-		break;
-	case Event::INTERNAL:
-		eventObj->Set(v8::String::NewSymbol("type"), v8::String::New("internal"));
-		break;
-	case Event::PLATFORM:
-		eventObj->Set(v8::String::NewSymbol("type"), v8::String::New("platform"));
-		break;
-	}
+	// we cannot make _event v8::ReadOnly as it will ignore subsequent setEvents
+	global->Set(v8::String::NewSymbol("_event"), eventObj);
+
+}
+
+v8::Handle<v8::Value> V8DataModel::getEventField(v8::Local<v8::String> property, const v8::AccessorInfo& info) {
+	v8::Local<v8::External> field = v8::Local<v8::External>::Cast(info.Data());
+	V8DataModel* dataModel = (V8DataModel*)field->Value();
 
-	if (event.data.node) {
+	Event* event = NULL;
+	if (!SWIG_IsOK(SWIG_V8_ConvertPtr(info.Holder(), (void**)&event, SWIGTYPE_p_uscxml__Event, 0)) || event == NULL)
+		return v8::Undefined();
+
+	v8::String::AsciiValue fieldName(property);
+	v8::Handle<v8::Value> value = dataModel->getEventFieldAsValue(*event, *fieldName);
+
+	// replace the accessor so that changes by scripts persist
+	info.Holder()->ForceSet(property, value);
+	return value;
+}
+
+void V8DataModel::setEventField(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info) {
+	info.Holder()->ForceSet(property, value);
+}
+
+v8::Handle<v8::Value> V8DataModel::getEventFieldAsValue(const Event& event, const std::string& field) {
+	std::string fieldVal;
+
+	if (field == "origintype") {
+		if (event.origintype.size() == 0) // test333
+			return v8::Undefined();
+		fieldVal = event.origintype;
+	} else if (field == "origin") {
+		if (event.origin.size() == 0) // test335
+			return v8::Undefined();
+		fieldVal = event.origin;
+	} else if (field == "sendid") {
+		if (event.hideSendId) // test337
+			return v8::Undefined();
+		fieldVal = event.sendid;
+	} else if (field == "invokeid") {
+		if (event.invokeid.size() == 0) // test339
+			return v8::Undefined();
+		fieldVal = event.invokeid;
+	} else if (field == "type") {
+		// test 331
+		switch (event.eventType) {
+		case Event::EXTERNAL:
+			fieldVal = "external";
+			break;
+		case Event::INTERNAL:
+			fieldVal = "internal";
+			break;
+		case Event::PLATFORM:
+			fieldVal = "platform";
+			break;
+		}
+	} else if (field == "data") {
+		if (event.data.node) {
 #ifndef NO_XERCESC
-		eventObj->Set(v8::String::NewSymbol("data"), getNodeAsValue(event.data.node));
+			return getNodeAsValue(event.data.node);
 #else
-		ERROR_EXECUTION_THROW("Compiled without DOM support");
+			// no nodes without DOM support
+			return v8::Undefined();
 #endif
-	} else {
+		}
 		// _event.data is KVP
 		Data data = event.data;
 		if (!event.params.empty()) {
@@ -415,19 +441,11 @@ void V8DataModel::setEvent(const Event& event) {
 				nameListIter++;
 			}
 		}
-		if (!data.empty()) {
-//			std::cout << Data::toJSON(data);
-			eventObj->Set(v8::String::NewSymbol("data"), getDataAsValue(data)); // set data part of _event
-		} else {
-			// test 343 / test 488
-			eventObj->Set(v8::String::NewSymbol("data"), v8::Undefined()); // set data part of _event
-		}
+		if (data.empty()) // test 343 / test 488
+			return v8::Undefined();
+		return getDataAsValue(data);
 	}
-	// we cannot make _event v8::ReadOnly as it will ignore subsequent setEvents
-	global->Set(v8::String::NewSymbol("_event"), eventObj);
-
-//    _event.Reset(_isolate, eventObj);
-//    _event = eventObj;
+	return v8::String::New(fieldVal.c_str());
 }
 
 Data V8DataModel::getAsData(const std::string& content) {
@@ -578,7 +596,7 @@ v8::Handle<v8::Value> V8DataModel::getDataAsValue(const Data& data) {
 	}
 	if (data.array.size() > 0) {
 		v8::Local<v8::Object> value = v8::Array::New(data.array.size());
-		std::list<Data>::const_iterator arrayIter = data.array.begin();
+		std::vector<Data>::const_iterator arrayIter = data.array.begin();
 		uint32_t index = 0;
 		while(arrayIter != data.array.end()) {
 			value->Set(index++, getDataAsValue(*arrayIter));
@@ -816,6 +834,63 @@ v8::Handle<v8::Value> V8DataModel::evalAsValue(const std::string& expr, bool don
 	return result;
 }
 
+std::shared_ptr<CompiledExpression> V8DataModel::compile(const std::string& expr) {
+	std::shared_ptr<CompiledExpression>& compiled = _compiled[expr];
+	if (!compiled)
+		compiled = std::shared_ptr<CompiledExpression>(new V8Expression(expr));
+	return compiled;
+}
+
+bool V8DataModel::evalCompiledAsBool(CompiledExpression& expr) {
+	v8::Locker locker;
+	v8::HandleScope handleScope;
+	v8::Context::Scope contextScope(_context);
+
+	v8::Handle<v8::Value> result = evalAsValue(expr);
+	return(result->ToBoolean()->BooleanValue());
+}
+
+Data V8DataModel::evalCompiledAsData(CompiledExpression& expr) {
+	v8::Locker locker;
+	v8::HandleScope handleScope;
+	v8::Context::Scope contextScope(_context);
+
+	v8::Handle<v8::Value> result = evalAsValue(expr);
+	Data data = getValueAsData(result);
+	return data;
+}
+
+v8::Handle<v8::Value> V8DataModel::evalAsValue(CompiledExpression& expr) {
+	V8Expression* v8Expr = dynamic_cast<V8Expression*>(&expr);
+	if (v8Expr == NULL)
+		return evalAsValue(expr.expr);
+
+	v8::TryCatch tryCatch;
+
+	// scripts are bound to the context they were compiled in, which is ours
+	v8::Local<v8::Script> script;
+	if (v8Expr->script.IsEmpty()) {
+		v8::Local<v8::String> source = v8::String::New(expr.expr.c_str());
+		script = v8::Script::Compile(source);
+		if (!script.IsEmpty())
+			v8Expr->script = v8::Persistent<v8::Script>::New(script);
+	} else {
+		script = v8::Local<v8::Script>::New(v8Expr->script);
+	}
+
+	v8::Handle<v8::Value> result;
+	if (!script.IsEmpty())
+		result = script->Run();
+
+	if (script.IsEmpty() || result.IsEmpty()) {
+		// throw an exception
+		if (tryCatch.HasCaught())
+			throwExceptionEvent(tryCatch);
+	}
+
+	return result;
+}
+
 void V8DataModel::throwExceptionEvent(const v8::TryCatch& tryCatch) {
 	assert(tryCatch.HasCaught());
 	ErrorEvent exceptionEvent;
@@ -74,6 +74,13 @@ public:
 	virtual Data evalAsData(const std::string& expr);
 	virtual Data getAsData(const std::string& content);
 
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr);
+	virtual bool evalCompiledAsBool(CompiledExpression& expr);
+	virtual Data evalCompiledAsData(CompiledExpression& expr);
+	virtual void evalCompiled(CompiledExpression& expr) {
+		evalCompiledAsData(expr);
+	}
+
 	virtual bool isDeclared(const std::string& expr);
 
 	virtual void assign(const std::string& location,
@@ -101,15 +108,27 @@ protected:
 	static v8::Handle<v8::Value> getInvokers(v8::Local<v8::String> property, const v8::AccessorInfo& info);
 	static v8::Handle<v8::Value> getAttribute(v8::Local<v8::String> property, const v8::AccessorInfo& info);
 	static void setWithException(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info);
+	static v8::Handle<v8::Value> getEventField(v8::Local<v8::String> property, const v8::AccessorInfo& info);
+	static void setEventField(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info);
 
 	v8::Handle<v8::Value> evalAsValue(const std::string& expr, bool dontThrow = false);
+	v8::Handle<v8::Value> evalAsValue(CompiledExpression& expr);
 	v8::Handle<v8::Value> getDataAsValue(const Data& data);
+	v8::Handle<v8::Value> getEventFieldAsValue(const Event& event, const std::string& field);
 	Data getValueAsData(const v8::Handle<v8::Value>& value);
 	v8::Handle<v8::Value> getNodeAsValue(const XERCESC_NS::DOMNode* node);
 	void throwExceptionEvent(const v8::TryCatch& tryCatch);
 
 	std::set<DataModelExtension*> _extensions;
 
+	/// An expression with its script compiled in our context when first evaluated
+	class V8Expression : public CompiledExpression {
+	public:
+		V8Expression(const std::string& expr) : CompiledExpression(expr) {}
+		v8::Persistent<v8::Script> script;
+	};
+	std::map<std::string, std::shared_ptr<CompiledExpression> > _compiled;
+
 private:
 	Data getValueAsData(const v8::Handle<v8::Value>& value, std::set<v8::Value*>& alreadySeen);
 
@@ -43,6 +43,7 @@
 
 #include "uscxml/interpreter/Logging.h"
 #include <boost/algorithm/string.hpp>
+#include <new>
 
 //#include "LuaDOM.cpp.inc" // TODO: activate XercesC bindings for test 530
 
@@ -86,6 +87,32 @@ static int luaEval(lua_State* luaState, const std::string& expr) {
 	return postStack - preStack;
 }
 
+// run the chunk for expr kept in the registry, only the first run builds the source and compiles it
+static int luaEvalRef(lua_State* luaState, int& ref, const std::string& expr, bool asValue) {
+	int preStack = lua_gettop(luaState);
+	if (ref == LUA_NOREF) {
+		// we need the result of the expression on the lua stack -> has to "return"!
+		std::string source = (asValue ? "return(" + boost::trim_copy(expr) + ")" : boost::trim_copy(expr));
+		if (luaL_loadstring(luaState, source.c_str())) {
+			std::string errMsg = lua_tostring(luaState, -1);
+			lua_pop(luaState, 1);  /* pop error message from the stack */
+			ERROR_EXECUTION_THROW(errMsg);
+		}
+		ref = luaL_ref(luaState, LUA_REGISTRYINDEX);
+	}
+
+	lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
+	if (lua_pcall(luaState, 0, LUA_MULTRET, 0)) {
+		std::string errMsg = lua_tostring(luaState, -1);
+		lua_pop(luaState, 1);  /* pop error message from the stack */
+		ERROR_EXECUTION_THROW(errMsg);
+	}
+	int postStack = lua_gettop(luaState);
+	return postStack - preStack;
+}
+
+static void luaMaterializeEvent(lua_State* luaState, int index);
+
 static Data getLuaAsData(lua_State* _luaState, const luabridge::LuaRef& lua) {
 	Data data;
 	if (lua.isFunction()) {
@@ -122,6 +149,11 @@ static Data getLuaAsData(lua_State* _luaState, const luabridge::LuaRef& lua) {
 		data.atom = lua.cast<std::string>();
 		data.type = Data::VERBATIM;
 	} else if(lua.isTable()) {
+		// an _event proxy has to present all its fields
+		lua.push(_luaState);
+		luaMaterializeEvent(_luaState, -1);
+		lua_pop(_luaState, 1);
+
 		// check whether it is to be interpreted as a map or an array
 		bool isArray = true;
 		std::map<std::string, luabridge::LuaRef> luaItems;
@@ -186,7 +218,7 @@ static luabridge::LuaRef getDataAsLua(lua_State* _luaState, const Data& data) {
 	}
 	if (data.array.size() > 0) {
 		luaData = luabridge::newTable(_luaState);
-		std::list<Data>::const_iterator arrayIter = data.array.begin();
+		std::vector<Data>::const_iterator arrayIter = data.array.begin();
 //		uint32_t index = 0;
 		while(arrayIter != data.array.end()) {
 //            luaData[index++] = getDataAsLua(_luaState, *arrayIter);
@@ -224,6 +256,137 @@ static luabridge::LuaRef getDataAsLua(lua_State* _luaState, const Data& data) {
 	return luabridge::LuaRef(_luaState);
 }
 
+/**
+ * _event is a table whose metatable holds a copy of the C++ event as
+ * userdata. Fields are only converted when a script first reads them and
+ * are then cached in the table itself.
+ */
+static const char* luaEventFields[] = { "name", "raw", "origin", "origintype", "invokeid", "sendid", "type", "data", NULL };
+
+static Event* luaGetEvent(lua_State* luaState, int index) {
+	if (!lua_getmetatable(luaState, index))
+		return NULL;
+	lua_getfield(luaState, -1, "__uscxmlEvent");
+	Event* event = (Event*)lua_touserdata(luaState, -1);
+	lua_pop(luaState, 2);
+	return event;
+}
+
+/// Push the given field of the event, returns whether there was a value
+static bool luaPushEventField(lua_State* luaState, const Event& event, const std::string& field) {
+	if (field == "name") {
+		lua_pushlstring(luaState, event.name.c_str(), event.name.size());
+	} else if (field == "raw" && event.raw.size() > 0) {
+		lua_pushlstring(luaState, event.raw.c_str(), event.raw.size());
+	} else if (field == "origin" && event.origin.size() > 0) {
+		lua_pushlstring(luaState, event.origin.c_str(), event.origin.size());
+	} else if (field == "origintype" && event.origintype.size() > 0) {
+		lua_pushlstring(luaState, event.origintype.c_str(), event.origintype.size());
+	} else if (field == "invokeid" && event.invokeid.size() > 0) {
+		lua_pushlstring(luaState, event.invokeid.c_str(), event.invokeid.size());
+	} else if (field == "sendid" && !event.hideSendId) {
+		lua_pushlstring(luaState, event.sendid.c_str(), event.sendid.size());
+	} else if (field == "type") {
+		switch (event.eventType) {
+		case Event::INTERNAL:
+			lua_pushstring(luaState, "internal");
+			break;
+		case Event::EXTERNAL:
+			lua_pushstring(luaState, "external");
+			break;
+		case Event::PLATFORM:
+			lua_pushstring(luaState, "platform");
+			break;
+		default:
+			return false;
+		}
+	} else if (field == "data") {
+		if (event.data.node) {
+#ifndef NO_XERCESC
+			SWIG_Lua_NewPointerObj(luaState, event.data.node, SWIGTYPE_p_XERCES_CPP_NAMESPACE__DOMNode, SWIG_POINTER_DISOWN);
+#else
+			// we may be called from within lua, do not throw
+			return false;
+#endif
+		} else {
+			// _event.data is KVP
+			Data d = event.data;
+
+			if (!event.params.empty()) {
+				Event::params_t::const_iterator paramIter = event.params.begin();
+				while(paramIter != event.params.end()) {
+					d.compound[paramIter->first] = paramIter->second;
+					paramIter++;
+				}
+			}
+			if (!event.namelist.empty()) {
+				Event::namelist_t::const_iterator nameListIter = event.namelist.begin();
+				while(nameListIter != event.namelist.end()) {
+					d.compound[nameListIter->first] = nameListIter->second;
+					nameListIter++;
+				}
+			}
+
+			if (d.empty())
+				return false;
+			// not necessarily a table test179
+			getDataAsLua(luaState, d).push(luaState);
+		}
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/// Convert all remaining fields of the _event proxy at the given index
+static void luaMaterializeEvent(lua_State* luaState, int index) {
+	index = (index < 0 ? lua_gettop(luaState) + index + 1 : index);
+	Event* event = luaGetEvent(luaState, index);
+	if (event == NULL)
+		return;
+
+	for (size_t i = 0; luaEventFields[i] != NULL; i++) {
+		lua_pushstring(luaState, luaEventFields[i]);
+		lua_rawget(luaState, index);
+		bool isSet = !lua_isnil(luaState, -1);
+		lua_pop(luaState, 1);
+		if (isSet || !luaPushEventField(luaState, *event, luaEventFields[i]))
+			continue;
+		lua_pushstring(luaState, luaEventFields[i]);
+		lua_insert(luaState, -2);
+		lua_rawset(luaState, index);
+	}
+}
+
+static int luaEventIndex(lua_State* luaState) {
+	if (lua_type(luaState, 2) != LUA_TSTRING)
+		return 0;
+	Event* event = luaGetEvent(luaState, 1);
+	if (event == NULL || !luaPushEventField(luaState, *event, lua_tostring(luaState, 2)))
+		return 0;
+
+	// cache in the table so that changes by scripts persist
+	lua_pushvalue(luaState, 2);
+	lua_pushvalue(luaState, -2);
+	lua_rawset(luaState, 1);
+	return 1;
+}
+
+#if LUA_VERSION_NUM >= 502
+static int luaEventPairs(lua_State* luaState) {
+	luaMaterializeEvent(luaState, 1);
+	lua_getglobal(luaState, "next");
+	lua_pushvalue(luaState, 1);
+	lua_pushnil(luaState);
+	return 3;
+}
+#endif
+
+static int luaEventGC(lua_State* luaState) {
+	((Event*)lua_touserdata(luaState, 1))->~Event();
+	return 0;
+}
+
 LuaDataModel::LuaDataModel() {
 	_luaState = NULL;
 }
@@ -283,6 +446,11 @@ void LuaDataModel::setup() {
 
 	luabridge::getGlobalNamespace(_luaState).addCFunction("In", luaInFunction);
 
+	luaL_newmetatable(_luaState, "uscxml.Event");
+	lua_pushcfunction(_luaState, luaEventGC);
+	lua_setfield(_luaState, -2, "__gc");
+	lua_pop(_luaState, 1);
+
 	luabridge::LuaRef ioProcTable = luabridge::newTable(_luaState);
 	std::map<std::string, IOProcessor> ioProcs = _callbacks->getIOProcessors();
 	std::map<std::string, IOProcessor>::const_iterator ioProcIter = ioProcs.begin();
@@ -318,73 +486,23 @@ void LuaDataModel::addExtension(DataModelExtension* ext) {
 }
 
 void LuaDataModel::setEvent(const Event& event) {
-	luabridge::LuaRef luaEvent(_luaState);
-	luaEvent = luabridge::newTable(_luaState);
-
-	luaEvent["name"] = event.name;
-	if (event.raw.size() > 0)
-		luaEvent["raw"] = event.raw;
-	if (event.origin.size() > 0)
-		luaEvent["origin"] = event.origin;
-	if (event.origintype.size() > 0)
-		luaEvent["origintype"] = event.origintype;
-	if (event.invokeid.size() > 0)
-		luaEvent["invokeid"] = event.invokeid;
-	if (!event.hideSendId)
-		luaEvent["sendid"] = event.sendid;
-//	luaEvent["inspect"] = luaInspect;
-
-	switch (event.eventType) {
-	case Event::INTERNAL:
-		luaEvent["type"] = "internal";
-		break;
-	case Event::EXTERNAL:
-		luaEvent["type"] = "external";
-		break;
-	case Event::PLATFORM:
-		luaEvent["type"] = "platform";
-		break;
-
-	default:
-		break;
-	}
-
-	if (event.data.node) {
-#ifndef NO_XERCESC
-		SWIG_Lua_NewPointerObj(_luaState, event.data.node, SWIGTYPE_p_XERCES_CPP_NAMESPACE__DOMNode, SWIG_POINTER_DISOWN);
-		luaEvent["data"] = luabridge::LuaRef::fromStack(_luaState, 1);
-#else
-		ERROR_EXECUTION_THROW("No DOM support in Lua datamodel");
+	lua_newtable(_luaState); // _event
+	lua_newtable(_luaState); // its metatable
+
+	new (lua_newuserdata(_luaState, sizeof(Event))) Event(event);
+	luaL_getmetatable(_luaState, "uscxml.Event");
+	lua_setmetatable(_luaState, -2);
+	lua_setfield(_luaState, -2, "__uscxmlEvent");
+
+	lua_pushcfunction(_luaState, luaEventIndex);
+	lua_setfield(_luaState, -2, "__index");
+#if LUA_VERSION_NUM >= 502
+	lua_pushcfunction(_luaState, luaEventPairs);
+	lua_setfield(_luaState, -2, "__pairs");
 #endif
-	} else {
-		// _event.data is KVP
-		Data d = event.data;
-
-		if (!event.params.empty()) {
-			Event::params_t::const_iterator paramIter = event.params.begin();
-			while(paramIter != event.params.end()) {
-				d.compound[paramIter->first] = paramIter->second;
-				paramIter++;
-			}
-		}
-		if (!event.namelist.empty()) {
-			Event::namelist_t::const_iterator nameListIter = event.namelist.begin();
-			while(nameListIter != event.namelist.end()) {
-				d.compound[nameListIter->first] = nameListIter->second;
-				nameListIter++;
-			}
-		}
-
-		if (!d.empty()) {
-			luabridge::LuaRef luaData = getDataAsLua(_luaState, d);
-			assert(luaEvent.isTable());
-			// assert(luaData.isTable()); // not necessarily test179
-			luaEvent["data"] = luaData;
-		}
-	}
-
-	luabridge::setGlobal(_luaState, luaEvent, "_event");
+	lua_setmetatable(_luaState, -2);
 
+	lua_setglobal(_luaState, "_event");
 }
 
 Data LuaDataModel::evalAsData(const std::string& content) {
@@ -550,6 +668,54 @@ bool LuaDataModel::evalAsBool(const std::string& expr) {
 	return false;
 }
 
+std::shared_ptr<CompiledExpression> LuaDataModel::compile(const std::string& expr) {
+	// the chunks stay in the registry until we close the state
+	std::shared_ptr<CompiledExpression>& compiled = _compiled[expr];
+	if (!compiled)
+		compiled = std::shared_ptr<CompiledExpression>(new LuaExpression(expr));
+	return compiled;
+}
+
+bool LuaDataModel::evalCompiledAsBool(CompiledExpression& expr) {
+	LuaExpression* luaExpr = dynamic_cast<LuaExpression*>(&expr);
+	if (luaExpr == NULL)
+		return evalAsBool(expr.expr);
+
+	int retVals = luaEvalRef(_luaState, luaExpr->valueRef, expr.expr, true);
+
+	if (retVals == 1) {
+		bool result = lua_toboolean(_luaState, -1);
+		lua_pop(_luaState, 1);
+		return result;
+	}
+	lua_pop(_luaState, retVals);
+
+	return false;
+}
+
+Data LuaDataModel::evalCompiledAsData(CompiledExpression& expr) {
+	LuaExpression* luaExpr = dynamic_cast<LuaExpression*>(&expr);
+	if (luaExpr == NULL)
+		return evalAsData(expr.expr);
+
+	Data data;
+	int retVals = luaEvalRef(_luaState, luaExpr->valueRef, expr.expr, true);
+	if (retVals == 1) {
+		data = getLuaAsData(_luaState, luabridge::LuaRef::fromStack(_luaState, -1));
+	}
+	lua_pop(_luaState, retVals);
+	return data;
+}
+
+void LuaDataModel::evalCompiled(CompiledExpression& expr) {
+	LuaExpression* luaExpr = dynamic_cast<LuaExpression*>(&expr);
+	if (luaExpr == NULL)
+		return eval(expr.expr);
+
+	int retVals = luaEvalRef(_luaState, luaExpr->stmntRef, expr.expr, false);
+	lua_pop(_luaState, retVals);
+}
+
 Data LuaDataModel::getAsData(const std::string& content) {
 	Data data;
 	std::string trimmedExpr = boost::trim_copy(content);
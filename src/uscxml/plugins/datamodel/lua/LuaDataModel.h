@@ -78,6 +78,11 @@ public:
 	virtual void eval(const std::string& content);
 	virtual Data getAsData(const std::string& content);
 
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr);
+	virtual bool evalCompiledAsBool(CompiledExpression& expr);
+	virtual Data evalCompiledAsData(CompiledExpression& expr);
+	virtual void evalCompiled(CompiledExpression& expr);
+
 	virtual bool isDeclared(const std::string& expr);
 
 	virtual void assign(const std::string& location,
@@ -92,7 +97,16 @@ protected:
 
 	static int luaInFunction(lua_State * l);
 
+	/// An expression with its chunks loaded into the registry when first evaluated
+	class LuaExpression : public CompiledExpression {
+	public:
+		LuaExpression(const std::string& expr) : CompiledExpression(expr), valueRef(LUA_NOREF), stmntRef(LUA_NOREF) {}
+		int valueRef; ///< as "return(expr)"
+		int stmntRef; ///< as the plain statement
+	};
+
 	lua_State* _luaState;
+	std::map<std::string, std::shared_ptr<CompiledExpression> > _compiled;
 };
 
 #ifdef BUILD_AS_PLUGINS
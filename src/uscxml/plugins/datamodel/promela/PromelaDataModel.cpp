@@ -183,7 +183,7 @@ void PromelaDataModel::setEvent(const Event& event) {
 		}
 
 		if (data.array.size() > 0) {
-			for (std::list<Data>::iterator iter = data.array.begin(); iter != data.array.end(); iter++) {
+			for (std::vector<Data>::iterator iter = data.array.begin(); iter != data.array.end(); iter++) {
 				adaptType(*iter);
 			}
 			return;
@@ -277,6 +277,37 @@ void PromelaDataModel::setEvent(const Event& event) {
 		return evaluateExpr(parser.ast);
 	}
 
+	std::shared_ptr<CompiledExpression> PromelaDataModel::compile(const std::string& expr) {
+		return std::shared_ptr<CompiledExpression>(new PromelaExpression(expr));
+	}
+
+	bool PromelaDataModel::evalCompiledAsBool(CompiledExpression& expr) {
+		PromelaExpression* pmlExpr = dynamic_cast<PromelaExpression*>(&expr);
+		if (pmlExpr == NULL)
+			return evalAsBool(expr.expr);
+
+		// syntax errors will throw every time as we do not keep a failed parser
+		if (!pmlExpr->exprParser)
+			pmlExpr->exprParser = std::shared_ptr<PromelaParser>(new PromelaParser(expr.expr, 1, PromelaParser::PROMELA_EXPR));
+		Data tmp = evaluateExpr(pmlExpr->exprParser->ast);
+
+		if (tmp.atom.compare("false") == 0)
+			return false;
+		if (tmp.atom.compare("0") == 0)
+			return false;
+		return true;
+	}
+
+	Data PromelaDataModel::evalCompiledAsData(CompiledExpression& expr) {
+		PromelaExpression* pmlExpr = dynamic_cast<PromelaExpression*>(&expr);
+		if (pmlExpr == NULL)
+			return evalAsData(expr.expr);
+
+		if (!pmlExpr->parser)
+			pmlExpr->parser = std::shared_ptr<PromelaParser>(new PromelaParser(expr.expr));
+		return evaluateExpr(pmlExpr->parser->ast);
+	}
+
 	Data PromelaDataModel::getAsData(const std::string& content) {
 		try {
 			evaluateExpr("__tmp = " + content);
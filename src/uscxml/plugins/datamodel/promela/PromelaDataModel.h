@@ -30,6 +30,8 @@
 
 namespace uscxml {
 
+class PromelaParser;
+
 class PromelaDataModel : public DataModelImpl {
 public:
 	PromelaDataModel();
@@ -60,6 +62,13 @@ public:
 	virtual Data evalAsData(const std::string& expr);
 	virtual Data getAsData(const std::string& content);
 
+	virtual std::shared_ptr<CompiledExpression> compile(const std::string& expr);
+	virtual bool evalCompiledAsBool(CompiledExpression& expr);
+	virtual Data evalCompiledAsData(CompiledExpression& expr);
+	virtual void evalCompiled(CompiledExpression& expr) {
+		evalCompiledAsData(expr);
+	}
+
 	virtual bool isDeclared(const std::string& expr);
 
 	virtual void assign(const std::string& location,
@@ -88,6 +97,14 @@ protected:
 
 	void adaptType(Data& data);
 
+	/// An expression with its syntax trees parsed when first evaluated
+	class PromelaExpression : public CompiledExpression {
+	public:
+		PromelaExpression(const std::string& expr) : CompiledExpression(expr) {}
+		std::shared_ptr<PromelaParser> exprParser; ///< parsed as PROMELA_EXPR
+		std::shared_ptr<PromelaParser> parser; ///< parsed as whatever it is
+	};
+
 	int _lastMType;
 
 	Event _event;
@@ -202,10 +202,10 @@ void USCXMLInvoker::invoke(const std::string& source, const Event& invokeEvent)
 		// TODO: setup invokers dom, check datamodel attribute and create new instance from parent if matching?
 
 		// copy monitors
-		std::set<InterpreterMonitor*> monitors = _callbacks->getMonitors();
-		for (auto monitor : monitors) {
-			if (monitor->copyToInvokers()) {
-				_invokedInterpreter.getImpl()->_monitors.insert(monitor);
+		const MonitorSnapshot& monitors = _callbacks->getMonitors();
+		for (auto& monitor : monitors.monitors) {
+			if (monitor.first->copyToInvokers()) {
+				_invokedInterpreter.getImpl()->addMonitor(monitor.first);
 			}
 		}
 
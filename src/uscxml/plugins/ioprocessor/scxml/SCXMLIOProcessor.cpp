@@ -21,6 +21,7 @@
 #include "SCXMLIOProcessor.h"
 #include "uscxml/messages/Event.h"
 #include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/util/EventDescriptor.h"
 
 #include <string.h>
 
@@ -79,6 +80,10 @@ void SCXMLIOProcessor::eventFromSCXML(const std::string& target, const Event& ev
 	// see http://www.w3.org/TR/scxml/#SendTargets
 	Event eventCopy(event);
 
+	// names from an eventexpr are resolved here, receivers match by the interned id
+	if (eventCopy.nameId == 0)
+		eventCopy.nameId = EventName::lookup(eventCopy.name);
+
 	// test 253 / 198 / 336
 	eventCopy.origintype = "http://www.w3.org/TR/scxml/#SCXMLEventProcessor";
 
@@ -191,6 +191,9 @@ void ChartToC::resortStates(DOMNode* node) {
 void ChartToC::setStateCompletion() {
 	setHistoryCompletion();
 
+	// resolve initial attributes without searching the DOM per state
+	ChartIndex chartIndex(_scxml);
+
 	for (size_t i = 0; i < _states.size(); i++) {
 		DOMElement* state(_states[i]);
 
@@ -205,7 +208,7 @@ void ChartToC::setStateCompletion() {
 			completion = getChildStates(state);
 
 		} else if (HAS_ATTR(state, kXMLCharInitial)) {
-			completion = getStates(tokenize(ATTR(state, kXMLCharInitial)), _scxml);
+			completion = getStates(tokenize(ATTR(state, kXMLCharInitial)), chartIndex);
 
 		} else {
 			std::list<DOMElement*> initElems = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "initial", state);
@@ -323,13 +326,16 @@ void ChartToC::prepare() {
 
 	_transitions.insert(_transitions.end(), tmp.begin(), tmp.end());
 
+	// exit sets and conflicts are asked for every pair of transitions
+	ChartIndex chartIndex(_scxml);
+
 	for (size_t i = 0; i < _transitions.size(); i++) {
 		DOMElement* transition(_transitions[i]);
 		transition->setAttribute(X("postFixOrder"), X(toStr(i)));
 
 		// and exit set
 		std::string exitSetBools;
-		std::list<DOMElement*> exitSet = getExitSet(transition, _scxml);
+		std::list<DOMElement*> exitSet = getExitSet(transition, chartIndex);
 		for (unsigned int j = 0; j < _states.size(); j++) {
 			DOMElement* state(_states[j]);
 			if (DOMUtils::isMember(state, exitSet)) {
@@ -344,10 +350,7 @@ void ChartToC::prepare() {
 		std::string conflictBools;
 		for (unsigned int j = 0; j < _transitions.size(); j++) {
 			DOMElement* t2(_transitions[j]);
-			if (DOMUtils::hasIntersection(getExitSet(transition, _scxml), getExitSet(t2, _scxml)) ||
-			        (getSourceState(transition) == getSourceState(t2)) ||
-			        (DOMUtils::isDescendant(getSourceState(transition), getSourceState(t2))) ||
-			        (DOMUtils::isDescendant(getSourceState(t2), getSourceState(transition)))) {
+			if (conflicts(transition, t2, chartIndex)) {
 				conflictBools += "1";
 			} else {
 				conflictBools += "0";
@@ -587,6 +590,34 @@ void ChartToC::writeMacros(std::ostream& stream) {
 	stream << "#endif " << std::endl;
 	stream << std::endl;
 
+	stream << "/**" << std::endl;
+	stream << " *    USCXML_BITSET_AVX2 / USCXML_BITSET_SSE2 / USCXML_BITSET_BYTEWISE" << std::endl;
+	stream << " *      Bitsets are combined 64 bits at a time with GCC, Clang and MSVC, define one" << std::endl;
+	stream << " *      of these to use 256 or 128 bit vectors or to fall back to single bytes." << std::endl;
+	stream << " *      The bitsets in the types below are padded to whole words." << std::endl;
+	stream << " */" << std::endl;
+	stream << std::endl;
+
+	stream << "#ifndef USCXML_BITSET_WORD_BYTES" << std::endl;
+	stream << "#  if defined(USCXML_BITSET_AVX2)" << std::endl;
+	stream << "#    include <immintrin.h>" << std::endl;
+	stream << "#    define USCXML_BITSET_WORD_BYTES 32" << std::endl;
+	stream << "#  elif defined(USCXML_BITSET_SSE2)" << std::endl;
+	stream << "#    include <emmintrin.h>" << std::endl;
+	stream << "#    define USCXML_BITSET_WORD_BYTES 16" << std::endl;
+	stream << "#  elif defined(USCXML_BITSET_BYTEWISE) || defined(USCXML_NO_STDTYPES_H) || !(defined(__GNUC__) || defined(_MSC_VER))" << std::endl;
+	stream << "#    define USCXML_BITSET_WORD_BYTES 1" << std::endl;
+	stream << "#  else" << std::endl;
+	stream << "#    define USCXML_BITSET_WORD_BYTES 8" << std::endl;
+	stream << "#  endif" << std::endl;
+	stream << "#endif" << std::endl;
+	stream << std::endl;
+
+	stream << "#define USCXML_BITSET_BYTES(bytes) ((((bytes) + USCXML_BITSET_WORD_BYTES - 1) / USCXML_BITSET_WORD_BYTES) * USCXML_BITSET_WORD_BYTES)" << std::endl;
+	stream << "#define USCXML_STATES_BITSET_BYTES USCXML_BITSET_BYTES(USCXML_MAX_NR_STATES_BYTES)" << std::endl;
+	stream << "#define USCXML_TRANS_BITSET_BYTES  USCXML_BITSET_BYTES(USCXML_MAX_NR_TRANS_BYTES)" << std::endl;
+	stream << std::endl;
+
 	stream << "/**" << std::endl;
 	stream << " *    USCXML_NUMBER_STATES / USCXML_NUMBER_TRANS" << std::endl;
 	stream << " *      Per default the number of states / transitions is retrieved from the machine" << std::endl;
@@ -785,9 +816,9 @@ void ChartToC::writeTypes(std::ostream& stream) {
 	stream << "    const exec_content_t on_entry;                     /* on entry handlers      */" << std::endl;
 	stream << "    const exec_content_t on_exit;                      /* on exit handlers       */" << std::endl;
 	stream << "    const invoke_t invoke;                             /* invocations            */" << std::endl;
-	stream << "    const unsigned char children[USCXML_MAX_NR_STATES_BYTES];   /* all children           */" << std::endl;
-	stream << "    const unsigned char completion[USCXML_MAX_NR_STATES_BYTES]; /* default completion     */" << std::endl;
-	stream << "    const unsigned char ancestors[USCXML_MAX_NR_STATES_BYTES];  /* all ancestors          */" << std::endl;
+	stream << "    const unsigned char children[USCXML_STATES_BITSET_BYTES];   /* all children           */" << std::endl;
+	stream << "    const unsigned char completion[USCXML_STATES_BITSET_BYTES]; /* default completion     */" << std::endl;
+	stream << "    const unsigned char ancestors[USCXML_STATES_BITSET_BYTES];  /* all ancestors          */" << std::endl;
 	stream << "    const uscxml_elem_data* data;                      /* data with late binding */" << std::endl;
 	stream << "    const unsigned char type;                          /* One of USCXML_STATE_*  */" << std::endl;
 	stream << "};" << std::endl;
@@ -798,14 +829,14 @@ void ChartToC::writeTypes(std::ostream& stream) {
 	stream << " */" << std::endl;
 	stream << "struct uscxml_transition {" << std::endl;
 	stream << "    const USCXML_NR_STATES_TYPE source;" << std::endl;
-	stream << "    const unsigned char target[USCXML_MAX_NR_STATES_BYTES];" << std::endl;
+	stream << "    const unsigned char target[USCXML_STATES_BITSET_BYTES];" << std::endl;
 	stream << "    const char* event;" << std::endl;
 	stream << "    const char* condition;" << std::endl;
 	stream << "    const is_enabled_t is_enabled;" << std::endl;
 	stream << "    const exec_content_t on_transition;" << std::endl;
 	stream << "    const unsigned char type;" << std::endl;
-	stream << "    const unsigned char conflicts[USCXML_MAX_NR_TRANS_BYTES];" << std::endl;
-	stream << "    const unsigned char exit_set[USCXML_MAX_NR_STATES_BYTES];" << std::endl;
+	stream << "    const unsigned char conflicts[USCXML_TRANS_BITSET_BYTES];" << std::endl;
+	stream << "    const unsigned char exit_set[USCXML_STATES_BITSET_BYTES];" << std::endl;
 	stream << "};" << std::endl;
 	stream << std::endl;
 
@@ -891,10 +922,10 @@ void ChartToC::writeTypes(std::ostream& stream) {
 	stream << "    unsigned char         flags;" << std::endl;
 	stream << "    const uscxml_machine* machine;" << std::endl;
 	stream << std::endl;
-	stream << "    unsigned char config[USCXML_MAX_NR_STATES_BYTES]; /* Make sure these macros specify a sufficient size */" << std::endl;
-	stream << "    unsigned char history[USCXML_MAX_NR_STATES_BYTES];" << std::endl;
-	stream << "    unsigned char invocations[USCXML_MAX_NR_STATES_BYTES];" << std::endl;
-	stream << "    unsigned char initialized_data[USCXML_MAX_NR_STATES_BYTES];" << std::endl;
+	stream << "    unsigned char config[USCXML_STATES_BITSET_BYTES]; /* Make sure these macros specify a sufficient size */" << std::endl;
+	stream << "    unsigned char history[USCXML_STATES_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char invocations[USCXML_STATES_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char initialized_data[USCXML_STATES_BITSET_BYTES];" << std::endl;
 	stream << std::endl;
 	stream << "    void* user_data;" << std::endl;
 	stream << "    void* event;" << std::endl;
@@ -961,12 +992,48 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << std::endl;
 
 	stream << "#ifndef USCXML_NO_BIT_OPERATIONS" << std::endl;
+	stream << "/* One word of a bitset, bitsets are padded to a multiple of USCXML_BITSET_WORD_BYTES */" << std::endl;
+	stream << "#if USCXML_BITSET_WORD_BYTES == 32" << std::endl;
+	stream << "#  define BITWORD_LOAD(p)        _mm256_loadu_si256((const __m256i*)(p))" << std::endl;
+	stream << "#  define BITWORD_STORE(p, w)    _mm256_storeu_si256((__m256i*)(p), w)" << std::endl;
+	stream << "#  define BITWORD_OR(a, b)       _mm256_or_si256(a, b)" << std::endl;
+	stream << "#  define BITWORD_AND(a, b)      _mm256_and_si256(a, b)" << std::endl;
+	stream << "#  define BITWORD_AND_NOT(a, b)  _mm256_andnot_si256(b, a)" << std::endl;
+	stream << "#  define BITWORD_ZERO           _mm256_setzero_si256()" << std::endl;
+	stream << "#  define BITWORD_IS_ZERO(w)     _mm256_testz_si256(w, w)" << std::endl;
+	stream << "#elif USCXML_BITSET_WORD_BYTES == 16" << std::endl;
+	stream << "#  define BITWORD_LOAD(p)        _mm_loadu_si128((const __m128i*)(p))" << std::endl;
+	stream << "#  define BITWORD_STORE(p, w)    _mm_storeu_si128((__m128i*)(p), w)" << std::endl;
+	stream << "#  define BITWORD_OR(a, b)       _mm_or_si128(a, b)" << std::endl;
+	stream << "#  define BITWORD_AND(a, b)      _mm_and_si128(a, b)" << std::endl;
+	stream << "#  define BITWORD_AND_NOT(a, b)  _mm_andnot_si128(b, a)" << std::endl;
+	stream << "#  define BITWORD_ZERO           _mm_setzero_si128()" << std::endl;
+	stream << "#  define BITWORD_IS_ZERO(w)     (_mm_movemask_epi8(_mm_cmpeq_epi8(w, _mm_setzero_si128())) == 0xFFFF)" << std::endl;
+	stream << "#else" << std::endl;
+	stream << "#  if USCXML_BITSET_WORD_BYTES == 8 && defined(__GNUC__)" << std::endl;
+	stream << "typedef uint64_t __attribute__((__may_alias__, __aligned__(1))) uscxml_bitword;" << std::endl;
+	stream << "#  elif USCXML_BITSET_WORD_BYTES == 8" << std::endl;
+	stream << "typedef uint64_t uscxml_bitword;" << std::endl;
+	stream << "#  else" << std::endl;
+	stream << "typedef unsigned char uscxml_bitword;" << std::endl;
+	stream << "#  endif" << std::endl;
+	stream << "#  define BITWORD_LOAD(p)        (*(const uscxml_bitword*)(p))" << std::endl;
+	stream << "#  define BITWORD_STORE(p, w)    (*(uscxml_bitword*)(p) = (uscxml_bitword)(w))" << std::endl;
+	stream << "#  define BITWORD_OR(a, b)       ((a) | (b))" << std::endl;
+	stream << "#  define BITWORD_AND(a, b)      ((a) & (b))" << std::endl;
+	stream << "#  define BITWORD_AND_NOT(a, b)  ((a) & ~(b))" << std::endl;
+	stream << "#  define BITWORD_ZERO           0" << std::endl;
+	stream << "#  define BITWORD_IS_ZERO(w)     ((w) == 0)" << std::endl;
+	stream << "#endif" << std::endl;
+	stream << std::endl;
+
 	stream << "/**" << std::endl;
 	stream << " * Return true if there is a common bit in a and b." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static int bit_has_and(const unsigned char* a, const unsigned char* b, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        if (a[i] & b[i])" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        if (!BITWORD_IS_ZERO(BITWORD_AND(BITWORD_LOAD(a + w), BITWORD_LOAD(b + w))))" << std::endl;
 	stream << "            return 1;" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "    return 0;" << std::endl;
@@ -978,8 +1045,9 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * but does not require string.h or cstring." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static void bit_clear_all(unsigned char* a, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        a[i] = 0;" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        BITWORD_STORE(a + w, BITWORD_ZERO);" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "}" << std::endl;
 	stream << std::endl;
@@ -988,8 +1056,9 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * Return true if there is any bit set in a." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static int bit_has_any(unsigned const char* a, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        if (a[i] > 0)" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        if (!BITWORD_IS_ZERO(BITWORD_LOAD(a + w)))" << std::endl;
 	stream << "            return 1;" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "    return 0;" << std::endl;
@@ -1000,8 +1069,9 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * Set all bits from given mask in dest, this is |= for bit arrays." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static void bit_or(unsigned char* dest, const unsigned char* mask, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        dest[i] |= mask[i];" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        BITWORD_STORE(dest + w, BITWORD_OR(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "}" << std::endl;
 	stream << std::endl;
@@ -1011,8 +1081,9 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * but does not require string.h or cstring." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static void bit_copy(unsigned char* dest, const unsigned char* source, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        dest[i] = source[i];" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        BITWORD_STORE(dest + w, BITWORD_LOAD(source + w));" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "}" << std::endl;
 	stream << std::endl;
@@ -1021,8 +1092,9 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * Unset bits from mask in dest." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static void bit_and_not(unsigned char* dest, const unsigned char* mask, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        dest[i] &= ~mask[i];" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        BITWORD_STORE(dest + w, BITWORD_AND_NOT(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));" << std::endl;
 	stream << "    }" << std::endl;
 	stream << "}" << std::endl;
 	stream << std::endl;
@@ -1031,9 +1103,10 @@ void ChartToC::writeHelpers(std::ostream& stream) {
 	stream << " * Set bits from mask in dest." << std::endl;
 	stream << " */" << std::endl;
 	stream << "static void bit_and(unsigned char* dest, const unsigned char* mask, size_t i) {" << std::endl;
-	stream << "    while(i--) {" << std::endl;
-	stream << "        dest[i] &= mask[i];" << std::endl;
-	stream << "    };" << std::endl;
+	stream << "    size_t w;" << std::endl;
+	stream << "    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {" << std::endl;
+	stream << "        BITWORD_STORE(dest + w, BITWORD_AND(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));" << std::endl;
+	stream << "    }" << std::endl;
 	stream << "}" << std::endl;
 	stream << std::endl;
 	stream << "#define USCXML_NO_BIT_OPERATIONS" << std::endl;
@@ -2192,12 +2265,12 @@ void ChartToC::writeFSM(std::ostream& stream) {
 	stream << "    USCXML_NR_TRANS_TYPE  nr_trans_bytes  = ((USCXML_NUMBER_TRANS + 7) & ~7) >> 3;" << std::endl;
 	stream << "    int err = USCXML_ERR_OK;" << std::endl;
 
-	stream << "    unsigned char conflicts  [USCXML_MAX_NR_TRANS_BYTES];" << std::endl;
-	stream << "    unsigned char trans_set  [USCXML_MAX_NR_TRANS_BYTES];" << std::endl;
-	stream << "    unsigned char target_set [USCXML_MAX_NR_STATES_BYTES];" << std::endl;
-	stream << "    unsigned char exit_set   [USCXML_MAX_NR_STATES_BYTES];" << std::endl;
-	stream << "    unsigned char entry_set  [USCXML_MAX_NR_STATES_BYTES];" << std::endl;
-	stream << "    unsigned char tmp_states [USCXML_MAX_NR_STATES_BYTES];" << std::endl;
+	stream << "    unsigned char conflicts  [USCXML_TRANS_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char trans_set  [USCXML_TRANS_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char target_set [USCXML_STATES_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char exit_set   [USCXML_STATES_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char entry_set  [USCXML_STATES_BITSET_BYTES];" << std::endl;
+	stream << "    unsigned char tmp_states [USCXML_STATES_BITSET_BYTES];" << std::endl;
 	stream << std::endl;
 
 	stream << "#ifdef USCXML_VERBOSE" << std::endl;
@@ -2840,7 +2840,7 @@ std::string ChartToPromela::dataToAssignments(const std::string& prefix, const D
 		}
 	} else if (data.array.size() > 0) {
 		size_t index = 0;
-		for(std::list<Data>::const_iterator aIter = data.array.begin(); aIter != data.array.end(); aIter++) {
+		for(std::vector<Data>::const_iterator aIter = data.array.begin(); aIter != data.array.end(); aIter++) {
 			retVal << dataToAssignments(prefix + "[" + toStr(index) + "]", *aIter);
 			index++;
 		}
@@ -7,43 +7,90 @@ extern "C" {
 }
 
 #include <stdlib.h>
+#include <ostream>
 #include <string>
+#include <vector>
 #include "uscxml/Common.h"
 
 namespace uscxml {
 
-USCXML_API inline std::string base64Encode(const char* data, unsigned int len, bool withBlockEnd = true) {
-	base64_encodestate* ctx = (base64_encodestate*)malloc(sizeof(base64_encodestate));
-	base64_init_encodestate(ctx);
-	
-	/**
-	 * Wikipedia: Very roughly, the final size of Base64-encoded binary data is equal to 1.37
-	 * times the original data size + 814 bytes (for headers). The size of the decoded data can
-	 * be approximated with this formula:
-	 */
-	
-	int written = 0;
-	char* out = (char*)malloc(len * 1.4 + 814);
-	written += base64_encode_block(data, len, out, ctx);
+/**
+ * Upper bound for the encoded size, libb64 breaks lines after 72 characters
+ * from 54 bytes of input.
+ */
+USCXML_API inline size_t base64EncodedSize(size_t len) {
+	return ((len + 2) / 3) * 4 + len / 54 + 2;
+}
+
+/// Upper bound for the decoded size, every character carries six bits
+USCXML_API inline size_t base64DecodedSize(size_t len) {
+	return ((len + 3) / 4) * 3;
+}
+
+/// Encode into a stream in fixed chunks, never holding the encoded data as a whole
+USCXML_API inline void base64Encode(const char* data, size_t len, std::ostream& stream, bool withBlockEnd = true) {
+	base64_encodestate ctx;
+	base64_init_encodestate(&ctx);
+
+	const size_t chunk = 54 * 1024;
+	std::vector<char> out(base64EncodedSize(chunk));
+
+	while (len > 0) {
+		size_t length = (len > chunk ? chunk : len);
+		stream.write(out.data(), base64_encode_block(data, length, out.data(), &ctx));
+		data += length;
+		len -= length;
+	}
+	if (withBlockEnd) {
+		int written = base64_encode_blockend(out.data(), &ctx);
+		stream.write(out.data(), written - 1);  // drop the newline
+	}
+}
+
+USCXML_API inline std::string base64Encode(const char* data, size_t len, bool withBlockEnd = true) {
+	base64_encodestate ctx;
+	base64_init_encodestate(&ctx);
+
+	// encode right into the result, base64_encode_block takes an int
+	std::string result;
+	result.resize(base64EncodedSize(len));
+
+	size_t written = 0;
+	const size_t chunk = 54 * 1024 * 1024;
+	while (len > 0) {
+		size_t length = (len > chunk ? chunk : len);
+		written += base64_encode_block(data, length, &result[written], &ctx);
+		data += length;
+		len -= length;
+	}
 	if (withBlockEnd) {
-		written += base64_encode_blockend(out + written, ctx);
+		written += base64_encode_blockend(&result[written], &ctx);
 		written--;  // drop the newline
 	}
-	std::string result(out, written);
-	free(ctx);
-	free(out);
+	result.resize(written);
 	return result;
 }
 
+/// Decode into out, which has to hold base64DecodedSize(len) bytes
+USCXML_API inline size_t base64Decode(const char* data, size_t len, char* out) {
+	base64_decodestate ctx;
+	base64_init_decodestate(&ctx);
+
+	size_t written = 0;
+	const size_t chunk = 64 * 1024 * 1024;
+	while (len > 0) {
+		size_t length = (len > chunk ? chunk : len);
+		written += base64_decode_block(data, length, out + written, &ctx);
+		data += length;
+		len -= length;
+	}
+	return written;
+}
+
 USCXML_API inline std::string base64Decode(const std::string& data) {
-	base64_decodestate* ctx = (base64_decodestate*)malloc(sizeof(base64_decodestate));
-	base64_init_decodestate(ctx);
-	
-	char* out = (char*)malloc(data.size());
-	size_t size = base64_decode_block(data.data(), data.size(), out, ctx);
-	free(ctx);
-	std::string result(out, size);
-	free(out);
+	std::string result;
+	result.resize(base64DecodedSize(data.size()));
+	result.resize(base64Decode(data.data(), data.size(), &result[0]));
 	return result;
 }
 
@@ -0,0 +1,99 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "ChartIndex.h"
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/Predicates.h"
+
+#include <limits>
+
+namespace uscxml {
+
+using namespace XERCESC_NS;
+
+const uint32_t ChartIndex::NONE = std::numeric_limits<uint32_t>::max();
+
+ChartIndex::ChartIndex(const DOMElement* root) : _root(root) {
+	if (root == NULL)
+		return;
+
+	uint32_t postFixOrder = 0;
+	indexElement(root, NONE, false, postFixOrder);
+}
+
+void ChartIndex::indexElement(const DOMElement* element, uint32_t enclosing, bool inState, uint32_t& postFixOrder) {
+	uint32_t order = NONE;
+
+	if (isState(element, false)) {
+		order = _states.size();
+		_states.push_back((DOMElement*)element);
+		_entries.push_back(Entry());
+
+		Entry& entry = _entries.back();
+		entry.depth = (enclosing == NONE ? 0 : _entries[enclosing].depth + 1);
+		entry.parent = (inState ? enclosing : NONE);
+		entry.lastDescendant = order;
+		if (entry.parent != NONE)
+			_entries[entry.parent].children.push_back(order);
+
+		_documentOrder[element] = order;
+		if (HAS_ATTR(element, kXMLCharId)) {
+			// insert will not replace, the first state with an id wins
+			_ids.insert(std::make_pair(ATTR(element, kXMLCharId), order));
+		}
+	}
+
+	for (DOMElement* child = element->getFirstElementChild(); child; child = child->getNextElementSibling()) {
+		// states of embedded documents belong to another chart
+		if (kXMLCharScxml.iequals(child->getLocalName()) == 0)
+			continue;
+		indexElement(child, (order != NONE ? order : enclosing), order != NONE, postFixOrder);
+	}
+
+	if (order != NONE) {
+		_entries[order].postFixOrder = postFixOrder++;
+		// all our descendants are indexed by now
+		if (enclosing != NONE)
+			_entries[enclosing].lastDescendant = _entries[order].lastDescendant;
+	}
+}
+
+DOMElement* ChartIndex::getState(const std::string& stateId) const {
+	auto idIter = _ids.find(stateId);
+	if (idIter == _ids.end())
+		return NULL;
+	return _states[idIter->second];
+}
+
+uint32_t ChartIndex::getDocumentOrder(const DOMElement* state) const {
+	auto orderIter = _documentOrder.find(state);
+	if (orderIter == _documentOrder.end())
+		return NONE;
+	return orderIter->second;
+}
+
+bool ChartIndex::isDescendant(const DOMElement* s1, const DOMElement* s2) const {
+	uint32_t order1 = getDocumentOrder(s1);
+	uint32_t order2 = getDocumentOrder(s2);
+	if (order1 == NONE || order2 == NONE)
+		return false;
+	return isDescendant(order1, order2);
+}
+
+}
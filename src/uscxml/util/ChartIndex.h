@@ -0,0 +1,121 @@
+/**
+ *  @file
+ *  @author     2016 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef CHARTINDEX_H_5C1E9A3F
+#define CHARTINDEX_H_5C1E9A3F
+
+#include "uscxml/Common.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+// forward declare
+namespace XERCESC_NS {
+class DOMElement;
+}
+
+namespace uscxml {
+
+/**
+ * The states of a chart indexed in a single pass over its DOM.
+ *
+ * States are the \<scxml\>, \<state\>, \<parallel\>, \<final\>, \<history\> and
+ * \<initial\> elements below the root in document order, without the states of
+ * embedded documents. A state's descendants occupy the document order right
+ * after it, so asking whether one state contains another compares two numbers.
+ * The index is a snapshot, build it anew after changing the DOM.
+ */
+class USCXML_API ChartIndex {
+public:
+	ChartIndex(const XERCESC_NS::DOMElement* root);
+
+	/// Position of an unknown element or of the root's parent
+	static const uint32_t NONE;
+
+	const XERCESC_NS::DOMElement* getRoot() const {
+		return _root;
+	}
+
+	/// All states in document order
+	const std::vector<XERCESC_NS::DOMElement*>& getStates() const {
+		return _states;
+	}
+
+	/// The first state in document order with the given id or NULL
+	XERCESC_NS::DOMElement* getState(const std::string& stateId) const;
+
+	/// The position of a state in document order or NONE
+	uint32_t getDocumentOrder(const XERCESC_NS::DOMElement* state) const;
+
+	/// The position of a state in post-fix order, children before their parent
+	uint32_t getPostFixOrder(uint32_t documentOrder) const {
+		return _entries[documentOrder].postFixOrder;
+	}
+
+	/// The number of states above a state, the root is at depth 0
+	uint32_t getDepth(uint32_t documentOrder) const {
+		return _entries[documentOrder].depth;
+	}
+
+	/// The state that is the parent element of a state or NONE
+	uint32_t getParent(uint32_t documentOrder) const {
+		return _entries[documentOrder].parent;
+	}
+
+	/// The last descendant of a state in document order, the state itself if there is none
+	uint32_t getLastDescendant(uint32_t documentOrder) const {
+		return _entries[documentOrder].lastDescendant;
+	}
+
+	/// The states that are child elements of a state in document order
+	const std::vector<uint32_t>& getChildren(uint32_t documentOrder) const {
+		return _entries[documentOrder].children;
+	}
+
+	/// Whether s1 is a proper descendant of s2
+	bool isDescendant(uint32_t s1, uint32_t s2) const {
+		return s1 > s2 && s1 <= _entries[s2].lastDescendant;
+	}
+
+	bool isDescendant(const XERCESC_NS::DOMElement* s1, const XERCESC_NS::DOMElement* s2) const;
+
+protected:
+	struct Entry {
+		uint32_t postFixOrder;
+		uint32_t depth;
+		uint32_t parent;
+		uint32_t lastDescendant;
+		std::vector<uint32_t> children;
+	};
+
+	const XERCESC_NS::DOMElement* _root;
+	std::vector<XERCESC_NS::DOMElement*> _states;
+	std::vector<Entry> _entries;
+	std::unordered_map<const XERCESC_NS::DOMElement*, uint32_t> _documentOrder;
+	std::unordered_map<std::string, uint32_t> _ids;
+
+private:
+	void indexElement(const XERCESC_NS::DOMElement* element, uint32_t enclosing, bool inState, uint32_t& postFixOrder);
+};
+
+}
+
+#endif /* end of include guard: CHARTINDEX_H_5C1E9A3F */
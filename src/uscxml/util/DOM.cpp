@@ -55,6 +55,15 @@ std::ostream& operator<< (std::ostream& os, const X& xmlString) {
 	return os;
 }
 
+std::string DOMUtils::textContent(const DOMNode* node) {
+	std::string content;
+	for (DOMNode* child = node->getFirstChild(); child; child = child->getNextSibling()) {
+		if (child->getNodeType() == DOMNode::TEXT_NODE || child->getNodeType() == DOMNode::CDATA_SECTION_NODE)
+			content += X(child->getNodeValue()).str();
+	}
+	return content;
+}
+
 std::string DOMUtils::idForNode(const DOMNode* node) {
 	std::string nodeId;
 	std::string seperator;
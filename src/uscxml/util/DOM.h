@@ -54,6 +54,9 @@ public:
 	static std::string xPathForNode(const XERCESC_NS::DOMNode* node, const std::string& ns = "");
 	static std::string idForNode(const XERCESC_NS::DOMNode* node);
 
+	/// The text and CDATA children of a node, unlike getTextContent() this does not allocate in the owner document
+	static std::string textContent(const XERCESC_NS::DOMNode* node);
+
 	static std::list<XERCESC_NS::DOMElement*> inPostFixOrder(const std::set<std::string>& elements,
 	        const XERCESC_NS::DOMElement* root,
 	        const bool includeEmbeddedDoc = false) {
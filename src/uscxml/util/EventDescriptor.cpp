@@ -0,0 +1,261 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "EventDescriptor.h"
+#include "uscxml/messages/Event.h"
+#include "uscxml/util/String.h"
+
+#include <boost/algorithm/string.hpp>
+#include <assert.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace uscxml {
+
+/**
+ * Strings to ids where finding never locks. The single writer, holding the
+ * respective mutex, publishes immutable entries into an open addressing table
+ * and publishes a larger copy when it fills up. Neither entries nor replaced
+ * tables are ever freed as readers might still see them.
+ */
+class InternMap {
+public:
+	InternMap() : _table(new Table(64)) {}
+
+	/// The id for key or 0 if it was not inserted yet
+	uint32_t find(const std::string& key) const {
+		const Table* table = _table.load(std::memory_order_acquire);
+		size_t hash = std::hash<std::string>()(key);
+		for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+			const Entry* entry = table->slots[i].load(std::memory_order_acquire);
+			if (entry == NULL)
+				return 0;
+			if (entry->hash == hash && entry->key == key)
+				return entry->id;
+		}
+	}
+
+	/// Only ever called with the writer's mutex held and for keys not found
+	void insert(const std::string& key, uint32_t id) {
+		Table* table = _table.load(std::memory_order_relaxed);
+
+		// keep the load factor below one half so probe sequences stay short
+		if ((table->size + 1) * 2 > table->mask + 1) {
+			Table* grown = new Table((table->mask + 1) * 2);
+			for (size_t i = 0; i <= table->mask; i++) {
+				const Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+				if (entry != NULL)
+					grown->put(entry);
+			}
+			_table.store(grown, std::memory_order_release);
+			table = grown;
+		}
+
+		Entry* entry = new Entry();
+		entry->hash = std::hash<std::string>()(key);
+		entry->key = key;
+		entry->id = id;
+		table->put(entry);
+	}
+
+protected:
+	struct Entry {
+		size_t hash;
+		std::string key;
+		uint32_t id;
+	};
+
+	struct Table {
+		Table(size_t capacity) : slots(new std::atomic<const Entry*>[capacity]), mask(capacity - 1), size(0) {
+			for (size_t i = 0; i < capacity; i++)
+				slots[i].store(NULL, std::memory_order_relaxed);
+		}
+
+		void put(const Entry* entry) {
+			size_t i = entry->hash & mask;
+			while (slots[i].load(std::memory_order_relaxed) != NULL)
+				i = (i + 1) & mask;
+			slots[i].store(entry, std::memory_order_release);
+			size++;
+		}
+
+		std::unique_ptr<std::atomic<const Entry*>[]> slots;
+		size_t mask;
+		size_t size;
+	};
+
+	std::atomic<Table*> _table;
+};
+
+static std::mutex _tokenMutex;
+static InternMap _tokens;
+static uint32_t _nrTokens = 0;
+
+// interned names by id in chunks that never move, so forId needs no lock
+#define EVENT_NAME_CHUNK 1024
+#define EVENT_NAME_CHUNKS 16384
+
+static std::mutex _nameMutex;
+static InternMap _nameIds;
+static std::atomic<EventName*> _nameChunks[EVENT_NAME_CHUNKS];
+static uint32_t _nrNames = 0;
+
+// split at the dots and map every token to its id
+static std::vector<uint32_t> splitTokens(const std::string& name, uint32_t (*tokenId)(const std::string&)) {
+	std::vector<uint32_t> tokens;
+	size_t start = 0;
+	while(true) {
+		size_t end = name.find('.', start);
+		tokens.push_back(tokenId(name.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+		if (end == std::string::npos)
+			break;
+		start = end + 1;
+	}
+	return tokens;
+}
+
+uint32_t EventDescriptor::intern(const std::string& token) {
+	uint32_t id = _tokens.find(token);
+	if (id != 0)
+		return id;
+
+	std::lock_guard<std::mutex> lock(_tokenMutex);
+	id = _tokens.find(token);
+	if (id != 0)
+		return id;
+
+	id = ++_nrTokens;
+	_tokens.insert(token, id);
+	return id;
+}
+
+uint32_t EventDescriptor::lookup(const std::string& token) {
+	return _tokens.find(token);
+}
+
+EventName::EventName(const std::string& name) : _name(name), _caseless(0), _id(0) {
+	if (_name.empty())
+		return;
+
+	_tokens = splitTokens(_name, EventDescriptor::lookup);
+	_caseless = EventDescriptor::lookup(boost::to_lower_copy(_name));
+}
+
+uint32_t EventName::intern(const std::string& name) {
+	if (name.empty())
+		return 0;
+
+	uint32_t id = lookup(name);
+	if (id != 0)
+		return id;
+
+	// intern the tokens as well, descriptors compiled later have to find them
+	EventName interned;
+	interned._name = name;
+	interned._tokens = splitTokens(name, EventDescriptor::intern);
+	interned._caseless = EventDescriptor::intern(boost::to_lower_copy(name));
+
+	std::lock_guard<std::mutex> lock(_nameMutex);
+	id = _nameIds.find(name);
+	if (id != 0)
+		return id;
+
+	if (_nrNames == EVENT_NAME_CHUNK * EVENT_NAME_CHUNKS) {
+		ERROR_PLATFORM_THROW("Too many interned event names");
+	}
+
+	id = ++_nrNames;
+	size_t chunk = (id - 1) / EVENT_NAME_CHUNK;
+	EventName* names = _nameChunks[chunk].load(std::memory_order_relaxed);
+	if (names == NULL) {
+		names = new EventName[EVENT_NAME_CHUNK];
+		_nameChunks[chunk].store(names, std::memory_order_release);
+	}
+	interned._id = id;
+	names[(id - 1) % EVENT_NAME_CHUNK] = interned;
+
+	// publishing the id makes the name visible to everyone who finds it
+	_nameIds.insert(name, id);
+	return id;
+}
+
+uint32_t EventName::lookup(const std::string& name) {
+	return _nameIds.find(name);
+}
+
+const EventName& EventName::forId(uint32_t id) {
+	assert(id > 0);
+	EventName* names = _nameChunks[(id - 1) / EVENT_NAME_CHUNK].load(std::memory_order_acquire);
+	assert(names != NULL);
+	return names[(id - 1) % EVENT_NAME_CHUNK];
+}
+
+EventDescriptor::EventDescriptor(const std::string& eventDescs) : _eventDescs(eventDescs), _isWildcard(false) {
+	std::list<std::string> tokens = tokenize(eventDescs);
+	for (auto eventDesc : tokens) {
+		// remove optional trailing .* for CCXML compatibility
+		if (eventDesc.size() > 0 && eventDesc[eventDesc.size() - 1] == '*')
+			eventDesc = eventDesc.substr(0, eventDesc.size() - 1);
+		if (eventDesc.size() > 0 && eventDesc[eventDesc.size() - 1] == '.')
+			eventDesc = eventDesc.substr(0, eventDesc.size() - 1);
+
+		// was eventDesc the * wildcard
+		if (eventDesc.size() == 0) {
+			_isWildcard = true;
+			continue;
+		}
+
+		Descriptor desc;
+		desc.name = eventDesc;
+		desc.tokens = splitTokens(eventDesc, intern);
+		desc.caseless = intern(boost::to_lower_copy(eventDesc));
+		desc.id = EventName::intern(eventDesc);
+		_descs.push_back(desc);
+	}
+}
+
+bool EventDescriptor::matches(const EventName& eventName) const {
+	if (eventName.empty())
+		return false;
+
+	if (_isWildcard)
+		return true;
+
+	const std::vector<uint32_t>& nameTokens = eventName.getTokens();
+	for (auto& desc : _descs) {
+		// are they the very same interned name or equal ignoring case?
+		if (desc.id == eventName.getId() || desc.caseless == eventName.getCaseless())
+			return true;
+
+		// eventDesc has to be a token-wise prefix of the event
+		if (desc.tokens.size() > nameTokens.size())
+			continue;
+
+		size_t i = 0;
+		while (i < desc.tokens.size() && desc.tokens[i] == nameTokens[i])
+			i++;
+		if (i == desc.tokens.size())
+			return true;
+	}
+	return false;
+}
+
+}
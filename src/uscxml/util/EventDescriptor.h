@@ -0,0 +1,130 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef EVENTDESCRIPTOR_H_2C6E0F8B
+#define EVENTDESCRIPTOR_H_2C6E0F8B
+
+#include "uscxml/Common.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace uscxml {
+
+/**
+ * An event name split at its dots into interned tokens.
+ *
+ * Tokens that were never part of an event descriptor are not interned and
+ * will never match, so arbitrary event names do not grow the token table.
+ *
+ * The names a document can raise, send or wait for are interned as a whole
+ * when a chart is initialized. Events carry the id of their name, so the
+ * tokenized name is only looked up and never built again.
+ */
+class USCXML_API EventName {
+public:
+	EventName() : _caseless(0), _id(0) {}
+	EventName(const std::string& name);
+
+	/// Intern a complete event name with all its tokens, ids start at 1
+	static uint32_t intern(const std::string& name);
+	/// The id of an interned event name or 0
+	static uint32_t lookup(const std::string& name);
+	/// The event name for an id from intern(), valid for the life of the process
+	static const EventName& forId(uint32_t id);
+
+	const std::string& str() const {
+		return _name;
+	}
+	bool empty() const {
+		return _name.empty();
+	}
+	const std::vector<uint32_t>& getTokens() const {
+		return _tokens;
+	}
+	/// The interned lower-cased name, 0 if no descriptor equals it
+	uint32_t getCaseless() const {
+		return _caseless;
+	}
+	/// The id of the interned name, 0 if it was not interned
+	uint32_t getId() const {
+		return _id;
+	}
+
+protected:
+	std::string _name;
+	std::vector<uint32_t> _tokens;
+	uint32_t _caseless;
+	uint32_t _id;
+};
+
+/**
+ * A compiled `event` attribute of a transition.
+ *
+ * The descriptors are parsed once and match as in section 3.12.1 of the
+ * recommendation: a descriptor matches if it is a token-wise prefix of the
+ * event name or equals it ignoring case, `*` matches every event and a
+ * trailing `.*` is ignored.
+ */
+class USCXML_API EventDescriptor {
+public:
+	EventDescriptor() : _isWildcard(false) {}
+	EventDescriptor(const std::string& eventDescs);
+
+	bool matches(const EventName& eventName) const;
+	bool matches(const std::string& eventName) const {
+		return matches(EventName(eventName));
+	}
+
+	const std::string& str() const {
+		return _eventDescs;
+	}
+	bool empty() const {
+		return _descs.empty() && !_isWildcard;
+	}
+	bool isWildcard() const {
+		return _isWildcard;
+	}
+
+	/// The individual descriptors with `*` and trailing `.*` removed
+	struct Descriptor {
+		std::string name;
+		std::vector<uint32_t> tokens;
+		uint32_t caseless;
+		uint32_t id; ///< The descriptor interned as an EventName
+	};
+	const std::vector<Descriptor>& getDescriptors() const {
+		return _descs;
+	}
+
+	/// Intern a token or a lower-cased name, ids start at 1
+	static uint32_t intern(const std::string& token);
+	/// The id of an already interned token or 0
+	static uint32_t lookup(const std::string& token);
+
+protected:
+	std::string _eventDescs;
+	std::vector<Descriptor> _descs;
+	bool _isWildcard;
+};
+
+}
+
+#endif /* end of include guard: EVENTDESCRIPTOR_H_2C6E0F8B */
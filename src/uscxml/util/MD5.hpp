@@ -26,18 +26,15 @@ extern "C" {
 
 #include <string.h>
 
+#include <istream>
 #include <sstream>
 #include <iomanip>
 #include "uscxml/Common.h"
 
 namespace uscxml {
 
-    USCXML_API inline std::string md5(const char* data, size_t length) {
-    	md5_state_t state;
+    USCXML_API inline std::string md5Digest(md5_state_t& state) {
     	md5_byte_t digest[16];
-
-    	md5_init(&state);
-    	md5_append(&state, (const md5_byte_t *)data, length);
     	md5_finish(&state, digest);
 
     	std::ostringstream ss;
@@ -49,10 +46,40 @@ namespace uscxml {
     	return ss.str();
     }
 
+    USCXML_API inline std::string md5(const char* data, size_t length) {
+    	md5_state_t state;
+    	md5_init(&state);
+
+    	// md5_append takes an int
+    	const size_t chunk = 1 << 30;
+    	while (length > chunk) {
+    		md5_append(&state, (const md5_byte_t *)data, chunk);
+    		data += chunk;
+    		length -= chunk;
+    	}
+    	md5_append(&state, (const md5_byte_t *)data, length);
+
+    	return md5Digest(state);
+    }
+
     USCXML_API inline std::string md5(const std::string& data) {
     	return md5(data.data(), data.size());
     }
 
+    /// Digest everything left in the stream without reading it into memory as a whole
+    USCXML_API inline std::string md5(std::istream& stream) {
+    	md5_state_t state;
+    	md5_init(&state);
+
+    	char buffer[64 * 1024];
+    	while (stream) {
+    		stream.read(buffer, sizeof(buffer));
+    		md5_append(&state, (const md5_byte_t *)buffer, stream.gcount());
+    	}
+
+    	return md5Digest(state);
+    }
+
 }
 
 
@@ -108,6 +108,34 @@ NEXT_ANCESTOR:
 	return ancestor;
 }
 
+DOMElement* findLCCA(const std::list<DOMElement*>& states, const ChartIndex& index) {
+	uint32_t front = index.getDocumentOrder(states.front());
+	if (front == ChartIndex::NONE)
+		return findLCCA(states);
+
+	std::list<uint32_t> orders;
+	for (auto state : states) {
+		orders.push_back(index.getDocumentOrder(state));
+	}
+
+	uint32_t uppermost = ChartIndex::NONE;
+	for (uint32_t ancestor = index.getParent(front); ancestor != ChartIndex::NONE; ancestor = index.getParent(ancestor)) {
+		uppermost = ancestor;
+		if (!isCompound(index.getStates()[ancestor]))
+			continue;
+		for (auto order : orders) {
+			if (!index.isDescendant(order, ancestor))
+				goto NEXT_ANCESTOR;
+		}
+		return index.getStates()[ancestor];
+NEXT_ANCESTOR:
+		;
+	}
+
+	// take uppermost root as ancestor
+	return (uppermost != ChartIndex::NONE ? index.getStates()[uppermost] : NULL);
+}
+
 /*
  * If state2 is null, returns the set of all ancestors of state1 in ancestry order
  * (state1's parent followed by the parent's parent, etc. up to an including the <scxml>
@@ -170,6 +198,23 @@ std::list<DOMElement*> getExitSet(const DOMElement* transition, const DOMElement
 	return statesToExit;
 }
 
+std::list<DOMElement*> getExitSet(const DOMElement* transition, const ChartIndex& index) {
+	std::list<DOMElement*> statesToExit;
+	if (HAS_ATTR(transition, kXMLCharTarget)) {
+		uint32_t domain = index.getDocumentOrder(getTransitionDomain(transition, index));
+		if (domain == ChartIndex::NONE)
+			return statesToExit;
+
+		// all proper states after the domain up to its last descendant
+		for (uint32_t i = domain + 1; i <= index.getLastDescendant(domain); i++) {
+			if (isState(index.getStates()[i]))
+				statesToExit.push_back(index.getStates()[i]);
+		}
+	}
+
+	return statesToExit;
+}
+
 bool conflicts(const DOMElement* t1, const DOMElement* t2, const DOMElement* root) {
 	return (
 	           (getSourceState(t1) == getSourceState(t2)) ||
@@ -179,6 +224,37 @@ bool conflicts(const DOMElement* t1, const DOMElement* t2, const DOMElement* roo
 	       );
 }
 
+bool conflicts(const DOMElement* t1, const DOMElement* t2, const ChartIndex& index) {
+	if ((getSourceState(t1) == getSourceState(t2)) ||
+	        (DOMUtils::isDescendant(getSourceState(t1), getSourceState(t2))) ||
+	        (DOMUtils::isDescendant(getSourceState(t2), getSourceState(t1))))
+		return true;
+
+	if (!HAS_ATTR(t1, kXMLCharTarget) || !HAS_ATTR(t2, kXMLCharTarget))
+		return false;
+
+	uint32_t domain1 = index.getDocumentOrder(getTransitionDomain(t1, index));
+	uint32_t domain2 = index.getDocumentOrder(getTransitionDomain(t2, index));
+	if (domain1 == ChartIndex::NONE || domain2 == ChartIndex::NONE)
+		return false;
+
+	// exit sets are the states below the domains, they intersect if one contains the other
+	uint32_t inner;
+	if (domain1 == domain2 || index.isDescendant(domain2, domain1)) {
+		inner = domain2;
+	} else if (index.isDescendant(domain1, domain2)) {
+		inner = domain1;
+	} else {
+		return false;
+	}
+
+	for (uint32_t i = inner + 1; i <= index.getLastDescendant(inner); i++) {
+		if (isState(index.getStates()[i]))
+			return true;
+	}
+	return false;
+}
+
 bool isState(const DOMElement* state, bool properOnly) {
 	if (!state)
 		return false;
@@ -273,6 +349,18 @@ std::list<DOMElement*> getTargetStates(const DOMElement* transition, const DOMEl
 	return targetStates;
 }
 
+std::list<DOMElement*> getTargetStates(const DOMElement* transition, const ChartIndex& index) {
+	std::list<DOMElement*> targetStates;
+
+	std::list<std::string> targetIds = tokenize(ATTR(transition, kXMLCharTarget));
+	for (auto targetIter = targetIds.begin(); targetIter != targetIds.end(); targetIter++) {
+		DOMElement* state = index.getState(*targetIter);
+		if (state) {
+			targetStates.push_back(state);
+		}
+	}
+	return targetStates;
+}
 
 DOMElement* getTransitionDomain(const DOMElement* transition, const DOMElement* root) {
 	std::list<DOMElement*> tStates = getTargetStates(transition, root);
@@ -296,6 +384,28 @@ BREAK_LOOP:
 	return findLCCA(tStates);
 }
 
+DOMElement* getTransitionDomain(const DOMElement* transition, const ChartIndex& index) {
+	std::list<DOMElement*> tStates = getTargetStates(transition, index);
+	if (tStates.size() == 0) {
+		return NULL;
+	}
+	std::string transitionType = (HAS_ATTR(transition, kXMLCharType) ? ATTR(transition, kXMLCharType) : "external");
+	DOMElement* source = getSourceState(transition);
+
+	if (iequals(transitionType, "internal") && isCompound(source)) {
+		for (auto tIter = tStates.begin(); tIter != tStates.end(); tIter++) {
+			if (!index.isDescendant(*tIter, source))
+				goto BREAK_LOOP;
+		}
+		return source;
+	}
+
+BREAK_LOOP:
+	tStates.push_front(source);
+
+	return findLCCA(tStates, index);
+}
+
 std::list<DOMElement*> getStates(const std::list<std::string>& stateIds, const DOMElement* root) {
 	std::list<DOMElement*> states;
 	std::list<std::string>::const_iterator tokenIter = stateIds.begin();
@@ -306,6 +416,16 @@ std::list<DOMElement*> getStates(const std::list<std::string>& stateIds, const D
 	return states;
 }
 
+std::list<DOMElement*> getStates(const std::list<std::string>& stateIds, const ChartIndex& index) {
+	std::list<DOMElement*> states;
+	std::list<std::string>::const_iterator tokenIter = stateIds.begin();
+	while(tokenIter != stateIds.end()) {
+		states.push_back(index.getState(*tokenIter));
+		tokenIter++;
+	}
+	return states;
+}
+
 DOMElement* getState(const std::string& stateId, const DOMElement* root) {
 
 	std::list<const DOMElement*> stateStack;
@@ -338,7 +458,8 @@ DOMElement* getState(const std::string& stateId, const DOMElement* root) {
  * attribute nor an <initial> element is specified, the SCXML Processor must use
  * the first child state in document order as the default initial state.
  */
-std::list<DOMElement*> getInitialStates(const DOMElement* state, const DOMElement* root) {
+template <class Chart>
+static std::list<DOMElement*> initialStates(const DOMElement* state, const DOMElement* root, const Chart& chart) {
 	if (!state) {
 		state = root;
 	}
@@ -358,7 +479,7 @@ std::list<DOMElement*> getInitialStates(const DOMElement* state, const DOMElemen
 	if (isCompound(state)) {
 		// initial attribute at element
 		if (HAS_ATTR(state, kXMLCharInitial)) {
-			return getStates(tokenize(ATTR(state, kXMLCharInitial)), root);
+			return getStates(tokenize(ATTR(state, kXMLCharInitial)), chart);
 		}
 
 		// initial element as child
@@ -366,7 +487,7 @@ std::list<DOMElement*> getInitialStates(const DOMElement* state, const DOMElemen
 		if(initElems.size() > 0 ) {
 			std::list<DOMElement*> initTrans = DOMUtils::filterChildElements(XML_PREFIX(initElems.front()).str() + "transition", initElems.front());
 			if (initTrans.size() > 0 && HAS_ATTR(initTrans.front(), kXMLCharTarget)) {
-				return getTargetStates(initTrans.front(), root);
+				return getTargetStates(initTrans.front(), chart);
 			}
 			return std::list<DOMElement*>();
 		}
@@ -385,30 +506,41 @@ std::list<DOMElement*> getInitialStates(const DOMElement* state, const DOMElemen
 	return std::list<DOMElement*>();
 }
 
+std::list<DOMElement*> getInitialStates(const DOMElement* state, const DOMElement* root) {
+	return initialStates(state, root, root);
+}
+
+std::list<DOMElement*> getInitialStates(const DOMElement* state, const ChartIndex& index) {
+	return initialStates(state, index.getRoot(), index);
+}
+
 std::list<DOMElement*> getReachableStates(const DOMElement* root) {
+	return getReachableStates(ChartIndex(root));
+}
+
+std::list<DOMElement*> getReachableStates(const ChartIndex& index) {
 	/** Check which states are reachable */
 
 	std::list<DOMElement*> reachable; // total transitive hull
 	std::list<DOMElement*> additions; // nodes added in last iteration
 	std::list<DOMElement*> current; // new nodes caused by nodes added
-	additions.push_back((DOMElement*)root);
+	additions.push_back((DOMElement*)index.getRoot());
+
+	// members of reachable and additions
+	std::set<const DOMElement*> known;
+	std::set<const DOMElement*> added;
+	added.insert(index.getRoot());
 
 	while (additions.size() > 0) {
 
-#if 0
-		for (auto stateIter = additions.begin(); stateIter != additions.end(); stateIter++) {
-			DOMElement* state = *stateIter;
-			std::cout << (HAS_ATTR(state, "id") ? ATTR(state, "id") : (std::string)X(state->getLocalName())) << ", " << std::endl;
-		}
-#endif
 		// reachable per initial attribute or document order - size will increase as we append new states
 		for (auto stateIter = additions.begin(); stateIter != additions.end(); stateIter++) {
 			// get the state's initial states
 			DOMElement* state = *stateIter;
-			std::list<DOMElement*> initials = getInitialStates(state, root);
+			std::list<DOMElement*> initials = getInitialStates(state, index);
 			for (auto initIter = initials.begin(); initIter != initials.end(); initIter++) {
 				DOMElement* initial = *initIter;
-				if (!DOMUtils::isMember(initial, additions) && !DOMUtils::isMember(initial, reachable)) {
+				if (added.find(initial) == added.end() && known.find(initial) == known.end()) {
 					current.push_back(initial);
 				}
 			}
@@ -420,10 +552,10 @@ std::list<DOMElement*> getReachableStates(const DOMElement* root) {
 			std::list<DOMElement*> transitions = DOMUtils::filterChildElements(XML_PREFIX(state).str() + "transition", state, false);
 			for (auto transIter = transitions.begin(); transIter != transitions.end(); transIter++) {
 				DOMElement* transition = *transIter;
-				std::list<DOMElement*> targets = getTargetStates(transition, root);
+				std::list<DOMElement*> targets = getTargetStates(transition, index);
 				for (auto targetIter = targets.begin(); targetIter != targets.end(); targetIter++) {
 					DOMElement* target = *targetIter;
-					if (!DOMUtils::isMember(target, additions) && !DOMUtils::isMember(target, reachable)) {
+					if (added.find(target) == added.end() && known.find(target) == known.end()) {
 						current.push_back(target);
 					}
 				}
@@ -441,7 +573,7 @@ std::list<DOMElement*> getReachableStates(const DOMElement* root) {
 					if (!isState(parentElem)) {
 						break;
 					}
-					if (!DOMUtils::isMember(parentElem, additions) && !DOMUtils::isMember(parentElem, reachable)) {
+					if (added.find(parentElem) == added.end() && known.find(parentElem) == known.end()) {
 						current.push_back(parentElem);
 					}
 					parent = parent->getParentNode();
@@ -451,9 +583,11 @@ std::list<DOMElement*> getReachableStates(const DOMElement* root) {
 
 		// add all additions from last iterations to reachable set
 		reachable.insert(reachable.end(), additions.begin(), additions.end());
+		known.insert(added.begin(), added.end());
 
 		// set current additions as new additions
 		additions = current;
+		added = std::set<const DOMElement*>(current.begin(), current.end());
 
 		// clear current set for next iteration
 		current.clear();
@@ -26,6 +26,7 @@
 #include <list>
 #include <xercesc/dom/DOM.hpp>
 #include "uscxml/util/DOM.h"
+#include "uscxml/util/ChartIndex.h"
 #include "uscxml/util/Convenience.h"
 
 // forward declare
@@ -89,6 +90,42 @@ bool USCXML_API conflicts(const XERCESC_NS::DOMElement* transition1,
                           const XERCESC_NS::DOMElement* transition2,
                           const XERCESC_NS::DOMElement* root);
 
+/**
+ * The same predicates answered from a ChartIndex. The variants above taking
+ * the root element search the DOM, which is cheaper for a single question.
+ * Build an index once when asking about many states or transitions of the
+ * same chart.
+ */
+
+XERCESC_NS::DOMElement USCXML_API *findLCCA(const std::list<XERCESC_NS::DOMElement*>& states,
+        const ChartIndex& index);
+
+std::list<XERCESC_NS::DOMElement*> USCXML_API getTargetStates(
+    const XERCESC_NS::DOMElement* transition,
+    const ChartIndex& index);
+
+XERCESC_NS::DOMElement USCXML_API *getTransitionDomain(
+    const XERCESC_NS::DOMElement* transition,
+    const ChartIndex& index);
+
+std::list<XERCESC_NS::DOMElement*> USCXML_API getStates(
+    const std::list<std::string>& stateIds,
+    const ChartIndex& index);
+
+std::list<XERCESC_NS::DOMElement*> USCXML_API getInitialStates(
+    const XERCESC_NS::DOMElement* state,
+    const ChartIndex& index);
+
+std::list<XERCESC_NS::DOMElement*> USCXML_API getReachableStates(const ChartIndex& index);
+
+std::list<XERCESC_NS::DOMElement*> USCXML_API getExitSet(
+    const XERCESC_NS::DOMElement* transition,
+    const ChartIndex& index);
+
+bool USCXML_API conflicts(const XERCESC_NS::DOMElement* transition1,
+                          const XERCESC_NS::DOMElement* transition2,
+                          const ChartIndex& index);
+
 bool USCXML_API isState(const XERCESC_NS::DOMElement* state, bool properOnly = true);
 bool USCXML_API isCompound(const XERCESC_NS::DOMElement* state);
 bool USCXML_API isAtomic(const XERCESC_NS::DOMElement* state);
@@ -0,0 +1,246 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#include "Snapshot.h"
+#include "uscxml/messages/Event.h"
+
+#ifndef NO_XERCESC
+#include "uscxml/util/DOM.h"
+#include <sstream>
+#endif
+
+#include <string.h>
+
+namespace uscxml {
+
+#define SNAPSHOT_MAGIC "USCX"
+#define SNAPSHOT_DELTA_MAGIC "USCD"
+#define SNAPSHOT_MAGIC_LEN 4
+
+// parts of a data object present in the encoding
+#define SNAPSHOT_DATA_ATOM     0x01
+#define SNAPSHOT_DATA_COMPOUND 0x02
+#define SNAPSHOT_DATA_ARRAY    0x04
+#define SNAPSHOT_DATA_BINARY   0x08
+#define SNAPSHOT_DATA_VERBATIM 0x10
+
+static uint8_t byteOrder() {
+	uint16_t probe = 1;
+	return *(uint8_t*)&probe;
+}
+
+void SnapshotWriter::writeHeader(bool isDelta) {
+	_buffer.append(isDelta ? SNAPSHOT_DELTA_MAGIC : SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+	_buffer.push_back((char)SnapshotReader::version);
+	_buffer.push_back((char)byteOrder());
+}
+
+void SnapshotWriter::writeVarint(uint64_t value) {
+	while (value >= 0x80) {
+		_buffer.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	_buffer.push_back((char)value);
+}
+
+void SnapshotWriter::writeString(const std::string& value) {
+	writeVarint(value.size());
+	_buffer.append(value);
+}
+
+void SnapshotWriter::writeBytes(const void* data, size_t size) {
+	writeVarint(size);
+	_buffer.append((const char*)data, size);
+}
+
+void SnapshotWriter::writeRaw(const std::string& encoded) {
+	_buffer.append(encoded);
+}
+
+void SnapshotWriter::writeData(const Data& data) {
+	uint8_t flags = 0;
+	std::string atom = data.atom;
+	Data::Type type = data.type;
+
+#ifndef NO_XERCESC
+	// DOM nodes are written as their XML serialization, just as with JSON
+	if (atom.size() == 0 && data.node) {
+		std::ostringstream xmlSerSS;
+		xmlSerSS << *data.node;
+		atom = xmlSerSS.str();
+		type = Data::VERBATIM;
+	}
+#endif
+
+	if (atom.size() > 0)
+		flags |= SNAPSHOT_DATA_ATOM;
+	if (data.compound.size() > 0)
+		flags |= SNAPSHOT_DATA_COMPOUND;
+	if (data.array.size() > 0)
+		flags |= SNAPSHOT_DATA_ARRAY;
+	if (data.binary)
+		flags |= SNAPSHOT_DATA_BINARY;
+	if (type == Data::VERBATIM)
+		flags |= SNAPSHOT_DATA_VERBATIM;
+
+	_buffer.push_back((char)flags);
+
+	if (flags & SNAPSHOT_DATA_ATOM) {
+		writeString(atom);
+	}
+	if (flags & SNAPSHOT_DATA_COMPOUND) {
+		writeVarint(data.compound.size());
+		for (auto& entry : data.compound) {
+			writeString(entry.first);
+			writeData(entry.second);
+		}
+	}
+	if (flags & SNAPSHOT_DATA_ARRAY) {
+		writeVarint(data.array.size());
+		for (auto& entry : data.array) {
+			writeData(entry);
+		}
+	}
+	if (flags & SNAPSHOT_DATA_BINARY) {
+		writeString(data.binary.getMimeType());
+		writeBytes(data.binary.getData(), data.binary.getSize());
+	}
+}
+
+bool SnapshotReader::isSnapshot(const std::string& buffer) {
+	return buffer.size() >= SNAPSHOT_MAGIC_LEN && (memcmp(buffer.data(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) == 0 || isDelta(buffer));
+}
+
+bool SnapshotReader::isDelta(const std::string& buffer) {
+	return buffer.size() >= SNAPSHOT_MAGIC_LEN && memcmp(buffer.data(), SNAPSHOT_DELTA_MAGIC, SNAPSHOT_MAGIC_LEN) == 0;
+}
+
+bool SnapshotReader::readHeader() {
+	const char* header = readBytes(SNAPSHOT_MAGIC_LEN + 2);
+	bool isDelta = (memcmp(header, SNAPSHOT_DELTA_MAGIC, SNAPSHOT_MAGIC_LEN) == 0);
+	if (!isDelta && memcmp(header, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) != 0) {
+		ERROR_PLATFORM_THROW("Not a binary snapshot");
+	}
+	if ((uint8_t)header[SNAPSHOT_MAGIC_LEN] != version) {
+		ERROR_PLATFORM_THROW("Unsupported snapshot version " + toStr((int)header[SNAPSHOT_MAGIC_LEN]));
+	}
+	if ((uint8_t)header[SNAPSHOT_MAGIC_LEN + 1] != byteOrder()) {
+		ERROR_PLATFORM_THROW("Snapshot was written with a different byte order");
+	}
+	return isDelta;
+}
+
+uint64_t SnapshotReader::readVarint() {
+	uint64_t value = 0;
+	for (size_t shift = 0; shift < 64; shift += 7) {
+		if (_offset >= _size) {
+			ERROR_PLATFORM_THROW("Truncated snapshot");
+		}
+		uint8_t byte = (uint8_t)_data[_offset++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+	ERROR_PLATFORM_THROW("Malformed varint in snapshot");
+}
+
+const char* SnapshotReader::readBytes(size_t size) {
+	if (size > _size - _offset) {
+		ERROR_PLATFORM_THROW("Truncated snapshot");
+	}
+	const char* bytes = _data + _offset;
+	_offset += size;
+	return bytes;
+}
+
+std::string SnapshotReader::readString() {
+	size_t size = readVarint();
+	return std::string(readBytes(size), size);
+}
+
+Data SnapshotReader::readData(size_t depth) {
+	if (depth > maxDataDepth) {
+		ERROR_PLATFORM_THROW("Data in snapshot is nested too deeply");
+	}
+
+	Data data;
+	uint8_t flags = (uint8_t)*readBytes(1);
+
+	data.type = (flags & SNAPSHOT_DATA_VERBATIM ? Data::VERBATIM : Data::INTERPRETED);
+
+	if (flags & SNAPSHOT_DATA_ATOM) {
+		data.atom = readString();
+	}
+	if (flags & SNAPSHOT_DATA_COMPOUND) {
+		size_t size = readVarint();
+		for (size_t i = 0; i < size; i++) {
+			std::string key = readString();
+			data.compound[key] = readData(depth + 1);
+		}
+	}
+	if (flags & SNAPSHOT_DATA_ARRAY) {
+		size_t size = readVarint();
+		for (size_t i = 0; i < size; i++) {
+			data.array.push_back(readData(depth + 1));
+		}
+	}
+	if (flags & SNAPSHOT_DATA_BINARY) {
+		std::string mimeType = readString();
+		size_t size = readVarint();
+		data.binary = Blob(readBytes(size), size, mimeType);
+	}
+	return data;
+}
+
+std::string SnapshotReader::readDataBytes() {
+	size_t start = _offset;
+	skipData(0);
+	return std::string(_data + start, _offset - start);
+}
+
+void SnapshotReader::skipData(size_t depth) {
+	if (depth > maxDataDepth) {
+		ERROR_PLATFORM_THROW("Data in snapshot is nested too deeply");
+	}
+
+	uint8_t flags = (uint8_t)*readBytes(1);
+
+	if (flags & SNAPSHOT_DATA_ATOM) {
+		readBytes(readVarint());
+	}
+	if (flags & SNAPSHOT_DATA_COMPOUND) {
+		size_t size = readVarint();
+		for (size_t i = 0; i < size; i++) {
+			readBytes(readVarint());
+			skipData(depth + 1);
+		}
+	}
+	if (flags & SNAPSHOT_DATA_ARRAY) {
+		size_t size = readVarint();
+		for (size_t i = 0; i < size; i++) {
+			skipData(depth + 1);
+		}
+	}
+	if (flags & SNAPSHOT_DATA_BINARY) {
+		readBytes(readVarint());
+		readBytes(readVarint());
+	}
+}
+
+}
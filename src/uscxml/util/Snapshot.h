@@ -0,0 +1,118 @@
+/**
+ *  @file
+ *  @author     2017 Stefan Radomski (stefan.radomski@cs.tu-darmstadt.de)
+ *  @copyright  Simplified BSD
+ *
+ *  @cond
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the FreeBSD license as published by the FreeBSD
+ *  project.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ *  You should have received a copy of the FreeBSD license along with this
+ *  program. If not, see <http://www.opensource.org/licenses/bsd-license>.
+ *  @endcond
+ */
+
+#ifndef SNAPSHOT_H_4C9A1E37
+#define SNAPSHOT_H_4C9A1E37
+
+#include "uscxml/Common.h"
+#include "uscxml/messages/Data.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace uscxml {
+
+/**
+ * Encodings of a serialized interpreter.
+ */
+enum SnapshotFormat {
+	SNAPSHOT_JSON = 0,  ///< A JSON document, portable and human readable
+	SNAPSHOT_BINARY = 1 ///< The compact encoding of the SnapshotWriter
+};
+
+/**
+ * Appends values to a binary snapshot.
+ *
+ * A snapshot starts with a header of magic, version and byte order, the
+ * magic distinguishes complete snapshots from deltas. Values are written in
+ * sequence without any framing and have to be read back in the same order.
+ * Integers are LEB128 varints, strings and byte ranges are prefixed with
+ * their length.
+ */
+class USCXML_API SnapshotWriter {
+public:
+	SnapshotWriter(std::string& buffer) : _buffer(buffer) {}
+
+	void writeHeader(bool isDelta = false);
+	void writeVarint(uint64_t value);
+	void writeString(const std::string& value);
+	void writeBytes(const void* data, size_t size);
+	void writeData(const Data& data);
+	/// Append already encoded values without a length prefix
+	void writeRaw(const std::string& encoded);
+
+protected:
+	std::string& _buffer;
+};
+
+/**
+ * Reads values of a binary snapshot in the order they were written.
+ *
+ * All methods throw an error.platform event on truncated or malformed input.
+ */
+class USCXML_API SnapshotReader {
+public:
+	SnapshotReader(const std::string& buffer) : _data(buffer.data()), _size(buffer.size()), _offset(0) {}
+	SnapshotReader(const char* data, size_t size) : _data(data), _size(size), _offset(0) {}
+
+	/// Whether the buffer starts with the magic of a binary snapshot or delta
+	static bool isSnapshot(const std::string& buffer);
+	/// Whether the buffer starts with the magic of a delta
+	static bool isDelta(const std::string& buffer);
+
+	/// Read the header and return whether it is the one of a delta
+	bool readHeader();
+	uint64_t readVarint();
+	std::string readString();
+	/// A pointer into the buffer valid for its lifetime
+	const char* readBytes(size_t size);
+	/// Nested compounds and arrays deeper than maxDataDepth are rejected
+	Data readData() {
+		return readData(0);
+	}
+	/// The encoding of the next data value without decoding it
+	std::string readDataBytes();
+
+	bool atEnd() {
+		return _offset == _size;
+	}
+
+	/// Number of bytes not yet read
+	size_t remaining() {
+		return _size - _offset;
+	}
+
+	/// Incremented with every incompatible change of the encoding
+	static const uint8_t version = 2;
+
+	/// Bounds the recursion on untrusted input
+	static const size_t maxDataDepth = 512;
+
+protected:
+	Data readData(size_t depth);
+	void skipData(size_t depth);
+
+	const char* _data;
+	size_t _size;
+	size_t _offset;
+};
+
+}
+
+#endif /* end of include guard: SNAPSHOT_H_4C9A1E37 */
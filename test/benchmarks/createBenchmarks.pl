@@ -155,6 +155,21 @@ sub benchConflictTransNested {
 
 }
 
+### Transitions by Event ===========
+
+# the conflicting transitions with the i-th transition of each state taking event ei
+sub benchEventTrans {
+	my $where = shift;
+
+	benchConflictTrans($where);
+
+	foreach my $state (@{$$where->{'children'}[0]->{'children'}}) {
+		for (my $i = 0; $i < $size; $i++) {
+			$state->{'transitions'}[$i]->{'event'} = "e".$i;
+		}
+	}
+}
+
 
 sub writeState {
 	my $state = shift;
@@ -251,5 +266,12 @@ sub xmllint {
 		# print Dumper($machine);
 		writeMachine($machine, "Transitions.${size}.scxml");
 		xmllint("benchConflictTrans${size}.scxml");
+
+		# run with test-performance Events.${size}.scxml e0
+		$machine = {};
+		$stateId = 1;
+		benchEventTrans(\$machine);
+		writeMachine($machine, "Events.${size}.scxml");
+		xmllint("benchEventTrans${size}.scxml");
 	}
 }
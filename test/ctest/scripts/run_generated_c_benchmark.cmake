@@ -0,0 +1,48 @@
+# see test/CMakeLists.txt for passed variables
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTDIR})
+file(GLOB BENCHMARK_CHARTS ${PROJECT_SOURCE_DIR}/test/benchmarks/*.scxml)
+
+if (NOT BENCHMARK_STEPS)
+	set(BENCHMARK_STEPS 100000)
+endif ()
+
+# compiler flags per bitset variant of the generated step function
+set(BITSET_VARIANTS "bytewise" "word" "sse2" "avx2")
+set(BITSET_FLAGS_bytewise "-DUSCXML_BITSET_BYTEWISE")
+set(BITSET_FLAGS_word "")
+set(BITSET_FLAGS_sse2 "-DUSCXML_BITSET_SSE2" "-msse2")
+set(BITSET_FLAGS_avx2 "-DUSCXML_BITSET_AVX2" "-mavx2")
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E echo "\"Chart\", \"Bitset\", \"Word (bytes)\", \"States\", \"Transitions\", \"Steps/s\"")
+
+foreach(CHART ${BENCHMARK_CHARTS})
+	get_filename_component(CHART_FILE ${CHART} NAME)
+
+	execute_process(COMMAND ${USCXML_TRANSFORM_BIN} -tc -i ${CHART} -o ${OUTDIR}/${CHART_FILE}.machine.c RESULT_VARIABLE CMD_RESULT)
+	if (CMD_RESULT)
+		message(FATAL_ERROR "Error running ${USCXML_TRANSFORM_BIN}: ${CMD_RESULT}")
+	endif ()
+
+	foreach(VARIANT ${BITSET_VARIANTS})
+		set(BENCHMARK_BIN ${OUTDIR}/${CHART_FILE}.${VARIANT})
+		execute_process(
+			COMMAND ${CXX_BIN} -O2 -std=c++11 ${BITSET_FLAGS_${VARIANT}}
+				-o ${BENCHMARK_BIN}
+				-include ${OUTDIR}/${CHART_FILE}.machine.c
+				-DAUTOINCLUDE_TEST=ON
+				${BENCHMARK_DRIVER}
+			WORKING_DIRECTORY ${OUTDIR} RESULT_VARIABLE CMD_RESULT)
+		if (CMD_RESULT)
+			# e.g. no SSE2 / AVX2 on this platform
+			message(STATUS "Skipping ${VARIANT} bitsets for ${CHART_FILE}, could not compile")
+		else ()
+			execute_process(
+				COMMAND ${BENCHMARK_BIN} ${BENCHMARK_STEPS} "${CHART_FILE}, ${VARIANT}"
+				WORKING_DIRECTORY ${OUTDIR} RESULT_VARIABLE CMD_RESULT)
+			if (CMD_RESULT)
+				message(STATUS "Skipping ${VARIANT} bitsets for ${CHART_FILE}, could not run: ${CMD_RESULT}")
+			endif ()
+		endif ()
+	endforeach()
+endforeach()
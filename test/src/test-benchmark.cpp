@@ -0,0 +1,81 @@
+#include "uscxml/config.h"
+#include "uscxml/debug/Benchmark.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Overhead of a benchmark probe when disabled and enabled, with a single
+ * thread and with several threads passing the same probe.
+ *
+ * test-benchmark [iterations]
+ */
+
+size_t iterations = 10000000;
+
+static volatile size_t sink = 0;
+
+static void probed(size_t runs) {
+	for (size_t i = 0; i < runs; i++) {
+		USCXML_BENCHMARK("test-benchmark: probe");
+		sink = i;
+	}
+}
+
+static void unprobed(size_t runs) {
+	for (size_t i = 0; i < runs; i++) {
+		sink = i;
+	}
+}
+
+static double nsPerRun(void (*loop)(size_t), size_t runs, size_t nrThreads) {
+	system_clock::time_point start = system_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < nrThreads; i++)
+		threads.push_back(std::thread(loop, runs));
+	for (auto& thread : threads)
+		thread.join();
+	return (double)duration_cast<nanoseconds>(system_clock::now() - start).count() / runs;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		iterations = strTo<size_t>(argv[1]);
+
+	std::cout << "\"Threads\", \"No probe (ns)\", \"Disabled (ns)\", \"Enabled (ns)\"" << std::endl;
+
+	for (size_t nrThreads = 1; nrThreads <= 4; nrThreads *= 2) {
+		double none = nsPerRun(unprobed, iterations, nrThreads);
+
+		Benchmark::setEnabled(false);
+		double disabled = nsPerRun(probed, iterations, nrThreads);
+
+		Benchmark::setEnabled(true);
+		double enabled = nsPerRun(probed, iterations, nrThreads);
+
+		std::cout << nrThreads << ", " << none << ", " << disabled << ", " << enabled << std::endl;
+	}
+
+	// every sample from the enabled runs is accounted for, also from exited threads
+	Data stats = Benchmark::toData();
+	if (strTo<size_t>(stats["test-benchmark: probe"]["count"].atom) != 7 * iterations) {
+		std::cerr << "Samples were lost" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	Benchmark::report(std::cout);
+
+	Benchmark::reset();
+	if (Benchmark::toData().compound.size() != 0) {
+		std::cerr << "Samples survived a reset" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return EXIT_SUCCESS;
+}
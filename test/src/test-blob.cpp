@@ -0,0 +1,130 @@
+#include "uscxml/config.h"
+#include "uscxml/messages/Blob.h"
+#include "uscxml/util/URL.h"
+#include "uscxml/util/MD5.hpp"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Move a large file through Blobs: mapping it, slicing it and encoding it
+ * compared to copying it in memory.
+ *
+ * test-blob [megabytes]
+ */
+
+size_t megabytes = 100;
+
+static double mbPerSec(size_t bytes, system_clock::time_point start) {
+	double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	return ((double)bytes / (1024 * 1024)) / (ms / 1000);
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		megabytes = strTo<size_t>(argv[1]);
+
+	size_t size = megabytes * 1024 * 1024;
+	std::string path = URL::getTempDir(false) + PATH_SEPERATOR + "test-blob.bin";
+
+	char* content = (char*)malloc(size);
+	for (size_t i = 0; i < size; i++)
+		content[i] = (char)(i * 7 + i / 4096);
+	{
+		std::ofstream file(path.c_str(), std::ios::binary);
+		file.write(content, size);
+	}
+	std::string expected = md5(content, size);
+
+	std::cout << "\"Operation\", \"Throughput (MB/s)\"" << std::endl;
+
+	system_clock::time_point start = system_clock::now();
+	char* copy = (char*)malloc(size);
+	memcpy(copy, content, size);
+	std::cout << "memcpy, " << mbPerSec(size, start) << std::endl;
+	free(copy);
+
+	start = system_clock::now();
+	{
+		Blob blob(content, size);
+	}
+	std::cout << "Blob copy, " << mbPerSec(size, start) << std::endl;
+
+	start = system_clock::now();
+	{
+		std::ifstream file(path.c_str(), std::ios::binary);
+		std::string read((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		Blob blob(read.data(), read.size());
+		if (blob.md5() != expected) {
+			std::cerr << "read: digest differs" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	std::cout << "read file + md5, " << mbPerSec(size, start) << std::endl;
+
+	Blob mapped;
+	start = system_clock::now();
+	{
+		mapped = Blob::fromFile(path);
+		if (mapped.getSize() != size || mapped.md5() != expected) {
+			std::cerr << "fromFile: digest differs" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	std::cout << "fromFile + md5, " << mbPerSec(size, start) << std::endl;
+
+	start = system_clock::now();
+	{
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (md5(file) != expected) {
+			std::cerr << "stream: digest differs" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	std::cout << "md5 stream, " << mbPerSec(size, start) << std::endl;
+
+	// slices share the memory of the mapped file, also when mapped at an offset
+	{
+		size_t offset = size / 3 + 17;
+		Blob slice = mapped.slice(offset, 1000).slice(10);
+		Blob region = Blob::fromFile(path, "application/octet-stream", offset + 10, 990);
+		if (slice.getData() != mapped.getData() + offset + 10 || slice.getSize() != 990 ||
+		        memcmp(region.getData(), content + offset + 10, 990) != 0 ||
+		        memcmp(slice.getData(), content + offset + 10, 990) != 0) {
+			std::cerr << "slice: content differs" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	start = system_clock::now();
+	std::string encoded = mapped.base64();
+	std::cout << "base64, " << mbPerSec(size, start) << std::endl;
+
+	start = system_clock::now();
+	{
+		std::ofstream file((path + ".b64").c_str(), std::ios::binary);
+		mapped.base64(file);
+	}
+	std::cout << "base64 stream, " << mbPerSec(size, start) << std::endl;
+
+	start = system_clock::now();
+	Blob decoded = Blob::fromBase64(encoded);
+	std::cout << "fromBase64, " << mbPerSec(size, start) << std::endl;
+
+	if (decoded.md5() != expected) {
+		std::cerr << "base64: roundtrip differs" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	free(content);
+	remove((path + ".b64").c_str());
+	remove(path.c_str());
+	return EXIT_SUCCESS;
+}
@@ -63,6 +63,31 @@
 #  define USCXML_MAX_NR_TRANS_BYTES 1
 #endif 
 
+/**
+ *    USCXML_BITSET_AVX2 / USCXML_BITSET_SSE2 / USCXML_BITSET_BYTEWISE
+ *      Bitsets are combined 64 bits at a time with GCC, Clang and MSVC, define one
+ *      of these to use 256 or 128 bit vectors or to fall back to single bytes.
+ *      The bitsets in the types below are padded to whole words.
+ */
+
+#ifndef USCXML_BITSET_WORD_BYTES
+#  if defined(USCXML_BITSET_AVX2)
+#    include <immintrin.h>
+#    define USCXML_BITSET_WORD_BYTES 32
+#  elif defined(USCXML_BITSET_SSE2)
+#    include <emmintrin.h>
+#    define USCXML_BITSET_WORD_BYTES 16
+#  elif defined(USCXML_BITSET_BYTEWISE) || defined(USCXML_NO_STDTYPES_H) || !(defined(__GNUC__) || defined(_MSC_VER))
+#    define USCXML_BITSET_WORD_BYTES 1
+#  else
+#    define USCXML_BITSET_WORD_BYTES 8
+#  endif
+#endif
+
+#define USCXML_BITSET_BYTES(bytes) ((((bytes) + USCXML_BITSET_WORD_BYTES - 1) / USCXML_BITSET_WORD_BYTES) * USCXML_BITSET_WORD_BYTES)
+#define USCXML_STATES_BITSET_BYTES USCXML_BITSET_BYTES(USCXML_MAX_NR_STATES_BYTES)
+#define USCXML_TRANS_BITSET_BYTES  USCXML_BITSET_BYTES(USCXML_MAX_NR_TRANS_BYTES)
+
 /**
  *    USCXML_NUMBER_STATES / USCXML_NUMBER_TRANS
  *      Per default the number of states / transitions is retrieved from the machine
@@ -237,9 +262,9 @@ struct uscxml_state {
     const exec_content_t on_entry;                     /* on entry handlers      */
     const exec_content_t on_exit;                      /* on exit handlers       */
     const invoke_t invoke;                             /* invocations            */
-    const unsigned char children[USCXML_MAX_NR_STATES_BYTES];   /* all children           */
-    const unsigned char completion[USCXML_MAX_NR_STATES_BYTES]; /* default completion     */
-    const unsigned char ancestors[USCXML_MAX_NR_STATES_BYTES];  /* all ancestors          */
+    const unsigned char children[USCXML_STATES_BITSET_BYTES];   /* all children           */
+    const unsigned char completion[USCXML_STATES_BITSET_BYTES]; /* default completion     */
+    const unsigned char ancestors[USCXML_STATES_BITSET_BYTES];  /* all ancestors          */
     const uscxml_elem_data* data;                      /* data with late binding */
     const unsigned char type;                          /* One of USCXML_STATE_*  */
 };
@@ -249,14 +274,14 @@ struct uscxml_state {
  */
 struct uscxml_transition {
     const USCXML_NR_STATES_TYPE source;
-    const unsigned char target[USCXML_MAX_NR_STATES_BYTES];
+    const unsigned char target[USCXML_STATES_BITSET_BYTES];
     const char* event;
     const char* condition;
     const is_enabled_t is_enabled;
     const exec_content_t on_transition;
     const unsigned char type;
-    const unsigned char conflicts[USCXML_MAX_NR_TRANS_BYTES];
-    const unsigned char exit_set[USCXML_MAX_NR_STATES_BYTES];
+    const unsigned char conflicts[USCXML_TRANS_BITSET_BYTES];
+    const unsigned char exit_set[USCXML_STATES_BITSET_BYTES];
 };
 
 /**
@@ -336,10 +361,10 @@ struct uscxml_ctx {
     unsigned char         flags;
     const uscxml_machine* machine;
 
-    unsigned char config[USCXML_MAX_NR_STATES_BYTES]; /* Make sure these macros specify a sufficient size */
-    unsigned char history[USCXML_MAX_NR_STATES_BYTES];
-    unsigned char invocations[USCXML_MAX_NR_STATES_BYTES];
-    unsigned char initialized_data[USCXML_MAX_NR_STATES_BYTES];
+    unsigned char config[USCXML_STATES_BITSET_BYTES]; /* Make sure these macros specify a sufficient size */
+    unsigned char history[USCXML_STATES_BITSET_BYTES];
+    unsigned char invocations[USCXML_STATES_BITSET_BYTES];
+    unsigned char initialized_data[USCXML_STATES_BITSET_BYTES];
 
     void* user_data;
     void* event;
@@ -1086,12 +1111,47 @@ static void printBitsetIndices(const unsigned char* a, size_t length) {
 #endif
 
 #ifndef USCXML_NO_BIT_OPERATIONS
+/* One word of a bitset, bitsets are padded to a multiple of USCXML_BITSET_WORD_BYTES */
+#if USCXML_BITSET_WORD_BYTES == 32
+#  define BITWORD_LOAD(p)        _mm256_loadu_si256((const __m256i*)(p))
+#  define BITWORD_STORE(p, w)    _mm256_storeu_si256((__m256i*)(p), w)
+#  define BITWORD_OR(a, b)       _mm256_or_si256(a, b)
+#  define BITWORD_AND(a, b)      _mm256_and_si256(a, b)
+#  define BITWORD_AND_NOT(a, b)  _mm256_andnot_si256(b, a)
+#  define BITWORD_ZERO           _mm256_setzero_si256()
+#  define BITWORD_IS_ZERO(w)     _mm256_testz_si256(w, w)
+#elif USCXML_BITSET_WORD_BYTES == 16
+#  define BITWORD_LOAD(p)        _mm_loadu_si128((const __m128i*)(p))
+#  define BITWORD_STORE(p, w)    _mm_storeu_si128((__m128i*)(p), w)
+#  define BITWORD_OR(a, b)       _mm_or_si128(a, b)
+#  define BITWORD_AND(a, b)      _mm_and_si128(a, b)
+#  define BITWORD_AND_NOT(a, b)  _mm_andnot_si128(b, a)
+#  define BITWORD_ZERO           _mm_setzero_si128()
+#  define BITWORD_IS_ZERO(w)     (_mm_movemask_epi8(_mm_cmpeq_epi8(w, _mm_setzero_si128())) == 0xFFFF)
+#else
+#  if USCXML_BITSET_WORD_BYTES == 8 && defined(__GNUC__)
+typedef uint64_t __attribute__((__may_alias__, __aligned__(1))) uscxml_bitword;
+#  elif USCXML_BITSET_WORD_BYTES == 8
+typedef uint64_t uscxml_bitword;
+#  else
+typedef unsigned char uscxml_bitword;
+#  endif
+#  define BITWORD_LOAD(p)        (*(const uscxml_bitword*)(p))
+#  define BITWORD_STORE(p, w)    (*(uscxml_bitword*)(p) = (uscxml_bitword)(w))
+#  define BITWORD_OR(a, b)       ((a) | (b))
+#  define BITWORD_AND(a, b)      ((a) & (b))
+#  define BITWORD_AND_NOT(a, b)  ((a) & ~(b))
+#  define BITWORD_ZERO           0
+#  define BITWORD_IS_ZERO(w)     ((w) == 0)
+#endif
+
 /**
  * Return true if there is a common bit in a and b.
  */
 static int bit_has_and(const unsigned char* a, const unsigned char* b, size_t i) {
-    while(i--) {
-        if (a[i] & b[i])
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        if (!BITWORD_IS_ZERO(BITWORD_AND(BITWORD_LOAD(a + w), BITWORD_LOAD(b + w))))
             return 1;
     }
     return 0;
@@ -1102,8 +1162,9 @@ static int bit_has_and(const unsigned char* a, const unsigned char* b, size_t i)
  * but does not require string.h or cstring.
  */
 static void bit_clear_all(unsigned char* a, size_t i) {
-    while(i--) {
-        a[i] = 0;
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        BITWORD_STORE(a + w, BITWORD_ZERO);
     }
 }
 
@@ -1111,8 +1172,9 @@ static void bit_clear_all(unsigned char* a, size_t i) {
  * Return true if there is any bit set in a.
  */
 static int bit_has_any(unsigned const char* a, size_t i) {
-    while(i--) {
-        if (a[i] > 0)
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        if (!BITWORD_IS_ZERO(BITWORD_LOAD(a + w)))
             return 1;
     }
     return 0;
@@ -1122,8 +1184,9 @@ static int bit_has_any(unsigned const char* a, size_t i) {
  * Set all bits from given mask in dest, this is |= for bit arrays.
  */
 static void bit_or(unsigned char* dest, const unsigned char* mask, size_t i) {
-    while(i--) {
-        dest[i] |= mask[i];
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        BITWORD_STORE(dest + w, BITWORD_OR(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));
     }
 }
 
@@ -1132,8 +1195,9 @@ static void bit_or(unsigned char* dest, const unsigned char* mask, size_t i) {
  * but does not require string.h or cstring.
  */
 static void bit_copy(unsigned char* dest, const unsigned char* source, size_t i) {
-    while(i--) {
-        dest[i] = source[i];
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        BITWORD_STORE(dest + w, BITWORD_LOAD(source + w));
     }
 }
 
@@ -1141,8 +1205,9 @@ static void bit_copy(unsigned char* dest, const unsigned char* source, size_t i)
  * Unset bits from mask in dest.
  */
 static void bit_and_not(unsigned char* dest, const unsigned char* mask, size_t i) {
-    while(i--) {
-        dest[i] &= ~mask[i];
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        BITWORD_STORE(dest + w, BITWORD_AND_NOT(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));
     }
 }
 
@@ -1150,9 +1215,10 @@ static void bit_and_not(unsigned char* dest, const unsigned char* mask, size_t i
  * Set bits from mask in dest.
  */
 static void bit_and(unsigned char* dest, const unsigned char* mask, size_t i) {
-    while(i--) {
-        dest[i] &= mask[i];
-    };
+    size_t w;
+    for (w = 0; w < i; w += USCXML_BITSET_WORD_BYTES) {
+        BITWORD_STORE(dest + w, BITWORD_AND(BITWORD_LOAD(dest + w), BITWORD_LOAD(mask + w)));
+    }
 }
 
 #define USCXML_NO_BIT_OPERATIONS
@@ -1165,12 +1231,12 @@ int uscxml_step(uscxml_ctx* ctx) {
     USCXML_NR_STATES_TYPE nr_states_bytes = ((USCXML_NUMBER_STATES + 7) & ~7) >> 3;
     USCXML_NR_TRANS_TYPE  nr_trans_bytes  = ((USCXML_NUMBER_TRANS + 7) & ~7) >> 3;
     int err = USCXML_ERR_OK;
-    unsigned char conflicts  [USCXML_MAX_NR_TRANS_BYTES];
-    unsigned char trans_set  [USCXML_MAX_NR_TRANS_BYTES];
-    unsigned char target_set [USCXML_MAX_NR_STATES_BYTES];
-    unsigned char exit_set   [USCXML_MAX_NR_STATES_BYTES];
-    unsigned char entry_set  [USCXML_MAX_NR_STATES_BYTES];
-    unsigned char tmp_states [USCXML_MAX_NR_STATES_BYTES];
+    unsigned char conflicts  [USCXML_TRANS_BITSET_BYTES];
+    unsigned char trans_set  [USCXML_TRANS_BITSET_BYTES];
+    unsigned char target_set [USCXML_STATES_BITSET_BYTES];
+    unsigned char exit_set   [USCXML_STATES_BITSET_BYTES];
+    unsigned char entry_set  [USCXML_STATES_BITSET_BYTES];
+    unsigned char tmp_states [USCXML_STATES_BITSET_BYTES];
 
 #ifdef USCXML_VERBOSE
     printf("Config: ");
@@ -0,0 +1,187 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/interpreter/FastMicroStep.h"
+#include "uscxml/interpreter/LargeMicroStep.h"
+#include "uscxml/util/ChartIndex.h"
+#include "uscxml/util/Predicates.h"
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/Convenience.h"
+
+#include <xercesc/dom/DOM.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace uscxml;
+using namespace XERCESC_NS;
+using namespace std::chrono;
+
+/**
+ * Time to index and initialize the microsteppers for generated charts of
+ * about 1k, 10k and 100k states, compared to resolving state ids by
+ * searching the DOM.
+ *
+ * test-chart-index [maxDepth]
+ */
+
+size_t maxDepth = 5;
+
+// FastMicroStep keeps a transition conflict matrix, quadratic in transitions
+size_t maxFastStates = 20000;
+
+// searching the DOM for every target is quadratic in states
+size_t maxSearchStates = 20000;
+
+class TimedFastMicroStep : public FastMicroStep {
+public:
+	TimedFastMicroStep() : FastMicroStep(NULL) {}
+	using FastMicroStep::init;
+};
+
+class TimedLargeMicroStep : public LargeMicroStep {
+public:
+	TimedLargeMicroStep() : LargeMicroStep(NULL) {}
+	using LargeMicroStep::init;
+};
+
+static size_t nrStates(size_t depth, size_t fanOut) {
+	size_t states = 1;
+	size_t level = 1;
+	for (size_t i = 0; i < depth; i++) {
+		level *= fanOut;
+		states += level;
+	}
+	return states;
+}
+
+// a balanced tree with every seventh compound state parallel, histories in compound states and transitions into the whole chart
+static void writeState(std::ostream& stream, size_t& id, size_t depth, size_t fanOut, size_t total) {
+	size_t ownId = id++;
+	if (depth == 0) {
+		stream << "<state id=\"s" << ownId << "\">";
+		stream << "<transition event=\"e" << ownId % 13 << "\" target=\"s" << (ownId * 7919 + 13) % total << "\"/>";
+		stream << "</state>";
+		return;
+	}
+
+	bool parallel = (ownId % 7 == 3);
+	if (parallel) {
+		stream << "<parallel id=\"s" << ownId << "\">";
+	} else {
+		stream << "<state id=\"s" << ownId << "\" initial=\"s" << id << "\">";
+		stream << "<history id=\"h" << ownId << "\" type=\"" << (ownId % 2 ? "deep" : "shallow") << "\"/>";
+		stream << "<transition event=\"back\" target=\"h" << ownId << "\"/>";
+	}
+	for (size_t i = 0; i < fanOut; i++) {
+		writeState(stream, id, depth - 1, fanOut, total);
+	}
+	stream << (parallel ? "</parallel>" : "</state>");
+}
+
+static std::string generateChart(size_t depth, size_t fanOut) {
+	std::stringstream ss;
+	size_t id = 0;
+	ss << "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"null\">";
+	writeState(ss, id, depth, fanOut, nrStates(depth, fanOut));
+	ss << "</scxml>";
+	return ss.str();
+}
+
+static double msSince(system_clock::time_point start) {
+	return duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		maxDepth = strTo<size_t>(argv[1]);
+
+	std::cout << "\"States\", \"Transitions\", \"Index (ms)\", \"Search ids (ms)\", \"Indexed ids (ms)\", ";
+	std::cout << "\"Indexed domains (ms)\", \"FastMicroStep init (ms)\", \"LargeMicroStep init (ms)\"" << std::endl;
+
+	for (size_t depth = 3; depth <= maxDepth; depth++) {
+		Interpreter interpreter = Interpreter::fromXML(generateChart(depth, 10), "");
+		DOMElement* scxml = interpreter.getImpl()->getDocument()->getDocumentElement();
+
+		system_clock::time_point start = system_clock::now();
+		ChartIndex index(scxml);
+		double indexMs = msSince(start);
+
+		std::list<DOMElement*> transitions = DOMUtils::filterChildElements(XML_PREFIX(scxml).str() + "transition", scxml, true);
+		std::list<std::string> targetIds;
+		for (auto transition : transitions) {
+			std::list<std::string> targets = tokenize(ATTR(transition, kXMLCharTarget));
+			targetIds.splice(targetIds.end(), targets);
+		}
+
+		std::string searchMs = "-";
+		if (index.getStates().size() <= maxSearchStates) {
+			start = system_clock::now();
+			std::list<DOMElement*> searched;
+			for (auto& targetId : targetIds)
+				searched.push_back(getState(targetId, scxml));
+			searchMs = toStr(msSince(start));
+
+			if (searched != getStates(targetIds, index)) {
+				std::cerr << "Indexed states differ from the searched ones" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+
+			// the root variants search the DOM and have to agree with the index
+			size_t checked = 0;
+			for (auto t1 = transitions.begin(); t1 != transitions.end() && checked < 50; t1++, checked++) {
+				if (getTransitionDomain(*t1, scxml) != getTransitionDomain(*t1, index) ||
+				        getExitSet(*t1, scxml) != getExitSet(*t1, index)) {
+					std::cerr << "Indexed exit set differs from the searched one" << std::endl;
+					exit(EXIT_FAILURE);
+				}
+				size_t pairs = 0;
+				for (auto t2 = transitions.begin(); t2 != transitions.end() && pairs < 50; t2++, pairs++) {
+					if (conflicts(*t1, *t2, scxml) != conflicts(*t1, *t2, index)) {
+						std::cerr << "Indexed conflicts differ from the searched ones" << std::endl;
+						exit(EXIT_FAILURE);
+					}
+				}
+			}
+		}
+
+		start = system_clock::now();
+		std::list<DOMElement*> indexed = getStates(targetIds, index);
+		double indexedMs = msSince(start);
+
+		if (indexed.size() != targetIds.size()) {
+			std::cerr << "Indexed states are missing targets" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+
+		start = system_clock::now();
+		for (auto transition : transitions) {
+			DOMElement* source = (DOMElement*)transition->getParentNode();
+			DOMElement* domain = getTransitionDomain(transition, index);
+			if (domain == NULL || (domain != source && !index.isDescendant(source, domain))) {
+				std::cerr << "Transition domain does not contain its source" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+		double domainMs = msSince(start);
+
+		std::string fastMs = "-";
+		if (index.getStates().size() <= maxFastStates) {
+			start = system_clock::now();
+			TimedFastMicroStep fast;
+			fast.init(scxml);
+			fastMs = toStr(msSince(start));
+		}
+
+		start = system_clock::now();
+		TimedLargeMicroStep large;
+		large.init(scxml);
+		double largeMs = msSince(start);
+
+		std::cout << index.getStates().size() << ", " << transitions.size() << ", " << indexMs << ", ";
+		std::cout << searchMs << ", " << indexedMs << ", " << domainMs << ", " << fastMs << ", " << largeMs << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
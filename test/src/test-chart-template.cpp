@@ -0,0 +1,94 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/ChartTemplate.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Compare startup time and resident memory per session when instantiating
+ * many sessions of the same document with and without a ChartTemplate. All
+ * sessions are run to completion afterwards and have to end in a pass state.
+ *
+ * test-chart-template <url> [sessions]
+ */
+
+static long rssKB() {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, 6, "VmRSS:") == 0)
+			return strTo<long>(line.substr(6, line.length() - 9));
+	}
+	return 0;
+}
+
+static bool measure(const std::string& name, const std::string& url, size_t nrSessions, bool useTemplate) {
+	std::vector<Interpreter> interpreters;
+	interpreters.reserve(nrSessions);
+
+	long rssBefore = rssKB();
+	system_clock::time_point start = system_clock::now();
+
+	std::shared_ptr<ChartTemplate> chartTemplate;
+	if (useTemplate)
+		chartTemplate = ChartTemplate::fromURL(url);
+
+	for (size_t i = 0; i < nrSessions; i++) {
+		Interpreter interpreter = (useTemplate ? Interpreter::fromTemplate(chartTemplate) : Interpreter::fromURL(url));
+		interpreter.step(0); // initialize
+		interpreters.push_back(interpreter);
+	}
+
+	long elapsedUs = duration_cast<microseconds>(system_clock::now() - start).count();
+	long rssAfter = rssKB();
+
+	std::cout << name << ": " << (double)elapsedUs / nrSessions << "us and ";
+	std::cout << (double)(rssAfter - rssBefore) / nrSessions << "KB per session";
+	if (useTemplate)
+		std::cout << (chartTemplate->isShared() ? " (shared)" : " (not shared)");
+	std::cout << std::endl;
+
+	// sessions sharing a DOM must not interfere
+	size_t nrPassed = 0;
+	for (auto& interpreter : interpreters) {
+		InterpreterState state = USCXML_UNDEF;
+		while(state != USCXML_IDLE && state != USCXML_FINISHED) {
+			state = interpreter.step(0);
+		}
+		if (interpreter.isInState("pass"))
+			nrPassed++;
+	}
+	if (nrPassed != nrSessions) {
+		std::cerr << name << ": only " << nrPassed << " of " << nrSessions << " sessions passed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cout << "Expected filename as first parameter" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	size_t nrSessions = (argc > 2 ? strTo<size_t>(argv[2]) : 1000);
+
+	// element children of data and content are handed to the datamodels as DOM nodes
+	std::shared_ptr<ChartTemplate> plain = ChartTemplate::fromXML("<scxml datamodel=\"null\"><final id=\"pass\"/></scxml>", "");
+	std::shared_ptr<ChartTemplate> withNodes = ChartTemplate::fromXML("<scxml datamodel=\"null\"><datamodel><data id=\"d\"><node/></data></datamodel><final id=\"pass\"/></scxml>", "");
+	if (!plain->isShared() || withNodes->isShared()) {
+		std::cerr << "Templates with XML in their data must not be shared" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (!measure("fromURL", argv[1], nrSessions, false) || !measure("fromTemplate", argv[1], nrSessions, true))
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/interpreter/InterpreterMonitor.h"
+#include "uscxml/interpreter/CompiledContentExecutor.h"
+#include "uscxml/plugins/Factory.h"
+#include "uscxml/util/DOM.h"
+#include "uscxml/util/String.h"
+#include "uscxml/server/HTTPServer.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include "XGetopt.h"
+#include "XGetopt.cpp"
+#else
+#include <getopt.h>
+#endif
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Compare the BasicContentExecutor with the CompiledContentExecutor.
+ *
+ * Without documents, a few charts exercising the executable content are run
+ * with both executors and the events they process and the monitor callbacks
+ * for their executable content have to be the same. With documents, e.g. the
+ * W3C tests, both have to agree on passing them and their times are printed.
+ *
+ * test-content-executor [-n iterations] [-s max steps] [file.scxml ...]
+ */
+
+size_t iterations = 100;
+size_t maxSteps = 10000;
+
+static void useCompiled(Interpreter& interpreter) {
+	ActionLanguage al;
+	al.execContent = ContentExecutor(std::shared_ptr<ContentExecutorImpl>(new CompiledContentExecutor(interpreter.getImpl().get())));
+	interpreter.setActionLanguage(al);
+}
+
+double run(const std::string& documentURI, bool compiled, bool& passed) {
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		Interpreter interpreter = Interpreter::fromURL(documentURI);
+		if (compiled)
+			useCompiled(interpreter);
+
+		InterpreterState state = InterpreterState::USCXML_UNDEF;
+		size_t steps = 0;
+		while(state != USCXML_FINISHED && steps++ < maxSteps) {
+			state = interpreter.step();
+		}
+		passed = interpreter.isInState("pass");
+	}
+	return duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+}
+
+/**
+ * Records the events processed and the executable content entered and left.
+ */
+class TraceMonitor : public InterpreterMonitor {
+public:
+	virtual uint32_t getCallbacks() {
+		return MonitorCallback::beforeProcessingEvent |
+		       MonitorCallback::beforeExecutingContent |
+		       MonitorCallback::afterExecutingContent;
+	}
+
+	virtual void beforeProcessingEvent(const std::string& sessionId, const Event& event) {
+		std::stringstream ss;
+		ss << "event " << event.name;
+		// the messages of errors are up to the datamodel
+		if (event.name.compare(0, 6, "error.") != 0 && !event.data.empty())
+			ss << " " << event.data.asJSON();
+		trace.push_back(ss.str());
+	}
+
+	virtual void beforeExecutingContent(const std::string& sessionId, const XERCESC_NS::DOMElement* execContent) {
+		trace.push_back("enter " + DOMUtils::xPathForNode(execContent));
+	}
+
+	virtual void afterExecutingContent(const std::string& sessionId, const XERCESC_NS::DOMElement* execContent) {
+		trace.push_back("exit " + DOMUtils::xPathForNode(execContent));
+	}
+
+	std::list<std::string> trace;
+};
+
+static std::list<std::string> trace(const std::string& xml, bool compiled) {
+	Interpreter interpreter = Interpreter::fromXML(xml, "");
+	if (compiled)
+		useCompiled(interpreter);
+
+	TraceMonitor monitor;
+	interpreter.addMonitor(&monitor);
+
+	InterpreterState state = InterpreterState::USCXML_UNDEF;
+	size_t steps = 0;
+	while(state != USCXML_FINISHED && steps++ < maxSteps) {
+		state = interpreter.step(0);
+	}
+	interpreter.removeMonitor(&monitor);
+
+	monitor.trace.push_back(interpreter.isInState("pass") ? "pass" : "fail");
+	return monitor.trace;
+}
+
+static bool compare(const std::string& name, const std::string& xml) {
+	std::list<std::string> basic = trace(xml, false);
+	std::list<std::string> compiled = trace(xml, true);
+
+	if (basic.back() != "pass") {
+		std::cerr << name << ": basic executor did not pass" << std::endl;
+		return false;
+	}
+
+	if (basic != compiled) {
+		std::cerr << name << ": executors disagree" << std::endl;
+		auto basicIter = basic.begin();
+		auto compiledIter = compiled.begin();
+		while (basicIter != basic.end() || compiledIter != compiled.end()) {
+			std::string b = (basicIter != basic.end() ? *basicIter++ : "");
+			std::string c = (compiledIter != compiled.end() ? *compiledIter++ : "");
+			std::cerr << (b == c ? "  " : "! ") << b << " | " << c << std::endl;
+		}
+		return false;
+	}
+
+	std::cout << name << ": " << basic.size() << " trace entries agree" << std::endl;
+	return true;
+}
+
+static const char* branches =
+    "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"ecmascript\">"
+    "  <datamodel><data id=\"x\" expr=\"0\"/></datamodel>"
+    "  <state id=\"s0\">"
+    "    <onentry><raise event=\"check\"/><raise event=\"check\"/><raise event=\"check\"/><raise event=\"done\"/></onentry>"
+    "    <transition event=\"check\">"
+    "      <if cond=\"x == 0\"><raise event=\"if\"/>"
+    "      <elseif cond=\"x == 1\"/><raise event=\"elseif\"/><raise event=\"elseif.second\"/>"
+    "      <else/><raise event=\"else\"/>"
+    "        <if cond=\"x &gt; 1\"><raise event=\"nested\"/><else/><raise event=\"unreachable\"/></if>"
+    "      </if>"
+    "      <assign location=\"x\" expr=\"x + 1\"/>"
+    "    </transition>"
+    "    <transition event=\"unreachable\" target=\"fail\"/>"
+    "    <transition event=\"done\" cond=\"x == 3\" target=\"pass\"/>"
+    "    <transition event=\"done\" target=\"fail\"/>"
+    "  </state>"
+    "  <final id=\"pass\"/><final id=\"fail\"/>"
+    "</scxml>";
+
+static const char* loops =
+    "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"ecmascript\">"
+    "  <datamodel>"
+    "    <data id=\"items\" expr=\"[1, 2, 3]\"/><data id=\"sum\" expr=\"0\"/><data id=\"count\" expr=\"0\"/>"
+    "  </datamodel>"
+    "  <state id=\"s0\">"
+    "    <onentry>"
+    "      <foreach item=\"item\" index=\"i\" array=\"items\">"
+    "        <assign location=\"sum\" expr=\"sum + item * (i + 1)\"/>"
+    "        <if cond=\"item == 2\"><raise event=\"two\"/></if>"
+    "        <foreach item=\"inner\" array=\"items\"><assign location=\"count\" expr=\"count + 1\"/></foreach>"
+    "      </foreach>"
+    "      <foreach item=\"item\" array=\"[]\"><raise event=\"unreachable\"/></foreach>"
+    "      <send event=\"result\" target=\"#_internal\"><param name=\"sum\" expr=\"sum\"/><param name=\"count\" expr=\"count\"/></send>"
+    "    </onentry>"
+    "    <transition event=\"unreachable\" target=\"fail\"/>"
+    "    <transition event=\"result\" cond=\"sum == 14 &amp;&amp; count == 9\" target=\"pass\"/>"
+    "    <transition event=\"result\" target=\"fail\"/>"
+    "  </state>"
+    "  <final id=\"pass\"/><final id=\"fail\"/>"
+    "</scxml>";
+
+// an error ends its block, a failing condition is false and an illegal array ends the foreach, errors are queued behind the raised events
+static const char* errors =
+    "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"ecmascript\">"
+    "  <datamodel><data id=\"errors\" expr=\"0\"/><data id=\"x\" expr=\"0\"/></datamodel>"
+    "  <state id=\"s0\">"
+    "    <onentry>"
+    "      <raise event=\"assign\"/><raise event=\"cond\"/><raise event=\"array\"/><raise event=\"body\"/>"
+    "    </onentry>"
+    "    <transition event=\"assign\"><assign location=\"undefined.field\" expr=\"1\"/><raise event=\"unreachable\"/></transition>"
+    "    <transition event=\"cond\">"
+    "      <if cond=\"undefined.field\"><raise event=\"unreachable\"/><else/><raise event=\"else\"/></if>"
+    "    </transition>"
+    "    <transition event=\"array\">"
+    "      <foreach item=\"item\" array=\"undefined.field\"><raise event=\"unreachable\"/></foreach>"
+    "      <raise event=\"unreachable\"/>"
+    "    </transition>"
+    "    <transition event=\"body\">"
+    "      <foreach item=\"item\" array=\"[1, 2, 3]\">"
+    "        <assign location=\"x\" expr=\"item\"/>"
+    "        <if cond=\"item == 2\"><assign location=\"undefined.field\" expr=\"1\"/></if>"
+    "      </foreach>"
+    "      <raise event=\"unreachable\"/>"
+    "    </transition>"
+    "    <transition event=\"error.execution\">"
+    "      <assign location=\"errors\" expr=\"errors + 1\"/>"
+    "      <if cond=\"errors == 4\"><raise event=\"done\"/></if>"
+    "    </transition>"
+    "    <transition event=\"unreachable\" target=\"fail\"/>"
+    "    <transition event=\"done\" cond=\"errors == 4 &amp;&amp; x == 2\" target=\"pass\"/>"
+    "    <transition event=\"done\" target=\"fail\"/>"
+    "  </state>"
+    "  <final id=\"pass\"/><final id=\"fail\"/>"
+    "</scxml>";
+
+int main(int argc, char** argv) {
+	int option;
+	while ((option = getopt(argc, argv, "n:s:")) != -1) {
+		switch(option) {
+		case 'n':
+			iterations = strTo<size_t>(optarg);
+			break;
+		case 's':
+			maxSteps = strTo<size_t>(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (optind >= argc) {
+		if (!Factory::getInstance()->hasDataModel("ecmascript")) {
+			std::cout << "No ecmascript datamodel to compare the executors with" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		bool agree = true;
+		agree &= compare("if/elseif/else", branches);
+		agree &= compare("foreach", loops);
+		agree &= compare("errors", errors);
+		return (agree ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	HTTPServer::getInstance(7080, 7443);
+
+	double basicTotal = 0;
+	double compiledTotal = 0;
+	bool agree = true;
+
+	std::cout << "\"Document\", \"Basic (ms)\", \"Compiled (ms)\", \"Speedup\"" << std::endl;
+	for (int i = optind; i < argc; i++) {
+		try {
+			bool basicPassed = false;
+			bool compiledPassed = false;
+			double basicMs = run(argv[i], false, basicPassed);
+			double compiledMs = run(argv[i], true, compiledPassed);
+
+			if (basicPassed != compiledPassed) {
+				std::cerr << argv[i] << ": executors disagree" << std::endl;
+				agree = false;
+			}
+
+			basicTotal += basicMs;
+			compiledTotal += compiledMs;
+			std::cout << "\"" << argv[i] << "\", " << basicMs << ", " << compiledMs << ", " << basicMs / compiledMs << std::endl;
+		} catch (Event e) {
+			std::cerr << argv[i] << ": " << e << std::endl;
+		}
+	}
+	std::cout << "\"Total\", " << basicTotal << ", " << compiledTotal << ", " << basicTotal / compiledTotal << std::endl;
+
+	return (agree ? EXIT_SUCCESS : EXIT_FAILURE);
+}
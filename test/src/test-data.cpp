@@ -0,0 +1,154 @@
+#include "uscxml/config.h"
+#include "uscxml/messages/Data.h"
+#include "uscxml/util/String.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Memory per value and conversion throughput of Data for typical JSON
+ * payloads and the cost of indexed array access.
+ *
+ * test-data [iterations]
+ */
+
+// count the bytes allocated by everything in this process
+static std::atomic<size_t> allocated(0);
+
+// size header in front of every allocation, keeps the default alignment
+#define ALLOC_HEADER 16
+
+void* operator new(size_t size) {
+	char* ptr = (char*)malloc(size + ALLOC_HEADER);
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	*(size_t*)ptr = size;
+	allocated += size;
+	return ptr + ALLOC_HEADER;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr == NULL)
+		return;
+	char* header = (char*)ptr - ALLOC_HEADER;
+	allocated -= *(size_t*)header;
+	free(header);
+}
+
+size_t iterations = 1000;
+
+static size_t countValues(const Data& data) {
+	size_t values = 1;
+	for (auto& item : data.compound)
+		values += countValues(item.second);
+	for (auto& item : data.array)
+		values += countValues(item);
+	return values;
+}
+
+static void measure(const std::string& name, const std::string& json) {
+	size_t before = allocated;
+	Data* data = new Data(Data::fromJSON(json));
+	size_t bytes = allocated - before;
+	size_t values = countValues(*data);
+
+	if (Data::fromJSON(Data::toJSON(*data)) != *data) {
+		std::cerr << name << ": JSON round trip differs" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		Data parsed = Data::fromJSON(json);
+	}
+	double parseMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		std::string written = Data::toJSON(*data);
+	}
+	double writeMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		Data copy = *data;
+		if (copy != *data) {
+			std::cerr << name << ": copy differs" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	double copyMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	double mb = (double)(json.size() * iterations) / (1024 * 1024);
+	std::cout << name << ", " << json.size() << ", " << values << ", ";
+	std::cout << (double)bytes / values << ", ";
+	std::cout << mb / (parseMs / 1000) << ", " << mb / (writeMs / 1000) << ", ";
+	std::cout << (iterations / (copyMs / 1000)) << std::endl;
+
+	delete data;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		iterations = strTo<size_t>(argv[1]);
+
+	std::cout << "sizeof(Data): " << sizeof(Data) << " bytes" << std::endl;
+	std::cout << "\"Payload\", \"JSON (bytes)\", \"Values\", \"Heap per value (bytes)\", \"fromJSON (MB/s)\", \"toJSON (MB/s)\", \"Copy+compare (1/s)\"" << std::endl;
+
+	// a typical event
+	measure("event", "{\"name\": \"sensor.update\", \"sendid\": \"s123\", \"origin\": \"#_scxml_4711\", "
+	        "\"data\": {\"id\": 17, \"value\": 21.5, \"unit\": \"celsius\", \"valid\": true}}");
+
+	// an array of numbers
+	{
+		std::string json = "[";
+		for (size_t i = 0; i < 1000; i++)
+			json += (i > 0 ? ", " : "") + toStr(i);
+		json += "]";
+		measure("numbers", json);
+	}
+
+	// an array of records as in the snapshot of a datamodel
+	{
+		std::string json = "[";
+		for (size_t i = 0; i < 1000; i++) {
+			json += (i > 0 ? ", " : "");
+			json += "{\"id\": \"data" + toStr(i) + "\", \"value\": " + toStr(i) + ", \"tags\": [\"a\", \"b\", \"c\"]}";
+		}
+		json += "]";
+		measure("records", json);
+	}
+
+	// indexed access into arrays
+	{
+		Data data;
+		for (size_t i = 0; i < 10000; i++)
+			data.array.push_back(Data(i));
+
+		for (size_t i = 0; i < data.array.size(); i += 97) {
+			if (data.item(i).atom != toStr(i) || data[i].atom != toStr(i)) {
+				std::cerr << "Indexed access returned the wrong item" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		system_clock::time_point start = system_clock::now();
+		size_t sum = 0;
+		for (size_t j = 0; j < iterations; j++) {
+			for (size_t i = 0; i < data.array.size(); i += 97) {
+				sum += data.item(i).atom.size();
+				sum += data[i].atom.size();
+			}
+		}
+		double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+		std::cout << "Indexed access: " << (ms * 1000 * 1000) / (iterations * 2 * (10000 / 97 + 1)) << "ns per access (" << sum << ")" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
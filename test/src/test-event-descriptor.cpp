@@ -0,0 +1,126 @@
+#include "uscxml/config.h"
+#include "uscxml/util/String.h"
+#include "uscxml/util/EventDescriptor.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Compare matches per second of nameMatch, compiled event descriptors and
+ * compiled descriptors with interned event names.
+ *
+ * test-event-descriptor [iterations]
+ */
+
+int main(int argc, char** argv) {
+	size_t iterations = (argc > 1 ? strTo<size_t>(argv[1]) : 1000000);
+
+	// typical transition event attributes
+	std::vector<std::string> descs = {
+		"foo",
+		"foo.bar",
+		"error.execution error.communication",
+		"done.state.s1 done.state.s2",
+		"done.invoke.*",
+		"event1 event2 event3 event4",
+		"*",
+		"quit.",
+	};
+
+	// typical event names
+	std::vector<std::string> names = {
+		"foo",
+		"foo.bar.baz",
+		"error.execution",
+		"done.state.s2",
+		"done.invoke.0815",
+		"event4",
+		"unknown.event",
+		"QUIT",
+	};
+
+	// interning is idempotent and names interned before a descriptor still match it
+	std::vector<uint32_t> nameIds;
+	for (auto& name : names) {
+		uint32_t nameId = EventName::intern(name);
+		if (nameId == 0 || EventName::intern(name) != nameId || EventName::lookup(name) != nameId ||
+		        EventName::forId(nameId).str() != name || EventName::forId(nameId).getId() != nameId) {
+			std::cerr << "'" << name << "' was not interned" << std::endl;
+			return EXIT_FAILURE;
+		}
+		nameIds.push_back(nameId);
+	}
+	if (EventName::lookup("never.interned") != 0) {
+		std::cerr << "Lookup interned a name" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// all have to agree
+	for (auto& desc : descs) {
+		EventDescriptor eventDesc(desc);
+		for (size_t i = 0; i < names.size(); i++) {
+			bool expected = nameMatch(desc, names[i]);
+			if (expected != eventDesc.matches(names[i]) || expected != eventDesc.matches(EventName::forId(nameIds[i]))) {
+				std::cerr << "'" << desc << "' and '" << names[i] << "' disagree" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	size_t nrMatches = iterations * descs.size() * names.size();
+	size_t matched = 0;
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		for (auto& name : names) {
+			for (auto& desc : descs) {
+				if (nameMatch(desc, name))
+					matched++;
+			}
+		}
+	}
+	double stringMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	std::cout << "nameMatch:       " << (size_t)(nrMatches / (stringMs / 1000)) << " matches/s (" << matched << " matched)" << std::endl;
+
+	// descriptors are compiled with the chart, event names once per event
+	std::vector<EventDescriptor> eventDescs;
+	for (auto& desc : descs)
+		eventDescs.push_back(EventDescriptor(desc));
+
+	matched = 0;
+	start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		for (auto& name : names) {
+			EventName eventName(name);
+			for (auto& eventDesc : eventDescs) {
+				if (eventDesc.matches(eventName))
+					matched++;
+			}
+		}
+	}
+	double compiledMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	std::cout << "EventDescriptor: " << (size_t)(nrMatches / (compiledMs / 1000)) << " matches/s (" << matched << " matched)" << std::endl;
+
+	// events carry the id of their name, interned with the chart
+	matched = 0;
+	start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		for (auto nameId : nameIds) {
+			const EventName& eventName = EventName::forId(nameId);
+			for (auto& eventDesc : eventDescs) {
+				if (eventDesc.matches(eventName))
+					matched++;
+			}
+		}
+	}
+	double internedMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	std::cout << "Interned names:  " << (size_t)(nrMatches / (internedMs / 1000)) << " matches/s (" << matched << " matched)" << std::endl;
+	std::cout << "Speedup: " << stringMs / compiledMs << "x, interned " << stringMs / internedMs << "x" << std::endl;
+
+	return EXIT_SUCCESS;
+}
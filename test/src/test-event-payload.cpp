@@ -0,0 +1,130 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/plugins/Factory.h"
+#include "uscxml/util/String.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Throughput of events with a 10KB payload per datamodel, once with guards
+ * only reading _event.name and once with guards reading _event.data. Before,
+ * the fields converted only when read are checked for their values and that
+ * changes by scripts persist.
+ *
+ * test-event-payload [events per run]
+ */
+
+size_t nrEvents = 10000;
+
+static double run(const std::string& dataModel, const std::string& cond, const Data& payload) {
+	std::string xml =
+	    "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"" + dataModel + "\">"
+	    "  <state id=\"s0\">"
+	    "    <transition event=\"tick\" cond=\"" + cond + "\" target=\"s1\" />"
+	    "  </state>"
+	    "  <state id=\"s1\">"
+	    "    <transition event=\"tick\" cond=\"" + cond + "\" target=\"s0\" />"
+	    "  </state>"
+	    "</scxml>";
+
+	Interpreter interpreter = Interpreter::fromXML(xml, "");
+	interpreter.step(0); // initialize
+
+	Event event("tick");
+	event.data = payload;
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < nrEvents; i++) {
+		interpreter.receive(event);
+		while(interpreter.step(0) != USCXML_IDLE) {}
+	}
+	double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	if (!interpreter.isInState(nrEvents % 2 == 0 ? "s0" : "s1")) {
+		std::cerr << dataModel << ": guard '" << cond << "' did not hold" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return nrEvents / (ms / 1000);
+}
+
+static void check(const std::string& dataModel,
+                  const std::string& guard,
+                  const std::string& change,
+                  const std::string& changed,
+                  const std::string& copied) {
+	std::string xml =
+	    "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" datamodel=\"" + dataModel + "\">"
+	    "  <state id=\"s0\">"
+	    "    <transition event=\"check\" cond=\"" + guard + "\" target=\"s1\">"
+	    "      <script>" + change + "</script>"
+	    "      <if cond=\"" + changed + "\">"
+	    "        <send event=\"copy\" target=\"#_internal\"><param name=\"copy\" expr=\"_event\"/></send>"
+	    "      </if>"
+	    "    </transition>"
+	    "    <transition event=\"*\" target=\"fail\"/>"
+	    "  </state>"
+	    "  <state id=\"s1\">"
+	    "    <transition event=\"copy\" cond=\"" + copied + "\" target=\"pass\"/>"
+	    "    <transition event=\"*\" target=\"fail\"/>"
+	    "  </state>"
+	    "  <final id=\"pass\"/>"
+	    "  <final id=\"fail\"/>"
+	    "</scxml>";
+
+	Interpreter interpreter = Interpreter::fromXML(xml, "");
+	interpreter.step(0); // initialize
+
+	Event event("check", Event::EXTERNAL);
+	event.data.compound["a"] = Data("one", Data::VERBATIM);
+	interpreter.receive(event);
+	InterpreterState state = USCXML_UNDEF;
+	while(state != USCXML_IDLE && state != USCXML_FINISHED) {
+		state = interpreter.step(0);
+	}
+
+	if (!interpreter.isInState("pass")) {
+		std::cerr << dataModel << ": _event fields did not read as expected" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		nrEvents = strTo<size_t>(argv[1]);
+
+	// 100 fields with 100 bytes each
+	Data payload;
+	for (size_t i = 0; i < 100; i++) {
+		payload.compound["field" + toStr(i)] = Data(std::string(100, 'x'), Data::VERBATIM);
+	}
+
+	std::cout << "\"Datamodel\", \"_event.name (events/s)\", \"_event.data (events/s)\"" << std::endl;
+
+	if (Factory::getInstance()->hasDataModel("lua")) {
+		check("lua",
+		      "_event.name == 'check' and _event.type == 'external' and _event.data.a == 'one' and _event.invokeid == nil",
+		      "_event.data.a = 'two'",
+		      "_event.data.a == 'two'",
+		      "_event.data.copy.data.a == 'two'");
+		double name = run("lua", "_event.name == 'tick'", payload);
+		double data = run("lua", "_event.data.field0 ~= nil", payload);
+		std::cout << "lua, " << (size_t)name << ", " << (size_t)data << std::endl;
+	}
+
+	if (Factory::getInstance()->hasDataModel("ecmascript")) {
+		check("ecmascript",
+		      "_event.name == 'check' &amp;&amp; _event.type == 'external' &amp;&amp; _event.data.a == 'one' &amp;&amp; _event.invokeid === undefined",
+		      "_event.data.a = 'two';",
+		      "_event.data.a == 'two'",
+		      "_event.data.copy.data.a == 'two'");
+		double name = run("ecmascript", "_event.name == 'tick'", payload);
+		double data = run("ecmascript", "_event.data.field0 != undefined", payload);
+		std::cout << "ecmascript, " << (size_t)name << ", " << (size_t)data << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
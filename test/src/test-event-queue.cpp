@@ -0,0 +1,142 @@
+#include "uscxml/config.h"
+#include "uscxml/interpreter/BasicEventQueue.h"
+#include "uscxml/interpreter/LockFreeEventQueue.h"
+#include "uscxml/util/String.h"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Contention benchmark of the external event queues with one consumer and
+ * 1 to 64 producers and throughput of bursts injected one by one or as a
+ * batch.
+ *
+ * test-event-queue [events per run]
+ */
+
+size_t nrEvents = 1000000;
+
+double run(std::shared_ptr<EventQueueImpl> queue, size_t nrProducers) {
+	Event event("foo.bar");
+	size_t perProducer = nrEvents / nrProducers;
+
+	system_clock::time_point start = system_clock::now();
+
+	std::vector<std::thread> producers;
+	for (size_t i = 0; i < nrProducers; i++) {
+		producers.push_back(std::thread([queue, perProducer, &event] {
+			for (size_t j = 0; j < perProducer; j++) {
+				queue->enqueue(event);
+			}
+		}));
+	}
+
+	size_t received = 0;
+	while (received < perProducer * nrProducers) {
+		Event dequeued = queue->dequeue(std::numeric_limits<size_t>::max());
+		if (dequeued.name != event.name) {
+			std::cerr << "Dequeued unexpected event '" << dequeued.name << "'" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		received++;
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	return received / (ms / 1000);
+}
+
+double runBursts(std::shared_ptr<EventQueueImpl> queue, size_t burstSize, bool batched) {
+	std::list<Event> burst;
+	std::vector<std::string> names;
+	for (size_t i = 0; i < burstSize; i++) {
+		names.push_back("sensor." + toStr(i));
+		burst.push_back(Event(names.back()));
+	}
+	size_t nrBursts = (nrEvents / burstSize > 0 ? nrEvents / burstSize : 1);
+
+	system_clock::time_point start = system_clock::now();
+
+	std::thread producer([queue, nrBursts, batched, &burst] {
+		for (size_t i = 0; i < nrBursts; i++) {
+			if (batched) {
+				queue->enqueueBatch(burst);
+			} else {
+				for (auto& event : burst)
+					queue->enqueue(event);
+			}
+		}
+	});
+
+	// events of a burst arrive in order and are never interleaved with another burst
+	size_t received = 0;
+	std::list<Event> events;
+	while (received < nrBursts * burstSize) {
+		if (batched) {
+			queue->dequeueBatch(events, 64, std::numeric_limits<size_t>::max());
+		} else {
+			events.push_back(queue->dequeue(std::numeric_limits<size_t>::max()));
+		}
+		for (auto& event : events) {
+			if (event.name != names[received % burstSize]) {
+				std::cerr << "Dequeued unexpected event '" << event.name << "'" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+			received++;
+		}
+		events.clear();
+	}
+	producer.join();
+
+	double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+	return received / (ms / 1000);
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		nrEvents = strTo<size_t>(argv[1]);
+
+	// both queues have to agree on their serialization
+	{
+		std::shared_ptr<EventQueueImpl> basic(new BasicEventQueue());
+		std::shared_ptr<EventQueueImpl> lockFree(new LockFreeEventQueue());
+		for (size_t i = 0; i < 10; i++) {
+			basic->enqueue(Event("event" + toStr(i)));
+			lockFree->enqueue(Event("event" + toStr(i)));
+		}
+		lockFree->dequeue(0);
+		lockFree->deserialize(basic->serialize());
+		if (lockFree->serialize().compound["BasicEventQueue"].array.size() != 19) {
+			std::cerr << "Serialization mismatch" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	std::cout << "\"Producers\", \"BasicEventQueue (events/s)\", \"LockFreeEventQueue (events/s)\"" << std::endl;
+	for (size_t nrProducers = 1; nrProducers <= 64; nrProducers *= 2) {
+		double basic = run(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()), nrProducers);
+		double lockFree = run(std::shared_ptr<EventQueueImpl>(new LockFreeEventQueue()), nrProducers);
+		std::cout << nrProducers << ", " << (size_t)basic << ", " << (size_t)lockFree << std::endl;
+	}
+
+	std::cout << std::endl << "\"Burst\", \"BasicEventQueue (events/s)\", \"batched (events/s)\", \"LockFreeEventQueue (events/s)\", \"batched (events/s)\"" << std::endl;
+	for (size_t burstSize = 1; burstSize <= 4096; burstSize *= 16) {
+		std::cout << burstSize;
+		std::cout << ", " << (size_t)runBursts(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()), burstSize, false);
+		std::cout << ", " << (size_t)runBursts(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()), burstSize, true);
+		std::cout << ", " << (size_t)runBursts(std::shared_ptr<EventQueueImpl>(new LockFreeEventQueue()), burstSize, false);
+		std::cout << ", " << (size_t)runBursts(std::shared_ptr<EventQueueImpl>(new LockFreeEventQueue()), burstSize, true);
+		std::cout << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef AUTOINCLUDE_TEST
+#include "test-c-machine.scxml.c"
+#endif
+
+using namespace std::chrono;
+
+/**
+ * Step throughput of a transpiled chart without a datamodel. The chart is
+ * passed with -include and the bitset variant with a USCXML_BITSET_* macro,
+ * see ctest/scripts/run_generated_c_benchmark.cmake.
+ *
+ * test-gen-c-benchmark [steps] [label]
+ */
+
+size_t steps = 100000;
+
+int main(int argc, char** argv) {
+	const char* label = "chart";
+	if (argc > 1)
+		steps = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		label = argv[2];
+
+	// no callbacks, the benchmark charts only have spontaneous transitions
+	uscxml_ctx ctx;
+	memset(&ctx, 0, sizeof(uscxml_ctx));
+	ctx.machine = &USCXML_MACHINE;
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < steps; i++) {
+		int err = uscxml_step(&ctx);
+		if (err != USCXML_ERR_OK) {
+			std::cerr << label << ": step " << i << " returned " << err << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	double ms = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	std::cout << label << ", " << USCXML_BITSET_WORD_BYTES << ", " << (size_t)ctx.machine->nr_states << ", "
+	          << (size_t)ctx.machine->nr_transitions << ", " << steps / (ms / 1000) << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -90,8 +90,8 @@ public:
 		return NULL;
 	}
 
-	std::set<InterpreterMonitor*> getMonitors() {
-		return std::set<InterpreterMonitor*>();
+	const MonitorSnapshot& getMonitors() {
+		return monitors;
 	}
 
 	std::string getBaseURL() {
@@ -995,6 +995,7 @@ NEXT_DESC:
 	DataModel dataModel;
 	std::map<std::string, IOProcessor> ioProcs;
 	std::map<std::string, Invoker> invokers;
+	MonitorSnapshot monitors; // generated machines have none
 
 protected:
 	struct scxml_foreach_info {
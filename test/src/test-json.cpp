@@ -0,0 +1,277 @@
+#include "uscxml/config.h"
+#include "uscxml/messages/Data.h"
+#include "uscxml/util/String.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+
+extern "C" {
+#include "jsmn/jsmn.h"
+}
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Compare the JSON reader and writer of Data with the jsmn based parser and
+ * the stream based writer they replaced. Both have to agree on the results.
+ *
+ * test-json [iterations]
+ */
+
+size_t iterations = 10000;
+
+static std::string legacyUnescape(const std::string& expr) {
+	bool escape = false;
+	std::string output;
+	for (std::string::size_type i = 0; i < expr.length(); ++i) {
+		if (escape) {
+			switch(expr[i])  {
+			case 'b':
+				output += '\b';
+				break;
+			case 'f':
+				output += '\f';
+				break;
+			case 'n':
+				output += '\n';
+				break;
+			case 'r':
+				output += '\r';
+				break;
+			case 't':
+				output += '\t';
+				break;
+			default:
+				output += expr[i];
+				break;
+			}
+			escape = false;
+		} else if (expr[i] == '\\') {
+			escape = true;
+		} else {
+			output += expr[i];
+		}
+	}
+	return output;
+}
+
+static std::string legacyEscape(const std::string& expr) {
+	std::stringstream os;
+	for (size_t i = 0; i < expr.size(); i++) {
+		switch (expr[i]) {
+		case '\t':
+			os << "\\t";
+			break;
+		case '\v':
+			os << "\\v";
+			break;
+		case '\b':
+			os << "\\b";
+			break;
+		case '\f':
+			os << "\\f";
+			break;
+		case '\n':
+			os << "\\n";
+			break;
+		case '\r':
+			os << "\\r";
+			break;
+		case '\"':
+			os << "\\\"";
+			break;
+		case '\\':
+			os << "\\\\";
+			break;
+		default:
+			os << expr[i];
+		}
+	}
+	return os.str();
+}
+
+/// The former Data::fromJSON, running jsmn until the token array is large enough
+static Data legacyFromJSON(const std::string& json) {
+	Data data;
+	jsmn_parser p;
+	jsmntok_t* t = NULL;
+
+	int rv;
+	int frac = 16;
+	do {
+		jsmn_init(&p);
+		frac /= 2;
+		int nrTokens = json.size() / frac;
+		free(t);
+		t = (jsmntok_t*)calloc(nrTokens + 1, sizeof(jsmntok_t));
+		rv = jsmn_parse(&p, json.c_str(), t, nrTokens);
+	} while (rv == JSMN_ERROR_NOMEM && frac > 1);
+
+	if (rv != 0 || (size_t)t[0].end != json.length()) {
+		free(t);
+		return data;
+	}
+
+	std::list<Data*> dataStack;
+	std::list<jsmntok_t> tokenStack;
+	dataStack.push_back(&data);
+
+	size_t currTok = 0;
+	do {
+		switch (t[currTok].type) {
+		case JSMN_STRING:
+			dataStack.back()->type = Data::VERBATIM;
+		case JSMN_PRIMITIVE: {
+			dataStack.back()->atom = legacyUnescape(json.substr(t[currTok].start, t[currTok].end - t[currTok].start));
+			dataStack.pop_back();
+			currTok++;
+			break;
+		}
+		case JSMN_OBJECT:
+		case JSMN_ARRAY:
+			tokenStack.push_back(t[currTok]);
+			currTok++;
+			break;
+		}
+
+		if (t[currTok].end == 0 || tokenStack.empty())
+			break;
+
+		while (t[currTok].end > tokenStack.back().end) {
+			tokenStack.pop_back();
+			dataStack.pop_back();
+		}
+
+		if (tokenStack.back().type == JSMN_OBJECT && (t[currTok].type == JSMN_PRIMITIVE || t[currTok].type == JSMN_STRING)) {
+			std::string key = legacyUnescape(json.substr(t[currTok].start, t[currTok].end - t[currTok].start));
+			dataStack.push_back(&(dataStack.back()->compound[key]));
+			currTok++;
+		}
+		if (tokenStack.back().type == JSMN_ARRAY) {
+			dataStack.back()->array.push_back(Data());
+			dataStack.push_back(&(dataStack.back()->array.back()));
+		}
+	} while (true);
+
+	free(t);
+	return data;
+}
+
+/// The former Data::toJSON, writing through a stringstream per nested value
+static std::string legacyToJSON(const Data& data, size_t indentation = 1) {
+	std::stringstream os;
+	std::string indent;
+	for (size_t i = 0; i <= indentation; i++) {
+		indent += "  ";
+	}
+	if (data.compound.size() > 0) {
+		size_t longestKey = 0;
+		for (auto& item : data.compound) {
+			if (item.first.size() > longestKey)
+				longestKey = item.first.size();
+		}
+		std::string seperator;
+		os << "{";
+		for (auto& item : data.compound) {
+			os << seperator << std::endl << indent << "  \"" << legacyEscape(item.first) << "\": " << std::string(longestKey - item.first.size(), ' ');
+			os << legacyToJSON(item.second, indentation + 1);
+			seperator = ", ";
+		}
+		os << std::endl << indent << "}";
+	} else if (data.array.size() > 0) {
+		std::string seperator;
+		os << std::endl << indent << "[";
+		for (auto& item : data.array) {
+			os << seperator << legacyToJSON(item, indentation + 1);
+			seperator = ", ";
+		}
+		os << "]";
+	} else if (data.atom.size() > 0) {
+		if (data.type == Data::VERBATIM) {
+			os << "\"" << legacyEscape(data.atom) << "\"";
+		} else {
+			os << data.atom;
+		}
+	} else {
+		os << (data.type == Data::VERBATIM ? "\"\"" : "null");
+	}
+	return os.str();
+}
+
+static void compare(const std::string& name, const std::string& json, size_t runs) {
+	Data legacy = legacyFromJSON(json);
+	Data data = Data::fromJSON(json);
+	if (data != legacy) {
+		std::cerr << name << ": parsed data differs" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	if (Data::toJSON(data) != legacyToJSON(data)) {
+		std::cerr << name << ": written JSON differs" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	if (Data::fromJSON(Data::toJSON(data)) != data) {
+		std::cerr << name << ": JSON does not roundtrip" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	double mb = (double)(json.size() * runs) / (1024 * 1024);
+	double ms[4];
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < runs; i++)
+		legacyFromJSON(json);
+	ms[0] = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	start = system_clock::now();
+	for (size_t i = 0; i < runs; i++)
+		Data::fromJSON(json);
+	ms[1] = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	start = system_clock::now();
+	for (size_t i = 0; i < runs; i++)
+		legacyToJSON(data);
+	ms[2] = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	std::string buffer;
+	start = system_clock::now();
+	for (size_t i = 0; i < runs; i++) {
+		buffer.clear();
+		Data::toJSON(data, buffer);
+	}
+	ms[3] = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	std::cout << name << ", " << json.size();
+	for (size_t i = 0; i < 4; i++)
+		std::cout << ", " << mb / (ms[i] / 1000);
+	std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1)
+		iterations = strTo<size_t>(argv[1]);
+
+	std::cout << "\"Payload\", \"JSON (bytes)\", \"jsmn (MB/s)\", \"fromJSON (MB/s)\", \"stream (MB/s)\", \"toJSON (MB/s)\"" << std::endl;
+
+	compare("event", "{\"name\": \"sensor.update\", \"sendid\": \"s123\", \"origin\": \"#_scxml_4711\", "
+	        "\"data\": {\"id\": 17, \"value\": 21.5, \"unit\": \"celsius\", \"valid\": true, \"note\": \"a \\\"quoted\\\"\\n\\tline\"}}",
+	        iterations);
+
+	// a snapshot of a few MB with many data elements and queued events
+	std::string snapshot = "{\"datamodel\": {";
+	for (size_t i = 0; i < 20000; i++) {
+		snapshot += (i > 0 ? ", " : "");
+		snapshot += "\"data" + toStr(i) + "\": {\"value\": " + toStr(i) + ", \"label\": \"item " + toStr(i) + "\", \"tags\": [\"a\", \"b\", \"c\"]}";
+	}
+	snapshot += "}, \"queue\": [";
+	for (size_t i = 0; i < 20000; i++) {
+		snapshot += (i > 0 ? ", " : "");
+		snapshot += "{\"name\": \"event" + toStr(i) + "\", \"data\": [1, 2, 3, 4, 5, 6, 7, 8]}";
+	}
+	snapshot += "]}";
+	compare("snapshot", snapshot, (iterations / 1000 > 0 ? iterations / 1000 : 1));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Time to process events with and without metrics and whether the counters
+ * account for every event and microstep.
+ *
+ * test-metrics [iterations] [states]
+ */
+
+std::string createChart(size_t nrStates) {
+	std::stringstream ss;
+	ss << "<scxml datamodel=\"null\" xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\">";
+	for (size_t i = 0; i < nrStates; i++) {
+		ss << "<state id=\"s" << i << "\">";
+		ss << "<onentry><raise event=\"entered\"/></onentry>";
+		ss << "<transition event=\"next\" target=\"s" << (i + 1) % nrStates << "\"/>";
+		ss << "</state>";
+	}
+	ss << "</scxml>";
+	return ss.str();
+}
+
+double processEvents(Interpreter& interpreter, size_t iterations) {
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		interpreter.receive(Event("next", Event::EXTERNAL));
+		InterpreterState state;
+		do {
+			state = interpreter.step(0);
+		} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+	}
+	return (double)duration_cast<nanoseconds>(system_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+	size_t iterations = (argc > 1 ? strTo<size_t>(argv[1]) : 100000);
+	size_t nrStates = (argc > 2 ? strTo<size_t>(argv[2]) : 10);
+
+	std::string chart = createChart(nrStates);
+
+	std::cout << "\"Metrics\", \"Per event (ns)\"" << std::endl;
+
+	Interpreter plain = Interpreter::fromXML(chart, "");
+	processEvents(plain, 1);
+	std::cout << "disabled, " << processEvents(plain, iterations) << std::endl;
+
+	Interpreter measured = Interpreter::fromXML(chart, "");
+	processEvents(measured, 1);
+	measured.setMetricsEnabled(true);
+	std::cout << "enabled, " << processEvents(measured, iterations) << std::endl;
+
+	Data metrics = measured.getMetrics();
+	std::cout << metrics << std::endl;
+
+	// every event raises another one when entering its target
+	if (strTo<size_t>(metrics["events"]["next"].atom) != iterations ||
+	        strTo<size_t>(metrics["events"]["entered"].atom) != iterations) {
+		std::cerr << "Events were not counted" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (strTo<size_t>(metrics["microsteps"].atom) < iterations) {
+		std::cerr << "Microsteps were not counted" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (strTo<size_t>(metrics["phases"]["transitions"]["count"].atom) != 2 * iterations) {
+		std::cerr << "Events are missing from the phases" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// disabled metrics are kept but not updated
+	measured.setMetricsEnabled(false);
+	processEvents(measured, 10);
+	if (measured.getMetrics()["events"]["next"] != metrics["events"]["next"]) {
+		std::cerr << "Disabled metrics were updated" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -19,6 +19,10 @@ system_clock::time_point endTime;
 
 class PerfMon : public InterpreterMonitor {
 public:
+	virtual uint32_t getCallbacks() {
+		return MonitorCallback::beforeEnteringState;
+	}
+
 	virtual void beforeEnteringState(const std::string& sessionId,
 	                                 const std::string& stateName,
 	                                 const XERCESC_NS::DOMElement* state) {
@@ -39,9 +43,12 @@ public:
 
 int main(int argc, char** argv) {
 	if (argc < 2) {
-		std::cout << "Expected filename as first parameter" << std::endl;
+		std::cout << "Expected filename as first parameter, optionally followed by an event to send per macrostep" << std::endl;
 		exit(EXIT_FAILURE);
 	}
+	// charts with evented transitions need an event for every macrostep
+	std::string eventName = (argc > 2 ? argv[2] : "");
+
 	{
 		start = system_clock::now();
 
@@ -60,7 +67,13 @@ int main(int argc, char** argv) {
 		std::cout << "\"Init (ms)\", \"Steps/s\"" << std::endl;
 
 		while(true) {
-			sc.step();
+			if (eventName.size() > 0) {
+				// never block on the empty queue, send the next event once idle
+				if (sc.step(0) == USCXML_IDLE)
+					sc.receive(Event(eventName));
+			} else {
+				sc.step();
+			}
 			if (exitPerf) {
 				goto DONE_AND_EXIT;
 			}
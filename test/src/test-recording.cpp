@@ -0,0 +1,122 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/debug/InterpreterRecorder.h"
+#include "uscxml/interpreter/BasicEventQueue.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace uscxml;
+
+/**
+ * Record a session with external events and a delayed event it sends
+ * itself, replay the recording on a virtual clock and check that it ends in
+ * the same configuration.
+ *
+ * test-recording
+ */
+
+static const char* chart =
+    "<scxml datamodel=\"null\" xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\">"
+    "	<state id=\"idle\">"
+    "		<transition event=\"go\" target=\"waiting\"/>"
+    "	</state>"
+    "	<state id=\"waiting\">"
+    "		<onentry><send event=\"timeout\" delay=\"100ms\" id=\"timer\"/></onentry>"
+    "		<onexit><cancel sendid=\"timer\"/></onexit>"
+    "		<transition event=\"timeout\" target=\"idle\"/>"
+    "		<transition event=\"abort\" target=\"aborted\"/>"
+    "	</state>"
+    "	<state id=\"aborted\"/>"
+    "</scxml>";
+
+static void runToIdle(Interpreter& interpreter) {
+	InterpreterState state;
+	do {
+		state = interpreter.step(0);
+	} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+}
+
+static void fail(const std::string& msg) {
+	std::cerr << msg << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+	std::stringstream stream;
+	InterpreterRecorder recorder("", &stream);
+
+	Interpreter interpreter = Interpreter::fromXML(chart, "");
+	interpreter.addMonitor(&recorder);
+	runToIdle(interpreter);
+
+	// times out and returns to idle
+	Event go("go", Event::EXTERNAL);
+	go.data.compound["attempt"] = Data(1);
+	interpreter.receive(go);
+	runToIdle(interpreter);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	runToIdle(interpreter);
+	if (!interpreter.isInState("idle"))
+		fail("Delayed event was not delivered while recording");
+
+	// aborted before the timeout
+	go.data.compound["attempt"] = Data(2);
+	interpreter.receive(go);
+	runToIdle(interpreter);
+	interpreter.receive(Event("abort", Event::EXTERNAL));
+	runToIdle(interpreter);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	runToIdle(interpreter);
+	if (!interpreter.isInState("aborted"))
+		fail("Session was not aborted while recording");
+
+	recorder.finish(interpreter);
+	InterpreterRecording recording = recorder.getRecording();
+
+	if (recording.events.size() != 3)
+		fail("Recorded " + toStr(recording.events.size()) + " events instead of 3");
+	if (recording.configuration != std::list<std::string>({ "aborted" }))
+		fail("Recorded the wrong configuration");
+
+	// what was streamed is what was recorded
+	InterpreterRecording streamed = InterpreterRecording::fromBuffer(stream.str());
+	if (streamed.toBuffer() != recording.toBuffer())
+		fail("Streamed recording differs");
+	if (streamed.events[1].event.name != "go" || streamed.events[1].event.data["attempt"].atom != "2")
+		fail("Event payload was not recorded");
+
+	// a recording whose writer died in the middle of an entry
+	std::string truncated = stream.str();
+	truncated.resize(truncated.size() - 3);
+	InterpreterRecording partial = InterpreterRecording::fromBuffer(truncated);
+	if (partial.finished || partial.events.size() != 3)
+		fail("Truncated recording was not read up to its last entry");
+
+	for (auto pace : { InterpreterReplay::AS_FAST_AS_POSSIBLE, InterpreterReplay::RECORDED }) {
+		Interpreter replayed = Interpreter::fromXML(chart, "");
+		ActionLanguage al;
+		al.externalQueue = EventQueue(std::shared_ptr<EventQueueImpl>(new BasicEventQueue()));
+		replayed.setActionLanguage(al);
+
+		InterpreterReplay::Result result = InterpreterReplay::replay(streamed, replayed, pace);
+		std::cout << (pace == InterpreterReplay::RECORDED ? "recorded" : "fast") << ": " << result.events << " events, ";
+		std::cout << result.macrosteps << " macrosteps in " << result.seconds << "s, p99 " << result.p99Ns << "ns" << std::endl;
+
+		if (result.events != 3)
+			fail("Replayed " + toStr(result.events) + " events instead of 3");
+		// the timeout is replayed from the chart's own delayed send
+		if (result.macrosteps != 4)
+			fail("Replayed " + toStr(result.macrosteps) + " macrosteps instead of 4");
+		if (!result.configurationMatches)
+			fail("Replayed into a different configuration");
+		// only the delayed event queue is replaced
+		if (!(replayed.getActionLanguage()->externalQueue == al.externalQueue))
+			fail("Replay did not keep the interpreter's external queue");
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/Scheduler.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Stress the scheduler with many sessions of which only a few are busy and
+ * simulate a day of sessions waiting on long delayed events on a virtual
+ * clock, on one and on many workers.
+ *
+ * test-scheduler [sessions] [workers]
+ */
+
+static std::string procStatus(const std::string& key) {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, key.length(), key) == 0)
+			return line.substr(key.length() + 1);
+	}
+	return "n/a";
+}
+
+static void printStats(const std::string& phase, Scheduler& scheduler) {
+	Scheduler::Stats stats = scheduler.getStats();
+	std::cout << phase << " - runs: " << stats.runs;
+	std::cout << ", avg latency (us): " << stats.avgLatencyUs();
+	std::cout << ", max latency (us): " << stats.maxLatencyUs;
+	std::cout << ", VmRSS: " << procStatus("VmRSS:") << ", Threads: " << procStatus("Threads:") << std::endl;
+}
+
+// a chain of states each left with a delayed event ten minutes later, every other one sent to #_internal
+static std::string timerChain(size_t nrStates) {
+	std::stringstream ss;
+	ss << "<scxml datamodel=\"null\">";
+	for (size_t i = 0; i < nrStates; i++) {
+		ss << "<state id=\"s" << i << "\">";
+		if (i % 2) {
+			// a session not woken for its internal tick would see the late event first
+			ss << "<onentry><send event=\"tick\" target=\"#_internal\" delay=\"600s\"/>";
+			ss << "<send event=\"late\" id=\"late" << i << "\" delay=\"601s\"/></onentry>";
+			ss << "<onexit><cancel sendid=\"late" << i << "\"/></onexit>";
+			ss << "<transition event=\"late\" target=\"failed\"/>";
+		} else {
+			// due with the tick, always to be processed after it
+			ss << "<onentry><send event=\"tick\" delay=\"600s\"/><send event=\"tock\" delay=\"600s\"/></onentry>";
+		}
+		ss << "<transition event=\"tick\" target=\"s" << i + 1 << "\"/>";
+		ss << "</state>";
+	}
+	ss << "<final id=\"s" << nrStates << "\"/>";
+	ss << "<final id=\"failed\"/>";
+	ss << "</scxml>";
+	return ss.str();
+}
+
+// the events processed by every session, each prefixed with the virtual time
+typedef std::vector<std::vector<std::string> > Traces;
+
+static uint64_t simulate(size_t nrSessions, size_t nrStates, size_t nrWorkers, Traces& traces) {
+	std::string xml = timerChain(nrStates);
+	std::shared_ptr<VirtualClock> clock(new VirtualClock());
+	Scheduler scheduler(nrWorkers, clock);
+
+	traces.clear();
+	traces.resize(nrSessions);
+	std::map<std::string, size_t> indices;
+	std::vector<Interpreter> interpreters;
+	for (size_t i = 0; i < nrSessions; i++) {
+		interpreters.push_back(Interpreter::fromXML(xml, ""));
+		indices[interpreters.back().getImpl()->getSessionId()] = i;
+	}
+
+	system_clock::time_point start = system_clock::now();
+	for (auto& interpreter : interpreters) {
+		// a session is only ever run by one worker at a time and only appends to its own trace
+		interpreter.on().processEvent([&indices, &traces, clock](const std::string& sessionId, const Event& event) {
+			traces[indices.at(sessionId)].push_back(toStr(clock->now()) + " " + event.name);
+		});
+		scheduler.add(interpreter);
+	}
+	scheduler.wait();
+
+	uint64_t simulatedMs = scheduler.getClock()->now();
+	std::cout << "Simulated " << simulatedMs / 3600000.0 << "h of " << nrSessions << " sessions on " << nrWorkers << " workers in ";
+	std::cout << duration_cast<milliseconds>(system_clock::now() - start).count() << "ms" << std::endl;
+	return simulatedMs;
+}
+
+int main(int argc, char** argv) {
+	size_t nrSessions = (argc > 1 ? strTo<size_t>(argv[1]) : 100000);
+	size_t nrWorkers = (argc > 2 ? strTo<size_t>(argv[2]) : std::thread::hardware_concurrency());
+
+	const char* xml =
+	    "<scxml datamodel=\"null\">"
+	    "  <state id=\"idle\">"
+	    "    <transition event=\"ping\" target=\"idle\" />"
+	    "    <transition event=\"quit\" target=\"done\" />"
+	    "  </state>"
+	    "  <final id=\"done\" />"
+	    "</scxml>";
+
+	Scheduler scheduler(nrWorkers);
+	std::vector<Interpreter> interpreters;
+
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < nrSessions; i++) {
+		Interpreter interpreter = Interpreter::fromXML(xml, "");
+		interpreters.push_back(interpreter);
+		scheduler.add(interpreter);
+	}
+
+	// every session is stepped once to initialize and then parks
+	while (scheduler.getStats().runs < nrSessions) {
+		std::this_thread::sleep_for(milliseconds(10));
+	}
+	std::cout << "Started " << nrSessions << " sessions on " << scheduler.getNumberOfWorkers() << " workers in ";
+	std::cout << duration_cast<milliseconds>(system_clock::now() - start).count() << "ms" << std::endl;
+	printStats("Idle", scheduler);
+
+	// keep about one percent of the sessions busy
+	start = system_clock::now();
+	size_t nrPings = 0;
+	for (size_t round = 0; round < 100; round++) {
+		for (size_t i = round % 100; i < nrSessions; i += 100) {
+			interpreters[i].receive(Event("ping"));
+			nrPings++;
+		}
+	}
+	std::cout << "Sent " << nrPings << " pings in ";
+	std::cout << duration_cast<milliseconds>(system_clock::now() - start).count() << "ms" << std::endl;
+
+	start = system_clock::now();
+	for (size_t i = 0; i < nrSessions; i++) {
+		interpreters[i].receive(Event("quit"));
+	}
+	scheduler.wait();
+	std::cout << "Finished all sessions in ";
+	std::cout << duration_cast<milliseconds>(system_clock::now() - start).count() << "ms" << std::endl;
+	printStats("Done", scheduler);
+
+	if (scheduler.getNumberOfSessions() != 0)
+		return EXIT_FAILURE;
+
+	// every session waits 144 times ten minutes, all of them at the same virtual times and none fails on a late event
+	size_t nrSimulated = std::min(nrSessions, (size_t)1000);
+	Traces expected;
+	uint64_t simulatedMs = simulate(nrSimulated, 144, 1, expected);
+	if (simulatedMs != 144 * 600 * 1000) {
+		std::cerr << "Virtual clock did not end after a day" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// more workers only change how the sessions interleave, not what each of them sees
+	for (size_t run = 0; run < 2; run++) {
+		Traces traces;
+		if (simulate(nrSimulated, 144, std::max(nrWorkers, (size_t)2), traces) != simulatedMs || traces != expected) {
+			std::cerr << "Sessions processed different events with " << std::max(nrWorkers, (size_t)2) << " workers" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -34,7 +34,8 @@ void printUsageAndExit() {
 #ifdef BUILD_AS_PLUGINS
 	printf(" [-p pluginPath]");
 #endif
-	printf(" <PATH>\n");
+	printf(" [-b] <PATH>\n");
+	printf("\t-b : use binary snapshots\n");
 	printf("\n");
 	exit(1);
 }
@@ -50,9 +51,13 @@ int main(int argc, char** argv) {
 #ifndef _WIN32
 	opterr = 0;
 #endif
+	SnapshotFormat format = SNAPSHOT_JSON;
 	int option;
-	while ((option = getopt(argc, argv, "vl:p:")) != -1) {
+	while ((option = getopt(argc, argv, "bvl:p:")) != -1) {
 		switch(option) {
+		case 'b':
+			format = SNAPSHOT_BINARY;
+			break;
 		case 'p':
 			uscxml::Factory::setDefaultPluginPath(optarg);
 			break;
@@ -121,7 +126,7 @@ RESTART_WITH_STATE:
 #if 1
 					if (state == USCXML_MACROSTEPPED) {
 //						assert(!interpreter.getImpl()->_internalQueue.dequeue(0));
-						serializedState = interpreter.serialize();
+						serializedState = interpreter.serialize(format);
 //                        std::cout << serializedState << std::endl;
 						goto RESTART_WITH_STATE;
 					}
@@ -0,0 +1,185 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/plugins/Factory.h"
+#include "uscxml/util/Snapshot.h"
+#include "uscxml/util/String.h"
+#include "uscxml/util/DOM.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Compare throughput and size of JSON and binary snapshots for a chart with
+ * many states and a large datamodel and of incremental checkpoints while
+ * events are processed. Deltas also have to capture data changed through
+ * another data element referencing it.
+ *
+ * test-snapshot [iterations] [states] [data elements] [datamodel]
+ */
+
+std::string createChart(size_t nrStates, size_t nrDatas, const std::string& datamodel) {
+	std::stringstream ss;
+	ss << "<scxml datamodel=\"" << datamodel << "\" xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\">";
+
+	// every data element holds an array of 32 numbers
+	ss << "<datamodel>";
+	for (size_t i = 0; i < nrDatas; i++) {
+		ss << "<data id=\"data" << i << "\" expr=\"" << (datamodel == "lua" ? "{" : "[");
+		for (size_t j = 0; j < 32; j++) {
+			ss << (j > 0 ? ", " : "") << i * j;
+		}
+		ss << (datamodel == "lua" ? "}" : "]") << "\"/>";
+	}
+	ss << "</datamodel>";
+
+	// a parallel state with compound children to have more than a single active state
+	ss << "<parallel id=\"p\">";
+	for (size_t i = 0; i < nrStates / 10; i++) {
+		ss << "<state id=\"c" << i << "\">";
+		for (size_t j = 0; j < 9; j++) {
+			ss << "<state id=\"s" << i << "_" << j << "\"><transition event=\"next\" target=\"s" << i << "_" << (j + 1) % 9 << "\">";
+			// a single data element changes per event
+			if (i == 0 && nrDatas > 0)
+				ss << "<assign location=\"data0\" expr=\"" << j << "\"/>";
+			ss << "</transition></state>";
+		}
+		ss << "</state>";
+	}
+	ss << "</parallel>";
+	ss << "</scxml>";
+	return ss.str();
+}
+
+// the documents of different interpreters differ, compare by id
+std::list<std::string> getConfigurationIds(Interpreter& interpreter) {
+	std::list<std::string> ids;
+	for (auto state : interpreter.getConfiguration()) {
+		ids.push_back(ATTR(state, kXMLCharId));
+	}
+	return ids;
+}
+
+// after b = a, assigning to b[0] changes a as well
+bool testAliasedDelta(const std::string& datamodel) {
+	bool lua = (datamodel == "lua");
+	std::stringstream ss;
+	ss << "<scxml datamodel=\"" << datamodel << "\" xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\">";
+	ss << "<datamodel><data id=\"a\" expr=\"" << (lua ? "{0}" : "[0]") << "\"/><data id=\"b\"/></datamodel>";
+	ss << "<state id=\"s0\"><onentry><assign location=\"b\" expr=\"a\"/></onentry>";
+	ss << "<transition event=\"next\" target=\"s1\"><assign location=\"" << (lua ? "b[1]" : "b[0]") << "\" expr=\"1\"/></transition></state>";
+	ss << "<state id=\"s1\"/>";
+	ss << "</scxml>";
+	std::string chart = ss.str();
+
+	Interpreter interpreter = Interpreter::fromXML(chart, "");
+	InterpreterState state;
+	do {
+		state = interpreter.step(0);
+	} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+
+	std::string base = interpreter.checkpoint();
+	interpreter.receive(Event("next"));
+	do {
+		state = interpreter.step(0);
+	} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+	std::list<std::string> deltas;
+	deltas.push_back(interpreter.checkpoint());
+
+	Interpreter restored = Interpreter::fromXML(chart, "");
+	restored.restore(base, deltas);
+	return restored.getImpl()->evalAsData(lua ? "a[1]" : "a[0]").atom == "1";
+}
+
+int main(int argc, char** argv) {
+	size_t iterations = (argc > 1 ? strTo<size_t>(argv[1]) : 100);
+	size_t nrStates = (argc > 2 ? strTo<size_t>(argv[2]) : 1000);
+	size_t nrDatas = (argc > 3 ? strTo<size_t>(argv[3]) : 1000);
+	std::string datamodel = (argc > 4 ? argv[4] : "ecmascript");
+
+	if (!Factory::getInstance()->hasDataModel(datamodel)) {
+		std::cout << "No " << datamodel << " datamodel to take snapshots of" << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	std::string chart = createChart(nrStates, nrDatas, datamodel);
+
+	Interpreter interpreter = Interpreter::fromXML(chart, "");
+	InterpreterState state = interpreter.step(0);
+	while (state != USCXML_IDLE && state != USCXML_FINISHED) {
+		state = interpreter.step(0);
+	}
+
+	std::cout << "\"Format\", \"Size (bytes)\", \"Serialize (ms)\", \"Deserialize (ms)\"" << std::endl;
+
+	SnapshotFormat formats[] = { SNAPSHOT_JSON, SNAPSHOT_BINARY };
+	for (auto format : formats) {
+		std::string snapshot;
+
+		system_clock::time_point start = system_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			snapshot = interpreter.serialize(format);
+		}
+		double serializeMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+		// initialize the chart before measuring
+		Interpreter restored = Interpreter::fromXML(chart, "");
+		restored.deserialize(snapshot);
+
+		start = system_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			restored.deserialize(snapshot);
+		}
+		double deserializeMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+		if (getConfigurationIds(restored) != getConfigurationIds(interpreter)) {
+			std::cerr << "Restored configuration differs" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::cout << (format == SNAPSHOT_JSON ? "\"JSON\", " : "\"Binary\", ") << snapshot.size() << ", "
+		          << serializeMs / iterations << ", " << deserializeMs / iterations << std::endl;
+	}
+
+	// checkpoint after every event
+	std::string base = interpreter.checkpoint();
+	std::list<std::string> deltas;
+	size_t deltaBytes = 0;
+	double checkpointMs = 0;
+
+	for (size_t i = 0; i < iterations; i++) {
+		interpreter.receive(Event("next"));
+		state = interpreter.step(0);
+		while (state != USCXML_IDLE && state != USCXML_FINISHED) {
+			state = interpreter.step(0);
+		}
+
+		system_clock::time_point start = system_clock::now();
+		deltas.push_back(interpreter.checkpoint());
+		checkpointMs += duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+		deltaBytes += deltas.back().size();
+	}
+
+	system_clock::time_point start = system_clock::now();
+	Interpreter restored = Interpreter::fromXML(chart, "");
+	restored.restore(base, deltas);
+	double restoreMs = duration_cast<microseconds>(system_clock::now() - start).count() / 1000.0;
+
+	if (getConfigurationIds(restored) != getConfigurationIds(interpreter)) {
+		std::cerr << "Configuration restored from deltas differs" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "\"Delta\", " << deltaBytes / iterations << ", " << checkpointMs / iterations << ", " << restoreMs << " (" << iterations << " deltas)" << std::endl;
+
+	if ((datamodel == "ecmascript" || datamodel == "lua") && !testAliasedDelta(datamodel)) {
+		std::cerr << "Delta lost a change through a reference" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include "uscxml/config.h"
+#include "uscxml/interpreter/TimerWheelDelayedEventQueue.h"
+#include "uscxml/interpreter/BasicDelayedEventQueue.h"
+#include "uscxml/interpreter/EventQueue.h"
+#include "uscxml/util/Convenience.h"
+
+#include <chrono>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Simulates many sessions with delayed sends and reports the process'
+ * memory and thread count as well as the jitter of delivered events.
+ *
+ * test-timer-wheel [sessions] [sends per session] [basic]
+ */
+
+std::mutex jitterMutex;
+std::vector<long> jitters;
+std::atomic<size_t> delivered(0);
+steady_clock::time_point start;
+
+class Session : public DelayedEventQueueCallbacks {
+public:
+	virtual ~Session() {}
+	void eventReady(Event& event, const std::string& eventId) {
+		long expected = strTo<long>(event.data.atom);
+		long actual = duration_cast<milliseconds>(steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> lock(jitterMutex);
+		jitters.push_back(actual - expected);
+		delivered++;
+	}
+	DelayedEventQueue queue;
+};
+
+static std::string procStatus(const std::string& key) {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.compare(0, key.length(), key) == 0)
+			return line.substr(key.length() + 1);
+	}
+	return "n/a";
+}
+
+int main(int argc, char** argv) {
+	size_t nrSessions = (argc > 1 ? strTo<size_t>(argv[1]) : 1000);
+	size_t nrSends = (argc > 2 ? strTo<size_t>(argv[2]) : 10);
+	bool useBasic = (argc > 3 && std::string(argv[3]) == "basic");
+
+	std::cout << "Sessions: " << nrSessions << ", sends per session: " << nrSends;
+	std::cout << ", queue: " << (useBasic ? "BasicDelayedEventQueue" : "TimerWheelDelayedEventQueue") << std::endl;
+	std::cout << "Before - VmRSS: " << procStatus("VmRSS:") << ", Threads: " << procStatus("Threads:") << std::endl;
+
+	std::vector<Session*> sessions;
+	for (size_t i = 0; i < nrSessions; i++) {
+		Session* session = new Session();
+		if (useBasic) {
+			session->queue = DelayedEventQueue(std::shared_ptr<DelayedEventQueueImpl>(new BasicDelayedEventQueue(session)));
+		} else {
+			session->queue = DelayedEventQueue(std::shared_ptr<DelayedEventQueueImpl>(new TimerWheelDelayedEventQueue(session)));
+		}
+		sessions.push_back(session);
+	}
+
+	start = steady_clock::now();
+	size_t maxDelay = 0;
+	for (size_t i = 0; i < nrSessions; i++) {
+		for (size_t j = 0; j < nrSends; j++) {
+			// spread delays between 10ms and 2s
+			size_t delayMs = 10 + ((i * 7919 + j * 104729) % 1990);
+			long dueMs = duration_cast<milliseconds>(steady_clock::now() - start).count() + delayMs;
+			maxDelay = std::max(maxDelay, delayMs);
+
+			Event e("timer");
+			e.data = Data(dueMs, Data::INTERPRETED);
+			sessions[i]->queue.enqueueDelayed(e, delayMs, e.getUUID());
+		}
+	}
+
+	std::cout << "Queued - VmRSS: " << procStatus("VmRSS:") << ", Threads: " << procStatus("Threads:") << std::endl;
+
+	steady_clock::time_point deadline = steady_clock::now() + milliseconds(maxDelay + 5000);
+	while (delivered < nrSessions * nrSends && steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(milliseconds(50));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jitterMutex);
+		std::sort(jitters.begin(), jitters.end());
+		if (jitters.size() > 0) {
+			long sum = 0;
+			for (auto jitter : jitters)
+				sum += jitter;
+			std::cout << "Jitter (ms) - min: " << jitters.front();
+			std::cout << ", avg: " << (double)sum / jitters.size();
+			std::cout << ", p50: " << jitters[jitters.size() / 2];
+			std::cout << ", p99: " << jitters[(jitters.size() * 99) / 100];
+			std::cout << ", max: " << jitters.back() << std::endl;
+		}
+	}
+	std::cout << "Delivered " << delivered << " of " << nrSessions * nrSends << std::endl;
+
+	for (auto session : sessions)
+		delete session;
+
+	return (delivered == nrSessions * nrSends ? EXIT_SUCCESS : EXIT_FAILURE);
+}
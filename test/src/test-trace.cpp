@@ -0,0 +1,174 @@
+#include "uscxml/config.h"
+#include "uscxml/Interpreter.h"
+#include "uscxml/interpreter/InterpreterImpl.h"
+#include "uscxml/util/Convenience.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace uscxml;
+using namespace std::chrono;
+
+/**
+ * Time to process events with and without the flight recorder, while another
+ * thread keeps dumping it, and whether the dumps contain the recent steps.
+ *
+ * test-trace [iterations] [states]
+ */
+
+std::string createChart(size_t nrStates) {
+	std::stringstream ss;
+	ss << "<scxml datamodel=\"null\" xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\">";
+	for (size_t i = 0; i < nrStates; i++) {
+		ss << "<state id=\"s" << i << "\">";
+		ss << "<onentry><raise event=\"entered\"/></onentry>";
+		ss << "<transition event=\"next\" target=\"s" << (i + 1) % nrStates << "\"/>";
+		ss << "</state>";
+	}
+	ss << "</scxml>";
+	return ss.str();
+}
+
+double processEvents(Interpreter& interpreter, size_t iterations) {
+	system_clock::time_point start = system_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		interpreter.receive(Event("next", Event::EXTERNAL));
+		InterpreterState state;
+		do {
+			state = interpreter.step(0);
+		} while (state != USCXML_IDLE && state != USCXML_FINISHED);
+	}
+	return (double)duration_cast<nanoseconds>(system_clock::now() - start).count() / iterations;
+}
+
+uint32_t readUInt32(const std::string& data, size_t& offset) {
+	uint32_t value = 0;
+	for (size_t i = 0; i < 4; i++)
+		value |= (uint32_t)(unsigned char)data[offset + i] << (8 * i);
+	offset += 4;
+	return value;
+}
+
+// number of records in a binary trace
+size_t countRecords(const std::string& trace) {
+	if (trace.size() < 12 || trace.substr(0, 8) != "USCXMLTR") {
+		std::cerr << "Binary trace has no header" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	size_t offset = 12;
+	offset += readUInt32(trace, offset); // session id
+	offset += 8; // ticks per nanosecond
+	for (size_t i = 0; i < 3; i++) {
+		uint32_t names = readUInt32(trace, offset);
+		for (uint32_t j = 0; j < names; j++) {
+			offset += 4;
+			offset += readUInt32(trace, offset);
+		}
+	}
+	size_t records = readUInt32(trace, offset);
+	if (trace.size() != offset + records * 16) {
+		std::cerr << "Binary trace has " << trace.size() << " bytes, expected " << offset + records * 16 << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return records;
+}
+
+int main(int argc, char** argv) {
+	size_t iterations = (argc > 1 ? strTo<size_t>(argv[1]) : 100000);
+	size_t nrStates = (argc > 2 ? strTo<size_t>(argv[2]) : 10);
+
+	std::string chart = createChart(nrStates);
+
+	std::cout << "\"Trace\", \"Per event (ns)\", \"Dumps\"" << std::endl;
+
+	Interpreter plain = Interpreter::fromXML(chart, "");
+	plain.setTraceCapacity(0);
+	processEvents(plain, 1);
+	std::cout << "disabled, " << processEvents(plain, iterations) << ", 0" << std::endl;
+
+	Interpreter traced = Interpreter::fromXML(chart, "");
+	traced.setTraceCapacity(InterpreterTrace::DEFAULT_CAPACITY);
+	processEvents(traced, 1);
+	std::cout << "enabled, " << processEvents(traced, iterations) << ", 0" << std::endl;
+
+	// dump the recorder concurrently, the interpreter must not wait for it
+	std::atomic<bool> done(false);
+	std::atomic<size_t> dumps(0);
+	std::thread reader([&traced, &done, &dumps]() {
+		while (!done) {
+			std::stringstream ss;
+			traced.writeTrace(ss, InterpreterTrace::BINARY);
+			countRecords(ss.str());
+			dumps++;
+		}
+	});
+	double perEvent = processEvents(traced, iterations);
+	done = true;
+	reader.join();
+	std::cout << "dumped, " << perEvent << ", " << dumps << std::endl;
+
+	std::stringstream disabledSS;
+	plain.writeTrace(disabledSS, InterpreterTrace::BINARY);
+	if (countRecords(disabledSS.str()) != 0) {
+		std::cerr << "Disabled trace has records" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::stringstream binarySS;
+	traced.writeTrace(binarySS, InterpreterTrace::BINARY);
+	if (countRecords(binarySS.str()) != InterpreterTrace::DEFAULT_CAPACITY) {
+		std::cerr << "Full trace does not have all records" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// a single event and its consequences by name
+	Interpreter single = Interpreter::fromXML(chart, "");
+	processEvents(single, 1);
+
+	// the chart never mentions this event, the trace keeps its name
+	single.receive(Event("not.in.chart", Event::EXTERNAL));
+	while (single.step(0) != USCXML_IDLE);
+	std::stringstream chromeSS;
+	single.writeTrace(chromeSS, InterpreterTrace::CHROME);
+	std::string chrome = chromeSS.str();
+	std::cout << chrome << std::endl;
+
+	if (chrome.find("\"name\":\"next\"") == std::string::npos ||
+	        chrome.find("\"name\":\"entered\"") == std::string::npos ||
+	        chrome.find("\"name\":\"exit s0\"") == std::string::npos ||
+	        chrome.find("\"name\":\"enter s1\"") == std::string::npos ||
+	        chrome.find("\"name\":\"onentry s1\",\"cat\":\"content\",\"ph\":\"B\"") == std::string::npos ||
+	        chrome.find("\"name\":\"onentry s1\",\"cat\":\"content\",\"ph\":\"E\"") == std::string::npos ||
+	        chrome.find("\"name\":\"stable\"") == std::string::npos ||
+	        chrome.find("\"name\":\"not.in.chart\"") == std::string::npos) {
+		std::cerr << "Chrome trace is missing records" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// several sessions share one timeline, each as its own thread
+	std::list<InterpreterTrace::Session> sessions;
+	sessions.push_back(single.getImpl()->readTrace());
+	sessions.push_back(traced.getImpl()->readTrace(10));
+	std::stringstream mergedSS;
+	InterpreterTrace::writeChrome(mergedSS, sessions);
+	std::string merged = mergedSS.str();
+	if (merged.find("\"traceEvents\"") != merged.rfind("\"traceEvents\"") ||
+	        merged.find("\"tid\":1") == std::string::npos ||
+	        merged.find("\"tid\":2") == std::string::npos ||
+	        merged.find("\"name\":" + Data::toJSON(Data(traced.getImpl()->getSessionId(), Data::VERBATIM))) == std::string::npos) {
+		std::cerr << "Chrome trace of several sessions is not a single timeline" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::stringstream lastSS;
+	single.writeTrace(lastSS, InterpreterTrace::BINARY, 3);
+	if (countRecords(lastSS.str()) != 3) {
+		std::cerr << "Trace was not limited to the last records" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -5,7 +5,9 @@
 #include "uscxml/util/DOM.h"
 #include "uscxml/interpreter/Logging.h"
 #include <xercesc/util/PlatformUtils.hpp>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 
 uscxml::Factory* factory = NULL;
 
@@ -227,6 +229,70 @@ bool illegalCompletion() {
 		assert(issueLocations.find("//state[@id=\"start\"]/transition[1]") != issueLocations.end());
 		assert(issueLocations.size() == 2);
 	}
+
+	if (1) {
+		// No legal completion below a parallel state
+
+		const char* xml =
+		    "<scxml>"
+		    " <parallel id=\"p\">"
+		    "   <state id=\"r1\" initial=\"a1\">"
+		    "     <state id=\"a1\" />"
+		    "     <state id=\"a2\" />"
+		    "     <transition event=\"e\" target=\"a1 a2\" />"
+		    "   </state>"
+		    "   <state id=\"r2\" />"
+		    " </parallel>"
+		    "</scxml>";
+
+		std::set<std::string> issueLocations = issueLocationsForXML(xml);
+		assert(issueLocations.find("//state[@id=\"r1\"]/transition[1]") != issueLocations.end());
+		assert(issueLocations.size() == 1);
+	}
+	return true;
+}
+
+static void writeLargeState(std::ostream& stream, size_t& id, size_t depth, size_t fanOut) {
+	size_t ownId = id++;
+	if (depth == 0) {
+		stream << "<state id=\"s" << ownId << "\"><transition event=\"e" << ownId % 13 << "\" target=\"s" << ownId / 2 << "\"/></state>";
+		return;
+	}
+
+	bool parallel = (ownId % 3 == 1);
+	if (parallel) {
+		stream << "<parallel id=\"s" << ownId << "\">";
+	} else {
+		stream << "<state id=\"s" << ownId << "\" initial=\"s" << id << "\">";
+	}
+	stream << "<history id=\"h" << ownId << "\" type=\"deep\"><transition target=\"s" << id << "\"/></history>";
+	for (size_t i = 0; i < fanOut; i++) {
+		writeLargeState(stream, id, depth - 1, fanOut);
+	}
+	stream << (parallel ? "</parallel>" : "</state>");
+}
+
+bool largeChart() {
+	if (1) {
+		// Validate a chart with some 50k states and nested parallel states
+
+		std::stringstream xml;
+		size_t id = 0;
+		xml << "<scxml xmlns=\"http://www.w3.org/2005/07/scxml\" version=\"1.0\" datamodel=\"null\">";
+		writeLargeState(xml, id, 6, 6);
+		xml << "</scxml>";
+
+		Interpreter interpreter = Interpreter::fromXML(xml.str(), "");
+
+		std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+		std::list<InterpreterIssue> issues = interpreter.validate();
+		long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start).count();
+		std::cout << "Validated " << id << " states in " << elapsedMs << "ms" << std::endl;
+
+		for (auto& issue : issues) {
+			assert(issue.severity != InterpreterIssue::USCXML_ISSUE_FATAL);
+		}
+	}
 	return true;
 }
 
@@ -905,6 +971,7 @@ int main(int argc, char** argv) {
 			uselessHistory1();
 			uselessHistory2();
 			illegalCompletion();
+			largeChart();
 			attributeConstraints();
 			optimallyEnabled();
 			invalidInitial();